@@ -9,6 +9,7 @@ static const uint8_t REG_SECONDS = 0x00u;
 static const uint8_t REG_HOURS = 0x02u;
 static const uint8_t REG_CONTROL = 0x0Eu;
 static const uint8_t REG_STATUS  = 0x0Fu;
+static const uint8_t REG_AGING_OFFSET = 0x10u;
 static const uint8_t REG_ALARM1_SECONDS = 0x07u;
 static const uint8_t REG_ALARM2_MINUTES = 0x0Bu;
 static const uint8_t REG_TEMP_MSB = 0x11u;
@@ -22,6 +23,52 @@ static const uint8_t BIT_MASK_OSF_FLAG   = 0b10000000;
 static const uint8_t BIT_SHIFT_AXMX = 0x07u;
 static const uint8_t BIT_SHIFT_DYDT = 0x06u;
 static const uint8_t BIT_SHIFT_AMPM = 0x05u;
+static const uint8_t BIT_SHIFT_CENTURY = 0x07u;
+static const uint8_t BIT_MASK_A1F = 0b00000001;
+static const uint8_t BIT_MASK_A2F = 0b00000010;
+static const uint8_t BIT_MASK_BSY = 0b00000100;
+static const uint8_t BIT_MASK_EN32KHZ = 0b00001000;
+static const uint8_t BIT_MASK_A1IE = 0b00000001;
+static const uint8_t BIT_MASK_A2IE = 0b00000010;
+static const uint8_t BIT_MASK_INTCN = 0b00000100;
+static const uint8_t BIT_MASK_RS = 0b00011000;
+static const uint8_t BIT_MASK_CONV = 0b00100000;
+static const uint8_t BIT_MASK_BBSQW = 0b01000000;
+static const uint8_t BIT_MASK_EOSC = 0b10000000;
+/** status flags set by hardware. writing 1 leaves them untouched, writing 0 clears them */
+static const uint8_t BIT_MASK_STATUS_FLAGS = 0b10000011;
+
+/**
+ * register shadow rules:
+ * the shadow holds the alarm registers, REG_CONTROL, REG_STATUS and REG_AGING_OFFSET (0x07-0x10)
+ * as last written, and the 12/24 hours mode bit of REG_HOURS.
+ * bits the chip changes on its own are never stored and never served from the shadow:
+ *  - REG_STATUS OSF/A2F/A1F are stored as 0 and always written as 1 (no-op),
+ *    except the ones being cleared which are written as 0.
+ *  - REG_STATUS BSY is read only and stored as 0.
+ *  - REG_CONTROL CONV is self clearing, stored as 0 and only written as 1 when requested.
+ * reading these bits always goes to the bus.
+ */
+static const uint8_t SHADOW_REG_FIRST = 0x07u;
+static const uint8_t SHADOW_REG_LAST  = 0x10u; //aging offset
+/** registers 0x00-0x12 can be staged in a transaction */
+static const uint8_t TXN_REG_COUNT = 0x13u;
+
+/**
+ * seconds edge detection: a coarse poll finds one rollover, the next one is a second later
+ * (the oscillator is within a few ppm) so the reads can sleep until just before it and poll back to back.
+ */
+static const uint64_t NS_PER_SECOND = 1000000000u;
+static const uint32_t EDGE_COARSE_POLL_US = 10000u;
+static const uint64_t EDGE_COARSE_TIMEOUT_NS = 1500000000u; /** a running oscillator rolls over within a second */
+static const uint8_t  EDGE_ATTEMPTS = 3u;                  /** seconds to retry when the sleep overshoots the edge */
+
+static const uint8_t DAYS_IN_MONTH[12] = {31,28,31,30,31,30,31,31,30,31,30,31};
+
+/** month length as the chip counts it: every year divisible by 4 is a leap year, 2100 included */
+static uint8_t days_in_month(uint8_t month, uint8_t year){
+    return (2u == month && 0u == year % 4u) ? 29u : DAYS_IN_MONTH[month - 1u];
+}
 
 
 bool ds3231_init(
@@ -40,7 +87,12 @@ bool ds3231_init(
         return false;
     }
     #endif
+    dev->__shadow_f = false;
+    dev->__txn_f = false;
+    ds3231_default_policy(&dev->__policy);
     if(false == i2c_initialized){
+        dev->bus = NULL;
+        dev->mux_channel = DS3231_BUS_NO_MUX;
         dev->i2c_scl_num = i2c_scl_num;
         dev->i2c_sda_num = i2c_sda_num;
         #ifdef CONFIG_USE_I2C_PORT
@@ -54,6 +106,8 @@ bool ds3231_init(
         }
 
     }else if(true == i2c_initialized && false == dev->__i2c_init_f){
+        dev->bus = NULL;
+        dev->mux_channel = DS3231_BUS_NO_MUX;
         dev->__i2c_init_f = true;
         return true;
     }else{
@@ -62,69 +116,215 @@ bool ds3231_init(
 
 }
 
+/**
+ * bcd codec.
+ * encoding is a table lookup, decoding is nibble arithmetic on the masked register:
+ * tens*10 + ones == value - 6*tens. both are constant time.
+ */
+#define BCD_ROW(tens) 0x##tens##0u,0x##tens##1u,0x##tens##2u,0x##tens##3u,0x##tens##4u, \
+                      0x##tens##5u,0x##tens##6u,0x##tens##7u,0x##tens##8u,0x##tens##9u
+static const uint8_t bcd_encode_table[100] = {
+    BCD_ROW(0),BCD_ROW(1),BCD_ROW(2),BCD_ROW(3),BCD_ROW(4),
+    BCD_ROW(5),BCD_ROW(6),BCD_ROW(7),BCD_ROW(8),BCD_ROW(9)
+};
+#undef BCD_ROW
+
+/** mask of a bcd field with width_of_tens bits of tens above the ones nibble */
+#define BCD_MASK(width_of_tens) ((uint8_t)((((0x01u << (width_of_tens)) - 1u) << 4u) | 0x0Fu))
+static const uint8_t BCD_MASK_SECONDS      = BCD_MASK(3);
+static const uint8_t BCD_MASK_MINUTES      = BCD_MASK(3);
+static const uint8_t BCD_MASK_HOURS_12     = BCD_MASK(1);
+static const uint8_t BCD_MASK_HOURS_24     = BCD_MASK(2);
+static const uint8_t BCD_MASK_DAY_OF_WEEK  = 0x07u;
+static const uint8_t BCD_MASK_DAY_OF_MONTH = BCD_MASK(2);
+/** masks of the 7 time registers packed little endian, hours filled in by mode */
+#define BCD_TIME_MASKS ( (uint64_t)BCD_MASK(3)               /* seconds */      \
+                       | ((uint64_t)BCD_MASK(3) << 8u)       /* minutes */      \
+                       | ((uint64_t)0x07u << 24u)            /* day of week */  \
+                       | ((uint64_t)BCD_MASK(2) << 32u)      /* day of month */ \
+                       | ((uint64_t)BCD_MASK(1) << 40u)      /* month, century decoded separately */ \
+                       | ((uint64_t)BCD_MASK(4) << 48u))     /* year */
+static const uint64_t BCD_LOW_NIBBLES = 0x0F0F0F0F0F0F0F0Full;
+
 /**
  * @brief internal conversion from decimal to bcd up to 99.
- * @param [number][in]: a pointer to the number to be converted.
+ * @param [number][in]: the number to be converted.
  * if the number is larger than 99 0 is returned.
  * */
-static uint8_t dec_to_bcd(uint8_t* number){
-    if(NULL == number){
-        return 0;
-    }else if(99 < *number){
-        return 0;
-    }else{
-        uint8_t temp_number = *number;
-        uint8_t temp_tens = 0;
-        uint8_t temp_ones = 0;
-        while(temp_number > 0x09){
-            temp_number -= 0x0A;
-            temp_tens += 1;
-        }
-        temp_ones = temp_number;
-        temp_tens <<= 4u;
-        temp_ones |= temp_tens;
-        return temp_ones;
-    }
+static uint8_t dec_to_bcd(uint8_t number){
+    return (number < 100u) ? bcd_encode_table[number] : 0u;
 }
 
 /**convert from bcd in ds3231 time/alarm regs into decimal. up to 99.
- * @param [number] a pointer to a number in bcd format smaller than 99.
- * @param [width_of_tens] how many bits 1..4 for the tens in the bcd format
+ * @param [number] a register value in bcd format.
+ * @param [mask] the BCD_MASK_* of the field, strips mode/flag bits sharing the register.
  * @returns a decimal format (uint8_t) of the number.
- * @return in case the number is NULL returns 0. 
  * */
-static uint8_t bcd_to_dec(uint8_t* number,uint8_t width_of_tens){
-    if(NULL == number){
-        return 0;
-    }else if(*number < 0x0A){
-        return *number;
-    }else if (99 < *number){
-        return 0;
-    }else{
-        uint8_t temp_number = *number;
-        //clear high nibble to get ones
-        const uint8_t temp_ones = temp_number &~ (0xf0u);
-        uint8_t temp_tens = temp_number >> 4u;
-        uint8_t mask = 0x00;
-        switch(width_of_tens){
-            default: 
-                mask = 0x00;
-                break;
-            case(0x01):
-                mask = 0xfe;
-                break;
-            case(0x02):
-                mask = 0xfc;
-                break;
-            case(0x03):
-                mask = 0xf8;
-                break;
-            case(0x04):
-                mask = 0xf0;
-                break;
-        }
-        temp_tens &= ~(mask);
-        return ((temp_tens * 0x0Au) + temp_ones);
+static uint8_t bcd_to_dec(uint8_t number,uint8_t mask){
+    number &= mask;
+    return number - (uint8_t)(6u * (number >> 4u));
+}
+
+/**
+ * register shadow helpers
+ */
+
+/** strip the bits that can't be served from the shadow */
+static uint8_t shadow_storable(uint8_t reg_address, uint8_t value){
+    if(REG_STATUS == reg_address){
+        return value & ~(BIT_MASK_STATUS_FLAGS | BIT_MASK_BSY);
+    }else if(REG_CONTROL == reg_address){
+        return value & ~(BIT_MASK_CONV);
+    }else{
+        return value;
+    }
+}
+
+/** update the shadow with a value that was read from or written to the chip */
+static void shadow_store(ds3231_dev_t* dev, uint8_t reg_address, uint8_t value){
+    if(dev->__shadow_f && SHADOW_REG_FIRST <= reg_address && SHADOW_REG_LAST >= reg_address){
+        dev->__shadow_regs[reg_address - SHADOW_REG_FIRST] = shadow_storable(reg_address,value);
+    }
+}
+
+/**
+ * @brief update the shadow with a value read from the chip. a register staged by an open
+ * transaction keeps the staged value, the chip only gets it at commit.
+ */
+static void shadow_refresh(ds3231_dev_t* dev, uint8_t reg_address, uint8_t value){
+    if(!(dev->__txn_f && (dev->__txn_dirty & (0x01ul << reg_address)))){
+        shadow_store(dev,reg_address,value);
+    }
+}
+
+/**
+ * @brief write registers, or stage them while a transaction is open.
+ * staged REG_STATUS flag clears and REG_CONTROL CONV requests accumulate so a later
+ * staged write of the same register doesn't undo them.
+ * @returns true on success false on fail
+ */
+static bool write_regs(ds3231_dev_t* dev, uint8_t reg_start, uint8_t* data, uint8_t byte_length){
+    if(dev->__txn_f){
+        if(0 == byte_length || TXN_REG_COUNT < (reg_start + byte_length)){
+            return false;
+        }
+        for(uint8_t i = 0; i < byte_length; i++){
+            const uint8_t reg = reg_start + i;
+            dev->__txn_regs[reg] = data[i];
+            dev->__txn_dirty |= (0x01ul << reg);
+            if(REG_STATUS == reg){
+                dev->__txn_status_clear |= BIT_MASK_STATUS_FLAGS & ~(data[i]);
+            }else if(REG_CONTROL == reg){
+                dev->__txn_control_set |= BIT_MASK_CONV & data[i];
+            }
+        }
+        dev->__txn_writes += (UINT32_MAX > dev->__txn_writes) ? 1u : 0u;
+        return true;
+    }else if(1 == byte_length){
+        return __ds3231_i2c_write_single(dev,reg_start,data[0]);
+    }else{
+        return __ds3231_i2c_write_multi(dev,data,reg_start,byte_length);
+    }
+}
+
+/**
+ * @brief apply staged registers of an open transaction to a buffer read from the chip,
+ * so read-modify-write inside a transaction sees the pending values.
+ */
+static void txn_overlay(ds3231_dev_t* dev, uint8_t reg_start, uint8_t* data, uint8_t byte_length){
+    if(dev->__txn_f){
+        for(uint8_t i = 0; i < byte_length; i++){
+            if(dev->__txn_dirty & (0x01ul << (reg_start + i))){
+                data[i] = dev->__txn_regs[reg_start + i];
+            }
+        }
+    }
+}
+
+/**
+ * @brief set and clear bits in REG_CONTROL, REG_STATUS or REG_AGING_OFFSET.
+ * with a valid shadow this costs a single write, or nothing when the register already holds the value.
+ * without a shadow it is a read-modify-write.
+ * @param [set_mask][in] bits to set. CONV starts a temperature conversion.
+ * @param [clear_mask][in] bits to clear. for REG_STATUS OSF/A2F/A1F in clear_mask are cleared on the chip,
+ * the other flags are left untouched.
+ * @returns true on success false on fail
+ */
+static bool update_reg(ds3231_dev_t* dev, uint8_t reg_address, uint8_t set_mask, uint8_t clear_mask){
+    uint8_t current_reg = 0;
+    uint8_t new_reg = 0;
+    bool res = false;
+    if(dev->__shadow_f){
+        current_reg = dev->__shadow_regs[reg_address - SHADOW_REG_FIRST];
+    }else{
+        res = __ds3231_i2c_read_single(dev,reg_address,&current_reg);
+        if(!res){
+            return res;
+        }
+        txn_overlay(dev,reg_address,&current_reg,1);
+        current_reg = shadow_storable(reg_address,current_reg);
+    }
+    new_reg = shadow_storable(reg_address,(current_reg & ~(clear_mask)) | set_mask);
+    if(REG_STATUS == reg_address){
+        //flags that are not cleared are written as 1 so a flag set by the chip meanwhile survives
+        clear_mask &= BIT_MASK_STATUS_FLAGS;
+        if(dev->__shadow_f && new_reg == current_reg && 0 == clear_mask){
+            return true;
+        }
+        uint8_t data = new_reg | (BIT_MASK_STATUS_FLAGS & ~(clear_mask));
+        res = write_regs(dev,reg_address,&data,1);
+    }else if(REG_CONTROL == reg_address){
+        set_mask &= BIT_MASK_CONV;
+        if(dev->__shadow_f && new_reg == current_reg && 0 == set_mask){
+            return true;
+        }
+        uint8_t data = new_reg | set_mask;
+        res = write_regs(dev,reg_address,&data,1);
+    }else{
+        if(dev->__shadow_f && new_reg == current_reg){
+            return true;
+        }
+        res = write_regs(dev,reg_address,&new_reg,1);
+    }
+    if(!res){
+        //the write may or may not have reached the chip
+        dev->__shadow_f = false;
+        return res;
+    }else{
+        shadow_store(dev,reg_address,new_reg);
+        return true;
+    }
+}
+
+bool ds3231_shadow_resync(ds3231_dev_t* dev){
+    if(NULL == dev){
+        return false;
+    }else if(!dev->__i2c_init_f){
+        return false;
+    }else{
+        //REG_HOURS up to the aging offset in one burst
+        uint8_t buffer[15] = {0};
+        bool res = __ds3231_i2c_read_multi(dev,REG_HOURS,buffer,15);
+        if(!res){
+            dev->__shadow_f = false;
+            return res;
+        }else{
+            dev->__shadow_f = true;
+            dev->__shadow_12_hours_f = (buffer[0] >> BIT_SHIFT_HOURS_24_12_SELECT_BIT) & 0x01u;
+            for(uint8_t reg = SHADOW_REG_FIRST; reg <= SHADOW_REG_LAST; reg++){
+                shadow_refresh(dev,reg,buffer[reg - REG_HOURS]);
+            }
+            return true;
+        }
+    }
+}
+
+bool ds3231_shadow_invalidate(ds3231_dev_t* dev){
+    if(NULL == dev){
+        return false;
+    }else{
+        dev->__shadow_f = false;
+        return true;
     }
 }
 
@@ -132,6 +332,51 @@ static uint8_t bcd_to_dec(uint8_t* number,uint8_t width_of_tens){
  * time set/get functions
  */
 
+static void set_hours(bool is_12_hours,ds3231_time_data_t* time_data,uint8_t* hours_reg){
+    if(is_12_hours){
+        time_data->hours = bcd_to_dec(*hours_reg,BCD_MASK_HOURS_12);
+        time_data->is_12_hours_format = is_12_hours;
+        time_data->pm = *hours_reg >> BIT_SHIFT_AMPM &0x01u;
+    }else{
+        time_data->hours = bcd_to_dec(*hours_reg,BCD_MASK_HOURS_24);
+        time_data->is_12_hours_format = is_12_hours;
+    }
+}
+
+/**
+ * @brief decode the time registers (7 bytes from REG_SECONDS).
+ * all fields are decoded at once: the registers are packed into a uint64_t, masked per field
+ * and converted with the bcd nibble arithmetic on every byte in parallel (no carries cross bytes).
+ */
+static void decode_time(const uint8_t* buffer, ds3231_time_data_t* time_data){
+    const bool is_12_hours = (buffer[2] >> BIT_SHIFT_HOURS_24_12_SELECT_BIT) & 0x01u;
+    uint64_t regs = 0;
+    for(uint8_t i = 0; i < 7; i++){
+        regs |= (uint64_t)buffer[i] << (8u * i);
+    }
+    regs &= BCD_TIME_MASKS | ((uint64_t)(is_12_hours ? BCD_MASK_HOURS_12 : BCD_MASK_HOURS_24) << 16u);
+    regs -= 6u * ((regs >> 4u) & BCD_LOW_NIBBLES);
+    time_data->seconds = (uint8_t)regs;
+    time_data->minutes = (uint8_t)(regs >> 8u);
+    time_data->hours = (uint8_t)(regs >> 16u);
+    time_data->day_of_week = (uint8_t)(regs >> 24u);
+    time_data->day_of_month = (uint8_t)(regs >> 32u);
+    time_data->month = (uint8_t)(regs >> 40u);
+    time_data->year = (uint8_t)(regs >> 48u);
+    time_data->century = (buffer[5] >> BIT_SHIFT_CENTURY) & 0x01u;
+    time_data->is_12_hours_format = is_12_hours;
+    time_data->pm = is_12_hours && ((buffer[2] >> BIT_SHIFT_AMPM) & 0x01u);
+}
+
+bool ds3231_decode_time(const uint8_t* regs, ds3231_time_data_t* time_data){
+    if(NULL == regs || NULL == time_data){
+        return false;
+    }else{
+        decode_time(regs,time_data);
+        return true;
+    }
+}
+
 bool ds3231_get_time(ds3231_dev_t* dev,
                       ds3231_time_data_t* time_data){
     if(NULL == dev || NULL == time_data){
@@ -140,25 +385,33 @@ bool ds3231_get_time(ds3231_dev_t* dev,
         return false;
     }else{
         uint8_t buffer[7] = {0};
-        uint8_t width_of_tens_hours = 0;
         bool res = __ds3231_i2c_read_multi(dev,REG_SECONDS,buffer,7);
         if(!res){
             return false;
         }else{
-            time_data->seconds = bcd_to_dec(&buffer[0],3);
-            time_data->minutes = bcd_to_dec(&buffer[1],3);
-            width_of_tens_hours =(buffer[2] >> BIT_SHIFT_HOURS_24_12_SELECT_BIT) &0x01u ? 1 : 2;
-            time_data->hours = bcd_to_dec(&buffer[2],width_of_tens_hours);
-            time_data->day_of_week = buffer[3];
-            time_data->day_of_month = bcd_to_dec(&buffer[4],2);
-            time_data->month = bcd_to_dec(&buffer[5],1);
-            time_data->year = bcd_to_dec(&buffer[6],4);
+            decode_time(buffer,time_data);
+            dev->__shadow_12_hours_f = time_data->is_12_hours_format;
             return true;
         }
     }
                     
 }
 
+static void encode_time(bool use_24_format, ds3231_time_data_t* time_data, uint8_t* buffer){
+    buffer[0] = dec_to_bcd(time_data->seconds);
+    buffer[1] = dec_to_bcd(time_data->minutes);
+    buffer[2] = dec_to_bcd(time_data->hours);
+    //set to 12 hours format
+    if(!use_24_format){
+        buffer[2] |= (1u << BIT_SHIFT_HOURS_24_12_SELECT_BIT);
+        buffer[2] |= ((uint8_t)time_data->pm << BIT_SHIFT_AMPM); //set PM flag if needed
+    }
+    buffer[3] = time_data->day_of_week; //no need to convert to bcd. MAX is 7
+    buffer[4] = dec_to_bcd(time_data->day_of_month);
+    buffer[5] = dec_to_bcd(time_data->month) | ((uint8_t)time_data->century << BIT_SHIFT_CENTURY);
+    buffer[6] = dec_to_bcd(time_data->year);
+}
+
 bool ds3231_set_time(ds3231_dev_t* dev, bool use_24_format,
                       ds3231_time_data_t* time_data){                  
     if(NULL == dev || NULL == time_data){
@@ -167,28 +420,245 @@ bool ds3231_set_time(ds3231_dev_t* dev, bool use_24_format,
         return false;
     }else{
         uint8_t buffer[7] = {0};  
-        buffer[0] = dec_to_bcd(&time_data->seconds);
-        buffer[1] = dec_to_bcd(&time_data->minutes);
-        buffer[2] = dec_to_bcd(&time_data->hours);
-        //set to 12 hours format
-        if(!use_24_format){
-            buffer[2] |= (1u << BIT_SHIFT_HOURS_24_12_SELECT_BIT);
-            buffer[2] |= ((uint8_t)time_data->pm << 0x06u); //set PM flag if needed
-        }
-        buffer[3] = time_data->day_of_week; //no need to convert to bcd. MAX is 7
-        buffer[4] = dec_to_bcd(&time_data->day_of_month);
-        buffer[5] = dec_to_bcd(&time_data->month);
-        buffer[6] = dec_to_bcd(&time_data->year);
+        encode_time(use_24_format,time_data,buffer);
         bool res = ds3231_clear_oscillator_stop_flag(dev);
         if(!res){
             return false;
         }else{
-            res = __ds3231_i2c_write_multi(dev,buffer,REG_SECONDS,7);
+            res = write_regs(dev,REG_SECONDS,buffer,7);
+            if(res && dev->__shadow_f){
+                dev->__shadow_12_hours_f = !use_24_format;
+            }
             return res;
         }
     }
 }
 
+bool ds3231_time_to_unix(const ds3231_time_data_t* time_data, int64_t* unix_time){
+    if(NULL == time_data || NULL == unix_time){
+        return false;
+    }else if(1u > time_data->month || 12u < time_data->month || 99u < time_data->year){
+        return false;
+    }else if(1u > time_data->day_of_month || days_in_month(time_data->month,time_data->year) < time_data->day_of_month){
+        return false;
+    }else if(time_data->is_12_hours_format ? (1u > time_data->hours || 12u < time_data->hours) : 23u < time_data->hours){
+        return false;
+    }else if(59u < time_data->minutes || 59u < time_data->seconds){
+        return false;
+    }else{
+        uint32_t hours = time_data->hours;
+        if(time_data->is_12_hours_format){
+            //12 AM is midnight, 12 PM is noon
+            hours = (hours % 12u) + (time_data->pm ? 12u : 0u);
+        }
+        const int32_t year = 2000 + (time_data->century ? 100 : 0) + time_data->year;
+        const int32_t days = ds3231_days_from_civil(year,time_data->month,time_data->day_of_month);
+        *unix_time = (int64_t)days * 86400
+                   + (int64_t)(hours * 3600u + time_data->minutes * 60u + time_data->seconds);
+        return true;
+    }
+}
+
+bool ds3231_unix_to_time(int64_t unix_time, bool use_24_format, ds3231_time_data_t* time_data){
+    if(NULL == time_data){
+        return false;
+    }else if(DS3231_UNIX_TIME_MIN > unix_time || DS3231_UNIX_TIME_MAX < unix_time){
+        return false;
+    }else{
+        const int32_t days = (int32_t)(unix_time / 86400);
+        uint32_t seconds_of_day = (uint32_t)(unix_time % 86400);
+        int32_t year = 0;
+        uint32_t month = 0;
+        uint32_t day = 0;
+        ds3231_civil_from_days(days,&year,&month,&day);
+        time_data->hours = (uint8_t)(seconds_of_day / 3600u);
+        seconds_of_day %= 3600u;
+        time_data->minutes = (uint8_t)(seconds_of_day / 60u);
+        time_data->seconds = (uint8_t)(seconds_of_day % 60u);
+        time_data->day_of_month = (uint8_t)day;
+        time_data->month = (uint8_t)month;
+        time_data->year = (uint8_t)((year - 2000) % 100);
+        time_data->century = 2100 <= year;
+        time_data->day_of_week = ds3231_day_of_week_from_days(days);
+        time_data->is_12_hours_format = !use_24_format;
+        time_data->pm = !use_24_format && 12u <= time_data->hours;
+        if(!use_24_format){
+            //0 -> 12 AM, 13 -> 1 PM
+            time_data->hours = (uint8_t)((time_data->hours + 11u) % 12u + 1u);
+        }
+        return true;
+    }
+}
+
+bool ds3231_get_unix_time(ds3231_dev_t* dev, int64_t* unix_time){
+    ds3231_time_data_t time_data = {0};
+    if(NULL == unix_time || !ds3231_get_time(dev,&time_data)){
+        return false;
+    }else{
+        return ds3231_time_to_unix(&time_data,unix_time);
+    }
+}
+
+bool ds3231_set_unix_time(ds3231_dev_t* dev, int64_t unix_time, bool use_24_format){
+    ds3231_time_data_t time_data = {0};
+    if(!ds3231_unix_to_time(unix_time,use_24_format,&time_data)){
+        return false;
+    }else{
+        return ds3231_set_time(dev,use_24_format,&time_data);
+    }
+}
+
+/**
+ * read the seconds register between two monotonic timestamps
+ */
+static bool read_seconds_timed(ds3231_dev_t* dev, uint8_t* seconds_reg, uint64_t* start_ns, uint64_t* end_ns){
+    return __ds3231_get_monotonic_ns(dev,start_ns)
+        && __ds3231_i2c_read_single(dev,REG_SECONDS,seconds_reg)
+        && __ds3231_get_monotonic_ns(dev,end_ns);
+}
+
+/**
+ * @brief poll the seconds register until it differs from seconds_reg.
+ * on entry seconds_reg and window_start_ns are the value and start of the last read,
+ * on return the rollover happened within [window_start_ns, window_end_ns]:
+ * after the last unchanged read started and before the changed read ended.
+ */
+static bool wait_seconds_change(ds3231_dev_t* dev, uint32_t poll_us, uint64_t deadline_ns,
+                                uint8_t* seconds_reg, uint64_t* window_start_ns, uint64_t* window_end_ns){
+    uint8_t cur = 0;
+    uint64_t start_ns = 0;
+    uint64_t end_ns = 0;
+    while(true){
+        if(0u < poll_us && !__ds3231_delay_us(dev,poll_us)){
+            return false;
+        }else if(!read_seconds_timed(dev,&cur,&start_ns,&end_ns)){
+            return false;
+        }else if(cur != *seconds_reg){
+            *seconds_reg = cur;
+            *window_end_ns = end_ns;
+            return true;
+        }else if(end_ns > deadline_ns){
+            //oscillator stopped
+            return false;
+        }
+        *window_start_ns = start_ns;
+    }
+}
+
+static bool wait_until(ds3231_dev_t* dev, uint64_t target_ns){
+    uint64_t now_ns = 0;
+    if(!__ds3231_get_monotonic_ns(dev,&now_ns)){
+        return false;
+    }else if(target_ns <= now_ns){
+        return true;
+    }else{
+        return __ds3231_delay_us(dev,(uint32_t)((target_ns - now_ns) / 1000u));
+    }
+}
+
+bool ds3231_get_time_aligned(ds3231_dev_t* dev, ds3231_time_data_t* time_data,
+                             uint64_t* edge_ns, uint32_t* error_bound_ns){
+    if(NULL == dev || NULL == time_data){
+        return false;
+    }else if(!dev->__i2c_init_f){
+        return false;
+    }else{
+        uint8_t seconds_reg = 0;
+        uint64_t window_start_ns = 0;
+        uint64_t window_end_ns = 0;
+        if(!read_seconds_timed(dev,&seconds_reg,&window_start_ns,&window_end_ns)
+                    || !wait_seconds_change(dev,EDGE_COARSE_POLL_US,window_start_ns + EDGE_COARSE_TIMEOUT_NS,
+                                            &seconds_reg,&window_start_ns,&window_end_ns)){
+            return false;
+        }
+        for(uint8_t attempt = 0; attempt < EDGE_ATTEMPTS; attempt++){
+            //the next rollover is within the coarse window moved by a second, wake up a window early
+            const uint64_t width_ns = window_end_ns - window_start_ns;
+            uint8_t cur = 0;
+            uint64_t start_ns = 0;
+            uint64_t end_ns = 0;
+            if(!wait_until(dev,window_start_ns + NS_PER_SECOND - width_ns)
+                        || !read_seconds_timed(dev,&cur,&start_ns,&end_ns)){
+                return false;
+            }else if(cur != seconds_reg){
+                //woke up after the rollover, aim for the next one
+                seconds_reg = cur;
+                window_start_ns += NS_PER_SECOND;
+                window_end_ns += NS_PER_SECOND;
+                continue;
+            }else if(!wait_seconds_change(dev,0u,window_end_ns + NS_PER_SECOND + width_ns,
+                                          &cur,&start_ns,&end_ns)){
+                return false;
+            }else{
+                uint8_t buffer[7] = {0};
+                //the full read must still be in the second that just started
+                if(!__ds3231_i2c_read_multi(dev,REG_SECONDS,buffer,7) || cur != buffer[0]){
+                    return false;
+                }
+                decode_time(buffer,time_data);
+                dev->__shadow_12_hours_f = time_data->is_12_hours_format;
+                if(NULL != edge_ns){
+                    *edge_ns = start_ns + (end_ns - start_ns) / 2u;
+                }
+                if(NULL != error_bound_ns){
+                    *error_bound_ns = (uint32_t)((end_ns - start_ns) / 2u);
+                }
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+bool ds3231_set_time_aligned(ds3231_dev_t* dev, bool use_24_format, ds3231_time_data_t* time_data,
+                             uint64_t start_ns, uint32_t* error_bound_ns){
+    if(NULL == dev || NULL == time_data){
+        return false;
+    }else if(!dev->__i2c_init_f){
+        return false;
+    }else if(dev->__txn_f){
+        //a staged write has no point in time
+        return false;
+    }else{
+        uint8_t buffer[7] = {0};
+        uint8_t probe[7] = {0};
+        uint64_t write_start_ns = 0;
+        uint64_t write_end_ns = 0;
+        encode_time(use_24_format,time_data,buffer);
+        if(!ds3231_clear_oscillator_stop_flag(dev)){
+            return false;
+        }
+        //a read of the same 7 registers measures the transport latency without touching the clock
+        if(!__ds3231_get_monotonic_ns(dev,&write_start_ns)
+                    || !__ds3231_i2c_read_multi(dev,REG_SECONDS,probe,7)
+                    || !__ds3231_get_monotonic_ns(dev,&write_end_ns)){
+            return false;
+        }
+        //the countdown chain resets somewhere within the write, center the write on start_ns
+        const uint64_t half_write_ns = (write_end_ns - write_start_ns) / 2u;
+        if(start_ns <= write_end_ns + half_write_ns){
+            //too late
+            return false;
+        }
+        if(!wait_until(dev,start_ns - half_write_ns)
+                    || !__ds3231_get_monotonic_ns(dev,&write_start_ns)
+                    || !__ds3231_i2c_write_multi(dev,buffer,REG_SECONDS,7)
+                    || !__ds3231_get_monotonic_ns(dev,&write_end_ns)){
+            dev->__shadow_f = false;
+            return false;
+        }
+        if(dev->__shadow_f){
+            dev->__shadow_12_hours_f = !use_24_format;
+        }
+        if(NULL != error_bound_ns){
+            const uint64_t early_ns = (start_ns > write_start_ns) ? start_ns - write_start_ns : write_start_ns - start_ns;
+            const uint64_t late_ns = (start_ns > write_end_ns) ? start_ns - write_end_ns : write_end_ns - start_ns;
+            *error_bound_ns = (uint32_t)((early_ns > late_ns) ? early_ns : late_ns);
+        }
+        return true;
+    }
+}
+
 /**
  * configuration functions
  */
@@ -205,6 +675,7 @@ bool ds3231_get_oscillator_stop_flag(ds3231_dev_t* dev, bool* is_stopped){
             return res_read;
         }else{
             *is_stopped = (reg_val >> BIT_SHIFT_OSF_FLAG) & 0x01;
+            shadow_refresh(dev,REG_STATUS,reg_val);
             return true;
         }
     }
@@ -217,56 +688,74 @@ bool ds3231_clear_oscillator_stop_flag(ds3231_dev_t* dev){
     }else if(!dev->__i2c_init_f){
         return false;
     }else{
-        uint8_t current_reg = 0;
-        bool res_op = __ds3231_i2c_read_single(dev,REG_STATUS,&current_reg);
-        if(!res_op){
-            return false;
-        }else{
-            current_reg |= BIT_MASK_OSF_FLAG;
-            res_op = __ds3231_i2c_write_single(dev,REG_STATUS,current_reg);
-            return res_op;
-        }
+        return update_reg(dev,REG_STATUS,0,BIT_MASK_OSF_FLAG); //OSF is cleared by writing 0
     }
 }
 
 
 bool ds3231_deinit(ds3231_dev_t* dev){
-    return __ds3231_i2c_deinit(dev);
+    if(NULL != dev){
+        dev->__shadow_f = false;
+    }
+    if(!__ds3231_i2c_deinit(dev)){
+        return false;
+    }else{
+        if(NULL != dev->bus){
+            dev->bus->__devices -= 1u;
+            dev->bus = NULL;
+        }
+        return true;
+    }
 }
 
 
-bool ds3231_disable_oscillator(ds3231_dev_t* dev){
-    if(NULL == dev){
+bool ds3231_get_aging_offset(ds3231_dev_t* dev, int8_t* aging_offset){
+    if(NULL == dev || NULL == aging_offset){
         return false;
     }else if(!dev->__i2c_init_f){
         return false;
+    }else if(dev->__shadow_f){
+        *aging_offset = (int8_t)dev->__shadow_regs[REG_AGING_OFFSET - SHADOW_REG_FIRST];
+        return true;
     }else{
-        uint8_t current_reg = 0;
-        bool res = __ds3231_i2c_read_single(dev,REG_CONTROL,&current_reg);
-        if(!res){
-            return res;
+        uint8_t reg_val = 0;
+        bool res_read = __ds3231_i2c_read_single(dev,REG_AGING_OFFSET,&reg_val);
+        if(!res_read){
+            return res_read;
         }else{
-            current_reg |= (0x01u << 0x07u);
-            res = __ds3231_i2c_write_single(dev,REG_CONTROL,current_reg);
-            return res;
+            txn_overlay(dev,REG_AGING_OFFSET,&reg_val,1);
+            *aging_offset = (int8_t)reg_val;
+            return true;
         }
     }
 }
+
+bool ds3231_set_aging_offset(ds3231_dev_t* dev, int8_t aging_offset){
+    if(NULL == dev){
+        return false;
+    }else if(!dev->__i2c_init_f){
+        return false;
+    }else{
+        return update_reg(dev,REG_AGING_OFFSET,(uint8_t)aging_offset,0xFFu);
+    }
+}
+
+bool ds3231_disable_oscillator(ds3231_dev_t* dev){
+    if(NULL == dev){
+        return false;
+    }else if(!dev->__i2c_init_f){
+        return false;
+    }else{
+        return update_reg(dev,REG_CONTROL,BIT_MASK_EOSC,0);
+    }
+}
 bool ds3231_enable_oscillator(ds3231_dev_t* dev){
     if(NULL == dev){
         return false;
     }else if(!dev->__i2c_init_f){
         return false;
     }else{
-        uint8_t current_reg = 0;
-        bool res = __ds3231_i2c_read_single(dev,REG_CONTROL,&current_reg);
-        if(!res){
-            return res;
-        }else{
-            current_reg &= ~(0x01u << 0x07u);
-            res = __ds3231_i2c_write_single(dev,REG_CONTROL,current_reg);
-            return res;
-        }
+        return update_reg(dev,REG_CONTROL,0,BIT_MASK_EOSC);
     }
 }
 
@@ -276,15 +765,7 @@ bool ds3231_enable_32khz_output(ds3231_dev_t* dev){
     }else if(!dev->__i2c_init_f){
         return false;
     }else{
-        uint8_t current_reg = 0;
-        bool res = __ds3231_i2c_read_single(dev,REG_STATUS,&current_reg);
-        if(!res){
-            return res;
-        }else{
-            current_reg |= (0x01u << 0x03u); //set EN32KHZ to 1
-            res = __ds3231_i2c_write_single(dev,REG_STATUS,current_reg);
-            return res;
-        }
+        return update_reg(dev,REG_STATUS,BIT_MASK_EN32KHZ,0); //set EN32KHZ to 1
     }
 }
 
@@ -294,15 +775,7 @@ bool ds3231_disable_32khz_output(ds3231_dev_t* dev){
     }else if(!dev->__i2c_init_f){
         return false;
     }else{
-        uint8_t current_reg = 0;
-        bool res = __ds3231_i2c_read_single(dev,REG_STATUS,&current_reg);
-        if(!res){
-            return res;
-        }else{
-            current_reg &= ~(0x01u << 0x03u); //set EN32KHZ bit to 0
-            res = __ds3231_i2c_write_single(dev,REG_STATUS,current_reg);
-            return res;
-        }
+        return update_reg(dev,REG_STATUS,0,BIT_MASK_EN32KHZ); //set EN32KHZ bit to 0
     }
 }
 
@@ -312,19 +785,12 @@ bool ds3231_enable_square_wave_output(ds3231_dev_t* dev, ds3231_sqw_frequecy fre
     }else if(!dev->__i2c_init_f){
         return false;
     }else{
-        uint8_t current_reg = 0;
-        bool res = __ds3231_i2c_read_single(dev,REG_CONTROL,&current_reg);
-        if(!res){
-            return res;
-        }else{
-            current_reg &= ~(1u << 0x02u); //set INTCN to 0
-            current_reg |= (frequency << 3);
-            if(enable_on_battery_backup){
-                current_reg |= (0x01u << 0x06u);
-            }
-            res = __ds3231_i2c_write_single(dev,REG_CONTROL,current_reg);
-            return res;
+        uint8_t set_mask = ((uint8_t)frequency << 3) & BIT_MASK_RS;
+        if(enable_on_battery_backup){
+            set_mask |= BIT_MASK_BBSQW;
         }
+        //set INTCN to 0 and replace the previous frequency
+        return update_reg(dev,REG_CONTROL,set_mask,BIT_MASK_INTCN | BIT_MASK_RS);
     }
 }
 
@@ -334,15 +800,7 @@ bool ds3231_disable_square_wave_output(ds3231_dev_t* dev){
     }else if(!dev->__i2c_init_f){
         return false;
     }else{
-        uint8_t current_reg = 0;
-        bool res = __ds3231_i2c_read_single(dev,REG_CONTROL,&current_reg);
-        if(!res){
-            return res;
-        }else{
-            current_reg |= (1u << 0x02u); //set INTCN bit to one
-            res = __ds3231_i2c_write_single(dev,REG_CONTROL,current_reg);
-            return res;
-        }
+        return update_reg(dev,REG_CONTROL,BIT_MASK_INTCN,0); //set INTCN bit to one
     }
 }
 
@@ -357,15 +815,214 @@ bool ds3231_clear_alarm_flag(ds3231_dev_t* dev, bool alarm2){
     }else if(!dev->__i2c_init_f){
         return false;
     }else{
-        uint8_t current_reg = 0;
-        bool res = __ds3231_i2c_read_single(dev,REG_STATUS,&current_reg);
+        return update_reg(dev,REG_STATUS,0,BIT_MASK_A1F << ((uint8_t)alarm2));
+    }
+}
+
+/**
+ * @brief encode alarm1 registers (4 bytes from REG_ALARM1_SECONDS).
+ * @param [is_12][in] hours mode of the clock, the alarm hours use the same mode
+ * @returns false on invalid options or missing time_data
+ */
+static bool encode_alarm1(ds3231_time_data_t* time_data, ds3231_alarm1_options alarm1_options,
+                          bool is_12, uint8_t* buffer){
+    if(DS3231_ALARM1_ONCE_PER_SECOND != alarm1_options && NULL == time_data){
+        return false;
+    }
+    switch(alarm1_options){
+        default:
+            return false;
+        case(DS3231_ALARM1_DAY_OF_MONTH_HOURS_MINUTES_SECONDS):
+            buffer[0] = dec_to_bcd(time_data->seconds);
+            buffer[1] = dec_to_bcd(time_data->minutes);
+            buffer[2] = dec_to_bcd(time_data->hours);
+            buffer[2] |= ((uint8_t)is_12 << 0x06u);
+            buffer[2] |= (((uint8_t)time_data->pm)  << 0x05u);
+            buffer[3] = dec_to_bcd(time_data->day_of_month);
+            buffer[3] &= ~(0x01u << BIT_SHIFT_DYDT); //clear DYDT to put in day of month mode. and set alarm mode
+            return true;
+        case(DS3231_ALARM1_ONCE_PER_SECOND):
+            buffer[0] = (0x01u << BIT_SHIFT_AXMX);
+            buffer[1] = (0x01u << BIT_SHIFT_AXMX);
+            buffer[2] = (0x01u << BIT_SHIFT_AXMX);
+            buffer[3] = (0x01u << BIT_SHIFT_AXMX);
+            return true;
+        case(DS3231_ALARM1_HOURS_MINUTES_SECONDS):
+            buffer[0] = dec_to_bcd(time_data->seconds);
+            buffer[1] = dec_to_bcd(time_data->minutes);
+            buffer[2] = dec_to_bcd(time_data->hours);
+            buffer[2] |= ((uint8_t)is_12 << 0x06u);
+            buffer[2] |= (((uint8_t)time_data->pm)  << 0x05u);
+            buffer[3] = (0x01u << BIT_SHIFT_AXMX);
+            return true;
+        case(DS3231_ALARM1_MINUTES_SECONDS):
+            buffer[0] = dec_to_bcd(time_data->seconds);
+            buffer[1] = dec_to_bcd(time_data->minutes);
+            buffer[2] = (0x01u << BIT_SHIFT_AXMX);
+            buffer[3] = (0x01u << BIT_SHIFT_AXMX);
+            return true;
+        case(DS3231_ALARM1_SECONDS):
+            buffer[0] = dec_to_bcd(time_data->seconds);
+            buffer[1] = (0x01u << BIT_SHIFT_AXMX);
+            buffer[2] = (0x01u << BIT_SHIFT_AXMX);
+            buffer[3] = (0x01u << BIT_SHIFT_AXMX);
+            return true;
+        case(DS3231_ALARM1_DAY_OF_WEEK_HOURS_MINUTES_SECONDS):
+            buffer[0] = dec_to_bcd(time_data->seconds);
+            buffer[1] = dec_to_bcd(time_data->minutes);
+            buffer[2] = dec_to_bcd(time_data->hours);
+            buffer[2] |= (((uint8_t)time_data->pm)  << 0x05u);
+            buffer[2] |= ((uint8_t)is_12 << 0x06u);
+            buffer[3] = dec_to_bcd(time_data->day_of_week);
+            buffer[3] |= (0x01u << BIT_SHIFT_DYDT); //set DYDT bit to set in day of week mode. and set alarm mode
+            return true;
+    }
+}
+
+/**
+ * @brief encode alarm2 registers (3 bytes from REG_ALARM2_MINUTES).
+ * @param [is_12][in] hours mode of the clock, the alarm hours use the same mode
+ * @returns false on invalid options or missing time_data
+ */
+static bool encode_alarm2(ds3231_time_data_t* time_data, ds3231_alarm2_options alarm2_options,
+                          bool is_12, uint8_t* buffer){
+    if(DS3231_ALARM2_ONCE_PER_MINUTE != alarm2_options && NULL == time_data){
+        return false;
+    }
+    switch(alarm2_options){
+        default:
+            return false;
+        case(DS3231_ALARM2_DAY_OF_MONTH_HOURS_MINUTES):
+            buffer[0] = dec_to_bcd(time_data->minutes);
+            buffer[1] = dec_to_bcd(time_data->hours);
+            buffer[1] |= ((uint8_t)is_12 << 0x06u);
+            buffer[1] |= (((uint8_t)time_data->pm)  << 0x05u);
+            buffer[2] = dec_to_bcd(time_data->day_of_month);
+            buffer[2] &= ~(0x01u << BIT_SHIFT_DYDT); //ensure DYDT is low to select day_of_month mode
+            return true;
+        case(DS3231_ALARM2_HOURS_MINUTES):
+            buffer[0] = dec_to_bcd(time_data->minutes);
+            buffer[1] = dec_to_bcd(time_data->hours);
+            buffer[1] |= ((uint8_t)is_12 << 0x06u);
+            buffer[1] |= (((uint8_t)time_data->pm)  << 0x05u);
+            buffer[2] = (0x01u << BIT_SHIFT_AXMX);
+            return true;
+        case(DS3231_ALARM2_MINUTES):
+            buffer[0] = dec_to_bcd(time_data->minutes);
+            buffer[1] = (0x01u << BIT_SHIFT_AXMX);
+            buffer[2] = (0x01u << BIT_SHIFT_AXMX);
+            return true;
+        case(DS3231_ALARM2_ONCE_PER_MINUTE):
+            buffer[0] = (0x01u << BIT_SHIFT_AXMX);
+            buffer[1] = (0x01u << BIT_SHIFT_AXMX);
+            buffer[2] = (0x01u << BIT_SHIFT_AXMX);
+            return true;
+        case(DS3231_ALARM2_DAY_OF_WEEK_HOURS_MINUTES):
+            buffer[0] = dec_to_bcd(time_data->minutes);
+            buffer[1] = dec_to_bcd(time_data->hours);
+            buffer[1] |= (((uint8_t)time_data->pm)  << 0x05u);
+            buffer[1] |= ((uint8_t)is_12 << 0x06u);
+            buffer[2] = dec_to_bcd(time_data->day_of_week);
+            buffer[2] |= (0x01u << BIT_SHIFT_DYDT); //set DYDT to enable day of week mode 
+            return true;
+    }
+}
+
+/**
+ * @brief program one or both alarms together with REG_CONTROL and REG_STATUS in a single
+ * burst write over the contiguous 0x07-0x0F window. the window is taken from the shadow when
+ * valid, otherwise REG_HOURS-REG_STATUS are read once in a single burst.
+ * interrupts of the programmed alarms and INTCN are enabled and their flags cleared.
+ * @param [control_clear_mask][in] extra REG_CONTROL bits to clear (e.g. the other alarm's AxIE)
+ * @returns true on success false on fail
+ */
+static bool write_alarm_window(ds3231_dev_t* dev,
+                               ds3231_time_data_t* alarm1_time, ds3231_alarm1_options* alarm1_options,
+                               ds3231_time_data_t* alarm2_time, ds3231_alarm2_options* alarm2_options,
+                               uint8_t control_clear_mask){
+    //REG_HOURS..REG_STATUS, the alarm window starts at window[REG_ALARM1_SECONDS - REG_HOURS]
+    uint8_t buffer[14] = {0};
+    uint8_t* window = &buffer[REG_ALARM1_SECONDS - REG_HOURS];
+    uint8_t* control = &buffer[REG_CONTROL - REG_HOURS];
+    uint8_t* status = &buffer[REG_STATUS - REG_HOURS];
+    uint8_t control_set_mask = BIT_MASK_INTCN;
+    uint8_t status_clear_mask = 0;
+    uint8_t reg_start = REG_ALARM1_SECONDS;
+    bool is_12 = false;
+    bool res = false;
+    if(dev->__shadow_f){
+        is_12 = dev->__shadow_12_hours_f;
+        for(uint8_t reg = REG_ALARM1_SECONDS; reg <= REG_STATUS; reg++){
+            buffer[reg - REG_HOURS] = dev->__shadow_regs[reg - SHADOW_REG_FIRST];
+        }
+    }else{
+        res = __ds3231_i2c_read_multi(dev,REG_HOURS,buffer,14);
         if(!res){
+            return res;
+        }
+        txn_overlay(dev,REG_HOURS,buffer,14);
+        is_12 = (buffer[0] >> BIT_SHIFT_HOURS_24_12_SELECT_BIT) & 0x01u;
+        *control = shadow_storable(REG_CONTROL,*control);
+        *status = shadow_storable(REG_STATUS,*status);
+    }
+    if(NULL != alarm1_options){
+        if(!encode_alarm1(alarm1_time,*alarm1_options,is_12,&window[0])){
             return false;
-        }else{
-            current_reg &= ~(0x01 << ((uint8_t)alarm2));
-            res = __ds3231_i2c_write_single(dev,REG_STATUS,current_reg);
+        }
+        control_set_mask |= BIT_MASK_A1IE;
+        status_clear_mask |= BIT_MASK_A1F;
+    }else{
+        //alarm1 untouched, start the burst at alarm2
+        reg_start = REG_ALARM2_MINUTES;
+    }
+    if(NULL != alarm2_options){
+        if(!encode_alarm2(alarm2_time,*alarm2_options,is_12,&window[REG_ALARM2_MINUTES - REG_ALARM1_SECONDS])){
+            return false;
+        }
+        control_set_mask |= BIT_MASK_A2IE;
+        status_clear_mask |= BIT_MASK_A2F;
+    }
+    *control = (*control & ~(control_clear_mask)) | control_set_mask;
+    //flags that are not cleared are written as 1 so they survive
+    *status |= (BIT_MASK_STATUS_FLAGS & ~(status_clear_mask));
+    res = write_regs(dev,reg_start,&buffer[reg_start - REG_HOURS],REG_STATUS - reg_start + 1);
+    if(!res){
+        dev->__shadow_f = false;
+        return res;
+    }else{
+        for(uint8_t reg = reg_start; reg <= REG_STATUS; reg++){
+            shadow_store(dev,reg,buffer[reg - REG_HOURS]);
+        }
+        return true;
+    }
+}
+
+bool ds3231_poll_events(ds3231_dev_t* dev, uint8_t clear_mask, uint8_t* flags){
+    if(NULL == dev){
+        return false;
+    }else if(!dev->__i2c_init_f){
+        return false;
+    }else{
+        uint8_t status = 0;
+        bool res = __ds3231_i2c_read_single(dev,REG_STATUS,&status);
+        if(!res){
             return res;
         }
+        shadow_refresh(dev,REG_STATUS,status);
+        if(NULL != flags){
+            *flags = status & (BIT_MASK_STATUS_FLAGS | BIT_MASK_BSY);
+        }
+        //a requested flag that was not set is not written as 0, it may have been set since the read
+        const uint8_t clear = clear_mask & status & BIT_MASK_STATUS_FLAGS;
+        if(0 == clear){
+            return true;
+        }else{
+            //keep EN32KHZ, including a change staged by an open transaction
+            uint8_t control_bits = status;
+            txn_overlay(dev,REG_STATUS,&control_bits,1);
+            uint8_t data = shadow_storable(REG_STATUS,control_bits) | (BIT_MASK_STATUS_FLAGS & ~(clear));
+            return write_regs(dev,REG_STATUS,&data,1);
+        }
     }
 }
 
@@ -376,153 +1033,24 @@ bool ds3231_set_alarm(ds3231_dev_t* dev, ds3231_time_data_t* time_data,
         return false;
     }else if(!dev->__i2c_init_f){
         return false;
+    }else if(NULL != alarm1_options){
+        //set A1IE and INTCN, reset A2IE
+        return write_alarm_window(dev,time_data,alarm1_options,NULL,NULL,BIT_MASK_A2IE);
+    }else{
+        //set A2IE and INTCN, reset A1IE
+        return write_alarm_window(dev,NULL,NULL,time_data,alarm2_options,BIT_MASK_A1IE);
+    }
+}
+
+bool ds3231_set_alarms(ds3231_dev_t* dev,
+                       ds3231_time_data_t* alarm1_time, ds3231_alarm1_options* alarm1_options,
+                       ds3231_time_data_t* alarm2_time, ds3231_alarm2_options* alarm2_options){
+    if(NULL == dev || (NULL == alarm1_options && NULL == alarm2_options)){
+        return false;
+    }else if(!dev->__i2c_init_f){
+        return false;
     }else{
-       uint8_t buffer[4] = {0};
-       uint8_t ctrl_reg_buffer = 0;
-       bool res = false;
-       bool is_12 = false;
-       res = __ds3231_i2c_read_single(dev,REG_HOURS,&ctrl_reg_buffer);
-       if(!res){
-        return res;
-       }else{
-        is_12 = (ctrl_reg_buffer >> 0x06u) & 0x01u ? true : false;
-        ctrl_reg_buffer = 0;
-       }       
-       if(NULL != alarm1_options){
-            if(DS3231_ALARM1_ONCE_PER_SECOND != *alarm1_options && NULL == time_data){
-                return false;
-            }
-            switch(*alarm1_options){
-                default:
-                    return false;
-                case(DS3231_ALARM1_DAY_OF_MONTH_HOURS_MINUTES_SECONDS):
-                    buffer[0] = dec_to_bcd(&time_data->seconds);
-                    buffer[1] = dec_to_bcd(&time_data->minutes);
-                    buffer[2] = dec_to_bcd(&time_data->hours);
-                    buffer[2] |= ((uint8_t)is_12 << 0x06u);
-                    buffer[2] |= (((uint8_t)time_data->pm)  << 0x05u);
-                    buffer[3] = dec_to_bcd(&time_data->day_of_month);
-                    buffer[3] &= ~(0x01u << BIT_SHIFT_DYDT); //clear DYDT to put in day of month mode. and set alarm mode
-                    break;
-                case(DS3231_ALARM1_ONCE_PER_SECOND):
-                    buffer[0] = (0x01u << BIT_SHIFT_AXMX);
-                    buffer[1] = (0x01u << BIT_SHIFT_AXMX);
-                    buffer[2] = (0x01u << BIT_SHIFT_AXMX);
-                    buffer[3] = (0x01u << BIT_SHIFT_AXMX);
-                    break;
-                case(DS3231_ALARM1_HOURS_MINUTES_SECONDS):
-                    buffer[0] = dec_to_bcd(&time_data->seconds);
-                    buffer[1] = dec_to_bcd(&time_data->minutes);
-                    buffer[2] = dec_to_bcd(&time_data->hours);
-                    buffer[2] |= ((uint8_t)is_12 << 0x06u);
-                    buffer[2] |= (((uint8_t)time_data->pm)  << 0x05u);
-                    buffer[3] = (0x01u << BIT_SHIFT_AXMX);
-                    break;
-                case(DS3231_ALARM1_MINUTES_SECONDS):
-                    buffer[0] = dec_to_bcd(&time_data->seconds);
-                    buffer[1] = dec_to_bcd(&time_data->minutes);
-                    buffer[2] = (0x01u << BIT_SHIFT_AXMX);
-                    buffer[3] = (0x01u << BIT_SHIFT_AXMX);
-                    break;
-                case(DS3231_ALARM1_SECONDS):
-                    buffer[0] = dec_to_bcd(&time_data->seconds);
-                    buffer[1] = (0x01u << BIT_SHIFT_AXMX);
-                    buffer[2] = (0x01u << BIT_SHIFT_AXMX);
-                    buffer[3] = (0x01u << BIT_SHIFT_AXMX);
-                    break;
-                case(DS3231_ALARM1_DAY_OF_WEEK_HOURS_MINUTES_SECONDS):
-                    buffer[0] = dec_to_bcd(&time_data->seconds);
-                    buffer[1] = dec_to_bcd(&time_data->minutes);
-                    buffer[2] = dec_to_bcd(&time_data->hours);
-                    buffer[2] |= (((uint8_t)time_data->pm)  << 0x05u);
-                    buffer[2] |= ((uint8_t)is_12 << 0x06u);
-                    buffer[3] = dec_to_bcd(&time_data->day_of_week);
-                    buffer[3] |= (0x01u << BIT_SHIFT_DYDT); //set DYDT bit to set in day of week mode. and set alarm mode
-                    break;
-            }
-            res = __ds3231_i2c_read_single(dev,REG_CONTROL,&ctrl_reg_buffer);
-            if(!res){
-                return res;
-            }else{
-                ctrl_reg_buffer |= 0x01u; //set A1IE
-                ctrl_reg_buffer &= ~(0x01u << 1); //reset A2IE
-                ctrl_reg_buffer |= (0x01u << 0x02u); //set intc
-                res = __ds3231_i2c_write_multi(dev,buffer,REG_ALARM1_SECONDS,4);
-                if(!res){
-                    return res;
-                }else{
-                    res = __ds3231_i2c_write_single(dev,REG_CONTROL,ctrl_reg_buffer);
-                    if(!res){
-                        return res;
-                    }else{
-                        return ds3231_clear_alarm_flag(dev,false);
-                    }
-                }
-            }
-       }else if(NULL != alarm2_options){
-            if(DS3231_ALARM2_ONCE_PER_MINUTE != *alarm2_options && NULL == time_data){
-                return false;
-            }
-            switch(*alarm2_options){
-                default:
-                    return false;
-                case(DS3231_ALARM2_DAY_OF_MONTH_HOURS_MINUTES):
-                    buffer[0] = dec_to_bcd(&time_data->minutes);
-                    buffer[1] = dec_to_bcd(&time_data->hours);
-                    buffer[1] |= ((uint8_t)is_12 << 0x06u);
-                    buffer[1] |= (((uint8_t)time_data->pm)  << 0x05u);
-                    buffer[2] = dec_to_bcd(&time_data->day_of_month);
-                    buffer[2] &= ~(0x01u << BIT_SHIFT_DYDT); //ensure DYDT is low to select day_of_month mode
-                    break;
-                case(DS3231_ALARM2_HOURS_MINUTES):
-                    buffer[0] = dec_to_bcd(&time_data->minutes);
-                    buffer[1] = dec_to_bcd(&time_data->hours);
-                    buffer[1] |= ((uint8_t)is_12 << 0x06u);
-                    buffer[1] |= (((uint8_t)time_data->pm)  << 0x05u);
-                    buffer[2] = (0x01u << BIT_SHIFT_AXMX);
-                    break;
-                case(DS3231_ALARM2_MINUTES):
-                    buffer[0] = dec_to_bcd(&time_data->minutes);
-                    buffer[1] = (0x01u << BIT_SHIFT_AXMX);
-                    buffer[2] = (0x01u << BIT_SHIFT_AXMX);
-                    break;
-                case(DS3231_ALARM2_ONCE_PER_MINUTE):
-                    buffer[0] = (0x01u << BIT_SHIFT_AXMX);
-                    buffer[1] = (0x01u << BIT_SHIFT_AXMX);
-                    buffer[2] = (0x01u << BIT_SHIFT_AXMX);
-                    break;
-                case(DS3231_ALARM2_DAY_OF_WEEK_HOURS_MINUTES):
-                    buffer[0] = dec_to_bcd(&time_data->minutes);
-                    buffer[1] = dec_to_bcd(&time_data->hours);
-                    buffer[1] |= (((uint8_t)time_data->pm)  << 0x05u);
-                    buffer[1] |= ((uint8_t)is_12 << 0x06u);
-                    buffer[2] = dec_to_bcd(&time_data->day_of_week);
-                    buffer[2] |= (0x01u << BIT_SHIFT_DYDT); //set DYDT to enable day of week mode 
-                    break;
-            }
-            res = __ds3231_i2c_read_single(dev,REG_CONTROL,&ctrl_reg_buffer);
-            if(!res){
-                return res;
-            }else{
-                ctrl_reg_buffer |= (0x01u << 0x01u); //set A2IE
-                ctrl_reg_buffer &= ~(0x01u); // reset A1IE
-                ctrl_reg_buffer |= (0x01u << 0x02u); //set intcn
-                res = __ds3231_i2c_write_multi(dev,buffer,REG_ALARM2_MINUTES,3);
-                if(!res){
-                    return res;
-                }else{
-                    res =  __ds3231_i2c_write_single(dev,REG_CONTROL,ctrl_reg_buffer);
-                    if(!res){
-                        return res;
-                    }else{
-                        return ds3231_clear_alarm_flag(dev,true);
-                    }
-                }
-            }
-            
-       }else{
-            return false;
-        }
+        return write_alarm_window(dev,alarm1_time,alarm1_options,alarm2_time,alarm2_options,0);
     }
 }
 
@@ -532,15 +1060,7 @@ bool ds3231_disable_alarm(ds3231_dev_t*dev, bool alarm2){
     }else if(!dev->__i2c_init_f){
         return false;
     }else{
-        uint8_t ctrl_reg_current = 0;
-        bool res = false;
-        res = __ds3231_i2c_read_single(dev,REG_CONTROL,&ctrl_reg_current);
-        if(!res){
-            return res;
-        }else{
-            ctrl_reg_current &= ~(0x01 << ((uint8_t)alarm2));
-            return __ds3231_i2c_write_single(dev,REG_CONTROL,ctrl_reg_current);
-        }
+        return update_reg(dev,REG_CONTROL,0,BIT_MASK_A1IE << ((uint8_t)alarm2));
     }
 }
 
@@ -550,26 +1070,119 @@ bool ds3231_enable_alarm(ds3231_dev_t* dev, bool alarm2){
     }else if(!dev->__i2c_init_f){
         return false;
     }else{
-        uint8_t ctrl_reg_current = 0;
-        bool res = false;
-        res = __ds3231_i2c_read_single(dev,REG_CONTROL,&ctrl_reg_current);
-        if(!res){
-            return res;
-        }else{
-            ctrl_reg_current |= (0x01 << ((uint8_t)alarm2));
-            return __ds3231_i2c_write_single(dev,REG_CONTROL,ctrl_reg_current);
-        }
+        return update_reg(dev,REG_CONTROL,BIT_MASK_A1IE << ((uint8_t)alarm2),0);
     }
 }
 
-static void set_hours(bool is_12_hours,ds3231_time_data_t* time_data,uint8_t* hours_reg){
-    if(is_12_hours){
-        time_data->hours = bcd_to_dec(hours_reg,1);
-        time_data->is_12_hours_format = is_12_hours;
-        time_data->pm = *hours_reg >> BIT_SHIFT_AMPM &0x01u;
-    }else{
-        time_data->hours = bcd_to_dec(hours_reg,2);
-        time_data->is_12_hours_format = is_12_hours;
+/**
+ * @brief decode the alarm1 registers (4 bytes from REG_ALARM1_SECONDS).
+ * @returns false if the mask bits don't form a valid ds3231_alarm1_options
+ */
+static bool decode_alarm1(uint8_t* alarm_regs, ds3231_time_data_t* time_data,
+                          ds3231_alarm1_options* alarm1_options){
+    uint8_t alarm_bit_flag = 0;
+    uint8_t temp_alarm = 0;
+    bool is_12_hours = false;
+    alarm_bit_flag = alarm_regs[0] >> BIT_SHIFT_AXMX &0x01;
+    temp_alarm = alarm_regs[1] >> BIT_SHIFT_AXMX &0x01;
+    temp_alarm <<= 0x01u;
+    alarm_bit_flag |= temp_alarm;
+    temp_alarm = alarm_regs[2] >> BIT_SHIFT_AXMX &0x01u;
+    temp_alarm <<= 0x02u;
+    alarm_bit_flag |= temp_alarm;
+    temp_alarm = alarm_regs[3] >> BIT_SHIFT_AXMX &0x01u;
+    temp_alarm <<= 0x03u;
+    alarm_bit_flag |= temp_alarm;
+    temp_alarm = alarm_regs[3] >> BIT_SHIFT_DYDT &0x01u;
+    temp_alarm <<= 0x04u;
+    alarm_bit_flag |= temp_alarm;
+    is_12_hours = alarm_regs[2] >> BIT_SHIFT_HOURS_24_12_SELECT_BIT &0x01u;
+
+    switch(alarm_bit_flag){
+        default:
+            return false;
+        case(DS3231_ALARM1_DAY_OF_MONTH_HOURS_MINUTES_SECONDS):
+            time_data->seconds = bcd_to_dec(alarm_regs[0],BCD_MASK_SECONDS);
+            time_data->minutes = bcd_to_dec(alarm_regs[1],BCD_MASK_MINUTES);
+            set_hours(is_12_hours,time_data,&alarm_regs[2]);
+            time_data->day_of_month = bcd_to_dec(alarm_regs[3],BCD_MASK_DAY_OF_MONTH);
+            *alarm1_options = alarm_bit_flag;
+            return true;
+        case(DS3231_ALARM1_ONCE_PER_SECOND):
+            *alarm1_options = alarm_bit_flag;
+            return true;
+        case(DS3231_ALARM1_HOURS_MINUTES_SECONDS):
+            time_data->seconds = bcd_to_dec(alarm_regs[0],BCD_MASK_SECONDS);
+            time_data->minutes = bcd_to_dec(alarm_regs[1],BCD_MASK_MINUTES);
+            set_hours(is_12_hours,time_data,&alarm_regs[2]);
+            *alarm1_options = alarm_bit_flag;
+            return true;
+        case(DS3231_ALARM1_MINUTES_SECONDS):
+            time_data->seconds = bcd_to_dec(alarm_regs[0],BCD_MASK_SECONDS);
+            time_data->minutes = bcd_to_dec(alarm_regs[1],BCD_MASK_MINUTES);
+            *alarm1_options = alarm_bit_flag;
+            return true;
+        case(DS3231_ALARM1_SECONDS):
+            time_data->seconds = bcd_to_dec(alarm_regs[0],BCD_MASK_SECONDS);
+            *alarm1_options = alarm_bit_flag;
+            return true;
+        case(DS3231_ALARM1_DAY_OF_WEEK_HOURS_MINUTES_SECONDS):
+            time_data->seconds = bcd_to_dec(alarm_regs[0],BCD_MASK_SECONDS);
+            time_data->minutes = bcd_to_dec(alarm_regs[1],BCD_MASK_MINUTES);
+            set_hours(is_12_hours,time_data,&alarm_regs[2]);
+            time_data->day_of_week = bcd_to_dec(alarm_regs[3],BCD_MASK_DAY_OF_WEEK);
+            *alarm1_options = alarm_bit_flag;
+            return true;
+    }
+}
+
+/**
+ * @brief decode the alarm2 registers (3 bytes from REG_ALARM2_MINUTES).
+ * @returns false if the mask bits don't form a valid ds3231_alarm2_options
+ */
+static bool decode_alarm2(uint8_t* alarm_regs, ds3231_time_data_t* time_data,
+                          ds3231_alarm2_options* alarm2_options){
+    uint8_t alarm_bit_flag = 0;
+    uint8_t temp_alarm = 0;
+    bool is_12_hours = false;
+    alarm_bit_flag = alarm_regs[0] >> BIT_SHIFT_AXMX &0x01u;
+    temp_alarm = alarm_regs[1] >> BIT_SHIFT_AXMX &0x01u;
+    temp_alarm <<= 0x01u;
+    alarm_bit_flag |= temp_alarm;
+    temp_alarm = alarm_regs[2] >> BIT_SHIFT_AXMX &0x01u;
+    temp_alarm <<= 0x02u;
+    alarm_bit_flag |= temp_alarm;
+    temp_alarm = alarm_regs[2] >> BIT_SHIFT_DYDT &0x01u;
+    temp_alarm <<= 0x03u;
+    alarm_bit_flag |= temp_alarm;
+    is_12_hours = alarm_regs[1] >> BIT_SHIFT_HOURS_24_12_SELECT_BIT &0x01u;
+    switch(alarm_bit_flag){
+        default:
+            return false;
+        case(DS3231_ALARM2_DAY_OF_MONTH_HOURS_MINUTES):
+            time_data->minutes = bcd_to_dec(alarm_regs[0],BCD_MASK_MINUTES);
+            set_hours(is_12_hours,time_data,&alarm_regs[1]);
+            time_data->day_of_month = bcd_to_dec(alarm_regs[2],BCD_MASK_DAY_OF_MONTH);
+            *alarm2_options = alarm_bit_flag;
+            return true;
+        case(DS3231_ALARM2_HOURS_MINUTES):
+            time_data->minutes = bcd_to_dec(alarm_regs[0],BCD_MASK_MINUTES);
+            set_hours(is_12_hours,time_data,&alarm_regs[1]);
+            *alarm2_options = alarm_bit_flag;
+            return true;
+        case(DS3231_ALARM2_MINUTES):
+            time_data->minutes = bcd_to_dec(alarm_regs[0],BCD_MASK_MINUTES);
+            *alarm2_options = alarm_bit_flag;
+            return true;
+        case(DS3231_ALARM2_ONCE_PER_MINUTE):
+            *alarm2_options = alarm_bit_flag;
+            return true;
+        case(DS3231_ALARM2_DAY_OF_WEEK_HOURS_MINUTES):
+            time_data->minutes = bcd_to_dec(alarm_regs[0],BCD_MASK_MINUTES);
+            set_hours(is_12_hours,time_data,&alarm_regs[1]);
+            time_data->day_of_week = bcd_to_dec(alarm_regs[2],BCD_MASK_DAY_OF_WEEK);
+            *alarm2_options = alarm_bit_flag;
+            return true;
     }
 }
 
@@ -577,9 +1190,6 @@ bool ds3231_get_alarm(ds3231_dev_t* dev, ds3231_time_data_t* time_data,
                       ds3231_alarm1_options* alarm1_options,
                       ds3231_alarm2_options* alarm2_options){
     uint8_t alarm_regs[4] = {0};
-    uint8_t alarm_bit_flag = 0;
-    uint8_t temp_alarm = 0;
-    bool is_12_hours = false;
     bool res = false;
     if(NULL == dev || NULL == time_data){
         return false;
@@ -590,104 +1200,14 @@ bool ds3231_get_alarm(ds3231_dev_t* dev, ds3231_time_data_t* time_data,
         if(!res){
             return false;
         }else{
-            alarm_bit_flag = alarm_regs[0] >> BIT_SHIFT_AXMX &0x01;
-            temp_alarm = alarm_regs[1] >> BIT_SHIFT_AXMX &0x01;
-            temp_alarm <<= 0x01u;
-            alarm_bit_flag |= temp_alarm;
-            temp_alarm = alarm_regs[2] >> BIT_SHIFT_AXMX &0x01u;
-            temp_alarm <<= 0x02u;
-            alarm_bit_flag |= temp_alarm;
-            temp_alarm = alarm_regs[3] >> BIT_SHIFT_AXMX &0x01u;
-            temp_alarm <<= 0x03u;
-            alarm_bit_flag |= temp_alarm;
-            temp_alarm = alarm_regs[3] >> BIT_SHIFT_DYDT &0x01u;
-            temp_alarm <<= 0x04u;
-            alarm_bit_flag |= temp_alarm;
-            is_12_hours = alarm_regs[2] >> BIT_SHIFT_HOURS_24_12_SELECT_BIT &0x01u;
-
-            switch(alarm_bit_flag){
-                default:
-                    return false;
-                case(DS3231_ALARM1_DAY_OF_MONTH_HOURS_MINUTES_SECONDS):
-                    *alarm1_options = alarm_bit_flag;
-                    time_data->seconds = bcd_to_dec(&alarm_regs[0],3);
-                    time_data->minutes = bcd_to_dec(&alarm_regs[1],3);
-                    set_hours(is_12_hours,time_data,&alarm_regs[2]);
-                    time_data->day_of_month = bcd_to_dec(&alarm_regs[3],2);
-                    *alarm1_options = alarm_bit_flag;
-                    return true;
-                case(DS3231_ALARM1_ONCE_PER_SECOND):
-                    *alarm1_options = alarm_bit_flag;
-                    return true;
-                case(DS3231_ALARM1_HOURS_MINUTES_SECONDS):
-                    time_data->seconds = bcd_to_dec(&alarm_regs[0],3);
-                    time_data->minutes = bcd_to_dec(&alarm_regs[1],3);
-                    set_hours(is_12_hours,time_data,&alarm_regs[2]);
-                    *alarm1_options = alarm_bit_flag;
-                    return true;
-                case(DS3231_ALARM1_MINUTES_SECONDS):
-                    time_data->seconds = bcd_to_dec(&alarm_regs[0],3);
-                    time_data->minutes = bcd_to_dec(&alarm_regs[1],3);
-                    *alarm1_options = alarm_bit_flag;
-                    return true;
-                case(DS3231_ALARM1_SECONDS):
-                    time_data->seconds = bcd_to_dec(&alarm_regs[0],3);
-                    *alarm1_options = alarm_bit_flag;
-                    return true;
-                case(DS3231_ALARM1_DAY_OF_WEEK_HOURS_MINUTES_SECONDS):
-                    time_data->seconds = bcd_to_dec(&alarm_regs[0],3);
-                    time_data->minutes = bcd_to_dec(&alarm_regs[1],3);
-                    set_hours(is_12_hours,time_data,&alarm_regs[2]);
-                    alarm_regs[3] &= ~(0xf0);
-                    time_data->day_of_week = alarm_regs[3];
-                    *alarm1_options = alarm_bit_flag;
-                    return true;
-            }
+            return decode_alarm1(alarm_regs,time_data,alarm1_options);
         }
     }else if (NULL != alarm2_options){
         res = __ds3231_i2c_read_multi(dev,REG_ALARM2_MINUTES,alarm_regs,3);
         if(!res){
             return false;
         }else{
-            alarm_bit_flag = alarm_regs[0] >> BIT_SHIFT_AXMX &0x01u;
-            temp_alarm = alarm_regs[1] >> BIT_SHIFT_AXMX &0x01u;
-            temp_alarm <<= 0x01u;
-            alarm_bit_flag |= temp_alarm;
-            temp_alarm = alarm_regs[2] >> BIT_SHIFT_AXMX &0x01u;
-            temp_alarm <<= 0x02u;
-            alarm_bit_flag |= temp_alarm;
-            temp_alarm = alarm_regs[2] >> BIT_SHIFT_DYDT &0x01u;
-            temp_alarm <<= 0x03u;
-            alarm_bit_flag |= temp_alarm;
-            is_12_hours = alarm_regs[1] >> BIT_SHIFT_HOURS_24_12_SELECT_BIT &0x01u;
-            switch(alarm_bit_flag){
-                default:
-                    return false;
-                case(DS3231_ALARM2_DAY_OF_MONTH_HOURS_MINUTES):
-                    time_data->minutes = bcd_to_dec(&alarm_regs[0],3);
-                    set_hours(is_12_hours,time_data,&alarm_regs[1]);
-                    time_data->day_of_month = bcd_to_dec(&alarm_regs[2],2);
-                    *alarm2_options = alarm_bit_flag;
-                    return true;
-                case(DS3231_ALARM2_HOURS_MINUTES):
-                    time_data->minutes = bcd_to_dec(&alarm_regs[0],3);
-                    set_hours(is_12_hours,time_data,&alarm_regs[1]);
-                    *alarm2_options = alarm_bit_flag;
-                    return true;
-                case(DS3231_ALARM2_MINUTES):
-                    time_data->minutes = bcd_to_dec(&alarm_regs[0],3);
-                    *alarm2_options = alarm_bit_flag;
-                    return true;
-                case(DS3231_ALARM2_ONCE_PER_MINUTE):
-                    *alarm2_options = alarm_bit_flag;
-                    return true;
-                case(DS3231_ALARM2_DAY_OF_WEEK_HOURS_MINUTES):
-                    time_data->minutes = bcd_to_dec(&alarm_regs[0],3);
-                    set_hours(is_12_hours,time_data,&alarm_regs[1]);
-                    time_data->day_of_week = bcd_to_dec(&alarm_regs[2],2);
-                    *alarm2_options = alarm_bit_flag;
-                    return true;
-            }
+            return decode_alarm2(alarm_regs,time_data,alarm2_options);
         }
     }else{
         return false;
@@ -711,6 +1231,16 @@ bool ds3231_is_12_hours_mode(ds3231_dev_t* dev,bool* is_12){
     }
 }
 
+bool ds3231_decode_temperature(const uint8_t* regs, int8_t* number, uint8_t* fraction){
+    if(NULL == regs || NULL == number || NULL == fraction){
+        return false;
+    }else{
+        *number = (int8_t)regs[0];
+        *fraction = regs[1] >> 0x06u;
+        return true;
+    }
+}
+
 bool ds3231_get_temperature(ds3231_dev_t*dev, int8_t* number,uint8_t* fraction){
     if(NULL == dev || NULL == number || NULL == fraction){
         return false;
@@ -722,9 +1252,172 @@ bool ds3231_get_temperature(ds3231_dev_t*dev, int8_t* number,uint8_t* fraction){
         if(!res){
             return res;
         }else{
-            *number = (int8_t)reg_buffer[0];
-            *fraction = reg_buffer[1] >> 0x06u;
+            return ds3231_decode_temperature(reg_buffer,number,fraction);
+        }
+    }
+}
+
+bool ds3231_start_temperature_conversion(ds3231_dev_t* dev){
+    if(NULL == dev){
+        return false;
+    }else if(!dev->__i2c_init_f){
+        return false;
+    }else{
+        return update_reg(dev,REG_CONTROL,BIT_MASK_CONV,0);
+    }
+}
+
+bool ds3231_read_snapshot(ds3231_dev_t* dev, ds3231_snapshot_t* snapshot){
+    if(NULL == dev || NULL == snapshot){
+        return false;
+    }else if(!dev->__i2c_init_f){
+        return false;
+    }else{
+        uint8_t regs[19] = {0};
+        bool res = __ds3231_i2c_read_multi(dev,REG_SECONDS,regs,19);
+        if(!res){
+            return res;
+        }else{
+            //an alarm that doesn't decode is left zeroed
+            const ds3231_snapshot_t empty = {0};
+            *snapshot = empty;
+            decode_time(&regs[REG_SECONDS],&snapshot->time);
+            snapshot->alarm1_valid = decode_alarm1(&regs[REG_ALARM1_SECONDS],&snapshot->alarm1,
+                                                   &snapshot->alarm1_options);
+            snapshot->alarm2_valid = decode_alarm2(&regs[REG_ALARM2_MINUTES],&snapshot->alarm2,
+                                                   &snapshot->alarm2_options);
+            snapshot->control = regs[REG_CONTROL];
+            snapshot->status = regs[REG_STATUS];
+            snapshot->alarm1_enabled = regs[REG_CONTROL] & BIT_MASK_A1IE;
+            snapshot->alarm2_enabled = regs[REG_CONTROL] & BIT_MASK_A2IE;
+            snapshot->alarm1_flag = regs[REG_STATUS] & BIT_MASK_A1F;
+            snapshot->alarm2_flag = regs[REG_STATUS] & BIT_MASK_A2F;
+            snapshot->oscillator_stopped = regs[REG_STATUS] & BIT_MASK_OSF_FLAG;
+            snapshot->busy = regs[REG_STATUS] & BIT_MASK_BSY;
+            snapshot->aging_offset = (int8_t)regs[SHADOW_REG_LAST];
+            snapshot->temperature = (int8_t)regs[REG_TEMP_MSB];
+            snapshot->temperature_fraction = regs[REG_TEMP_MSB + 1] >> 0x06u;
+            dev->__shadow_12_hours_f = snapshot->time.is_12_hours_format;
+            for(uint8_t reg = SHADOW_REG_FIRST; reg <= SHADOW_REG_LAST; reg++){
+                shadow_refresh(dev,reg,regs[reg]);
+            }
             return true;
         }
     }
-}
\ No newline at end of file
+}
+
+bool ds3231_txn_begin(ds3231_dev_t* dev){
+    if(NULL == dev){
+        return false;
+    }else if(!dev->__i2c_init_f || dev->__txn_f){
+        return false;
+    }else{
+        dev->__txn_dirty = 0;
+        dev->__txn_status_clear = 0;
+        dev->__txn_control_set = 0;
+        dev->__txn_writes = 0;
+        dev->__txn_f = true;
+        return true;
+    }
+}
+
+bool ds3231_txn_commit(ds3231_dev_t* dev, uint8_t* saved_transactions){
+    if(NULL == dev){
+        return false;
+    }else if(!dev->__i2c_init_f || !dev->__txn_f){
+        return false;
+    }else{
+        uint8_t bursts = 0;
+        uint8_t reg = 0;
+        bool res = true;
+        dev->__txn_f = false;
+        dev->__txn_regs[REG_STATUS] &= ~(dev->__txn_status_clear);
+        dev->__txn_regs[REG_CONTROL] |= dev->__txn_control_set;
+        //merge adjacent dirty registers into one burst each
+        while(res && reg < TXN_REG_COUNT){
+            if(!(dev->__txn_dirty & (0x01ul << reg))){
+                reg++;
+                continue;
+            }
+            const uint8_t reg_start = reg;
+            while(reg < TXN_REG_COUNT && (dev->__txn_dirty & (0x01ul << reg))){
+                reg++;
+            }
+            res = write_regs(dev,reg_start,&dev->__txn_regs[reg_start],reg - reg_start);
+            bursts++;
+        }
+        if(NULL != saved_transactions){
+            const uint32_t saved = (dev->__txn_writes > bursts) ? dev->__txn_writes - bursts : 0u;
+            *saved_transactions = (UINT8_MAX < saved) ? UINT8_MAX : (uint8_t)saved;
+        }
+        dev->__txn_dirty = 0;
+        if(!res){
+            dev->__shadow_f = false;
+        }
+        return res;
+    }
+}
+
+bool ds3231_txn_abort(ds3231_dev_t* dev){
+    if(NULL == dev){
+        return false;
+    }else if(!dev->__txn_f){
+        return false;
+    }else{
+        dev->__txn_f = false;
+        dev->__txn_dirty = 0;
+        //the shadow already holds the staged values
+        dev->__shadow_f = false;
+        return true;
+    }
+}
+
+#ifdef CONFIG_USE_STATS
+void __ds3231_stats_record(ds3231_dev_t* dev, ds3231_stats_op op, uint8_t byte_length,
+                           ds3231_stats_status status, uint32_t latency_us){
+    ds3231_stats_t* stats = &dev->__stats;
+    uint8_t bucket = 0;
+    if(DS3231_STATS_OP_READ == op){
+        stats->reads += 1;
+        stats->bytes_read += (DS3231_STATS_STATUS_OK == status) ? byte_length : 0;
+    }else{
+        stats->writes += 1;
+        stats->bytes_written += (DS3231_STATS_STATUS_OK == status) ? byte_length : 0;
+    }
+    if(DS3231_STATS_STATUS_NACK == status){
+        stats->nacks += 1;
+    }else if(DS3231_STATS_STATUS_TIMEOUT == status){
+        stats->timeouts += 1;
+    }else if(DS3231_STATS_STATUS_ERROR == status){
+        stats->errors += 1;
+    }
+    if(latency_us > stats->max_latency_us[op]){
+        stats->max_latency_us[op] = latency_us;
+    }
+    //bucket is the bit length of the latency
+    while(0 != latency_us && bucket < (DS3231_STATS_LATENCY_BUCKETS - 1)){
+        latency_us >>= 1u;
+        bucket++;
+    }
+    stats->latency_histogram[op][bucket] += 1;
+}
+
+bool ds3231_get_stats(ds3231_dev_t* dev, ds3231_stats_t* stats){
+    if(NULL == dev || NULL == stats){
+        return false;
+    }else{
+        *stats = dev->__stats;
+        return true;
+    }
+}
+
+bool ds3231_reset_stats(ds3231_dev_t* dev){
+    if(NULL == dev){
+        return false;
+    }else{
+        const ds3231_stats_t empty = {0};
+        dev->__stats = empty;
+        return true;
+    }
+}
+#endif
@@ -0,0 +1,285 @@
+#include "ds3231_lib_async.h"
+#include "ds3231_lib_private.h"
+
+
+static const uint8_t  REG_SECONDS = 0x00u;
+static const uint8_t  REG_TEMP_MSB = 0x11u;
+static const uint8_t  REG_COUNT = 0x13u;
+static const uint32_t QUEUE_MASK = DS3231_ASYNC_QUEUE_SIZE - 1u;
+/** reading a gap register costs 9 clocks, a separate read at least 3 conditions and 3 bytes */
+static const uint8_t  READ_MERGE_GAP = 3u;
+
+_Static_assert(0u == (DS3231_ASYNC_QUEUE_SIZE & (DS3231_ASYNC_QUEUE_SIZE - 1u)),
+               "DS3231_ASYNC_QUEUE_SIZE must be a power of two");
+
+
+static bool async_is_read(const ds3231_async_op_t* op){
+    return DS3231_ASYNC_OP_READ == op->kind
+        || DS3231_ASYNC_OP_GET_TIME == op->kind
+        || DS3231_ASYNC_OP_GET_TEMPERATURE == op->kind;
+}
+
+/**
+ * claim the next free slot. the slot belongs to the producer until async_publish
+ */
+static ds3231_async_op_t* async_reserve(ds3231_async_t* async, ds3231_async_op_kind kind,
+                                        uint8_t reg_start, uint8_t byte_length){
+    if(NULL == async || NULL == async->dev){
+        return NULL;
+    }else if(0u == byte_length || REG_COUNT < reg_start + byte_length){
+        return NULL;
+    }
+    const uint32_t tail = atomic_load_explicit(&async->tail,memory_order_relaxed);
+    const uint32_t head = atomic_load_explicit(&async->head,memory_order_acquire);
+    if(DS3231_ASYNC_QUEUE_SIZE <= tail - head){
+        return NULL;
+    }else{
+        ds3231_async_op_t* op = &async->ops[tail & QUEUE_MASK];
+        op->kind = kind;
+        op->reg_start = reg_start;
+        op->byte_length = byte_length;
+        op->out = NULL;
+        op->out_fraction = NULL;
+        op->call = NULL;
+        op->call_arg = NULL;
+        return op;
+    }
+}
+
+/**
+ * hand the slot to the worker
+ */
+static bool async_publish(ds3231_async_t* async, ds3231_async_op_t* op, const ds3231_async_completion_t* completion){
+    if(NULL != completion){
+        op->completion = *completion;
+    }else{
+        op->completion = (ds3231_async_completion_t){0};
+    }
+    if(NULL != op->completion.future){
+        atomic_store_explicit(&op->completion.future->done,false,memory_order_relaxed);
+    }
+    op->enqueued_ns = 0u;
+    __ds3231_get_monotonic_ns(async->dev,&op->enqueued_ns);
+    const uint32_t tail = atomic_load_explicit(&async->tail,memory_order_relaxed);
+    atomic_store_explicit(&async->tail,tail + 1u,memory_order_release);
+    return true;
+}
+
+static void async_complete(ds3231_async_t* async, ds3231_async_op_t* op, bool result){
+    if(result){
+        if(DS3231_ASYNC_OP_READ == op->kind){
+            uint8_t* out = (uint8_t*)op->out;
+            for(uint8_t i = 0; i < op->byte_length; i++){
+                out[i] = op->payload.regs[i];
+            }
+        }else if(DS3231_ASYNC_OP_GET_TIME == op->kind){
+            ds3231_time_data_t* time_data = (ds3231_time_data_t*)op->out;
+            ds3231_decode_time(op->payload.regs,time_data);
+            async->dev->__shadow_12_hours_f = time_data->is_12_hours_format;
+        }else if(DS3231_ASYNC_OP_GET_TEMPERATURE == op->kind){
+            ds3231_decode_temperature(op->payload.regs,(int8_t*)op->out,op->out_fraction);
+        }
+    }
+    async->completed += 1u;
+    if(NULL != op->completion.cb){
+        op->completion.cb(result,op->completion.ctx);
+    }
+    if(NULL != op->completion.future){
+        uint64_t now_ns = 0;
+        __ds3231_get_monotonic_ns(async->dev,&now_ns);
+        op->completion.future->result = result;
+        op->completion.future->latency_us = (uint32_t)((now_ns - op->enqueued_ns) / 1000u);
+        atomic_store_explicit(&op->completion.future->done,true,memory_order_release);
+    }
+}
+
+/**
+ * one burst read covering the run of queued reads starting at head
+ */
+static uint32_t async_run_reads(ds3231_async_t* async, uint32_t head, uint32_t tail){
+    const ds3231_async_op_t* first = &async->ops[head & QUEUE_MASK];
+    uint8_t low = first->reg_start;
+    uint8_t high = first->reg_start + first->byte_length - 1u;
+    uint32_t count = 1u;
+    while(head + count != tail){
+        const ds3231_async_op_t* next = &async->ops[(head + count) & QUEUE_MASK];
+        const uint8_t next_low = next->reg_start;
+        const uint8_t next_high = next->reg_start + next->byte_length - 1u;
+        if(!async_is_read(next) || next_low > high + 1u + READ_MERGE_GAP || next_high + 1u + READ_MERGE_GAP < low){
+            break;
+        }
+        low = (next_low < low) ? next_low : low;
+        high = (next_high > high) ? next_high : high;
+        count += 1u;
+    }
+    uint8_t regs[0x13] = {0};
+    const bool res = __ds3231_i2c_read_multi(async->dev,low,regs,high - low + 1u);
+    async->transactions += 1u;
+    for(uint32_t i = 0; i < count; i++){
+        ds3231_async_op_t* op = &async->ops[(head + i) & QUEUE_MASK];
+        for(uint8_t reg = 0; reg < op->byte_length; reg++){
+            op->payload.regs[reg] = regs[op->reg_start - low + reg];
+        }
+        async_complete(async,op,res);
+    }
+    return count;
+}
+
+/**
+ * one burst write covering the run of queued writes to consecutive registers starting at head.
+ * overlapping writes are not merged, status flag clears and CONV would be lost.
+ */
+static uint32_t async_run_writes(ds3231_async_t* async, uint32_t head, uint32_t tail){
+    const ds3231_async_op_t* first = &async->ops[head & QUEUE_MASK];
+    const uint8_t low = first->reg_start;
+    uint8_t high = first->reg_start + first->byte_length - 1u;
+    uint8_t regs[0x13] = {0};
+    uint32_t count = 0u;
+    while(head + count != tail){
+        const ds3231_async_op_t* next = &async->ops[(head + count) & QUEUE_MASK];
+        if(DS3231_ASYNC_OP_WRITE != next->kind || (0u < count && next->reg_start != high + 1u)){
+            break;
+        }
+        for(uint8_t reg = 0; reg < next->byte_length; reg++){
+            regs[next->reg_start - low + reg] = next->payload.regs[reg];
+        }
+        high = next->reg_start + next->byte_length - 1u;
+        count += 1u;
+    }
+    const bool res = __ds3231_i2c_write_multi(async->dev,regs,low,high - low + 1u);
+    async->transactions += 1u;
+    async->dev->__shadow_f = false;
+    for(uint32_t i = 0; i < count; i++){
+        async_complete(async,&async->ops[(head + i) & QUEUE_MASK],res);
+    }
+    return count;
+}
+
+
+bool ds3231_async_init(ds3231_async_t* async, ds3231_dev_t* dev){
+    if(NULL == async || NULL == dev){
+        return false;
+    }else{
+        async->dev = dev;
+        atomic_init(&async->head,0u);
+        atomic_init(&async->tail,0u);
+        async->transactions = 0u;
+        async->completed = 0u;
+        return true;
+    }
+}
+
+bool ds3231_async_read(ds3231_async_t* async, uint8_t reg_start, uint8_t* data_out, uint8_t byte_length,
+                       const ds3231_async_completion_t* completion){
+    ds3231_async_op_t* op = async_reserve(async,DS3231_ASYNC_OP_READ,reg_start,byte_length);
+    if(NULL == op || NULL == data_out){
+        return false;
+    }else{
+        op->out = data_out;
+        return async_publish(async,op,completion);
+    }
+}
+
+bool ds3231_async_write(ds3231_async_t* async, uint8_t reg_start, const uint8_t* data, uint8_t byte_length,
+                        const ds3231_async_completion_t* completion){
+    ds3231_async_op_t* op = async_reserve(async,DS3231_ASYNC_OP_WRITE,reg_start,byte_length);
+    if(NULL == op || NULL == data){
+        return false;
+    }else{
+        for(uint8_t i = 0; i < byte_length; i++){
+            op->payload.regs[i] = data[i];
+        }
+        return async_publish(async,op,completion);
+    }
+}
+
+bool ds3231_async_get_time(ds3231_async_t* async, ds3231_time_data_t* time_data,
+                           const ds3231_async_completion_t* completion){
+    ds3231_async_op_t* op = async_reserve(async,DS3231_ASYNC_OP_GET_TIME,REG_SECONDS,7u);
+    if(NULL == op || NULL == time_data){
+        return false;
+    }else{
+        op->out = time_data;
+        return async_publish(async,op,completion);
+    }
+}
+
+bool ds3231_async_get_temperature(ds3231_async_t* async, int8_t* number, uint8_t* fraction,
+                                  const ds3231_async_completion_t* completion){
+    ds3231_async_op_t* op = async_reserve(async,DS3231_ASYNC_OP_GET_TEMPERATURE,REG_TEMP_MSB,2u);
+    if(NULL == op || NULL == number || NULL == fraction){
+        return false;
+    }else{
+        op->out = number;
+        op->out_fraction = fraction;
+        return async_publish(async,op,completion);
+    }
+}
+
+bool ds3231_async_set_time(ds3231_async_t* async, bool use_24_format, const ds3231_time_data_t* time_data,
+                           const ds3231_async_completion_t* completion){
+    ds3231_async_op_t* op = async_reserve(async,DS3231_ASYNC_OP_SET_TIME,REG_SECONDS,7u);
+    if(NULL == op || NULL == time_data){
+        return false;
+    }else{
+        op->use_24_format = use_24_format;
+        op->payload.time = *time_data;
+        return async_publish(async,op,completion);
+    }
+}
+
+bool ds3231_async_call(ds3231_async_t* async, ds3231_async_call_t call, void* arg,
+                       const ds3231_async_completion_t* completion){
+    ds3231_async_op_t* op = async_reserve(async,DS3231_ASYNC_OP_CALL,REG_SECONDS,1u);
+    if(NULL == op || NULL == call){
+        return false;
+    }else{
+        op->call = call;
+        op->call_arg = arg;
+        return async_publish(async,op,completion);
+    }
+}
+
+bool ds3231_async_poll(ds3231_async_t* async, uint32_t* completed){
+    if(NULL == async || NULL == async->dev){
+        return false;
+    }else{
+        uint32_t head = atomic_load_explicit(&async->head,memory_order_relaxed);
+        const uint32_t tail = atomic_load_explicit(&async->tail,memory_order_acquire);
+        uint32_t done = 0u;
+        while(head != tail){
+            ds3231_async_op_t* op = &async->ops[head & QUEUE_MASK];
+            uint32_t count = 1u;
+            if(async_is_read(op)){
+                count = async_run_reads(async,head,tail);
+            }else if(DS3231_ASYNC_OP_WRITE == op->kind){
+                count = async_run_writes(async,head,tail);
+            }else if(DS3231_ASYNC_OP_SET_TIME == op->kind){
+                async_complete(async,op,ds3231_set_time(async->dev,op->use_24_format,&op->payload.time));
+            }else{
+                async_complete(async,op,op->call(async->dev,op->call_arg));
+            }
+            head += count;
+            done += count;
+            //release the slots only after their results were delivered
+            atomic_store_explicit(&async->head,head,memory_order_release);
+        }
+        if(NULL != completed){
+            *completed = done;
+        }
+        return true;
+    }
+}
+
+bool ds3231_async_future_done(ds3231_async_future_t* future, bool* result){
+    if(NULL == future){
+        return false;
+    }else if(!atomic_load_explicit(&future->done,memory_order_acquire)){
+        return false;
+    }else{
+        if(NULL != result){
+            *result = future->result;
+        }
+        return true;
+    }
+}
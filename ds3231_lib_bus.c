@@ -0,0 +1,175 @@
+#include "ds3231_lib.h"
+#include "ds3231_lib_private.h"
+
+
+static const uint8_t REG_SECONDS = 0x00u;
+static const uint8_t MUX_CHANNELS = 8u;
+static const uint8_t MUX_ADDRESS_FIRST = 0x70u;
+static const uint8_t MUX_ADDRESS_LAST = 0x77u;
+
+
+bool ds3231_bus_init(ds3231_bus_t* bus, uint32_t i2c_sda_num, uint32_t i2c_scl_num,
+                     int32_t i2c_port, uint8_t mux_address){
+    if(NULL == bus){
+        return false;
+    }else if(true == bus->__i2c_init_f){
+        return false;
+    }else if(0u != mux_address && (MUX_ADDRESS_FIRST > mux_address || MUX_ADDRESS_LAST < mux_address)){
+        return false;
+    }else{
+        bus->i2c_sda_num = i2c_sda_num;
+        bus->i2c_scl_num = i2c_scl_num;
+        #ifdef CONFIG_USE_I2C_PORT
+        bus->i2c_port = i2c_port;
+        #else
+        (void)i2c_port;
+        #endif
+        bus->__lock = NULL;
+        bus->mux_address = mux_address;
+        bus->__mux_channel = DS3231_BUS_MUX_UNKNOWN;
+        bus->__devices = 0u;
+        bus->__sweep_start = 0u;
+        return __ds3231_bus_init(bus);
+    }
+}
+
+bool ds3231_bus_attach(ds3231_dev_t* dev, ds3231_bus_t* bus, uint8_t mux_channel){
+    if(NULL == dev || NULL == bus){
+        return false;
+    }else if(!bus->__i2c_init_f || UINT8_MAX == bus->__devices){
+        return false;
+    }else if(DS3231_BUS_NO_MUX != mux_channel && (0u == bus->mux_address || MUX_CHANNELS <= mux_channel)){
+        return false;
+    }else{
+        dev->bus = bus;
+        dev->mux_channel = mux_channel;
+        dev->i2c_sda_num = bus->i2c_sda_num;
+        dev->i2c_scl_num = bus->i2c_scl_num;
+        #ifdef CONFIG_USE_I2C_PORT
+        dev->i2c_port = bus->i2c_port;
+        #endif
+        dev->__shadow_f = false;
+        dev->__txn_f = false;
+        ds3231_default_policy(&dev->__policy);
+        if(!__ds3231_i2c_init(dev)){
+            dev->bus = NULL;
+            return false;
+        }
+        bus->__devices += 1u;
+        return true;
+    }
+}
+
+bool ds3231_bus_lock(ds3231_bus_t* bus){
+    if(NULL == bus){
+        return false;
+    }else if(!bus->__i2c_init_f){
+        return false;
+    }else{
+        return __ds3231_bus_lock(bus);
+    }
+}
+
+bool ds3231_bus_unlock(ds3231_bus_t* bus){
+    if(NULL == bus){
+        return false;
+    }else if(!bus->__i2c_init_f){
+        return false;
+    }else{
+        return __ds3231_bus_unlock(bus);
+    }
+}
+
+bool ds3231_bus_sweep_time(ds3231_bus_t* bus, ds3231_dev_t** devs, uint8_t count,
+                           ds3231_time_data_t* times, uint64_t* read_ns, bool* valid, uint32_t* sweep_ns){
+    if(NULL == bus || NULL == devs || NULL == times || 0u == count){
+        return false;
+    }else if(!bus->__i2c_init_f){
+        return false;
+    }else if(!__ds3231_bus_lock(bus)){
+        return false;
+    }else{
+        const uint8_t start = bus->__sweep_start % count;
+        uint64_t first_ns = 0;
+        uint64_t last_ns = 0;
+        bool first_f = false;
+        bool res = true;
+        for(uint8_t i = 0; i < count; i++){
+            const uint8_t index = (uint8_t)(((uint16_t)start + i) % count);
+            ds3231_dev_t* dev = devs[index];
+            uint8_t buffer[7] = {0};
+            uint64_t begin_ns = 0;
+            uint64_t end_ns = 0;
+            const bool ok = NULL != dev && bus == dev->bus && dev->__i2c_init_f
+                         && __ds3231_get_monotonic_ns(dev,&begin_ns)
+                         && __ds3231_i2c_read_multi(dev,REG_SECONDS,buffer,7)
+                         && __ds3231_get_monotonic_ns(dev,&end_ns);
+            if(ok){
+                ds3231_decode_time(buffer,&times[index]);
+                dev->__shadow_12_hours_f = times[index].is_12_hours_format;
+                if(NULL != read_ns){
+                    read_ns[index] = begin_ns + (end_ns - begin_ns) / 2u;
+                }
+                if(!first_f){
+                    first_ns = begin_ns;
+                    first_f = true;
+                }
+                last_ns = end_ns;
+            }
+            if(NULL != valid){
+                valid[index] = ok;
+            }
+            res = res && ok;
+        }
+        bus->__sweep_start = (uint8_t)((start + 1u) % count);
+        __ds3231_bus_unlock(bus);
+        if(NULL != sweep_ns){
+            *sweep_ns = (uint32_t)(last_ns - first_ns);
+        }
+        return res;
+    }
+}
+
+bool ds3231_bus_deinit(ds3231_bus_t* bus){
+    if(NULL == bus){
+        return false;
+    }else if(!bus->__i2c_init_f){
+        return false;
+    }else if(0u != bus->__devices){
+        return false;
+    }else{
+        return __ds3231_bus_deinit(bus);
+    }
+}
+
+
+/**
+ * private API used by the ports around every transfer
+ */
+
+bool __ds3231_bus_acquire(ds3231_dev_t* dev){
+    ds3231_bus_t* bus = dev->bus;
+    if(NULL == bus){
+        return true;
+    }else if(!__ds3231_bus_lock(bus)){
+        return false;
+    }else if(0u == bus->mux_address || dev->mux_channel == bus->__mux_channel){
+        return true;
+    }else{
+        //devices in front of the mux need every channel closed, same address behind it
+        const uint8_t control = (DS3231_BUS_NO_MUX == dev->mux_channel) ? 0u : (uint8_t)(0x01u << dev->mux_channel);
+        if(!__ds3231_bus_write_mux(bus,control)){
+            bus->__mux_channel = DS3231_BUS_MUX_UNKNOWN;
+            __ds3231_bus_unlock(bus);
+            return false;
+        }
+        bus->__mux_channel = dev->mux_channel;
+        return true;
+    }
+}
+
+void __ds3231_bus_release(ds3231_dev_t* dev){
+    if(NULL != dev->bus){
+        __ds3231_bus_unlock(dev->bus);
+    }
+}
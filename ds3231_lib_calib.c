@@ -0,0 +1,176 @@
+#include "ds3231_lib_calib.h"
+#include "ds3231_lib_private.h"
+
+
+static const int64_t NS_PER_SECOND = 1000000000;
+static const int64_t MAX_RATE_PPB = 1000000;  /** 1000ppm, i.e. ns per second. points further apart are a jump */
+static const int32_t PPB_PER_AGING_STEP = 100;
+
+
+static const ds3231_calib_point_t* calib_point(const ds3231_calib_t* calib, uint8_t i){
+    //i = 0 is the oldest point in the window
+    return &calib->__points[(calib->__next + DS3231_CALIB_POINTS - calib->__count + i) % DS3231_CALIB_POINTS];
+}
+
+
+bool ds3231_calib_init(ds3231_calib_t* calib, ds3231_dev_t* dev, uint32_t min_span_s,
+                       ds3231_calib_reference_t reference, void* reference_ctx){
+    if(NULL == calib || NULL == dev){
+        return false;
+    }else{
+        *calib = (ds3231_calib_t){0};
+        calib->dev = dev;
+        calib->reference = reference;
+        calib->reference_ctx = reference_ctx;
+        calib->min_span_s = min_span_s;
+        return true;
+    }
+}
+
+bool ds3231_calib_sample(ds3231_calib_t* calib){
+    if(NULL == calib || NULL == calib->dev){
+        return false;
+    }else{
+        ds3231_time_data_t time = {0};
+        int64_t seconds = 0;
+        uint64_t edge_ns = 0;
+        uint64_t reference_ns = 0;
+        if(!ds3231_get_time_aligned(calib->dev,&time,&edge_ns,NULL)
+                    || !ds3231_time_to_unix(&time,&seconds)){
+            return false;
+        }
+        if(NULL == calib->reference){
+            reference_ns = edge_ns;
+        }else if(!calib->reference(edge_ns,&reference_ns,calib->reference_ctx)){
+            return false;
+        }
+        return ds3231_calib_add_point(calib,seconds,reference_ns);
+    }
+}
+
+bool ds3231_calib_add_point(ds3231_calib_t* calib, int64_t rtc_seconds, uint64_t reference_ns){
+    if(NULL == calib){
+        return false;
+    }else{
+        if(0u < calib->__count){
+            const ds3231_calib_point_t* last = calib_point(calib,calib->__count - 1u);
+            const int64_t rtc_elapsed_s = rtc_seconds - last->rtc_seconds;
+            const int64_t reference_elapsed_ns = (int64_t)(reference_ns - last->reference_ns);
+            const int64_t difference_ns = reference_elapsed_ns - rtc_elapsed_s * NS_PER_SECOND;
+            const int64_t bound_ns = NS_PER_SECOND / 2 + rtc_elapsed_s * MAX_RATE_PPB;
+            if(0 >= rtc_elapsed_s || 0 > reference_elapsed_ns || bound_ns < difference_ns || -bound_ns > difference_ns){
+                calib->__count = 0u;
+            }
+        }
+        calib->__points[calib->__next] = (ds3231_calib_point_t){.rtc_seconds = rtc_seconds, .reference_ns = reference_ns};
+        calib->__next = (uint8_t)((calib->__next + 1u) % DS3231_CALIB_POINTS);
+        if(DS3231_CALIB_POINTS > calib->__count){
+            calib->__count += 1u;
+        }
+        return true;
+    }
+}
+
+bool ds3231_calib_estimate(const ds3231_calib_t* calib, int32_t* rate_ppb, uint32_t* residual_ns){
+    if(NULL == calib || NULL == rate_ppb){
+        return false;
+    }else if(DS3231_CALIB_MIN_POINTS > calib->__count){
+        return false;
+    }
+    const ds3231_calib_point_t* first = calib_point(calib,0u);
+    const ds3231_calib_point_t* last = calib_point(calib,calib->__count - 1u);
+    if((int64_t)calib->min_span_s > last->rtc_seconds - first->rtc_seconds){
+        return false;
+    }else{
+        //x: rtc seconds, e: reference minus rtc time in ns, both from the oldest point.
+        //the slope of e over x is in ns per second, i.e. ppb
+        const int64_t n = calib->__count;
+        int64_t sum_x = 0;
+        int64_t sum_e = 0;
+        int64_t sum_xx = 0;
+        int64_t sum_xe = 0;
+        for(uint8_t i = 0; i < calib->__count; i++){
+            const ds3231_calib_point_t* point = calib_point(calib,i);
+            const int64_t x = point->rtc_seconds - first->rtc_seconds;
+            const int64_t e = (int64_t)(point->reference_ns - first->reference_ns) - x * NS_PER_SECOND;
+            sum_x += x;
+            sum_e += e;
+            sum_xx += x * x;
+            sum_xe += x * e;
+        }
+        const int64_t denominator = n * sum_xx - sum_x * sum_x;
+        const int64_t numerator = n * sum_xe - sum_x * sum_e;
+        if(0 >= denominator){
+            return false;
+        }
+        //round half away from zero
+        const int64_t slope = (0 <= numerator) ? (numerator + denominator / 2) / denominator
+                                               : (numerator - denominator / 2) / denominator;
+        if(MAX_RATE_PPB < slope || -MAX_RATE_PPB > slope){
+            return false;
+        }
+        //a fast rtc counts its seconds in less reference time, e falls
+        *rate_ppb = (int32_t)(-slope);
+        if(NULL != residual_ns){
+            const int64_t intercept = (sum_e - slope * sum_x) / n;
+            uint64_t worst = 0u;
+            for(uint8_t i = 0; i < calib->__count; i++){
+                const ds3231_calib_point_t* point = calib_point(calib,i);
+                const int64_t x = point->rtc_seconds - first->rtc_seconds;
+                const int64_t e = (int64_t)(point->reference_ns - first->reference_ns) - x * NS_PER_SECOND;
+                const int64_t residual = e - intercept - slope * x;
+                const uint64_t distance = (uint64_t)((0 <= residual) ? residual : -residual);
+                worst = (distance > worst) ? distance : worst;
+            }
+            *residual_ns = (UINT32_MAX < worst) ? UINT32_MAX : (uint32_t)worst;
+        }
+        return true;
+    }
+}
+
+bool ds3231_calib_apply(ds3231_calib_t* calib, int8_t* aging_offset, bool* written){
+    int32_t rate_ppb = 0;
+    int8_t current = 0;
+    if(NULL == calib || NULL == calib->dev){
+        return false;
+    }else if(!ds3231_calib_estimate(calib,&rate_ppb,NULL)){
+        return false;
+    }else if(!ds3231_get_aging_offset(calib->dev,&current)){
+        return false;
+    }else{
+        //a positive offset slows the oscillator, a fast rtc needs more
+        const int32_t half = PPB_PER_AGING_STEP / 2;
+        const int32_t steps = (0 <= rate_ppb) ? (rate_ppb + half) / PPB_PER_AGING_STEP
+                                              : (rate_ppb - half) / PPB_PER_AGING_STEP;
+        int32_t target = (int32_t)current + steps;
+        target = (INT8_MAX < target) ? INT8_MAX : ((INT8_MIN > target) ? INT8_MIN : target);
+        const bool changed = (int32_t)current != target;
+        if(changed){
+            if(!ds3231_set_aging_offset(calib->dev,(int8_t)target)){
+                return false;
+            }
+            //best effort, the next automatic conversion applies it as well
+            ds3231_start_temperature_conversion(calib->dev);
+            //the window was measured at the old offset
+            calib->__count = 0u;
+            calib->corrections += 1u;
+            current = (int8_t)target;
+        }
+        if(NULL != aging_offset){
+            *aging_offset = current;
+        }
+        if(NULL != written){
+            *written = changed;
+        }
+        return true;
+    }
+}
+
+bool ds3231_calib_reset(ds3231_calib_t* calib){
+    if(NULL == calib){
+        return false;
+    }else{
+        calib->__count = 0u;
+        return true;
+    }
+}
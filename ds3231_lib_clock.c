@@ -0,0 +1,230 @@
+#include "ds3231_lib_clock.h"
+#include "ds3231_lib_private.h"
+
+
+static const int64_t  NS_PER_SECOND = 1000000000;
+static const uint64_t MIN_RATE_INTERVAL_NS = 10000000000u;   /** shorter intervals are dominated by the anchor uncertainty */
+static const int32_t  MAX_RATE_PPB = 1000000;
+
+typedef struct{
+  int64_t seconds;
+  uint64_t ns;
+  int32_t rate_ppb;
+}clock_published_t;
+
+
+/**
+ * correction of a monotonic interval for the rtc rate. split in whole seconds and the rest
+ * so the product can't overflow for any uptime.
+ */
+static int64_t clock_correction(uint64_t elapsed_ns, int32_t rate_ppb){
+    return (int64_t)(elapsed_ns / NS_PER_SECOND) * rate_ppb
+         + ((int64_t)(elapsed_ns % NS_PER_SECOND) * rate_ppb) / NS_PER_SECOND;
+}
+
+/** publish the anchor for ds3231_now and ds3231_stamp_batch, written by the anchoring task only */
+static void clock_publish(ds3231_clock_t* clock){
+    const uint32_t words[DS3231_CLOCK_PUBLISHED_WORDS] = {
+        (uint32_t)((uint64_t)clock->anchor_seconds), (uint32_t)((uint64_t)clock->anchor_seconds >> 32u),
+        (uint32_t)clock->anchor_ns, (uint32_t)(clock->anchor_ns >> 32u),
+        (uint32_t)clock->rate_ppb
+    };
+    const uint32_t sequence = atomic_load_explicit(&clock->__sequence,memory_order_relaxed);
+    atomic_store_explicit(&clock->__sequence,sequence + 1u,memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    for(uint32_t i = 0; i < DS3231_CLOCK_PUBLISHED_WORDS; i++){
+        atomic_store_explicit(&clock->__published[i],words[i],memory_order_relaxed);
+    }
+    atomic_store_explicit(&clock->__sequence,sequence + 2u,memory_order_release);
+}
+
+static bool clock_load(ds3231_clock_t* clock, clock_published_t* published){
+    for(uint32_t attempt = 0; attempt < DS3231_CLOCK_READ_RETRIES; attempt++){
+        const uint32_t begin = atomic_load_explicit(&clock->__sequence,memory_order_acquire);
+        if(0u == begin){
+            return false;
+        }else if(begin & 0x01u){
+            continue;
+        }
+        uint32_t words[DS3231_CLOCK_PUBLISHED_WORDS];
+        for(uint32_t i = 0; i < DS3231_CLOCK_PUBLISHED_WORDS; i++){
+            words[i] = atomic_load_explicit(&clock->__published[i],memory_order_relaxed);
+        }
+        atomic_thread_fence(memory_order_acquire);
+        if(begin == atomic_load_explicit(&clock->__sequence,memory_order_relaxed)){
+            published->seconds = (int64_t)((uint64_t)words[0] | ((uint64_t)words[1] << 32u));
+            published->ns = (uint64_t)words[2] | ((uint64_t)words[3] << 32u);
+            published->rate_ppb = (int32_t)words[4];
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ds3231_clock_init(ds3231_clock_t* clock, ds3231_dev_t* dev, uint32_t reanchor_interval_s){
+    if(NULL == clock || NULL == dev){
+        return false;
+    }else{
+        clock->dev = dev;
+        clock->anchor_seconds = 0;
+        clock->anchor_ns = 0u;
+        clock->anchor_uncertainty_ns = 0u;
+        clock->reanchor_interval_ns = (uint64_t)reanchor_interval_s * NS_PER_SECOND;
+        clock->skew_ns = 0;
+        clock->rate_ppb = 0;
+        clock->anchors = 0u;
+        clock->__base_seconds = 0;
+        clock->__base_ns = 0u;
+        clock->__anchor_f = false;
+        atomic_init(&clock->__sequence,0u);
+        for(uint32_t i = 0; i < DS3231_CLOCK_PUBLISHED_WORDS; i++){
+            atomic_init(&clock->__published[i],0u);
+        }
+        return true;
+    }
+}
+
+bool ds3231_clock_anchor(ds3231_clock_t* clock){
+    if(NULL == clock || NULL == clock->dev){
+        return false;
+    }else if(!clock->dev->__i2c_init_f){
+        return false;
+    }else{
+        uint64_t edge_ns = 0;
+        uint32_t uncertainty_ns = 0;
+        ds3231_time_data_t time = {0};
+        int64_t seconds = 0;
+        if(!ds3231_get_time_aligned(clock->dev,&time,&edge_ns,&uncertainty_ns)
+                    || !ds3231_time_to_unix(&time,&seconds)){
+            return false;
+        }
+        if(clock->__anchor_f){
+            const uint64_t elapsed_ns = edge_ns - clock->anchor_ns;
+            const int64_t rtc_elapsed_ns = (seconds - clock->anchor_seconds) * NS_PER_SECOND;
+            clock->skew_ns = rtc_elapsed_ns - ((int64_t)elapsed_ns + clock_correction(elapsed_ns,clock->rate_ppb));
+        }
+        if(!clock->__anchor_f || NS_PER_SECOND <= clock->skew_ns || -NS_PER_SECOND >= clock->skew_ns){
+            //first anchor or the rtc was set, restart the rate measurement
+            clock->__base_seconds = seconds;
+            clock->__base_ns = edge_ns;
+            clock->rate_ppb = 0;
+        }else if(MIN_RATE_INTERVAL_NS <= edge_ns - clock->__base_ns){
+            const uint64_t base_elapsed_ns = edge_ns - clock->__base_ns;
+            const int64_t difference_ns = (seconds - clock->__base_seconds) * NS_PER_SECOND - (int64_t)base_elapsed_ns;
+            //ppb = difference * 1e9 / elapsed, elapsed taken in milliseconds to stay in range
+            int64_t rate_ppb = (difference_ns * 1000) / (int64_t)(base_elapsed_ns / 1000000u);
+            if(MAX_RATE_PPB < rate_ppb){
+                rate_ppb = MAX_RATE_PPB;
+            }else if(-MAX_RATE_PPB > rate_ppb){
+                rate_ppb = -MAX_RATE_PPB;
+            }
+            clock->rate_ppb = (int32_t)rate_ppb;
+        }
+        clock->anchor_seconds = seconds;
+        clock->anchor_ns = edge_ns;
+        clock->anchor_uncertainty_ns = uncertainty_ns;
+        clock->anchors += 1u;
+        clock->__anchor_f = true;
+        clock_publish(clock);
+        return true;
+    }
+}
+
+bool ds3231_clock_poll(ds3231_clock_t* clock, bool* reanchored){
+    if(NULL == clock || NULL == clock->dev){
+        return false;
+    }else{
+        uint64_t now_ns = 0;
+        bool due = !clock->__anchor_f;
+        if(!due){
+            if(!__ds3231_get_monotonic_ns(clock->dev,&now_ns)){
+                return false;
+            }
+            due = clock->reanchor_interval_ns <= now_ns - clock->anchor_ns;
+        }
+        if(NULL != reanchored){
+            *reanchored = false;
+        }
+        if(!due){
+            return true;
+        }else if(!ds3231_clock_anchor(clock)){
+            return false;
+        }else{
+            if(NULL != reanchored){
+                *reanchored = true;
+            }
+            return true;
+        }
+    }
+}
+
+bool ds3231_now(ds3231_clock_t* clock, ds3231_timespec_t* now){
+    clock_published_t anchor;
+    if(NULL == clock || NULL == now){
+        return false;
+    }else if(!clock_load(clock,&anchor)){
+        //never anchored, or a re-anchor kept publishing
+        return false;
+    }else{
+        uint64_t now_ns = 0;
+        if(!__ds3231_get_monotonic_ns(clock->dev,&now_ns)){
+            return false;
+        }
+        const uint64_t elapsed_ns = (now_ns > anchor.ns) ? now_ns - anchor.ns : 0u;
+        int64_t total_ns = (int64_t)elapsed_ns + clock_correction(elapsed_ns,anchor.rate_ppb);
+        if(0 > total_ns){
+            total_ns = 0;
+        }
+        now->seconds = anchor.seconds + total_ns / NS_PER_SECOND;
+        now->nanoseconds = (uint32_t)(total_ns % NS_PER_SECOND);
+        return true;
+    }
+}
+
+bool ds3231_clock_get_skew(ds3231_clock_t* clock, int64_t* skew_ns, int32_t* rate_ppb){
+    if(NULL == clock){
+        return false;
+    }else if(2u > clock->anchors){
+        return false;
+    }else{
+        if(NULL != skew_ns){
+            *skew_ns = clock->skew_ns;
+        }
+        if(NULL != rate_ppb){
+            *rate_ppb = clock->rate_ppb;
+        }
+        return true;
+    }
+}
+
+bool ds3231_stamp_batch(ds3231_clock_t* clock, const uint64_t* monotonic_ns, ds3231_timespec_t* stamps, uint32_t count){
+    clock_published_t anchor;
+    if(NULL == clock || NULL == monotonic_ns || NULL == stamps){
+        return false;
+    }else if(!clock_load(clock,&anchor)){
+        return false;
+    }else{
+        //rate as a 32.32 fixed point factor plus 32 more fraction bits, the correction is two multiplies
+        //and shifts per stamp. the elapsed time is split at bit 32 so the products stay in range for years,
+        //the extra bits only matter for the high part and keep the result within a few ns of ds3231_now
+        const int64_t scaled = (int64_t)anchor.rate_ppb * ((int64_t)1 << 32);
+        int64_t factor = scaled / NS_PER_SECOND;
+        int64_t rest = scaled - factor * NS_PER_SECOND;
+        if(0 > rest){
+            //floor, so the extra fraction is never negative
+            factor -= 1;
+            rest += NS_PER_SECOND;
+        }
+        const int64_t fraction = ((rest << 32) + NS_PER_SECOND / 2) / NS_PER_SECOND;
+        const int64_t base_ns = anchor.seconds * NS_PER_SECOND;
+        for(uint32_t i = 0; i < count; i++){
+            const int64_t elapsed_ns = (int64_t)(monotonic_ns[i] - anchor.ns);
+            const int64_t high = elapsed_ns >> 32;
+            const int64_t low = (int64_t)(elapsed_ns & 0xFFFFFFFF);
+            const int64_t total_ns = base_ns + elapsed_ns + high * factor + ((low * factor) >> 32) + ((high * fraction) >> 32);
+            stamps[i].seconds = total_ns / NS_PER_SECOND;
+            stamps[i].nanoseconds = (uint32_t)(total_ns - stamps[i].seconds * NS_PER_SECOND);
+        }
+        return true;
+    }
+}
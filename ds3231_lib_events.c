@@ -0,0 +1,136 @@
+#include "ds3231_lib_events.h"
+#include "ds3231_lib_private.h"
+#ifdef ESP_PLATFORM
+#include "esp_attr.h"
+#else
+#define IRAM_ATTR
+#define DRAM_ATTR
+#endif
+
+
+/** read by the isr path, kept out of flash */
+static DRAM_ATTR const uint32_t QUEUE_MASK = DS3231_EVENTS_QUEUE_SIZE - 1u;
+
+_Static_assert(0u == (DS3231_EVENTS_QUEUE_SIZE & (DS3231_EVENTS_QUEUE_SIZE - 1u)),
+               "DS3231_EVENTS_QUEUE_SIZE must be a power of two");
+
+
+static void events_dispatch(ds3231_events_t* events, ds3231_event_kind kind, uint64_t edge_ns){
+    if(NULL != events->__cbs[kind]){
+        uint64_t now_ns = edge_ns;
+        __ds3231_get_monotonic_ns(events->dev,&now_ns);
+        const uint64_t latency_ns = (now_ns > edge_ns) ? now_ns - edge_ns : 0u;
+        events->last_latency_ns = (UINT32_MAX < latency_ns) ? UINT32_MAX : (uint32_t)latency_ns;
+        events->max_latency_ns = (events->last_latency_ns > events->max_latency_ns) ? events->last_latency_ns : events->max_latency_ns;
+        events->dispatched += 1u;
+        events->__cbs[kind](kind,edge_ns,events->__ctxs[kind]);
+    }
+}
+
+
+bool ds3231_events_init(ds3231_events_t* events, ds3231_dev_t* dev, ds3231_events_notify_t notify, void* notify_ctx){
+    if(NULL == events || NULL == dev){
+        return false;
+    }else{
+        events->dev = dev;
+        atomic_init(&events->head,0u);
+        atomic_init(&events->tail,0u);
+        atomic_init(&events->dropped,0u);
+        events->notify = notify;
+        events->notify_ctx = notify_ctx;
+        for(uint8_t kind = 0; kind < DS3231_EVENT_KINDS; kind++){
+            events->__cbs[kind] = NULL;
+            events->__ctxs[kind] = NULL;
+        }
+        events->dispatched = 0u;
+        events->status_reads = 0u;
+        events->last_latency_ns = 0u;
+        events->max_latency_ns = 0u;
+        return true;
+    }
+}
+
+bool ds3231_events_on(ds3231_events_t* events, ds3231_event_kind kind, ds3231_event_cb_t cb, void* ctx){
+    if(NULL == events || DS3231_EVENT_KINDS <= kind){
+        return false;
+    }else{
+        events->__cbs[kind] = cb;
+        events->__ctxs[kind] = ctx;
+        return true;
+    }
+}
+
+IRAM_ATTR bool ds3231_events_push(ds3231_events_t* events, uint64_t edge_ns){
+    if(NULL == events){
+        return false;
+    }
+    const uint32_t tail = atomic_load_explicit(&events->tail,memory_order_relaxed);
+    const uint32_t head = atomic_load_explicit(&events->head,memory_order_acquire);
+    if(DS3231_EVENTS_QUEUE_SIZE <= tail - head){
+        atomic_fetch_add_explicit(&events->dropped,1u,memory_order_relaxed);
+        return false;
+    }else{
+        events->__edges[tail & QUEUE_MASK] = edge_ns;
+        atomic_store_explicit(&events->tail,tail + 1u,memory_order_release);
+        if(NULL != events->notify){
+            events->notify(events->notify_ctx);
+        }
+        return true;
+    }
+}
+
+IRAM_ATTR void ds3231_events_isr_handler(void* arg){
+    ds3231_events_t* events = (ds3231_events_t*)arg;
+    uint64_t edge_ns = 0;
+    if(NULL != events && __ds3231_get_monotonic_ns(events->dev,&edge_ns)){
+        ds3231_events_push(events,edge_ns);
+    }
+}
+
+bool ds3231_events_pump(ds3231_events_t* events, ds3231_edge_source_t* source, uint32_t timeout_ms){
+    uint64_t edge_ns = 0;
+    if(NULL == events || NULL == source || NULL == source->wait){
+        return false;
+    }else if(!source->wait(source,timeout_ms,&edge_ns)){
+        return false;
+    }else{
+        return ds3231_events_push(events,edge_ns);
+    }
+}
+
+bool ds3231_events_process(ds3231_events_t* events, uint32_t* dispatched){
+    if(NULL == events || NULL == events->dev){
+        return false;
+    }
+    const uint32_t head = atomic_load_explicit(&events->head,memory_order_relaxed);
+    const uint32_t tail = atomic_load_explicit(&events->tail,memory_order_acquire);
+    const uint32_t before = events->dispatched;
+    if(NULL != dispatched){
+        *dispatched = 0u;
+    }
+    if(head == tail){
+        return true;
+    }
+    //the flags are levels, one read serves every edge queued so far
+    const uint64_t edge_ns = events->__edges[head & QUEUE_MASK];
+    uint8_t set_flags = 0;
+    events->status_reads += 1u;
+    if(!ds3231_poll_events(events->dev,DS3231_FLAG_A1F | DS3231_FLAG_A2F | DS3231_FLAG_OSF,&set_flags)){
+        return false;
+    }
+    //release the slots only once the flags are cleared, a failed call is retried with the same edges
+    atomic_store_explicit(&events->head,tail,memory_order_release);
+    if(set_flags & DS3231_FLAG_A1F){
+        events_dispatch(events,DS3231_EVENT_ALARM1,edge_ns);
+    }
+    if(set_flags & DS3231_FLAG_A2F){
+        events_dispatch(events,DS3231_EVENT_ALARM2,edge_ns);
+    }
+    if(set_flags & DS3231_FLAG_OSF){
+        events_dispatch(events,DS3231_EVENT_OSC_STOP,edge_ns);
+    }
+    if(NULL != dispatched){
+        *dispatched = events->dispatched - before;
+    }
+    return true;
+}
@@ -0,0 +1,104 @@
+#include "ds3231_lib_events.h"
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/gpio.h>
+
+/**
+ * linux edge sources for ds3231_events_pump. build it next to ds3231_lib_events.c on linux,
+ * with the linux port or the simulator.
+ */
+
+static const char* gpio_consumer = "ds3231-int";
+
+
+static uint64_t monotonic_ns(void){
+    struct timespec now = {0};
+    clock_gettime(CLOCK_MONOTONIC,&now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+static bool source_poll(int fd, uint32_t timeout_ms){
+    struct pollfd pfd = {.fd = fd, .events = POLLIN};
+    return 0 < poll(&pfd,1,(int)timeout_ms) && (pfd.revents & POLLIN);
+}
+
+static bool eventfd_wait(ds3231_edge_source_t* source, uint32_t timeout_ms, uint64_t* edge_ns){
+    uint64_t count = 0;
+    if(!source_poll(source->fd,timeout_ms)){
+        return false;
+    }else if(sizeof(count) != read(source->fd,&count,sizeof(count))){
+        return false;
+    }else{
+        //writes that piled up are one edge, the status read serves them together anyway
+        *edge_ns = monotonic_ns();
+        return true;
+    }
+}
+
+static bool gpio_wait(ds3231_edge_source_t* source, uint32_t timeout_ms, uint64_t* edge_ns){
+    struct gpio_v2_line_event event;
+    if(!source_poll(source->fd,timeout_ms)){
+        return false;
+    }else if(sizeof(event) != read(source->fd,&event,sizeof(event))){
+        return false;
+    }else{
+        //stamped by the kernel in the interrupt, CLOCK_MONOTONIC unless the line asked otherwise
+        *edge_ns = event.timestamp_ns;
+        return true;
+    }
+}
+
+
+bool ds3231_edge_source_eventfd(ds3231_edge_source_t* source, int fd){
+    if(NULL == source || 0 > fd){
+        return false;
+    }else{
+        source->wait = eventfd_wait;
+        source->ctx = NULL;
+        source->fd = fd;
+        return true;
+    }
+}
+
+bool ds3231_edge_source_gpio(ds3231_edge_source_t* source, const char* chip_path, uint32_t offset){
+    if(NULL == source || NULL == chip_path){
+        return false;
+    }
+    const int chip_fd = open(chip_path,O_RDONLY | O_CLOEXEC);
+    if(0 > chip_fd){
+        return false;
+    }else{
+        //INT is active low and open drain, an alarm pulls it down
+        struct gpio_v2_line_request request;
+        memset(&request,0,sizeof(request));
+        request.offsets[0] = offset;
+        request.num_lines = 1u;
+        request.config.flags = GPIO_V2_LINE_FLAG_INPUT | GPIO_V2_LINE_FLAG_EDGE_FALLING;
+        strncpy(request.consumer,gpio_consumer,sizeof(request.consumer) - 1u);
+        const int err = ioctl(chip_fd,GPIO_V2_GET_LINE_IOCTL,&request);
+        close(chip_fd);
+        if(0 > err){
+            return false;
+        }
+        source->wait = gpio_wait;
+        source->ctx = NULL;
+        source->fd = request.fd;
+        return true;
+    }
+}
+
+bool ds3231_edge_source_close(ds3231_edge_source_t* source){
+    if(NULL == source || gpio_wait != source->wait){
+        return false;
+    }else if(0 != close(source->fd)){
+        return false;
+    }else{
+        source->wait = NULL;
+        source->fd = -1;
+        return true;
+    }
+}
@@ -0,0 +1,178 @@
+#include "ds3231_lib.h"
+#include "ds3231_lib_private.h"
+
+
+static const uint32_t DEFAULT_SCL_SPEED_HZ = 400000u;
+static const uint8_t  DEFAULT_TIMEOUT_FACTOR = 4u;
+static const uint32_t DEFAULT_TIMEOUT_MARGIN_US = 2000u;
+static const uint8_t  DEFAULT_RETRIES = 2u;
+static const uint32_t DEFAULT_BACKOFF_US = 500u;
+static const uint32_t DEFAULT_BACKOFF_MAX_US = 4000u;
+static const uint8_t  DEFAULT_RECOVER_AFTER = 2u;
+static const uint32_t CLOCKS_PER_BYTE = 9u;        /** 8 data bits and ack */
+static const uint32_t RECOVERY_CLOCKS = 10u;       /** 9 clocks to release sda and a stop */
+
+
+/**
+ * wire time of a transfer scaled into a timeout
+ */
+static uint64_t policy_timeout_us(const ds3231_policy_t* policy, uint32_t clocks){
+    const uint64_t wire_us = ((uint64_t)clocks * 1000000u + policy->scl_speed_hz - 1u) / policy->scl_speed_hz;
+    return wire_us * policy->timeout_factor + policy->timeout_margin_us;
+}
+
+static uint32_t policy_transfer_clocks(ds3231_stats_op op, uint8_t byte_length){
+    if(DS3231_STATS_OP_READ == op){
+        //start, address, register, repeated start, address, data, stop
+        return 3u + (3u + byte_length) * CLOCKS_PER_BYTE;
+    }else{
+        //start, address, register, data, stop
+        return 2u + (2u + byte_length) * CLOCKS_PER_BYTE;
+    }
+}
+
+static bool policy_valid(const ds3231_policy_t* policy){
+    return 0u != policy->scl_speed_hz && 0u != policy->timeout_factor && policy->backoff_us <= policy->backoff_max_us;
+}
+
+static bool policy_recover(ds3231_dev_t* dev){
+    ds3231_bus_t* bus = dev->bus;
+    if(NULL == bus){
+        return __ds3231_i2c_recover(dev);
+    }else if(__ds3231_bus_lock(bus)){
+        const bool res = __ds3231_i2c_recover(dev);
+        //the glitch may have reached the mux as well
+        bus->__mux_channel = DS3231_BUS_MUX_UNKNOWN;
+        __ds3231_bus_unlock(bus);
+        return res;
+    }else{
+        return false;
+    }
+}
+
+static uint64_t policy_attempt_timeout_us(const ds3231_policy_t* policy, ds3231_stats_op op, uint8_t byte_length){
+    const uint64_t timeout_us = policy_timeout_us(policy,policy_transfer_clocks(op,byte_length));
+    return __ds3231_i2c_timeout_us((UINT32_MAX < timeout_us) ? UINT32_MAX : (uint32_t)timeout_us);
+}
+
+/**
+ * the policy bound of one transfer and the number of bus recoveries it contains
+ */
+static uint64_t policy_worst_case_us(const ds3231_policy_t* policy, ds3231_stats_op op, uint8_t byte_length,
+                                     uint8_t* recoveries){
+    uint64_t total_us = policy_attempt_timeout_us(policy,op,byte_length) * (policy->retries + 1u);
+    uint64_t backoff_us = policy->backoff_us;
+    *recoveries = 0u;
+    for(uint8_t retry = 1; retry <= policy->retries; retry++){
+        total_us += backoff_us;
+        backoff_us = (policy->backoff_max_us / 2u < backoff_us) ? policy->backoff_max_us : 2u * backoff_us;
+        if(0u != policy->recover_after && 0u == retry % policy->recover_after){
+            total_us += policy_timeout_us(policy,RECOVERY_CLOCKS);
+            *recoveries += 1u;
+        }
+    }
+    return total_us;
+}
+
+
+bool ds3231_default_policy(ds3231_policy_t* policy){
+    if(NULL == policy){
+        return false;
+    }else{
+        policy->scl_speed_hz = DEFAULT_SCL_SPEED_HZ;
+        policy->timeout_factor = DEFAULT_TIMEOUT_FACTOR;
+        policy->timeout_margin_us = DEFAULT_TIMEOUT_MARGIN_US;
+        policy->retries = DEFAULT_RETRIES;
+        policy->backoff_us = DEFAULT_BACKOFF_US;
+        policy->backoff_max_us = DEFAULT_BACKOFF_MAX_US;
+        policy->recover_after = DEFAULT_RECOVER_AFTER;
+        return true;
+    }
+}
+
+bool ds3231_set_policy(ds3231_dev_t* dev, const ds3231_policy_t* policy){
+    if(NULL == dev || NULL == policy){
+        return false;
+    }else if(!policy_valid(policy)){
+        return false;
+    }else{
+        dev->__policy = *policy;
+        return true;
+    }
+}
+
+bool ds3231_get_policy(ds3231_dev_t* dev, ds3231_policy_t* policy){
+    if(NULL == dev || NULL == policy){
+        return false;
+    }else{
+        *policy = dev->__policy;
+        return true;
+    }
+}
+
+bool ds3231_policy_worst_case_us(const ds3231_policy_t* policy, ds3231_stats_op op, uint8_t byte_length, uint32_t* us){
+    if(NULL == policy || NULL == us || DS3231_STATS_OP_COUNT <= op){
+        return false;
+    }else if(!policy_valid(policy)){
+        return false;
+    }else{
+        uint8_t recoveries = 0;
+        const uint64_t total_us = policy_worst_case_us(policy,op,byte_length,&recoveries);
+        *us = (UINT32_MAX < total_us) ? UINT32_MAX : (uint32_t)total_us;
+        return true;
+    }
+}
+
+bool ds3231_worst_case_us(ds3231_dev_t* dev, ds3231_stats_op op, uint8_t byte_length, uint32_t* us){
+    if(NULL == dev || NULL == us || DS3231_STATS_OP_COUNT <= op){
+        return false;
+    }else{
+        ds3231_policy_t policy = dev->__policy;
+        if(!policy_valid(&policy)){
+            //the policy the first transfer falls back to
+            ds3231_default_policy(&policy);
+        }
+        uint8_t recoveries = 0;
+        uint64_t total_us = policy_worst_case_us(&policy,op,byte_length,&recoveries);
+        if(NULL != dev->bus && 0u != dev->bus->mux_address){
+            //the mux is routed before the first attempt and again after every recovery
+            total_us += (uint64_t)__ds3231_bus_mux_timeout_us() * (1u + recoveries);
+        }
+        *us = (UINT32_MAX < total_us) ? UINT32_MAX : (uint32_t)total_us;
+        return true;
+    }
+}
+
+
+/**
+ * private API used by the ports around every transfer
+ */
+
+void __ds3231_policy_begin(ds3231_dev_t* dev, ds3231_attempt_t* attempt, ds3231_stats_op op, uint8_t byte_length){
+    if(!policy_valid(&dev->__policy)){
+        //a device set up without ds3231_init or ds3231_bus_attach, e.g. zeroed
+        ds3231_default_policy(&dev->__policy);
+    }
+    attempt->timeout_us = (uint32_t)policy_attempt_timeout_us(&dev->__policy,op,byte_length);
+    attempt->backoff_us = dev->__policy.backoff_us;
+    attempt->attempts = 0u;
+    attempt->failures = 0u;
+}
+
+bool __ds3231_policy_retry(ds3231_dev_t* dev, ds3231_attempt_t* attempt, ds3231_stats_status status){
+    const ds3231_policy_t* policy = &dev->__policy;
+    attempt->attempts += 1u;
+    if(DS3231_STATS_STATUS_OK == status || policy->retries < attempt->attempts){
+        return false;
+    }else{
+        attempt->failures += 1u;
+        __ds3231_delay_us(dev,attempt->backoff_us);
+        attempt->backoff_us = (policy->backoff_max_us / 2u < attempt->backoff_us) ? policy->backoff_max_us : 2u * attempt->backoff_us;
+        if(0u != policy->recover_after && policy->recover_after <= attempt->failures){
+            attempt->failures = 0u;
+            //a port that can't recover the bus ends the transfer, more attempts would only time out
+            return policy_recover(dev);
+        }
+        return true;
+    }
+}
@@ -1,22 +1,204 @@
 #include "ds3231_lib_private.h"
+#include <stdatomic.h>
 #include "driver/i2c_master.h"
 #include "driver/i2c_types.h"
 #include "esp_err.h"
 #include "driver/gpio.h"
+#include "esp_timer.h"
+#include "esp_rom_sys.h"
+#include "esp_attr.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
 
 
 static const uint8_t  ds3231_i2c_device_address = 0b1101000u; //taken from https://www.analog.com/media/en/technical-documentation/data-sheets/DS3231.pdf
 static const uint32_t ds3231_i2c_device_speed  =  400000u;
 static const uint8_t  ds3231_i2c_max_reg_address = 0x12u;
-static const int32_t  ds3231_i2c_timeout_single = 30; /** minimum is 28(number of bits) / 400_000 = 0.07ms */
-static const int32_t  ds3231_i2c_timeout_multi = ds3231_i2c_timeout_single * ds3231_i2c_max_reg_address; /** minimum is 28(number of bits) / 400_000 = 0.07ms */
+static const int32_t  mux_i2c_timeout_ms = 2; /** 2 bytes at 400kHz take 0.05ms, the rest is driver overhead */
+static const uint32_t mux_i2c_device_speed = 400000u;
 
+/**
+ * bus locks come from a static pool so ds3231_bus_init does not allocate
+ */
+typedef struct{
+    StaticSemaphore_t buffer;
+    SemaphoreHandle_t handle;
+    atomic_bool used;
+}bus_lock_t;
+
+static bus_lock_t bus_locks[DS3231_BUS_POOL_SIZE];
+
+static bus_lock_t* bus_lock_claim(void){
+    for(uint32_t i = 0; i < DS3231_BUS_POOL_SIZE; i++){
+        if(!atomic_exchange_explicit(&bus_locks[i].used,true,memory_order_acquire)){
+            bus_locks[i].handle = xSemaphoreCreateRecursiveMutexStatic(&bus_locks[i].buffer);
+            return &bus_locks[i];
+        }
+    }
+    return NULL;
+}
+
+static void bus_lock_release(bus_lock_t* lock){
+    vSemaphoreDelete(lock->handle);
+    lock->handle = NULL;
+    atomic_store_explicit(&lock->used,false,memory_order_release);
+}
+
+static ds3231_stats_status transfer_status(esp_err_t err){
+    switch(err){
+        case(ESP_OK):
+            return DS3231_STATS_STATUS_OK;
+        case(ESP_ERR_TIMEOUT):
+            return DS3231_STATS_STATUS_TIMEOUT;
+        case(ESP_ERR_INVALID_STATE):
+        case(ESP_ERR_INVALID_RESPONSE):
+            //the i2c master driver reports an unexpected nack with these
+            return DS3231_STATS_STATUS_NACK;
+        default:
+            return DS3231_STATS_STATUS_ERROR;
+    }
+}
+
+/**
+ * the driver takes whole milliseconds
+ */
+static int32_t timeout_ms(const ds3231_attempt_t* attempt){
+    return (int32_t)((attempt->timeout_us + 999u) / 1000u);
+}
+
+
+bool __ds3231_bus_init(ds3231_bus_t* bus){
+    if(NULL == bus){
+        return false;
+    }else if(true == bus->__i2c_init_f){
+        return false;
+    }else{
+        const i2c_master_bus_config_t bus_config = {
+            .clk_source = I2C_CLK_SRC_DEFAULT,
+            .i2c_port =  (i2c_port_num_t)bus->i2c_port,
+            .scl_io_num = (gpio_num_t)bus->i2c_scl_num,
+            .sda_io_num = (gpio_num_t)bus->i2c_sda_num,
+            .glitch_ignore_cnt = 7,
+            .flags.enable_internal_pullup = true
+        };
+        const i2c_device_config_t mux_config = {
+            .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+            .device_address = bus->mux_address,
+            .scl_speed_hz = mux_i2c_device_speed
+        };
+        bus_lock_t* lock = bus_lock_claim();
+        if(NULL == lock){
+            return false;
+        }
+        i2c_master_bus_handle_t bus_handle = NULL;
+        esp_err_t err = i2c_new_master_bus(&bus_config,&bus_handle);
+        if(ESP_OK != err){
+            bus_lock_release(lock);
+            return false;
+        }
+        i2c_master_dev_handle_t mux_handle = NULL;
+        if(0u != bus->mux_address){
+            err = i2c_master_bus_add_device(bus_handle,&mux_config,&mux_handle);
+            if(ESP_OK != err){
+                i2c_del_master_bus(bus_handle);
+                bus_lock_release(lock);
+                return false;
+            }
+        }
+        bus->i2c_bus = bus_handle;
+        bus->__mux_dev = mux_handle;
+        bus->__lock = lock;
+        bus->__i2c_init_f = true;
+        return true;
+    }
+}
+
+bool __ds3231_bus_deinit(ds3231_bus_t* bus){
+    if(NULL == bus){
+        return false;
+    }else if(false == bus->__i2c_init_f){
+        return false;
+    }else{
+        esp_err_t err = ESP_OK;
+        if(NULL != bus->__mux_dev){
+            err = i2c_master_bus_rm_device((i2c_master_dev_handle_t)bus->__mux_dev);
+            if(ESP_OK != err){
+                return false;
+            }
+            bus->__mux_dev = NULL;
+        }
+        err = i2c_del_master_bus((i2c_master_bus_handle_t)bus->i2c_bus);
+        if(ESP_OK != err){
+            return false;
+        }else{
+            bus_lock_release((bus_lock_t*)bus->__lock);
+            bus->i2c_bus = NULL;
+            bus->__lock = NULL;
+            bus->__i2c_init_f = false;
+            return true;
+        }
+    }
+}
+
+bool __ds3231_bus_lock(ds3231_bus_t* bus){
+    if(NULL == bus || NULL == bus->__lock){
+        return false;
+    }else{
+        return pdTRUE == xSemaphoreTakeRecursive(((bus_lock_t*)bus->__lock)->handle,portMAX_DELAY);
+    }
+}
+
+bool __ds3231_bus_unlock(ds3231_bus_t* bus){
+    if(NULL == bus || NULL == bus->__lock){
+        return false;
+    }else{
+        return pdTRUE == xSemaphoreGiveRecursive(((bus_lock_t*)bus->__lock)->handle);
+    }
+}
+
+bool __ds3231_bus_write_mux(ds3231_bus_t* bus, uint8_t control){
+    if(NULL == bus || NULL == bus->__mux_dev){
+        return false;
+    }else{
+        return ESP_OK == i2c_master_transmit((i2c_master_dev_handle_t)bus->__mux_dev,&control,1,mux_i2c_timeout_ms);
+    }
+}
+
+
+/**
+ * device on a shared bus: only the device handle is owned by dev
+ */
+static bool i2c_init_on_bus(ds3231_dev_t* dev){
+    const i2c_device_config_t device_config = {
+        .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+        .device_address = ds3231_i2c_device_address,
+        .scl_speed_hz = ds3231_i2c_device_speed
+    };
+    i2c_master_dev_handle_t dev_handle = NULL;
+    esp_err_t err = i2c_master_bus_add_device(
+        (i2c_master_bus_handle_t)dev->bus->i2c_bus,
+        &device_config,
+        &dev_handle
+    );
+    if(ESP_OK != err){
+        return false;
+    }
+    dev->__i2c_bus_handle = NULL;
+    dev->__i2c_dev_handle = dev_handle;
+    dev->i2c_bus = NULL;
+    dev->i2c_dev = &dev->__i2c_dev_handle;
+    dev->__i2c_init_f = true;
+    return true;
+}
 
 bool __ds3231_i2c_init(ds3231_dev_t* dev){
     if(NULL == dev){
         return false;
     }else if(true == dev->__i2c_init_f){
         return false;
+    }else if(NULL != dev->bus){
+        return i2c_init_on_bus(dev);
     }else{
         const i2c_master_bus_config_t bus_config = {
             .clk_source = I2C_CLK_SRC_DEFAULT,
@@ -31,38 +213,27 @@ bool __ds3231_i2c_init(ds3231_dev_t* dev){
             .device_address = ds3231_i2c_device_address,
             .scl_speed_hz = ds3231_i2c_device_speed
         };
-
-
-        i2c_master_bus_handle_t* i2c_bus_handle = malloc(sizeof(i2c_master_bus_handle_t));
-        if (NULL == i2c_bus_handle){
-            return false;
-        }
-        dev->i2c_bus = (i2c_master_bus_handle_t*)i2c_bus_handle;
-
-        esp_err_t err = i2c_new_master_bus(&bus_config,(i2c_master_bus_handle_t*)dev->i2c_bus);
+        //the handles are stored in dev only once both exist, a failed init leaves dev untouched
+        i2c_master_bus_handle_t bus_handle = NULL;
+        i2c_master_dev_handle_t dev_handle = NULL;
+        esp_err_t err = i2c_new_master_bus(&bus_config,&bus_handle);
         if(ESP_OK != err){
             return false;
         }
-        i2c_master_dev_handle_t * i2c_dev_handle = malloc(sizeof(i2c_master_dev_handle_t));
-        if(NULL == i2c_dev_handle){
-            return false;
-        }
-        dev->i2c_dev = (i2c_master_dev_handle_t*)i2c_dev_handle;
-        err = i2c_master_bus_add_device(
-            *((i2c_master_bus_handle_t*)dev->i2c_bus),
-            &device_config,
-            (i2c_master_dev_handle_t*)dev->i2c_dev
-        );
+        err = i2c_master_bus_add_device(bus_handle,&device_config,&dev_handle);
         if(ESP_OK != err){
+            i2c_del_master_bus(bus_handle);
             return false;
         }
-
+        dev->__i2c_bus_handle = bus_handle;
+        dev->__i2c_dev_handle = dev_handle;
+        dev->i2c_bus = &dev->__i2c_bus_handle;
+        dev->i2c_dev = &dev->__i2c_dev_handle;
         dev->__i2c_init_f = true;
-        return true;     
+        return true;
     }
-
-
 }
+
 bool __ds3231_i2c_deinit(ds3231_dev_t* dev){
     if(NULL == dev){
         return false;
@@ -70,27 +241,39 @@ bool __ds3231_i2c_deinit(ds3231_dev_t* dev){
     else if(false == dev->__i2c_init_f){
         return false;
     }
-    else if(NULL == dev->i2c_bus || NULL == dev->i2c_dev){
-        return false;
-    }else{
-        
+    else if(NULL != dev->bus && NULL != dev->i2c_dev){
         esp_err_t err = i2c_master_bus_rm_device(*((i2c_master_dev_handle_t*)dev->i2c_dev));
         if(ESP_OK != err){
             return false;
         }
+        dev->__i2c_init_f = false;
+        dev->__i2c_dev_handle = NULL;
+        dev->i2c_dev = NULL;
+        return true;
+    }
+    else if(NULL == dev->i2c_bus){
+        return false;
+    }else{
+        esp_err_t err = ESP_OK;
+        //i2c_dev is already gone when a previous deinit failed to delete the bus
+        if(NULL != dev->i2c_dev){
+            err = i2c_master_bus_rm_device(*((i2c_master_dev_handle_t*)dev->i2c_dev));
+            if(ESP_OK != err){
+                return false;
+            }
+            dev->__i2c_dev_handle = NULL;
+            dev->i2c_dev = NULL;
+        }
         err = i2c_del_master_bus(*((i2c_master_bus_handle_t*)dev->i2c_bus));
         if(ESP_OK != err){
             return false;
         }else{
             dev->__i2c_init_f = false;
-            free(dev->i2c_bus);
-            free(dev->i2c_dev);
+            dev->__i2c_bus_handle = NULL;
             dev->i2c_bus = NULL;
-            dev->i2c_dev = NULL;
             return true;
         }
     }
-
 }
 
 /**
@@ -103,16 +286,31 @@ bool __ds3231_i2c_write_single(ds3231_dev_t* dev, uint8_t reg_address,uint8_t da
     else if(false == dev->__i2c_init_f){
         return false;
     }else{
-         i2c_master_transmit_multi_buffer_info_t buffer_info[2] = {
+        i2c_master_transmit_multi_buffer_info_t buffer_info[2] = {
             {.write_buffer = &reg_address,.buffer_size = 1},
             {.write_buffer = &data, .buffer_size = 1}
         };
-        esp_err_t err = i2c_master_multi_buffer_transmit(
-            *((i2c_master_dev_handle_t*)dev->i2c_dev),
-            buffer_info,
-            2,
-            ds3231_i2c_timeout_single
-        );
+        ds3231_attempt_t attempt;
+        esp_err_t err = ESP_OK;
+        __ds3231_policy_begin(dev,&attempt,DS3231_STATS_OP_WRITE,1);
+        do{
+            if(!__ds3231_bus_acquire(dev)){
+                return false;
+            }
+            #ifdef CONFIG_USE_STATS
+            const int64_t start_us = esp_timer_get_time();
+            #endif
+            err = i2c_master_multi_buffer_transmit(
+                *((i2c_master_dev_handle_t*)dev->i2c_dev),
+                buffer_info,
+                2,
+                timeout_ms(&attempt)
+            );
+            #ifdef CONFIG_USE_STATS
+            __ds3231_stats_record(dev,DS3231_STATS_OP_WRITE,1,transfer_status(err),(uint32_t)(esp_timer_get_time() - start_us));
+            #endif
+            __ds3231_bus_release(dev);
+        }while(__ds3231_policy_retry(dev,&attempt,transfer_status(err)));
         if(ESP_OK != err){
             return false;
         }else{
@@ -134,12 +332,27 @@ bool __ds3231_i2c_write_multi(ds3231_dev_t* dev, uint8_t* data, uint8_t reg_addr
             {.write_buffer = &reg_address_start,.buffer_size = 1},
             {.write_buffer = data, .buffer_size = (size_t)byte_length}
         };
-        esp_err_t err = i2c_master_multi_buffer_transmit(
-            *((i2c_master_dev_handle_t*)dev->i2c_dev),
-            buffer_info,
-            2,
-            ds3231_i2c_timeout_single
-        );
+        ds3231_attempt_t attempt;
+        esp_err_t err = ESP_OK;
+        __ds3231_policy_begin(dev,&attempt,DS3231_STATS_OP_WRITE,byte_length);
+        do{
+            if(!__ds3231_bus_acquire(dev)){
+                return false;
+            }
+            #ifdef CONFIG_USE_STATS
+            const int64_t start_us = esp_timer_get_time();
+            #endif
+            err = i2c_master_multi_buffer_transmit(
+                *((i2c_master_dev_handle_t*)dev->i2c_dev),
+                buffer_info,
+                2,
+                timeout_ms(&attempt)
+            );
+            #ifdef CONFIG_USE_STATS
+            __ds3231_stats_record(dev,DS3231_STATS_OP_WRITE,byte_length,transfer_status(err),(uint32_t)(esp_timer_get_time() - start_us));
+            #endif
+            __ds3231_bus_release(dev);
+        }while(__ds3231_policy_retry(dev,&attempt,transfer_status(err)));
         if(ESP_OK != err){
             return false;
         }else{
@@ -149,20 +362,39 @@ bool __ds3231_i2c_write_multi(ds3231_dev_t* dev, uint8_t* data, uint8_t reg_addr
 }
 
 bool __ds3231_i2c_read_single(ds3231_dev_t* dev, uint8_t reg_address, uint8_t* data_out){
-    if(NULL == dev || ds3231_i2c_max_reg_address < reg_address){
+    return __ds3231_i2c_read_multi(dev,reg_address,data_out,1);
+}
+
+bool __ds3231_i2c_read_multi(ds3231_dev_t* dev, uint8_t reg_address_start, uint8_t* data_out, uint8_t byte_length){
+    if(NULL == dev || ds3231_i2c_max_reg_address < (reg_address_start + byte_length - 1)){
         return false;
     }
     else if(false == dev->__i2c_init_f){
         return false;
     }else{
-        esp_err_t err = i2c_master_transmit_receive(
-            (*((i2c_master_dev_handle_t*)dev->i2c_dev)),
-            &reg_address,
-            1,
-            data_out,
-            1,
-            ds3231_i2c_timeout_single
-        );
+        ds3231_attempt_t attempt;
+        esp_err_t err = ESP_OK;
+        __ds3231_policy_begin(dev,&attempt,DS3231_STATS_OP_READ,byte_length);
+        do{
+            if(!__ds3231_bus_acquire(dev)){
+                return false;
+            }
+            #ifdef CONFIG_USE_STATS
+            const int64_t start_us = esp_timer_get_time();
+            #endif
+            err = i2c_master_transmit_receive(
+                (*((i2c_master_dev_handle_t*)dev->i2c_dev)),
+                &reg_address_start,
+                1,
+                data_out,
+                (size_t)byte_length,
+                timeout_ms(&attempt)
+            );
+            #ifdef CONFIG_USE_STATS
+            __ds3231_stats_record(dev,DS3231_STATS_OP_READ,byte_length,transfer_status(err),(uint32_t)(esp_timer_get_time() - start_us));
+            #endif
+            __ds3231_bus_release(dev);
+        }while(__ds3231_policy_retry(dev,&attempt,transfer_status(err)));
         if(ESP_OK != err){
             return false;
         }else{
@@ -170,26 +402,53 @@ bool __ds3231_i2c_read_single(ds3231_dev_t* dev, uint8_t reg_address, uint8_t* d
         }
     }
 }
-bool __ds3231_i2c_read_multi(ds3231_dev_t* dev, uint8_t reg_address_start, uint8_t* data_out, uint8_t byte_length){
-    if(NULL == dev || ds3231_i2c_max_reg_address < (reg_address_start + byte_length - 1)){
+
+uint32_t __ds3231_i2c_timeout_us(uint32_t timeout_us){
+    //the driver takes whole milliseconds
+    return (UINT32_MAX - 999u < timeout_us) ? UINT32_MAX : ((timeout_us + 999u) / 1000u) * 1000u;
+}
+
+uint32_t __ds3231_bus_mux_timeout_us(void){
+    return (uint32_t)mux_i2c_timeout_ms * 1000u;
+}
+
+bool __ds3231_i2c_recover(ds3231_dev_t* dev){
+    if(NULL == dev){
+        return false;
+    }else if(NULL != dev->bus){
+        return ESP_OK == i2c_master_bus_reset((i2c_master_bus_handle_t)dev->bus->i2c_bus);
+    }else if(NULL != dev->i2c_bus){
+        //clocks scl until sda is released and sends a stop
+        return ESP_OK == i2c_master_bus_reset(*((i2c_master_bus_handle_t*)dev->i2c_bus));
+    }else{
         return false;
     }
-    else if(false == dev->__i2c_init_f){
+}
+
+//called from ds3231_events_isr_handler, must run with the flash cache disabled
+IRAM_ATTR bool __ds3231_get_monotonic_ns(ds3231_dev_t* dev, uint64_t* ns){
+    if(NULL == dev || NULL == ns){
         return false;
     }else{
-        esp_err_t err = i2c_master_transmit_receive(
-            (*((i2c_master_dev_handle_t*)dev->i2c_dev)),
-            &reg_address_start,
-            1,
-            data_out,
-            (size_t)byte_length,
-            ds3231_i2c_timeout_multi
-        );
-        if(ESP_OK != err){
-            return false;
-        }else{
-            return true;
-        }
+        *ns = (uint64_t)esp_timer_get_time() * 1000u;
+        return true;
     }
 }
 
+bool __ds3231_delay_us(ds3231_dev_t* dev, uint32_t us){
+    if(NULL == dev){
+        return false;
+    }else{
+        const int64_t end_us = esp_timer_get_time() + us;
+        const uint32_t tick_us = portTICK_PERIOD_MS * 1000u;
+        //vTaskDelay may return up to a tick early, sleep one tick less and spin the rest
+        if(2u * tick_us <= us){
+            vTaskDelay((TickType_t)(us / tick_us - 1u));
+        }
+        const int64_t now_us = esp_timer_get_time();
+        if(end_us > now_us){
+            esp_rom_delay_us((uint32_t)(end_us - now_us));
+        }
+        return true;
+    }
+}
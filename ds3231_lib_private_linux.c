@@ -0,0 +1,443 @@
+#include "ds3231_lib_private.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+
+/**
+ * linux port over /dev/i2c-N. build it instead of ds3231_lib_private.c with CONFIG_USE_I2C_FD
+ * and CONFIG_USE_I2C_PORT defined. i2c_port selects the adapter number, sda/scl are unused.
+ * every transfer is a single ioctl:
+ *  - plain i2c adapters: I2C_RDWR, reads are a write + repeated start read message pair.
+ *  - smbus only adapters (e.g. the i2c-stub module): I2C_SMBUS i2c block transfers.
+ * devices on a shared bus use the file descriptor of the bus, a mux needs a plain i2c adapter.
+ * the adapter's own retries are turned off and every attempt runs under the policy timeout, set
+ * with I2C_TIMEOUT when it differs from the one set last. the timeout belongs to the adapter, so
+ * other users of the same adapter see it too. i2c-dev can't recover a stuck bus, a transfer
+ * fails when the policy's recovery is due.
+ */
+
+static const uint8_t  ds3231_i2c_device_address = 0b1101000u; //taken from https://www.analog.com/media/en/technical-documentation/data-sheets/DS3231.pdf
+static const uint8_t  ds3231_i2c_max_reg_address = 0x12u;
+static const unsigned long ds3231_i2c_smbus_funcs = I2C_FUNC_SMBUS_BYTE_DATA | I2C_FUNC_SMBUS_I2C_BLOCK;
+static const uint32_t ds3231_i2c_timeout_step_us = 10000u; /** unit of I2C_TIMEOUT */
+
+
+/**
+ * bus locks come from a static pool so ds3231_bus_init does not allocate
+ */
+typedef struct{
+    pthread_mutex_t mutex;
+    atomic_bool used;
+}bus_lock_t;
+
+static bus_lock_t bus_locks[DS3231_BUS_POOL_SIZE];
+
+static bus_lock_t* bus_lock_claim(void){
+    for(uint32_t i = 0; i < DS3231_BUS_POOL_SIZE; i++){
+        if(!atomic_exchange_explicit(&bus_locks[i].used,true,memory_order_acquire)){
+            pthread_mutexattr_t attr;
+            pthread_mutexattr_init(&attr);
+            pthread_mutexattr_settype(&attr,PTHREAD_MUTEX_RECURSIVE);
+            const int err = pthread_mutex_init(&bus_locks[i].mutex,&attr);
+            pthread_mutexattr_destroy(&attr);
+            if(0 != err){
+                atomic_store_explicit(&bus_locks[i].used,false,memory_order_release);
+                return NULL;
+            }
+            return &bus_locks[i];
+        }
+    }
+    return NULL;
+}
+
+static void bus_lock_release(bus_lock_t* lock){
+    pthread_mutex_destroy(&lock->mutex);
+    atomic_store_explicit(&lock->used,false,memory_order_release);
+}
+
+/**
+ * set the adapter timeout in 10ms steps unless it is already set
+ */
+static bool i2c_set_timeout(int fd, uint32_t* timeout_steps, uint32_t timeout_us){
+    const uint32_t steps = __ds3231_i2c_timeout_us(timeout_us) / ds3231_i2c_timeout_step_us;
+    if(steps == *timeout_steps){
+        return true;
+    }else if(0 > ioctl(fd,I2C_TIMEOUT,(unsigned long)steps)){
+        return false;
+    }else{
+        *timeout_steps = steps;
+        return true;
+    }
+}
+
+/**
+ * open the adapter and check it can talk to the ds3231.
+ * the policy does the retries, the adapter starts with one 10ms step of timeout
+ */
+static int i2c_open(int32_t i2c_port, unsigned long* funcs, uint32_t* timeout_steps){
+    char path[20] = {0};
+    snprintf(path,sizeof(path),"/dev/i2c-%d",(int)i2c_port);
+    int fd = open(path,O_RDWR | O_CLOEXEC);
+    if(0 > fd){
+        return -1;
+    }
+    *timeout_steps = 0u;
+    if(0 > ioctl(fd,I2C_FUNCS,funcs) || 0 > ioctl(fd,I2C_RETRIES,0ul)
+                || !i2c_set_timeout(fd,timeout_steps,ds3231_i2c_timeout_step_us)){
+        close(fd);
+        return -1;
+    }
+    if(!(*funcs & I2C_FUNC_I2C)){
+        //smbus transfers address the device set with I2C_SLAVE
+        if(ds3231_i2c_smbus_funcs != (*funcs & ds3231_i2c_smbus_funcs)
+                    || 0 > ioctl(fd,I2C_SLAVE,(unsigned long)ds3231_i2c_device_address)){
+            close(fd);
+            return -1;
+        }
+    }
+    return fd;
+}
+
+bool __ds3231_bus_init(ds3231_bus_t* bus){
+    if(NULL == bus){
+        return false;
+    }else if(true == bus->__i2c_init_f){
+        return false;
+    }else{
+        unsigned long funcs = 0;
+        bus_lock_t* lock = bus_lock_claim();
+        if(NULL == lock){
+            return false;
+        }
+        int fd = i2c_open(bus->i2c_port,&funcs,&bus->__i2c_timeout);
+        if(0 > fd || (0u != bus->mux_address && !(funcs & I2C_FUNC_I2C))){
+            if(0 <= fd){
+                close(fd);
+            }
+            bus_lock_release(lock);
+            return false;
+        }
+        bus->i2c_fd = fd;
+        bus->__i2c_funcs = (uint32_t)funcs;
+        bus->__lock = lock;
+        bus->__i2c_init_f = true;
+        return true;
+    }
+}
+
+bool __ds3231_bus_deinit(ds3231_bus_t* bus){
+    if(NULL == bus){
+        return false;
+    }else if(false == bus->__i2c_init_f){
+        return false;
+    }else{
+        int err = close(bus->i2c_fd);
+        bus_lock_release((bus_lock_t*)bus->__lock);
+        bus->i2c_fd = -1;
+        bus->__lock = NULL;
+        bus->__i2c_init_f = false;
+        return 0 == err;
+    }
+}
+
+bool __ds3231_bus_lock(ds3231_bus_t* bus){
+    if(NULL == bus || NULL == bus->__lock){
+        return false;
+    }else{
+        return 0 == pthread_mutex_lock(&((bus_lock_t*)bus->__lock)->mutex);
+    }
+}
+
+bool __ds3231_bus_unlock(ds3231_bus_t* bus){
+    if(NULL == bus || NULL == bus->__lock){
+        return false;
+    }else{
+        return 0 == pthread_mutex_unlock(&((bus_lock_t*)bus->__lock)->mutex);
+    }
+}
+
+bool __ds3231_bus_write_mux(ds3231_bus_t* bus, uint8_t control){
+    if(NULL == bus || 0u == bus->mux_address){
+        return false;
+    }else{
+        struct i2c_msg msg = {
+            .addr = bus->mux_address,
+            .flags = 0,
+            .len = 1,
+            .buf = &control
+        };
+        struct i2c_rdwr_ioctl_data data = {
+            .msgs = &msg,
+            .nmsgs = 1
+        };
+        return i2c_set_timeout(bus->i2c_fd,&bus->__i2c_timeout,__ds3231_bus_mux_timeout_us())
+            && 1 == ioctl(bus->i2c_fd,I2C_RDWR,&data);
+    }
+}
+
+
+bool __ds3231_i2c_init(ds3231_dev_t* dev){
+    if(NULL == dev){
+        return false;
+    }else if(true == dev->__i2c_init_f){
+        return false;
+    }else if(NULL != dev->bus){
+        //the file descriptor stays owned by the bus
+        dev->i2c_fd = dev->bus->i2c_fd;
+        dev->__i2c_funcs = dev->bus->__i2c_funcs;
+        dev->__i2c_init_f = true;
+        return true;
+    }else{
+        unsigned long funcs = 0;
+        int fd = i2c_open(dev->i2c_port,&funcs,&dev->__i2c_timeout);
+        if(0 > fd){
+            return false;
+        }
+        dev->i2c_fd = fd;
+        dev->__i2c_funcs = (uint32_t)funcs;
+        dev->__i2c_init_f = true;
+        return true;
+    }
+}
+
+bool __ds3231_i2c_deinit(ds3231_dev_t* dev){
+    if(NULL == dev){
+        return false;
+    }
+    else if(false == dev->__i2c_init_f){
+        return false;
+    }else if(NULL != dev->bus){
+        dev->i2c_fd = -1;
+        dev->__i2c_funcs = 0u;
+        dev->__i2c_init_f = false;
+        return true;
+    }else{
+        int err = close(dev->i2c_fd);
+        dev->i2c_fd = -1;
+        dev->__i2c_init_f = false;
+        return 0 == err;
+    }
+}
+
+static ds3231_stats_status transfer_status(int err){
+    switch(err){
+        case(ENXIO):
+        case(EREMOTEIO):
+            //adapters report a nack with these
+            return DS3231_STATS_STATUS_NACK;
+        case(ETIMEDOUT):
+            return DS3231_STATS_STATUS_TIMEOUT;
+        default:
+            return DS3231_STATS_STATUS_ERROR;
+    }
+}
+
+static uint64_t monotonic_ns(void){
+    struct timespec now = {0};
+    clock_gettime(CLOCK_MONOTONIC,&now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+/**
+ * run one transfer ioctl under the device policy and record every attempt in the device counters.
+ * i2c-dev has no per transfer timeout, the adapter one is set to the attempt's
+ */
+static int i2c_ioctl(ds3231_dev_t* dev, unsigned long request, void* arg,
+                     ds3231_stats_op op, uint8_t byte_length){
+    ds3231_attempt_t attempt;
+    int ret = 0;
+    int err = 0;
+    __ds3231_policy_begin(dev,&attempt,op,byte_length);
+    do{
+        if(!__ds3231_bus_acquire(dev)){
+            errno = EBUSY;
+            return -1;
+        }
+        //devices on a shared bus share its adapter timeout
+        uint32_t* timeout_steps = (NULL != dev->bus) ? &dev->bus->__i2c_timeout : &dev->__i2c_timeout;
+        if(!i2c_set_timeout(dev->i2c_fd,timeout_steps,attempt.timeout_us)){
+            err = errno;
+            __ds3231_bus_release(dev);
+            errno = err;
+            return -1;
+        }
+        #ifdef CONFIG_USE_STATS
+        const uint64_t start_ns = monotonic_ns();
+        #endif
+        ret = ioctl(dev->i2c_fd,request,arg);
+        err = (0 > ret) ? errno : 0;
+        #ifdef CONFIG_USE_STATS
+        __ds3231_stats_record(dev,op,byte_length,(0 > ret) ? transfer_status(err) : DS3231_STATS_STATUS_OK,
+                              (uint32_t)((monotonic_ns() - start_ns) / 1000u));
+        #endif
+        __ds3231_bus_release(dev);
+    }while(__ds3231_policy_retry(dev,&attempt,(0 > ret) ? transfer_status(err) : DS3231_STATS_STATUS_OK));
+    errno = err;
+    return ret;
+}
+
+/**
+ * run the messages as one combined transaction
+ */
+static bool i2c_rdwr(ds3231_dev_t* dev, struct i2c_msg* msgs, uint32_t num_msgs,
+                     ds3231_stats_op op, uint8_t byte_length){
+    struct i2c_rdwr_ioctl_data data = {
+        .msgs = msgs,
+        .nmsgs = num_msgs
+    };
+    return (int)num_msgs == i2c_ioctl(dev,I2C_RDWR,&data,op,byte_length);
+}
+
+/**
+ * run one smbus transfer. data->block[0] holds the length of i2c block transfers
+ */
+static bool i2c_smbus(ds3231_dev_t* dev, uint8_t read_write, uint8_t reg_address,
+                      uint32_t size, union i2c_smbus_data* data, uint8_t byte_length){
+    struct i2c_smbus_ioctl_data args = {
+        .read_write = read_write,
+        .command = reg_address,
+        .size = size,
+        .data = data
+    };
+    const ds3231_stats_op op = (I2C_SMBUS_READ == read_write) ? DS3231_STATS_OP_READ : DS3231_STATS_OP_WRITE;
+    return 0 == i2c_ioctl(dev,I2C_SMBUS,&args,op,byte_length);
+}
+
+bool __ds3231_i2c_write_single(ds3231_dev_t* dev, uint8_t reg_address,uint8_t data){
+    if(NULL == dev || ds3231_i2c_max_reg_address < reg_address){
+        return false;
+    }
+    else if(false == dev->__i2c_init_f){
+        return false;
+    }else if(!(dev->__i2c_funcs & I2C_FUNC_I2C)){
+        union i2c_smbus_data smbus_data = {.byte = data};
+        return i2c_smbus(dev,I2C_SMBUS_WRITE,reg_address,I2C_SMBUS_BYTE_DATA,&smbus_data,1);
+    }else{
+        uint8_t buffer[2] = {reg_address,data};
+        struct i2c_msg msg = {
+            .addr = ds3231_i2c_device_address,
+            .flags = 0,
+            .len = 2,
+            .buf = buffer
+        };
+        return i2c_rdwr(dev,&msg,1,DS3231_STATS_OP_WRITE,1);
+    }
+}
+
+bool __ds3231_i2c_write_multi(ds3231_dev_t* dev, uint8_t* data, uint8_t reg_address_start, uint8_t byte_length){
+    if(NULL == dev
+                || ds3231_i2c_max_reg_address < (reg_address_start + byte_length - 1)
+                || NULL == data){
+        return false;
+    }else if(false == dev->__i2c_init_f){
+        return false;
+    }else if(!(dev->__i2c_funcs & I2C_FUNC_I2C)){
+        union i2c_smbus_data smbus_data = {0};
+        smbus_data.block[0] = byte_length;
+        for(uint8_t i = 0; i < byte_length; i++){
+            smbus_data.block[i + 1] = data[i];
+        }
+        return i2c_smbus(dev,I2C_SMBUS_WRITE,reg_address_start,I2C_SMBUS_I2C_BLOCK_DATA,&smbus_data,byte_length);
+    }else if(dev->__i2c_funcs & I2C_FUNC_NOSTART){
+        //register address and data go out as one message on the wire, no copy
+        struct i2c_msg msgs[2] = {
+            {.addr = ds3231_i2c_device_address, .flags = 0, .len = 1, .buf = &reg_address_start},
+            {.addr = ds3231_i2c_device_address, .flags = I2C_M_NOSTART, .len = byte_length, .buf = data}
+        };
+        return i2c_rdwr(dev,msgs,2,DS3231_STATS_OP_WRITE,byte_length);
+    }else{
+        //the adapter can't continue a message, the register file is small enough to stage on the stack
+        uint8_t buffer[0x13u + 1u] = {0};
+        buffer[0] = reg_address_start;
+        for(uint8_t i = 0; i < byte_length; i++){
+            buffer[i + 1] = data[i];
+        }
+        struct i2c_msg msg = {
+            .addr = ds3231_i2c_device_address,
+            .flags = 0,
+            .len = (uint16_t)(byte_length + 1u),
+            .buf = buffer
+        };
+        return i2c_rdwr(dev,&msg,1,DS3231_STATS_OP_WRITE,byte_length);
+    }
+}
+
+bool __ds3231_i2c_read_single(ds3231_dev_t* dev, uint8_t reg_address, uint8_t* data_out){
+    return __ds3231_i2c_read_multi(dev,reg_address,data_out,1);
+}
+
+bool __ds3231_i2c_read_multi(ds3231_dev_t* dev, uint8_t reg_address_start, uint8_t* data_out, uint8_t byte_length){
+    if(NULL == dev || NULL == data_out || ds3231_i2c_max_reg_address < (reg_address_start + byte_length - 1)){
+        return false;
+    }
+    else if(false == dev->__i2c_init_f){
+        return false;
+    }else if(!(dev->__i2c_funcs & I2C_FUNC_I2C)){
+        union i2c_smbus_data smbus_data = {0};
+        smbus_data.block[0] = byte_length;
+        if(!i2c_smbus(dev,I2C_SMBUS_READ,reg_address_start,I2C_SMBUS_I2C_BLOCK_DATA,&smbus_data,byte_length)){
+            return false;
+        }
+        for(uint8_t i = 0; i < byte_length; i++){
+            data_out[i] = smbus_data.block[i + 1];
+        }
+        return true;
+    }else{
+        struct i2c_msg msgs[2] = {
+            {.addr = ds3231_i2c_device_address, .flags = 0, .len = 1, .buf = &reg_address_start},
+            {.addr = ds3231_i2c_device_address, .flags = I2C_M_RD, .len = byte_length, .buf = data_out}
+        };
+        return i2c_rdwr(dev,msgs,2,DS3231_STATS_OP_READ,byte_length);
+    }
+}
+
+uint32_t __ds3231_i2c_timeout_us(uint32_t timeout_us){
+    //I2C_TIMEOUT takes 10ms steps
+    const uint64_t steps = ((uint64_t)timeout_us + ds3231_i2c_timeout_step_us - 1u) / ds3231_i2c_timeout_step_us;
+    return (UINT32_MAX / ds3231_i2c_timeout_step_us < steps) ? UINT32_MAX : (uint32_t)steps * ds3231_i2c_timeout_step_us;
+}
+
+uint32_t __ds3231_bus_mux_timeout_us(void){
+    return ds3231_i2c_timeout_step_us;
+}
+
+bool __ds3231_i2c_recover(ds3231_dev_t* dev){
+    //adapter drivers recover a stuck bus themselves on a timeout, i2c-dev has no request for it.
+    //failing here ends the transfer, see __ds3231_policy_retry
+    (void)dev;
+    return false;
+}
+
+bool __ds3231_get_monotonic_ns(ds3231_dev_t* dev, uint64_t* ns){
+    if(NULL == dev || NULL == ns){
+        return false;
+    }else{
+        *ns = monotonic_ns();
+        return true;
+    }
+}
+
+bool __ds3231_delay_us(ds3231_dev_t* dev, uint32_t us){
+    if(NULL == dev){
+        return false;
+    }else{
+        struct timespec delay = {
+            .tv_sec = (time_t)(us / 1000000u),
+            .tv_nsec = (long)(us % 1000000u) * 1000
+        };
+        //resume after signals until the whole delay has passed
+        while(0 != nanosleep(&delay,&delay)){
+            if(EINTR != errno){
+                return false;
+            }
+        }
+        return true;
+    }
+}
@@ -0,0 +1,660 @@
+#include "ds3231_lib_private.h"
+#include "ds3231_lib_sim.h"
+
+
+static const uint8_t  ds3231_i2c_max_reg_address = 0x12u;
+static const uint64_t ds3231_sim_second_ns = 1000000000u;
+static const uint32_t ds3231_sim_conversion_ns = 125000000u; /** typical tCONV */
+static const uint8_t  ds3231_sim_conversion_period = 64u;   /** seconds between automatic conversions */
+static const uint8_t  ds3231_sim_clocks_per_byte = 9u;      /** 8 data bits and ack */
+static const uint8_t  ds3231_sim_clocks_per_condition = 1u; /** start, repeated start or stop */
+static const uint32_t ds3231_sim_mux_timeout_us = 50u;      /** start, 2 bytes and stop at 400kHz */
+
+static const uint8_t REG_SECONDS = 0x00u;
+static const uint8_t REG_MINUTES = 0x01u;
+static const uint8_t REG_HOURS = 0x02u;
+static const uint8_t REG_DAY = 0x03u;
+static const uint8_t REG_DATE = 0x04u;
+static const uint8_t REG_MONTH = 0x05u;
+static const uint8_t REG_YEAR = 0x06u;
+static const uint8_t REG_ALARM1_SECONDS = 0x07u;
+static const uint8_t REG_ALARM2_MINUTES = 0x0Bu;
+static const uint8_t REG_CONTROL = 0x0Eu;
+static const uint8_t REG_STATUS  = 0x0Fu;
+static const uint8_t REG_AGING_OFFSET = 0x10u;
+static const uint8_t REG_TEMP_MSB = 0x11u;
+static const uint8_t REG_TEMP_LSB = 0x12u;
+
+static const uint8_t BIT_MASK_12_HOURS = 0b01000000;
+static const uint8_t BIT_MASK_PM = 0b00100000;
+static const uint8_t BIT_MASK_CENTURY = 0b10000000;
+static const uint8_t BIT_MASK_AXMX = 0b10000000;
+static const uint8_t BIT_MASK_DYDT = 0b01000000;
+static const uint8_t BIT_MASK_A1F = 0b00000001;
+static const uint8_t BIT_MASK_A2F = 0b00000010;
+static const uint8_t BIT_MASK_BSY = 0b00000100;
+static const uint8_t BIT_MASK_EN32KHZ = 0b00001000;
+static const uint8_t BIT_MASK_OSF = 0b10000000;
+static const uint8_t BIT_MASK_STATUS_FLAGS = 0b10000011;
+static const uint8_t BIT_MASK_A1IE = 0b00000001;
+static const uint8_t BIT_MASK_A2IE = 0b00000010;
+static const uint8_t BIT_MASK_INTCN = 0b00000100;
+static const uint8_t BIT_MASK_CONV = 0b00100000;
+static const uint8_t BIT_MASK_EOSC = 0b10000000;
+
+static const uint8_t days_in_month[12] = {31,28,31,30,31,30,31,31,30,31,30,31};
+
+
+static uint8_t sim_bcd(uint8_t number){
+    return (uint8_t)(((number / 10u) << 4u) | (number % 10u));
+}
+
+static uint8_t sim_dec(uint8_t number){
+    return (uint8_t)((number >> 4u) * 10u + (number & 0x0Fu));
+}
+
+/** hours register (time or alarm) in 0-23 */
+static uint8_t sim_hours_24(uint8_t hours_reg){
+    if(hours_reg & BIT_MASK_12_HOURS){
+        uint8_t hours = sim_dec(hours_reg & 0x1Fu) % 12u;
+        return (hours_reg & BIT_MASK_PM) ? hours + 12u : hours;
+    }else{
+        return sim_dec(hours_reg & 0x3Fu);
+    }
+}
+
+static bool sim_oscillator_running(ds3231_sim_t* sim){
+    return !(sim->on_battery && (sim->regs[REG_CONTROL] & BIT_MASK_EOSC));
+}
+
+/** length of one second of the oscillator, trimmed by drift and aging offset */
+static uint64_t sim_tick_period(ds3231_sim_t* sim){
+    const int64_t aging = (int8_t)sim->regs[REG_AGING_OFFSET];
+    return (uint64_t)((int64_t)ds3231_sim_second_ns - sim->drift_ppb + aging * 100);
+}
+
+static void sim_start_conversion(ds3231_sim_t* sim){
+    sim->busy_remaining_ns = sim->conversion_ns;
+    sim->regs[REG_STATUS] |= BIT_MASK_BSY;
+}
+
+static void sim_finish_conversion(ds3231_sim_t* sim){
+    sim->regs[REG_TEMP_MSB] = (uint8_t)(int8_t)(sim->temperature_quarters >> 2);
+    sim->regs[REG_TEMP_LSB] = (uint8_t)((sim->temperature_quarters & 0x03) << 6u);
+    sim->regs[REG_STATUS] &= ~(BIT_MASK_BSY);
+    sim->regs[REG_CONTROL] &= ~(BIT_MASK_CONV);
+}
+
+static void sim_check_oscillator(ds3231_sim_t* sim){
+    if(!sim_oscillator_running(sim)){
+        sim->regs[REG_STATUS] |= BIT_MASK_OSF;
+    }
+}
+
+static void sim_next_day(ds3231_sim_t* sim){
+    uint8_t* regs = sim->regs;
+    uint8_t day = regs[REG_DAY] & 0x07u;
+    uint8_t date = sim_dec(regs[REG_DATE] & 0x3Fu) + 1u;
+    uint8_t month = sim_dec(regs[REG_MONTH] & 0x1Fu);
+    uint8_t century = regs[REG_MONTH] & BIT_MASK_CENTURY;
+    uint8_t year = sim_dec(regs[REG_YEAR]);
+    uint8_t month_days = 31u;
+    if(1u <= month && 12u >= month){
+        month_days = days_in_month[month - 1u];
+    }
+    //the chip treats every year divisible by 4 as leap year
+    if(2u == month && 0u == (year % 4u)){
+        month_days = 29u;
+    }
+    regs[REG_DAY] = (day % 7u) + 1u;
+    if(date > month_days){
+        date = 1u;
+        month += 1u;
+        if(month > 12u){
+            month = 1u;
+            year += 1u;
+            if(year > 99u){
+                year = 0u;
+                century ^= BIT_MASK_CENTURY;
+            }
+        }
+    }
+    regs[REG_DATE] = sim_bcd(date);
+    regs[REG_MONTH] = sim_bcd(month) | century;
+    regs[REG_YEAR] = sim_bcd(year);
+}
+
+static void sim_next_hour(ds3231_sim_t* sim){
+    uint8_t* regs = sim->regs;
+    if(regs[REG_HOURS] & BIT_MASK_12_HOURS){
+        uint8_t hours = sim_dec(regs[REG_HOURS] & 0x1Fu) + 1u;
+        uint8_t pm = regs[REG_HOURS] & BIT_MASK_PM;
+        if(12u == hours){
+            pm ^= BIT_MASK_PM;
+            if(!pm){
+                sim_next_day(sim);
+            }
+        }else if(12u < hours){
+            hours = 1u;
+        }
+        regs[REG_HOURS] = BIT_MASK_12_HOURS | pm | sim_bcd(hours);
+    }else{
+        uint8_t hours = sim_dec(regs[REG_HOURS] & 0x3Fu) + 1u;
+        if(24u <= hours){
+            hours = 0u;
+            sim_next_day(sim);
+        }
+        regs[REG_HOURS] = sim_bcd(hours);
+    }
+}
+
+static bool sim_day_match(ds3231_sim_t* sim, uint8_t alarm_day_reg){
+    if(alarm_day_reg & BIT_MASK_DYDT){
+        return (alarm_day_reg & 0x0Fu) == (sim->regs[REG_DAY] & 0x07u);
+    }else{
+        return sim_dec(alarm_day_reg & 0x3Fu) == sim_dec(sim->regs[REG_DATE] & 0x3Fu);
+    }
+}
+
+static void sim_match_alarms(ds3231_sim_t* sim){
+    uint8_t* regs = sim->regs;
+    const uint8_t* alarm1 = &regs[REG_ALARM1_SECONDS];
+    const uint8_t* alarm2 = &regs[REG_ALARM2_MINUTES];
+    bool match = ((alarm1[0] & BIT_MASK_AXMX) || sim_dec(alarm1[0] & 0x7Fu) == sim_dec(regs[REG_SECONDS] & 0x7Fu))
+              && ((alarm1[1] & BIT_MASK_AXMX) || sim_dec(alarm1[1] & 0x7Fu) == sim_dec(regs[REG_MINUTES] & 0x7Fu))
+              && ((alarm1[2] & BIT_MASK_AXMX) || sim_hours_24(alarm1[2]) == sim_hours_24(regs[REG_HOURS]))
+              && ((alarm1[3] & BIT_MASK_AXMX) || sim_day_match(sim,alarm1[3]));
+    if(match){
+        regs[REG_STATUS] |= BIT_MASK_A1F;
+    }
+    //alarm2 has no seconds register, it matches at 00 seconds
+    if(0u == (regs[REG_SECONDS] & 0x7Fu)){
+        match = ((alarm2[0] & BIT_MASK_AXMX) || sim_dec(alarm2[0] & 0x7Fu) == sim_dec(regs[REG_MINUTES] & 0x7Fu))
+             && ((alarm2[1] & BIT_MASK_AXMX) || sim_hours_24(alarm2[1]) == sim_hours_24(regs[REG_HOURS]))
+             && ((alarm2[2] & BIT_MASK_AXMX) || sim_day_match(sim,alarm2[2]));
+        if(match){
+            regs[REG_STATUS] |= BIT_MASK_A2F;
+        }
+    }
+}
+
+static void sim_tick(ds3231_sim_t* sim){
+    uint8_t* regs = sim->regs;
+    uint8_t seconds = sim_dec(regs[REG_SECONDS] & 0x7Fu) + 1u;
+    if(60u > seconds){
+        regs[REG_SECONDS] = sim_bcd(seconds);
+    }else{
+        uint8_t minutes = sim_dec(regs[REG_MINUTES] & 0x7Fu) + 1u;
+        regs[REG_SECONDS] = 0u;
+        if(60u > minutes){
+            regs[REG_MINUTES] = sim_bcd(minutes);
+        }else{
+            regs[REG_MINUTES] = 0u;
+            sim_next_hour(sim);
+        }
+    }
+    sim_match_alarms(sim);
+    sim->conversion_ticks += 1u;
+    if(ds3231_sim_conversion_period <= sim->conversion_ticks){
+        sim->conversion_ticks = 0u;
+        if(0u == sim->busy_remaining_ns){
+            sim_start_conversion(sim);
+        }
+    }
+}
+
+static void sim_write_reg(ds3231_sim_t* sim, uint8_t reg_address, uint8_t data){
+    uint8_t* regs = sim->regs;
+    if(REG_SECONDS == reg_address){
+        //writing the seconds register resets the countdown chain
+        regs[REG_SECONDS] = data & 0x7Fu;
+        sim->phase_ns = 0u;
+    }else if(REG_STATUS == reg_address){
+        //flags can only be cleared, BSY is read only
+        regs[REG_STATUS] = (regs[REG_STATUS] & data & BIT_MASK_STATUS_FLAGS)
+                         | (data & BIT_MASK_EN32KHZ)
+                         | (regs[REG_STATUS] & BIT_MASK_BSY);
+    }else if(REG_CONTROL == reg_address){
+        const bool converting = regs[REG_CONTROL] & BIT_MASK_CONV;
+        regs[REG_CONTROL] = (data & ~(BIT_MASK_CONV)) | (converting ? BIT_MASK_CONV : 0u);
+        if((data & BIT_MASK_CONV) && !converting){
+            regs[REG_CONTROL] |= BIT_MASK_CONV;
+            if(0u == sim->busy_remaining_ns){
+                sim_start_conversion(sim);
+            }
+        }
+        sim_check_oscillator(sim);
+    }else if(REG_TEMP_MSB == reg_address || REG_TEMP_LSB == reg_address){
+        //read only
+    }else{
+        regs[reg_address] = data;
+    }
+}
+
+
+bool ds3231_sim_init(ds3231_sim_t* sim){
+    if(NULL == sim){
+        return false;
+    }else{
+        for(uint8_t i = 0; i <= ds3231_i2c_max_reg_address; i++){
+            sim->regs[i] = 0u;
+        }
+        sim->regs[REG_DAY] = 0x01u;
+        sim->regs[REG_DATE] = 0x01u;
+        sim->regs[REG_MONTH] = 0x01u;
+        sim->regs[REG_CONTROL] = 0x1Cu; //INTCN, RS2, RS1
+        sim->regs[REG_STATUS] = BIT_MASK_OSF | BIT_MASK_EN32KHZ;
+        sim->now_ns = 0u;
+        sim->phase_ns = 0u;
+        sim->busy_remaining_ns = 0u;
+        sim->latency_ns = 0u;
+        sim->conversion_ns = ds3231_sim_conversion_ns;
+        sim->drift_ppb = 0;
+        sim->conversion_ticks = 0u;
+        sim->temperature_quarters = 25 * 4;
+        sim->on_battery = false;
+        ds3231_sim_set_fault(sim,&(ds3231_sim_fault_t){0});
+        ds3231_sim_reset_counters(sim);
+        sim_finish_conversion(sim);
+        return true;
+    }
+}
+
+bool ds3231_sim_attach(ds3231_dev_t* dev, ds3231_sim_t* sim){
+    if(NULL == dev || NULL == sim){
+        return false;
+    }else{
+        dev->i2c_dev = sim;
+        return true;
+    }
+}
+
+bool ds3231_sim_mux_init(ds3231_sim_mux_t* mux){
+    if(NULL == mux){
+        return false;
+    }else{
+        mux->control = 0u;
+        mux->transactions = 0u;
+        mux->wire_bytes = 0u;
+        mux->wire_clocks = 0u;
+        return true;
+    }
+}
+
+bool ds3231_sim_attach_bus(ds3231_bus_t* bus, ds3231_sim_mux_t* mux){
+    if(NULL == bus){
+        return false;
+    }else{
+        bus->i2c_bus = mux;
+        return true;
+    }
+}
+
+bool ds3231_sim_advance_ns(ds3231_sim_t* sim, uint64_t ns){
+    if(NULL == sim){
+        return false;
+    }
+    while(0u < ns){
+        const bool running = sim_oscillator_running(sim);
+        const uint64_t period = sim_tick_period(sim);
+        uint64_t step = ns;
+        if(running){
+            const uint64_t to_tick = (sim->phase_ns >= period) ? 0u : period - sim->phase_ns;
+            step = (to_tick < step) ? to_tick : step;
+        }
+        if(0u != sim->busy_remaining_ns && sim->busy_remaining_ns < step){
+            step = sim->busy_remaining_ns;
+        }
+        sim->now_ns += step;
+        ns -= step;
+        if(0u != sim->busy_remaining_ns){
+            sim->busy_remaining_ns -= step;
+            if(0u == sim->busy_remaining_ns){
+                sim_finish_conversion(sim);
+            }
+        }
+        if(running){
+            sim->phase_ns += step;
+            if(sim->phase_ns >= period){
+                sim->phase_ns -= period;
+                sim_tick(sim);
+            }
+        }
+    }
+    return true;
+}
+
+bool ds3231_sim_set_latency(ds3231_sim_t* sim, uint32_t latency_ns){
+    if(NULL == sim){
+        return false;
+    }else{
+        sim->latency_ns = latency_ns;
+        return true;
+    }
+}
+
+bool ds3231_sim_set_drift(ds3231_sim_t* sim, int32_t drift_ppb){
+    if(NULL == sim){
+        return false;
+    }else{
+        sim->drift_ppb = drift_ppb;
+        return true;
+    }
+}
+
+bool ds3231_sim_set_temperature(ds3231_sim_t* sim, int16_t temperature_quarters){
+    if(NULL == sim){
+        return false;
+    }else{
+        sim->temperature_quarters = temperature_quarters;
+        return true;
+    }
+}
+
+bool ds3231_sim_set_battery(ds3231_sim_t* sim, bool on_battery){
+    if(NULL == sim){
+        return false;
+    }else{
+        sim->on_battery = on_battery;
+        sim_check_oscillator(sim);
+        return true;
+    }
+}
+
+bool ds3231_sim_reset_counters(ds3231_sim_t* sim){
+    if(NULL == sim){
+        return false;
+    }else{
+        sim->transactions = 0u;
+        sim->wire_bytes = 0u;
+        sim->wire_clocks = 0u;
+        sim->drops = 0u;
+        sim->nacks = 0u;
+        sim->delays = 0u;
+        sim->recoveries = 0u;
+        return true;
+    }
+}
+
+bool ds3231_sim_get_bus_time(ds3231_sim_t* sim, uint32_t scl_speed_hz, uint64_t* bus_time_ns){
+    if(NULL == sim || NULL == bus_time_ns || 0u == scl_speed_hz){
+        return false;
+    }else{
+        *bus_time_ns = (sim->wire_clocks * ds3231_sim_second_ns) / scl_speed_hz;
+        return true;
+    }
+}
+
+/** count one transaction with its conditions and bytes on the wire */
+static void sim_count(ds3231_sim_t* sim, uint8_t conditions, uint8_t wire_bytes){
+    sim->transactions += 1u;
+    sim->wire_bytes += wire_bytes;
+    sim->wire_clocks += (uint64_t)conditions * ds3231_sim_clocks_per_condition
+                      + (uint64_t)wire_bytes * ds3231_sim_clocks_per_byte;
+}
+
+bool ds3231_sim_set_fault(ds3231_sim_t* sim, const ds3231_sim_fault_t* fault){
+    if(NULL == sim || NULL == fault){
+        return false;
+    }else{
+        sim->fault = *fault;
+        //xorshift can't leave 0
+        sim->__random = (0u == fault->seed) ? 1u : fault->seed;
+        return true;
+    }
+}
+
+bool ds3231_sim_int_active(ds3231_sim_t* sim){
+    if(NULL == sim){
+        return false;
+    }else{
+        const uint8_t control = sim->regs[REG_CONTROL];
+        const uint8_t status = sim->regs[REG_STATUS];
+        return (control & BIT_MASK_INTCN)
+            && (((control & BIT_MASK_A1IE) && (status & BIT_MASK_A1F))
+                || ((control & BIT_MASK_A2IE) && (status & BIT_MASK_A2F)));
+    }
+}
+
+
+/**
+ * private API
+ */
+
+/**
+ * a device behind the simulated mux only answers while its channel is routed
+ */
+static bool sim_routed(ds3231_dev_t* dev){
+    if(NULL == dev->bus || NULL == dev->bus->i2c_bus || DS3231_BUS_NO_MUX == dev->mux_channel){
+        return true;
+    }else{
+        const ds3231_sim_mux_t* mux = (const ds3231_sim_mux_t*)dev->bus->i2c_bus;
+        return (mux->control >> dev->mux_channel) & 0x01u;
+    }
+}
+
+/**
+ * decide the fate of one transaction and spend its time on failure. returns the status the
+ * master sees, on DS3231_STATS_STATUS_OK the transaction runs normally
+ */
+static ds3231_stats_status sim_fault(ds3231_dev_t* dev, ds3231_sim_t* sim, uint32_t timeout_us){
+    const uint64_t timeout_ns = (uint64_t)timeout_us * 1000u;
+    if(!sim_routed(dev)){
+        ds3231_sim_advance_ns(sim,sim->latency_ns);
+        return DS3231_STATS_STATUS_NACK;
+    }else if(sim->fault.stuck){
+        ds3231_sim_advance_ns(sim,timeout_ns);
+        return DS3231_STATS_STATUS_TIMEOUT;
+    }
+    sim->__random ^= sim->__random << 13u;
+    sim->__random ^= sim->__random >> 17u;
+    sim->__random ^= sim->__random << 5u;
+    const uint32_t draw = sim->__random % 1000000u;
+    if(draw < sim->fault.drop_ppm){
+        sim->drops += 1u;
+        ds3231_sim_advance_ns(sim,timeout_ns);
+        return DS3231_STATS_STATUS_TIMEOUT;
+    }else if(draw - sim->fault.drop_ppm < sim->fault.nack_ppm){
+        sim->nacks += 1u;
+        ds3231_sim_advance_ns(sim,sim->latency_ns);
+        return DS3231_STATS_STATUS_NACK;
+    }else if(draw - sim->fault.drop_ppm - sim->fault.nack_ppm < sim->fault.delay_ppm){
+        sim->delays += 1u;
+        if(timeout_ns < (uint64_t)sim->latency_ns + sim->fault.delay_ns){
+            ds3231_sim_advance_ns(sim,timeout_ns);
+            return DS3231_STATS_STATUS_TIMEOUT;
+        }
+        ds3231_sim_advance_ns(sim,sim->fault.delay_ns);
+    }
+    return DS3231_STATS_STATUS_OK;
+}
+
+bool __ds3231_bus_init(ds3231_bus_t* bus){
+    if(NULL == bus){
+        return false;
+    }else if(true == bus->__i2c_init_f){
+        return false;
+    }else if(0u != bus->mux_address && NULL == bus->i2c_bus){
+        return false;
+    }else{
+        bus->__i2c_init_f = true;
+        return true;
+    }
+}
+
+bool __ds3231_bus_deinit(ds3231_bus_t* bus){
+    if(NULL == bus){
+        return false;
+    }else if(false == bus->__i2c_init_f){
+        return false;
+    }else{
+        bus->__i2c_init_f = false;
+        return true;
+    }
+}
+
+bool __ds3231_bus_lock(ds3231_bus_t* bus){
+    return NULL != bus;
+}
+
+bool __ds3231_bus_unlock(ds3231_bus_t* bus){
+    return NULL != bus;
+}
+
+bool __ds3231_bus_write_mux(ds3231_bus_t* bus, uint8_t control){
+    if(NULL == bus || NULL == bus->i2c_bus){
+        return false;
+    }else{
+        ds3231_sim_mux_t* mux = (ds3231_sim_mux_t*)bus->i2c_bus;
+        mux->control = control;
+        //start, address, control, stop
+        mux->transactions += 1u;
+        mux->wire_bytes += 2u;
+        mux->wire_clocks += 2u * ds3231_sim_clocks_per_condition + 2u * ds3231_sim_clocks_per_byte;
+        return true;
+    }
+}
+
+bool __ds3231_i2c_init(ds3231_dev_t* dev){
+    if(NULL == dev || NULL == dev->i2c_dev){
+        return false;
+    }else if(true == dev->__i2c_init_f){
+        return false;
+    }else{
+        dev->__i2c_init_f = true;
+        return true;
+    }
+}
+
+bool __ds3231_i2c_deinit(ds3231_dev_t* dev){
+    if(NULL == dev){
+        return false;
+    }else if(false == dev->__i2c_init_f){
+        return false;
+    }else{
+        dev->__i2c_init_f = false;
+        return true;
+    }
+}
+
+bool __ds3231_i2c_write_single(ds3231_dev_t* dev, uint8_t reg_address,uint8_t data){
+    return __ds3231_i2c_write_multi(dev,&data,reg_address,1);
+}
+
+bool __ds3231_i2c_write_multi(ds3231_dev_t* dev, uint8_t* data, uint8_t reg_address_start, uint8_t byte_length){
+    if(NULL == dev || NULL == data || 0 == byte_length
+                || ds3231_i2c_max_reg_address < (reg_address_start + byte_length - 1)){
+        return false;
+    }else if(false == dev->__i2c_init_f){
+        return false;
+    }else{
+        ds3231_sim_t* sim = (ds3231_sim_t*)dev->i2c_dev;
+        ds3231_attempt_t attempt;
+        ds3231_stats_status status = DS3231_STATS_STATUS_OK;
+        __ds3231_policy_begin(dev,&attempt,DS3231_STATS_OP_WRITE,byte_length);
+        do{
+            if(!__ds3231_bus_acquire(dev)){
+                return false;
+            }
+            const uint64_t start_ns = sim->now_ns;
+            status = sim_fault(dev,sim,attempt.timeout_us);
+            if(DS3231_STATS_STATUS_OK == status){
+                //writes take effect on the acknowledge at the end of the transfer
+                ds3231_sim_advance_ns(sim,sim->latency_ns);
+                for(uint8_t i = 0; i < byte_length; i++){
+                    sim_write_reg(sim,reg_address_start + i,data[i]);
+                }
+                //start, address, register, data, stop
+                sim_count(sim,2u,2u + byte_length);
+            }
+            #ifdef CONFIG_USE_STATS
+            __ds3231_stats_record(dev,DS3231_STATS_OP_WRITE,byte_length,status,(uint32_t)((sim->now_ns - start_ns) / 1000u));
+            #else
+            (void)start_ns;
+            #endif
+            __ds3231_bus_release(dev);
+        }while(__ds3231_policy_retry(dev,&attempt,status));
+        return DS3231_STATS_STATUS_OK == status;
+    }
+}
+
+bool __ds3231_i2c_read_single(ds3231_dev_t* dev, uint8_t reg_address, uint8_t* data_out){
+    return __ds3231_i2c_read_multi(dev,reg_address,data_out,1);
+}
+
+bool __ds3231_i2c_read_multi(ds3231_dev_t* dev, uint8_t reg_address_start, uint8_t* data_out, uint8_t byte_length){
+    if(NULL == dev || NULL == data_out || 0 == byte_length
+                || ds3231_i2c_max_reg_address < (reg_address_start + byte_length - 1)){
+        return false;
+    }else if(false == dev->__i2c_init_f){
+        return false;
+    }else{
+        ds3231_sim_t* sim = (ds3231_sim_t*)dev->i2c_dev;
+        ds3231_attempt_t attempt;
+        ds3231_stats_status status = DS3231_STATS_STATUS_OK;
+        __ds3231_policy_begin(dev,&attempt,DS3231_STATS_OP_READ,byte_length);
+        do{
+            if(!__ds3231_bus_acquire(dev)){
+                return false;
+            }
+            const uint64_t start_ns = sim->now_ns;
+            status = sim_fault(dev,sim,attempt.timeout_us);
+            if(DS3231_STATS_STATUS_OK == status){
+                //the registers are latched on the start condition
+                for(uint8_t i = 0; i < byte_length; i++){
+                    data_out[i] = sim->regs[reg_address_start + i];
+                }
+                ds3231_sim_advance_ns(sim,sim->latency_ns);
+                //start, address, register, repeated start, address, data, stop
+                sim_count(sim,3u,3u + byte_length);
+            }
+            #ifdef CONFIG_USE_STATS
+            __ds3231_stats_record(dev,DS3231_STATS_OP_READ,byte_length,status,(uint32_t)((sim->now_ns - start_ns) / 1000u));
+            #else
+            (void)start_ns;
+            #endif
+            __ds3231_bus_release(dev);
+        }while(__ds3231_policy_retry(dev,&attempt,status));
+        return DS3231_STATS_STATUS_OK == status;
+    }
+}
+
+bool __ds3231_i2c_recover(ds3231_dev_t* dev){
+    if(NULL == dev || NULL == dev->i2c_dev){
+        return false;
+    }else{
+        ds3231_sim_t* sim = (ds3231_sim_t*)dev->i2c_dev;
+        //9 clocks and a stop at 400kHz
+        ds3231_sim_advance_ns(sim,25000u);
+        sim->fault.stuck = false;
+        sim->recoveries += 1u;
+        return true;
+    }
+}
+
+uint32_t __ds3231_i2c_timeout_us(uint32_t timeout_us){
+    return timeout_us;
+}
+
+uint32_t __ds3231_bus_mux_timeout_us(void){
+    //the simulated mux takes no time, bound it like a real one
+    return ds3231_sim_mux_timeout_us;
+}
+
+bool __ds3231_get_monotonic_ns(ds3231_dev_t* dev, uint64_t* ns){
+    if(NULL == dev || NULL == dev->i2c_dev || NULL == ns){
+        return false;
+    }else{
+        *ns = ((ds3231_sim_t*)dev->i2c_dev)->now_ns;
+        return true;
+    }
+}
+
+bool __ds3231_delay_us(ds3231_dev_t* dev, uint32_t us){
+    if(NULL == dev || NULL == dev->i2c_dev){
+        return false;
+    }else{
+        //waiting is simulated time passing
+        return ds3231_sim_advance_ns((ds3231_sim_t*)dev->i2c_dev,(uint64_t)us * 1000u);
+    }
+}
@@ -0,0 +1,83 @@
+#include "ds3231_lib_seqlock.h"
+#include "ds3231_lib_private.h"
+#include <string.h>
+
+
+bool ds3231_seqlock_init(ds3231_seqlock_t* seqlock, ds3231_dev_t* dev){
+    if(NULL == seqlock || NULL == dev){
+        return false;
+    }else{
+        seqlock->dev = dev;
+        atomic_init(&seqlock->__sequence,0u);
+        for(uint32_t i = 0; i < DS3231_SEQLOCK_WORDS; i++){
+            atomic_init(&seqlock->__words[i],0u);
+        }
+        return true;
+    }
+}
+
+bool ds3231_seqlock_refresh(ds3231_seqlock_t* seqlock){
+    if(NULL == seqlock || NULL == seqlock->dev){
+        return false;
+    }else{
+        ds3231_snapshot_t snapshot = {0};
+        uint64_t begin_ns = 0;
+        uint64_t end_ns = 0;
+        if(!__ds3231_get_monotonic_ns(seqlock->dev,&begin_ns)
+                    || !ds3231_read_snapshot(seqlock->dev,&snapshot)
+                    || !__ds3231_get_monotonic_ns(seqlock->dev,&end_ns)){
+            return false;
+        }
+        return ds3231_seqlock_publish(seqlock,&snapshot,begin_ns + (end_ns - begin_ns) / 2u);
+    }
+}
+
+bool ds3231_seqlock_publish(ds3231_seqlock_t* seqlock, const ds3231_snapshot_t* snapshot, uint64_t read_ns){
+    if(NULL == seqlock || NULL == snapshot){
+        return false;
+    }else{
+        uint32_t words[DS3231_SEQLOCK_WORDS] = {0};
+        const ds3231_seqlock_data_t data = {.snapshot = *snapshot, .read_ns = read_ns};
+        memcpy(words,&data,sizeof(data));
+        const uint32_t sequence = atomic_load_explicit(&seqlock->__sequence,memory_order_relaxed);
+        atomic_store_explicit(&seqlock->__sequence,sequence + 1u,memory_order_relaxed);
+        //the odd count must be visible before any word changes
+        atomic_thread_fence(memory_order_release);
+        for(uint32_t i = 0; i < DS3231_SEQLOCK_WORDS; i++){
+            atomic_store_explicit(&seqlock->__words[i],words[i],memory_order_relaxed);
+        }
+        atomic_store_explicit(&seqlock->__sequence,sequence + 2u,memory_order_release);
+        return true;
+    }
+}
+
+bool ds3231_seqlock_read(ds3231_seqlock_t* seqlock, ds3231_snapshot_t* snapshot, uint64_t* read_ns){
+    if(NULL == seqlock || NULL == snapshot){
+        return false;
+    }else{
+        for(uint32_t attempt = 0; attempt < DS3231_SEQLOCK_READ_RETRIES; attempt++){
+            const uint32_t begin = atomic_load_explicit(&seqlock->__sequence,memory_order_acquire);
+            if(0u == begin){
+                return false;
+            }else if(begin & 0x01u){
+                continue;
+            }
+            uint32_t words[DS3231_SEQLOCK_WORDS];
+            for(uint32_t i = 0; i < DS3231_SEQLOCK_WORDS; i++){
+                words[i] = atomic_load_explicit(&seqlock->__words[i],memory_order_relaxed);
+            }
+            //the word loads must complete before the count is checked again
+            atomic_thread_fence(memory_order_acquire);
+            if(begin == atomic_load_explicit(&seqlock->__sequence,memory_order_relaxed)){
+                ds3231_seqlock_data_t data;
+                memcpy(&data,words,sizeof(data));
+                *snapshot = data.snapshot;
+                if(NULL != read_ns){
+                    *read_ns = data.read_ns;
+                }
+                return true;
+            }
+        }
+        return false;
+    }
+}
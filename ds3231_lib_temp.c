@@ -0,0 +1,229 @@
+#include "ds3231_lib_temp.h"
+#include "ds3231_lib_private.h"
+
+
+static const uint8_t  REG_CONTROL = 0x0Eu;
+static const uint8_t  BIT_MASK_BSY = 0b00000100;
+static const uint8_t  BIT_MASK_CONV = 0b00100000;
+static const uint64_t CONVERSION_PERIOD_NS = 64000000000ull; /** automatic conversion every 64 seconds */
+static const uint64_t CONVERSION_MAX_NS = 200000000ull;      /** tCONV max */
+static const uint64_t JITTER_NS = 100000000ull;              /** spread of tCONV around the 64 second tick */
+static const uint64_t DRIFT_NS = 10000000ull;                /** host against chip clock error per period, ~150ppm */
+static const uint64_t PROBE_NS = (uint64_t)DS3231_TEMP_PROBE_MS * 1000000u;
+
+
+static int16_t temp_to_centi(const uint8_t* regs){
+    const int16_t quarters = (int16_t)((int8_t)regs[0] * 4 + (regs[1] >> 0x06u));
+    return (int16_t)(quarters * 25);
+}
+
+static void temp_record(ds3231_temp_t* temp, int16_t centi){
+    temp->__samples[temp->__sample_next] = centi;
+    temp->__sample_next = (uint16_t)((temp->__sample_next + 1u) % DS3231_TEMP_SAMPLES);
+    if(DS3231_TEMP_SAMPLES > temp->__sample_count){
+        temp->__sample_count += 1u;
+    }
+    if(0u == temp->__count){
+        temp->__offset = centi;
+        temp->__min = centi;
+        temp->__max = centi;
+    }
+    //shifted by the first sample the sums stay small, no floating point needed
+    const int64_t delta = (int64_t)centi - temp->__offset;
+    temp->__count += 1u;
+    temp->__sum += delta;
+    temp->__sum_sq += (uint64_t)(delta * delta);
+    temp->__min = (centi < temp->__min) ? centi : temp->__min;
+    temp->__max = (centi > temp->__max) ? centi : temp->__max;
+}
+
+/** the next automatic conversion completes between earliest_ns and latest_ns */
+static void temp_expect(ds3231_temp_t* temp, uint64_t earliest_ns, uint64_t latest_ns){
+    temp->__window_start_ns = (earliest_ns > JITTER_NS) ? earliest_ns - JITTER_NS : 0u;
+    temp->__window_end_ns = latest_ns + JITTER_NS;
+}
+
+/** move a passed window to the following conversion, widened by the clock error */
+static void temp_next_window(ds3231_temp_t* temp, uint64_t now_ns){
+    while(temp->__window_end_ns < now_ns){
+        temp->__window_start_ns += CONVERSION_PERIOD_NS - DRIFT_NS;
+        temp->__window_end_ns += CONVERSION_PERIOD_NS + DRIFT_NS;
+    }
+    if(CONVERSION_PERIOD_NS < temp->__window_end_ns - temp->__window_start_ns){
+        temp->__window_start_ns = temp->__window_end_ns - CONVERSION_PERIOD_NS;
+    }
+}
+
+/**
+ * @brief read control up to the temperature (0x0E-0x12) in one burst.
+ * @param [regs][out] 5 registers
+ */
+static bool temp_read(ds3231_temp_t* temp, uint8_t* regs, uint64_t* begin_ns, uint64_t* end_ns){
+    temp->reads += 1u;
+    return __ds3231_get_monotonic_ns(temp->dev,begin_ns)
+        && __ds3231_i2c_read_multi(temp->dev,REG_CONTROL,regs,5)
+        && __ds3231_get_monotonic_ns(temp->dev,end_ns);
+}
+
+static void temp_observe(ds3231_temp_t* temp, const uint8_t* regs, uint64_t begin_ns, uint64_t end_ns){
+    const int16_t centi = temp_to_centi(&regs[3]);
+    const bool busy = regs[1] & BIT_MASK_BSY;
+    const uint64_t previous_ns = temp->__read_ns;
+    if(!temp->__valid_f){
+        temp->__valid_f = true;
+        temp->centi = centi;
+        temp_record(temp,centi);
+        //phase unknown, a conversion completes within one period from now
+        if(busy){
+            temp_expect(temp,begin_ns,end_ns + CONVERSION_MAX_NS);
+        }else{
+            temp->__window_start_ns = end_ns;
+            temp->__window_end_ns = end_ns + CONVERSION_PERIOD_NS;
+        }
+    }else if(centi != temp->centi){
+        //completed after the previous read, the next one a period later
+        temp->centi = centi;
+        temp_record(temp,centi);
+        const uint64_t earliest_ns = (previous_ns + CONVERSION_PERIOD_NS > begin_ns) ? previous_ns : begin_ns - CONVERSION_PERIOD_NS;
+        temp_expect(temp,earliest_ns + CONVERSION_PERIOD_NS,end_ns + CONVERSION_PERIOD_NS);
+    }else if(busy){
+        temp_expect(temp,begin_ns,end_ns + CONVERSION_MAX_NS);
+    }else if(begin_ns > temp->__window_end_ns){
+        //the conversion was due and produced the same value
+        temp_record(temp,centi);
+        temp_next_window(temp,begin_ns);
+    }
+    temp->__read_ns = end_ns;
+}
+
+
+bool ds3231_temp_init(ds3231_temp_t* temp, ds3231_dev_t* dev){
+    if(NULL == temp || NULL == dev){
+        return false;
+    }else{
+        *temp = (ds3231_temp_t){0};
+        temp->dev = dev;
+        return true;
+    }
+}
+
+bool ds3231_temp_get(ds3231_temp_t* temp, int16_t* centi){
+    if(NULL == temp || NULL == temp->dev || NULL == centi){
+        return false;
+    }else if(!temp->dev->__i2c_init_f){
+        return false;
+    }else{
+        uint64_t now_ns = 0;
+        if(!__ds3231_get_monotonic_ns(temp->dev,&now_ns)){
+            return false;
+        }
+        if(temp->__valid_f && (now_ns < temp->__window_start_ns || now_ns - temp->__read_ns < PROBE_NS)){
+            temp->hits += 1u;
+            *centi = temp->centi;
+            return true;
+        }
+        uint8_t regs[5] = {0};
+        uint64_t begin_ns = 0;
+        uint64_t end_ns = 0;
+        if(!temp_read(temp,regs,&begin_ns,&end_ns)){
+            return false;
+        }
+        temp_observe(temp,regs,begin_ns,end_ns);
+        *centi = temp->centi;
+        return true;
+    }
+}
+
+bool ds3231_temp_convert(ds3231_temp_t* temp, int16_t* centi){
+    if(NULL == temp || NULL == temp->dev){
+        return false;
+    }else if(!temp->dev->__i2c_init_f){
+        return false;
+    }else{
+        uint8_t regs[5] = {0};
+        uint64_t begin_ns = 0;
+        uint64_t end_ns = 0;
+        uint32_t waited_us = 0;
+        uint32_t backoff_us = DS3231_TEMP_POLL_US;
+        bool started = false;
+        while(true){
+            if(!temp_read(temp,regs,&begin_ns,&end_ns)){
+                return false;
+            }
+            const bool busy = regs[1] & BIT_MASK_BSY;
+            if(!started){
+                //an automatic conversion holds BSY, CONV can't start before it ends
+                temp_observe(temp,regs,begin_ns,end_ns);
+                if(!busy){
+                    if(!ds3231_start_temperature_conversion(temp->dev)){
+                        return false;
+                    }
+                    started = true;
+                }
+            }else if(!busy && !(regs[0] & BIT_MASK_CONV)){
+                break;
+            }
+            if(DS3231_TEMP_CONVERT_TIMEOUT_US <= waited_us){
+                return false;
+            }
+            __ds3231_delay_us(temp->dev,backoff_us);
+            waited_us += backoff_us;
+            backoff_us = (DS3231_TEMP_POLL_MAX_US / 2u < backoff_us) ? DS3231_TEMP_POLL_MAX_US : 2u * backoff_us;
+        }
+        //the forced conversion says nothing about the automatic phase
+        temp->centi = temp_to_centi(&regs[3]);
+        temp->__read_ns = end_ns;
+        temp_record(temp,temp->centi);
+        if(NULL != centi){
+            *centi = temp->centi;
+        }
+        return true;
+    }
+}
+
+bool ds3231_temp_get_stats(const ds3231_temp_t* temp, ds3231_temp_stats_t* stats){
+    if(NULL == temp || NULL == stats){
+        return false;
+    }else if(0u == temp->__count){
+        return false;
+    }else{
+        const int64_t count = temp->__count;
+        //round half away from zero
+        const int64_t mean = (0 <= temp->__sum) ? (temp->__sum + count / 2) / count : (temp->__sum - count / 2) / count;
+        const uint64_t sum_abs = (uint64_t)((0 <= temp->__sum) ? temp->__sum : -temp->__sum);
+        const uint64_t spread = temp->__sum_sq - (sum_abs * sum_abs) / (uint64_t)count;
+        stats->count = temp->__count;
+        stats->min_centi = temp->__min;
+        stats->max_centi = temp->__max;
+        stats->mean_centi = (int16_t)(temp->__offset + mean);
+        stats->variance_centi2 = (uint32_t)(spread / (uint64_t)count);
+        return true;
+    }
+}
+
+bool ds3231_temp_reset_stats(ds3231_temp_t* temp){
+    if(NULL == temp){
+        return false;
+    }else{
+        temp->__count = 0u;
+        temp->__sum = 0;
+        temp->__sum_sq = 0u;
+        return true;
+    }
+}
+
+bool ds3231_temp_history(const ds3231_temp_t* temp, int16_t* centi, uint16_t max_count, uint16_t* count){
+    if(NULL == temp || NULL == centi || NULL == count){
+        return false;
+    }else{
+        const uint16_t copied = (temp->__sample_count < max_count) ? temp->__sample_count : max_count;
+        //the newest copied samples end just before __sample_next
+        uint16_t index = (uint16_t)((temp->__sample_next + DS3231_TEMP_SAMPLES - copied) % DS3231_TEMP_SAMPLES);
+        for(uint16_t i = 0; i < copied; i++){
+            centi[i] = temp->__samples[index];
+            index = (uint16_t)((index + 1u) % DS3231_TEMP_SAMPLES);
+        }
+        *count = copied;
+        return true;
+    }
+}
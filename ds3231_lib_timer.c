@@ -0,0 +1,289 @@
+#include "ds3231_lib_timer.h"
+#include "ds3231_lib_private.h"
+
+
+static const uint8_t HEAP_ALARM1 = 0u;
+static const uint8_t HEAP_ALARM2 = 1u;
+static const int64_t SECONDS_PER_MINUTE = 60;
+/** an alarm matches day of month, hours, minutes (and seconds), so it must fire within the shortest month */
+static const int64_t ALARM_HORIZON_S = 27 * 86400;
+/** a deadline this close may pass before the alarm write lands */
+static const int64_t ALARM_MIN_LEAD_S = 1;
+/** dispatch rounds of one service when deadlines keep passing while arming */
+static const uint8_t SERVICE_ROUNDS = 3u;
+
+
+static bool heap_less(const ds3231_timer_t* a, const ds3231_timer_t* b){
+    return a->deadline < b->deadline;
+}
+
+static void heap_place(ds3231_timers_t* timers, uint8_t heap, uint16_t index, ds3231_timer_t* timer){
+    timers->__heaps[heap][index] = timer;
+    timer->__index = index;
+}
+
+static void heap_sift_up(ds3231_timers_t* timers, uint8_t heap, uint16_t index){
+    ds3231_timer_t* timer = timers->__heaps[heap][index];
+    while(0u < index){
+        const uint16_t parent = (uint16_t)((index - 1u) / 2u);
+        if(!heap_less(timer,timers->__heaps[heap][parent])){
+            break;
+        }
+        heap_place(timers,heap,index,timers->__heaps[heap][parent]);
+        index = parent;
+    }
+    heap_place(timers,heap,index,timer);
+}
+
+static void heap_sift_down(ds3231_timers_t* timers, uint8_t heap, uint16_t index){
+    ds3231_timer_t* timer = timers->__heaps[heap][index];
+    const uint16_t count = timers->__counts[heap];
+    while(true){
+        uint16_t child = (uint16_t)(2u * index + 1u);
+        if(child >= count){
+            break;
+        }
+        if(child + 1u < count && heap_less(timers->__heaps[heap][child + 1u],timers->__heaps[heap][child])){
+            child += 1u;
+        }
+        if(!heap_less(timers->__heaps[heap][child],timer)){
+            break;
+        }
+        heap_place(timers,heap,index,timers->__heaps[heap][child]);
+        index = child;
+    }
+    heap_place(timers,heap,index,timer);
+}
+
+static bool heap_insert(ds3231_timers_t* timers, ds3231_timer_t* timer){
+    const uint8_t heap = (0 == timer->deadline % SECONDS_PER_MINUTE) ? HEAP_ALARM2 : HEAP_ALARM1;
+    if(DS3231_TIMERS_MAX <= timers->__counts[heap]){
+        return false;
+    }else{
+        const uint16_t index = timers->__counts[heap];
+        timers->__counts[heap] += 1u;
+        timer->__heap = heap + 1u;
+        heap_place(timers,heap,index,timer);
+        heap_sift_up(timers,heap,index);
+        return true;
+    }
+}
+
+static void heap_remove(ds3231_timers_t* timers, ds3231_timer_t* timer){
+    const uint8_t heap = timer->__heap - 1u;
+    const uint16_t index = timer->__index;
+    const uint16_t last = timers->__counts[heap] - 1u;
+    timers->__counts[heap] = last;
+    timer->__heap = 0u;
+    if(index != last){
+        heap_place(timers,heap,index,timers->__heaps[heap][last]);
+        heap_sift_down(timers,heap,index);
+        heap_sift_up(timers,heap,index);
+    }
+}
+
+/**
+ * deadline an alarm should hold, 0 to disable it
+ */
+static int64_t alarm_target(const ds3231_timers_t* timers, uint8_t heap, int64_t now){
+    if(0u == timers->__counts[heap]){
+        return 0;
+    }
+    int64_t target = timers->__heaps[heap][0]->deadline;
+    if(ALARM_HORIZON_S < target - now){
+        target = now + ALARM_HORIZON_S;
+        if(HEAP_ALARM2 == heap){
+            target -= target % SECONDS_PER_MINUTE;
+        }
+    }
+    return target;
+}
+
+/**
+ * run every timer of both heaps that is due at now
+ */
+static void timers_dispatch(ds3231_timers_t* timers, int64_t now){
+    for(uint8_t heap = HEAP_ALARM1; heap <= HEAP_ALARM2; heap++){
+        while(0u < timers->__counts[heap] && now >= timers->__heaps[heap][0]->deadline){
+            ds3231_timer_t* timer = timers->__heaps[heap][0];
+            heap_remove(timers,timer);
+            if(0u != timer->period_s){
+                //skip expiries missed while the node was asleep or off
+                const int64_t missed = (now - timer->deadline) / timer->period_s;
+                const int64_t deadline = timer->deadline + (missed + 1) * (int64_t)timer->period_s;
+                timer->deadline = deadline;
+                //the next deadline may belong to the other alarm and find its heap full
+                if(DS3231_UNIX_TIME_MAX < deadline || !heap_insert(timers,timer)){
+                    timers->dropped += 1u;
+                }
+            }
+            timers->fired += 1u;
+            timer->cb(timer,timer->ctx);
+        }
+    }
+}
+
+/**
+ * nearest deadline held by an alarm, 0 if none
+ */
+static int64_t timers_earliest_armed(const ds3231_timers_t* timers){
+    int64_t earliest = 0;
+    for(uint8_t heap = HEAP_ALARM1; heap <= HEAP_ALARM2; heap++){
+        if(0 < timers->__armed[heap] && (0 == earliest || timers->__armed[heap] < earliest)){
+            earliest = timers->__armed[heap];
+        }
+    }
+    return earliest;
+}
+
+/**
+ * program the alarms whose target changed, both in one burst. an alarm that lost its last timer
+ * while the other is programmed is disabled by the same burst.
+ */
+static bool timers_arm(ds3231_timers_t* timers, int64_t now){
+    ds3231_time_data_t alarm_time[2] = {0};
+    ds3231_alarm1_options alarm1_options = DS3231_ALARM1_DAY_OF_MONTH_HOURS_MINUTES_SECONDS;
+    ds3231_alarm2_options alarm2_options = DS3231_ALARM2_DAY_OF_MONTH_HOURS_MINUTES;
+    bool program[2] = {false,false};
+    bool disable[2] = {false,false};
+    int64_t target[2] = {0,0};
+    for(uint8_t heap = HEAP_ALARM1; heap <= HEAP_ALARM2; heap++){
+        target[heap] = alarm_target(timers,heap,now);
+        if(target[heap] == timers->__armed[heap]){
+            continue;
+        }else if(0 == target[heap]){
+            disable[heap] = true;
+        }else{
+            //same hours format as the device, the alarm registers follow it
+            if(!ds3231_unix_to_time(target[heap],!timers->dev->__shadow_12_hours_f,&alarm_time[heap])){
+                return false;
+            }
+            program[heap] = true;
+        }
+    }
+    bool res = true;
+    if(program[HEAP_ALARM1] && program[HEAP_ALARM2]){
+        res = ds3231_set_alarms(timers->dev,&alarm_time[HEAP_ALARM1],&alarm1_options,&alarm_time[HEAP_ALARM2],&alarm2_options);
+    }else if(program[HEAP_ALARM1] || program[HEAP_ALARM2]){
+        const uint8_t heap = program[HEAP_ALARM1] ? HEAP_ALARM1 : HEAP_ALARM2;
+        const uint8_t other = (HEAP_ALARM1 == heap) ? HEAP_ALARM2 : HEAP_ALARM1;
+        if(disable[other]){
+            //ds3231_set_alarm clears the interrupt enable of the other alarm in the same write
+            res = ds3231_set_alarm(timers->dev,&alarm_time[heap],(HEAP_ALARM1 == heap) ? &alarm1_options : NULL,
+                                   (HEAP_ALARM2 == heap) ? &alarm2_options : NULL);
+            if(res){
+                timers->__armed[other] = 0;
+            }
+            disable[other] = false;
+        }else{
+            res = ds3231_set_alarms(timers->dev,
+                                    &alarm_time[HEAP_ALARM1],program[HEAP_ALARM1] ? &alarm1_options : NULL,
+                                    &alarm_time[HEAP_ALARM2],program[HEAP_ALARM2] ? &alarm2_options : NULL);
+        }
+    }
+    for(uint8_t heap = HEAP_ALARM1; heap <= HEAP_ALARM2; heap++){
+        if(program[heap]){
+            timers->__armed[heap] = res ? target[heap] : -1;
+        }
+    }
+    if(!res){
+        return false;
+    }
+    for(uint8_t heap = HEAP_ALARM1; heap <= HEAP_ALARM2; heap++){
+        if(disable[heap]){
+            if(!ds3231_disable_alarm(timers->dev,HEAP_ALARM2 == heap)){
+                return false;
+            }
+            timers->__armed[heap] = 0;
+        }
+    }
+    return true;
+}
+
+bool ds3231_timers_init(ds3231_timers_t* timers, ds3231_dev_t* dev){
+    if(NULL == timers || NULL == dev){
+        return false;
+    }else{
+        timers->dev = dev;
+        timers->__counts[HEAP_ALARM1] = 0u;
+        timers->__counts[HEAP_ALARM2] = 0u;
+        timers->__armed[HEAP_ALARM1] = -1;
+        timers->__armed[HEAP_ALARM2] = -1;
+        timers->fired = 0u;
+        timers->wakes = 0u;
+        timers->dropped = 0u;
+        return true;
+    }
+}
+
+bool ds3231_timer_start(ds3231_timers_t* timers, ds3231_timer_t* timer, int64_t deadline, uint32_t period_s,
+                        ds3231_timer_cb_t cb, void* ctx){
+    if(NULL == timers || NULL == timer || NULL == cb){
+        return false;
+    }else if(DS3231_UNIX_TIME_MIN > deadline || DS3231_UNIX_TIME_MAX < deadline){
+        return false;
+    }else{
+        if(0u != timer->__heap){
+            heap_remove(timers,timer);
+        }
+        timer->deadline = deadline;
+        timer->period_s = period_s;
+        timer->cb = cb;
+        timer->ctx = ctx;
+        return heap_insert(timers,timer);
+    }
+}
+
+bool ds3231_timer_stop(ds3231_timers_t* timers, ds3231_timer_t* timer){
+    if(NULL == timers || NULL == timer){
+        return false;
+    }else if(0u == timer->__heap){
+        return false;
+    }else{
+        heap_remove(timers,timer);
+        return true;
+    }
+}
+
+bool ds3231_timers_service(ds3231_timers_t* timers, int64_t* next_deadline){
+    if(NULL == timers || NULL == timers->dev){
+        return false;
+    }else{
+        int64_t now = 0;
+        if(!ds3231_get_unix_time(timers->dev,&now)){
+            return false;
+        }
+        for(uint8_t round = 0; round < SERVICE_ROUNDS; round++){
+            if((0 < timers->__armed[HEAP_ALARM1] && now >= timers->__armed[HEAP_ALARM1])
+                        || (0 < timers->__armed[HEAP_ALARM2] && now >= timers->__armed[HEAP_ALARM2])){
+                timers->wakes += 1u;
+            }
+            timers_dispatch(timers,now);
+            if(!timers_arm(timers,now)){
+                return false;
+            }
+            const int64_t earliest = timers_earliest_armed(timers);
+            if(0 == earliest || ALARM_MIN_LEAD_S < earliest - now){
+                break;
+            }
+            //armed for the next second, the write may have landed after the match
+            int64_t later = 0;
+            if(!ds3231_get_unix_time(timers->dev,&later)){
+                return false;
+            }else if(later < earliest){
+                break;
+            }
+            now = later;
+        }
+        if(NULL != next_deadline){
+            int64_t next = 0;
+            for(uint8_t heap = HEAP_ALARM1; heap <= HEAP_ALARM2; heap++){
+                if(0u < timers->__counts[heap] && (0 == next || timers->__heaps[heap][0]->deadline < next)){
+                    next = timers->__heaps[heap][0]->deadline;
+                }
+            }
+            *next_deadline = next;
+        }
+        return true;
+    }
+}
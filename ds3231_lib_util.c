@@ -26,7 +26,7 @@ static const uint8_t tm1637_symbol_table[10] = {
 
 
 bool ds3231_decimal_to_tm1637(uint8_t decimal_number,uint8_t* tm1637_number, uint8_t byte_size_tm1637,bool dot){
-    if(decimal_number > 99 || NULL == tm1637_number || 0x02u < byte_size_tm1637){
+    if(decimal_number > 99 || NULL == tm1637_number || 0x02u > byte_size_tm1637){
         return false;
     }else{
         uint8_t tens = 0;
@@ -42,4 +42,260 @@ bool ds3231_decimal_to_tm1637(uint8_t decimal_number,uint8_t* tm1637_number, uin
         }
         return true;
     }
-}
\ No newline at end of file
+}
+
+/**
+ * text formatting
+ */
+
+static const char two_digits[201] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+typedef struct{
+    char* buffer;
+    size_t size;
+    size_t length;
+    bool fit;
+}format_out_t;
+
+static void put_char(format_out_t* out, char c){
+    if(out->length + 1u < out->size){
+        out->buffer[out->length] = c;
+        out->length += 1u;
+    }else{
+        out->fit = false;
+    }
+}
+
+static void put_two(format_out_t* out, uint8_t value){
+    put_char(out,two_digits[2u * value]);
+    put_char(out,two_digits[2u * value + 1u]);
+}
+
+static uint8_t hours_24(const ds3231_time_data_t* time_data){
+    if(time_data->is_12_hours_format){
+        return (uint8_t)(time_data->hours % 12u + (time_data->pm ? 12u : 0u));
+    }else{
+        return time_data->hours;
+    }
+}
+
+/** fields that index the digit table must stay below 100 */
+static bool format_valid(const ds3231_time_data_t* time_data){
+    if(time_data->is_12_hours_format && (1u > time_data->hours || 12u < time_data->hours)){
+        return false;
+    }else if(!time_data->is_12_hours_format && 23u < time_data->hours){
+        return false;
+    }else{
+        return 59u >= time_data->seconds && 59u >= time_data->minutes
+            && 1u <= time_data->day_of_month && 31u >= time_data->day_of_month
+            && 1u <= time_data->month && 12u >= time_data->month
+            && 99u >= time_data->year && 1u <= time_data->day_of_week && 7u >= time_data->day_of_week;
+    }
+}
+
+static void put_date_time(format_out_t* out, const ds3231_time_data_t* time_data){
+    put_two(out,time_data->century ? 21u : 20u);
+    put_two(out,time_data->year);
+    put_char(out,'-');
+    put_two(out,time_data->month);
+    put_char(out,'-');
+    put_two(out,time_data->day_of_month);
+    put_char(out,'T');
+    put_two(out,hours_24(time_data));
+    put_char(out,':');
+    put_two(out,time_data->minutes);
+    put_char(out,':');
+    put_two(out,time_data->seconds);
+}
+
+static bool format_end(format_out_t* out, size_t* length){
+    if(!out->fit){
+        out->length = 0u;
+    }
+    out->buffer[out->length] = '\0';
+    if(NULL != length){
+        *length = out->length;
+    }
+    return out->fit;
+}
+
+bool ds3231_format_iso8601(const ds3231_time_data_t* time_data, char* buffer, size_t size, size_t* length){
+    if(NULL == time_data || NULL == buffer || 0u == size){
+        return false;
+    }else{
+        format_out_t out = {.buffer = buffer, .size = size, .length = 0u, .fit = format_valid(time_data)};
+        if(out.fit){
+            put_date_time(&out,time_data);
+        }
+        return format_end(&out,length);
+    }
+}
+
+bool ds3231_format_rfc3339(const ds3231_time_data_t* time_data, int16_t offset_minutes,
+                           char* buffer, size_t size, size_t* length){
+    if(NULL == time_data || NULL == buffer || 0u == size){
+        return false;
+    }else{
+        format_out_t out = {.buffer = buffer, .size = size, .length = 0u,
+                            .fit = format_valid(time_data) && -1439 <= offset_minutes && 1439 >= offset_minutes};
+        if(out.fit){
+            put_date_time(&out,time_data);
+            if(0 == offset_minutes){
+                put_char(&out,'Z');
+            }else{
+                const uint16_t offset = (uint16_t)((0 > offset_minutes) ? -offset_minutes : offset_minutes);
+                put_char(&out,(0 > offset_minutes) ? '-' : '+');
+                put_two(&out,(uint8_t)(offset / 60u));
+                put_char(&out,':');
+                put_two(&out,(uint8_t)(offset % 60u));
+            }
+        }
+        return format_end(&out,length);
+    }
+}
+
+bool ds3231_format_hhmmss(const ds3231_time_data_t* time_data, char* buffer, size_t size, size_t* length){
+    if(NULL == time_data || NULL == buffer || 0u == size){
+        return false;
+    }else{
+        format_out_t out = {.buffer = buffer, .size = size, .length = 0u, .fit = format_valid(time_data)};
+        if(out.fit){
+            put_two(&out,hours_24(time_data));
+            put_two(&out,time_data->minutes);
+            put_two(&out,time_data->seconds);
+        }
+        return format_end(&out,length);
+    }
+}
+
+bool ds3231_format(const ds3231_time_data_t* time_data, const char* pattern, char* buffer, size_t size, size_t* length){
+    if(NULL == time_data || NULL == pattern || NULL == buffer || 0u == size){
+        return false;
+    }else{
+        format_out_t out = {.buffer = buffer, .size = size, .length = 0u, .fit = format_valid(time_data)};
+        const uint8_t hours = hours_24(time_data);
+        for(const char* c = pattern; out.fit && '\0' != *c; c++){
+            if('%' != *c){
+                put_char(&out,*c);
+                continue;
+            }
+            c++;
+            switch(*c){
+                case 'Y':
+                    put_two(&out,time_data->century ? 21u : 20u);
+                    put_two(&out,time_data->year);
+                    break;
+                case 'y':
+                    put_two(&out,time_data->year);
+                    break;
+                case 'm':
+                    put_two(&out,time_data->month);
+                    break;
+                case 'd':
+                    put_two(&out,time_data->day_of_month);
+                    break;
+                case 'H':
+                    put_two(&out,hours);
+                    break;
+                case 'I':
+                    put_two(&out,(0u == hours % 12u) ? 12u : hours % 12u);
+                    break;
+                case 'p':
+                    put_char(&out,(12u <= hours) ? 'P' : 'A');
+                    put_char(&out,'M');
+                    break;
+                case 'M':
+                    put_two(&out,time_data->minutes);
+                    break;
+                case 'S':
+                    put_two(&out,time_data->seconds);
+                    break;
+                case 'u':
+                    put_char(&out,(char)('0' + time_data->day_of_week));
+                    break;
+                case '%':
+                    put_char(&out,'%');
+                    break;
+                default:
+                    //unknown conversion or a trailing %
+                    out.fit = false;
+                    break;
+            }
+        }
+        return format_end(&out,length);
+    }
+}
+
+
+/**
+ * tm1637 clock frames
+ */
+
+bool ds3231_tm1637_init(ds3231_tm1637_t* display, ds3231_tm1637_layout layout, bool use_24_hours,
+                        bool suppress_leading_zero, bool blink_colon){
+    if(NULL == display || DS3231_TM1637_MM_SS < layout){
+        return false;
+    }else{
+        display->layout = layout;
+        display->use_24_hours = use_24_hours;
+        display->suppress_leading_zero = suppress_leading_zero;
+        display->blink_colon = blink_colon;
+        for(uint8_t i = 0; i < DS3231_TM1637_DIGITS; i++){
+            display->__frame[i] = 0u;
+        }
+        display->__valid_f = false;
+        return true;
+    }
+}
+
+bool ds3231_tm1637_update(ds3231_tm1637_t* display, const ds3231_time_data_t* time_data,
+                          uint8_t* frame, uint8_t* changed_mask){
+    if(NULL == display || NULL == time_data || NULL == changed_mask){
+        return false;
+    }else if(time_data->is_12_hours_format ? (1u > time_data->hours || 12u < time_data->hours) : 23u < time_data->hours){
+        return false;
+    }else if(59u < time_data->minutes || 59u < time_data->seconds){
+        return false;
+    }
+    uint8_t left = time_data->minutes;
+    uint8_t right = time_data->seconds;
+    if(DS3231_TM1637_HH_MM == display->layout){
+        const uint8_t hours = hours_24(time_data);
+        left = display->use_24_hours ? hours : (uint8_t)((0u == hours % 12u) ? 12u : hours % 12u);
+        right = time_data->minutes;
+    }
+    const bool colon = !display->blink_colon || 0u == (time_data->seconds & 0x01u);
+    uint8_t next[DS3231_TM1637_DIGITS];
+    ds3231_decimal_to_tm1637(left,&next[0],2u,colon);
+    ds3231_decimal_to_tm1637(right,&next[2],2u,false);
+    if(display->suppress_leading_zero && 10u > left){
+        next[0] = 0u;
+    }
+    uint8_t mask = 0u;
+    for(uint8_t i = 0; i < DS3231_TM1637_DIGITS; i++){
+        if(!display->__valid_f || next[i] != display->__frame[i]){
+            mask |= (uint8_t)(1u << i);
+        }
+        display->__frame[i] = next[i];
+        if(NULL != frame){
+            frame[i] = next[i];
+        }
+    }
+    display->__valid_f = true;
+    *changed_mask = mask;
+    return true;
+}
+
+bool ds3231_tm1637_invalidate(ds3231_tm1637_t* display){
+    if(NULL == display){
+        return false;
+    }else{
+        display->__valid_f = false;
+        return true;
+    }
+}
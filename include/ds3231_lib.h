@@ -2,10 +2,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "ds3231_lib_config.h"
-
-#ifdef CONFIG_USE_UTIL
-#include "ds3231_lib_util.h"
-#endif
+#include "ds3231_lib_epoch.h"
 
 /**
  * TODO: 1. seperate config file
@@ -32,22 +29,162 @@ typedef struct{
   bool is_12_hours_format;
   /**flag for PM/AM in 12 hours format */
   bool pm;
+  /** century bit of the month register: false for 20xx, true for 21xx. set by the chip when year rolls over from 99 */
+  bool century;
 }ds3231_time_data_t;
 
 
+typedef enum{
+  DS3231_STATS_OP_READ,
+  DS3231_STATS_OP_WRITE,
+  DS3231_STATS_OP_COUNT
+}ds3231_stats_op;
+
+typedef enum{
+  DS3231_STATS_STATUS_OK,
+  DS3231_STATS_STATUS_NACK,
+  DS3231_STATS_STATUS_TIMEOUT,
+  DS3231_STATS_STATUS_ERROR
+}ds3231_stats_status;
+
+#ifdef CONFIG_USE_STATS
+/** log2 latency buckets. bucket 0 counts transfers under 1us, bucket n counts [2^(n-1), 2^n) us, the last one everything above */
+#define DS3231_STATS_LATENCY_BUCKETS 20
+
+typedef struct{
+  uint32_t reads;
+  uint32_t writes;
+  uint32_t bytes_read;
+  uint32_t bytes_written;
+  uint32_t nacks;
+  uint32_t timeouts;
+  /** failures other than nack and timeout */
+  uint32_t errors;
+  /** slowest transfer per ds3231_stats_op */
+  uint32_t max_latency_us[DS3231_STATS_OP_COUNT];
+  uint32_t latency_histogram[DS3231_STATS_OP_COUNT][DS3231_STATS_LATENCY_BUCKETS];
+}ds3231_stats_t;
+#endif
+
+/**
+ * transfer timeout, retry and bus recovery policy of a device, see ds3231_set_policy.
+ * the timeout of a transfer is its wire time at scl_speed_hz times timeout_factor plus timeout_margin_us.
+ * a failed transfer is retried after a back off that doubles from backoff_us up to backoff_max_us.
+ */
+typedef struct{
+  /** scl frequency the timeouts are derived from */
+  uint32_t scl_speed_hz;
+  /** wire time multiplier covering clock stretching and arbitration, at least 1 */
+  uint8_t timeout_factor;
+  /** added to every timeout for driver and scheduling overhead */
+  uint32_t timeout_margin_us;
+  /** attempts after the first one */
+  uint8_t retries;
+  /** back off before the first retry */
+  uint32_t backoff_us;
+  /** back off limit */
+  uint32_t backoff_max_us;
+  /** failed attempts of a transfer after which the bus is recovered (9 scl clocks and a stop) before retrying, 0 never.
+   * a port that can't recover the bus fails the transfer there */
+  uint8_t recover_after;
+}ds3231_policy_t;
+
+/** mux channel of a device that is not behind a mux */
+#define DS3231_BUS_NO_MUX 0xFFu
+/** mux routing of a bus is not known, e.g. after a failed control write or a bus recovery */
+#define DS3231_BUS_MUX_UNKNOWN 0xFEu
+
+#ifndef DS3231_BUS_POOL_SIZE
+/** shared buses initialized at once. the port takes their locks from a static pool of this size, nothing is allocated */
+#define DS3231_BUS_POOL_SIZE 2
+#endif
+
+/**
+ * i2c bus shared by several devices, see ds3231_bus_init.
+ * transfers of the attached devices are serialized by a recursive lock and routed through
+ * an optional TCA9548A style mux, so several ds3231 (same address) can sit on one port.
+ */
+typedef struct{
+    #ifdef CONFIG_USE_I2C_BUS
+    void * i2c_bus;
+    /** port device handle of the mux */
+    void * __mux_dev;
+    #endif
+    #ifdef CONFIG_USE_I2C_PORT
+    int32_t i2c_port;
+    #endif
+    #ifdef CONFIG_USE_I2C_FD
+    int32_t i2c_fd;
+    /** I2C_FUNCS of the adapter */
+    uint32_t __i2c_funcs;
+    /** adapter timeout last set with I2C_TIMEOUT, in its 10ms steps */
+    uint32_t __i2c_timeout;
+    #endif
+    uint32_t i2c_sda_num;
+    uint32_t i2c_scl_num;
+    /** port recursive lock, an entry of the port's static pool */
+    void * __lock;
+    /** 7 bit address of the mux, 0 without a mux */
+    uint8_t mux_address;
+    /** channel the mux currently routes, DS3231_BUS_MUX_UNKNOWN when unknown */
+    uint8_t __mux_channel;
+    /** number of attached devices */
+    uint8_t __devices;
+    /** first device of the next sweep */
+    uint8_t __sweep_start;
+    bool __i2c_init_f;
+}ds3231_bus_t;
+
+/**
+ * the port keeps its handles inside the device, init and deinit never allocate.
+ * an initialized device must not be copied or moved, i2c_bus and i2c_dev point into it.
+ */
 typedef struct{
     #ifdef CONFIG_USE_I2C_BUS
     void * i2c_bus;
+    /** storage of the port bus handle i2c_bus points to when the port created the bus */
+    void * __i2c_bus_handle;
     #endif
     #ifdef CONFIG_USE_I2C_DEVICE
     void * i2c_dev;
+    /** storage of the port device handle i2c_dev points to when the port created the device */
+    void * __i2c_dev_handle;
     #endif
     #ifdef CONFIG_USE_I2C_PORT
     int32_t i2c_port;
     #endif
+    #ifdef CONFIG_USE_I2C_FD
+    int32_t i2c_fd;
+    /** I2C_FUNCS of the adapter */
+    uint32_t __i2c_funcs;
+    /** adapter timeout last set with I2C_TIMEOUT, in its 10ms steps */
+    uint32_t __i2c_timeout;
+    #endif
     uint32_t i2c_sda_num;
     uint32_t i2c_scl_num;
+    /** shared bus the device is attached to, NULL when the device owns its bus. see ds3231_bus_attach */
+    ds3231_bus_t* bus;
+    /** mux channel of the device on a shared bus, DS3231_BUS_NO_MUX if not behind a mux */
+    uint8_t mux_channel;
+    /** see ds3231_set_policy */
+    ds3231_policy_t __policy;
     bool __i2c_init_f;
+    /** write-through copy of registers 0x07-0x10 (alarms, control, status, aging offset). see ds3231_shadow_resync */
+    uint8_t __shadow_regs[10];
+    /** 12/24 hours mode of REG_HOURS, valid with the shadow */
+    bool __shadow_12_hours_f;
+    bool __shadow_f;
+    /** registers 0x00-0x12 staged by an open transaction. see ds3231_txn_begin */
+    uint8_t __txn_regs[0x13];
+    uint32_t __txn_dirty;
+    uint8_t __txn_status_clear;
+    uint8_t __txn_control_set;
+    /** writes staged by the open transaction, saturates */
+    uint32_t __txn_writes;
+    bool __txn_f;
+    #ifdef CONFIG_USE_STATS
+    ds3231_stats_t __stats;
+    #endif
 }ds3231_dev_t;
 
 
@@ -58,6 +195,14 @@ typedef enum{
   DS3231_SQW_8192HZ
 }ds3231_sqw_frequecy;
 
+/** REG_STATUS bits returned by ds3231_poll_events, combine with | */
+typedef enum{
+  DS3231_FLAG_A1F = 0x01,
+  DS3231_FLAG_A2F = 0x02,
+  DS3231_FLAG_BSY = 0x04,
+  DS3231_FLAG_OSF = 0x80
+}ds3231_status_flag;
+
 
 typedef enum{
   DS3231_ALARM1_DAY_OF_MONTH_HOURS_MINUTES_SECONDS = 0x00,
@@ -77,6 +222,38 @@ typedef enum{
   DS3231_ALARM2_DAY_OF_WEEK_HOURS_MINUTES = 0x08,
 }ds3231_alarm2_options;
 
+/**
+ * decoded copy of the whole register file (0x00-0x12), see ds3231_read_snapshot
+ */
+typedef struct{
+  ds3231_time_data_t time;
+  ds3231_time_data_t alarm1;
+  ds3231_alarm1_options alarm1_options;
+  /** false if the alarm1 mask bits are not a valid ds3231_alarm1_options, alarm1 and alarm1_options are zeroed then */
+  bool alarm1_valid;
+  ds3231_time_data_t alarm2;
+  ds3231_alarm2_options alarm2_options;
+  /** false if the alarm2 mask bits are not a valid ds3231_alarm2_options, alarm2 and alarm2_options are zeroed then */
+  bool alarm2_valid;
+  /** raw control register */
+  uint8_t control;
+  /** raw status register */
+  uint8_t status;
+  bool alarm1_enabled;
+  bool alarm2_enabled;
+  bool alarm1_flag;
+  bool alarm2_flag;
+  bool oscillator_stopped;
+  /** temperature conversion in progress */
+  bool busy;
+  /** aging offset in two's complement */
+  int8_t aging_offset;
+  /** integer part of the temperature */
+  int8_t temperature;
+  /** fractional part of the temperature in 0.25 steps (0..3) */
+  uint8_t temperature_fraction;
+}ds3231_snapshot_t;
+
 /**
  * public API not dependent on microcontroller type
  */
@@ -111,6 +288,81 @@ bool ds3231_set_time(ds3231_dev_t* dev, bool use_24_format,
 bool ds3231_get_time(ds3231_dev_t* dev,
                       ds3231_time_data_t* time_data);
 
+/**
+ * @brief decode the 7 time registers (0x00-0x06) as read from the chip, no bus traffic.
+ * @param [regs][in] the registers starting at the seconds register
+ * @param [time_data][out] a pointer to ds3231_time_data_t
+ */
+bool ds3231_decode_time(const uint8_t* regs, ds3231_time_data_t* time_data);
+
+/**
+ * @brief wait for the next seconds rollover and read the time that just started.
+ * a coarse poll of the seconds register finds one rollover, the read then sleeps until just
+ * before the next one and polls back to back. blocks up to about two seconds.
+ * @param [dev][in] a pointer to ds3231_dev_t
+ * @param [time_data][out] a pointer to ds3231_time_data_t
+ * @param [edge_ns][out] monotonic time of the rollover as counted by the port. can be NULL.
+ * @param [error_bound_ns][out] the rollover happened within edge_ns +- error_bound_ns. can be NULL.
+ * @returns true on success false on fail or if the oscillator is stopped
+ */
+bool ds3231_get_time_aligned(ds3231_dev_t* dev, ds3231_time_data_t* time_data,
+                             uint64_t* edge_ns, uint32_t* error_bound_ns);
+
+/**
+ * @brief set the time so that its second starts at a given monotonic time.
+ * writing the seconds register restarts the second, so the write is timed to land on start_ns.
+ * the oscillator stop flag is cleared first and a read of the same registers measures the
+ * transport latency, the write is centered on start_ns. the clock is only written once, a fail
+ * before that write leaves it untouched.
+ * @param [dev][in] a pointer to ds3231_dev_t
+ * @param [use_24_format][in] true for 24 hours mode
+ * @param [time_data][in] the time of the second starting at start_ns
+ * @param [start_ns][in] monotonic time as counted by the port. must leave room for three transactions.
+ * @param [error_bound_ns][out] the new second started within start_ns +- error_bound_ns. can be NULL.
+ * @returns true on success false on fail, if start_ns is too close or inside a transaction
+ */
+bool ds3231_set_time_aligned(ds3231_dev_t* dev, bool use_24_format, ds3231_time_data_t* time_data,
+                             uint64_t start_ns, uint32_t* error_bound_ns);
+
+
+/**
+ * @brief convert a time to seconds since 1970-01-01 00:00:00, no bus traffic.
+ * year and century select 2000-2199, 12 hours format is taken into account.
+ * day_of_month is checked against the month length as the chip counts it (every fourth year is a
+ * leap year), so 2100-02-29 is taken and converts to 2100-03-01.
+ * @param [time_data][in] a pointer to ds3231_time_data_t
+ * @param [unix_time][out] a pointer to int64_t
+ * @returns true on success false if a field is out of range or the day is past the end of the month
+ */
+bool ds3231_time_to_unix(const ds3231_time_data_t* time_data, int64_t* unix_time);
+
+/**
+ * @brief convert seconds since 1970-01-01 00:00:00 to a time, no bus traffic.
+ * day_of_week is set to the iso day of week, 1 = monday .. 7 = sunday.
+ * @param [unix_time][in] must be in the range DS3231_UNIX_TIME_MIN-DS3231_UNIX_TIME_MAX
+ * @param [use_24_format][in] true for 24 hours format, false for 12 hours format with pm
+ * @param [time_data][out] a pointer to ds3231_time_data_t
+ * @returns true on success false if unix_time is out of range
+ */
+bool ds3231_unix_to_time(int64_t unix_time, bool use_24_format, ds3231_time_data_t* time_data);
+
+/**
+ * @brief get the time from ds3231 as seconds since 1970-01-01 00:00:00, in a single burst read.
+ * the chip takes every fourth year as leap year, so 2100-02-29 reads as 2100-03-01.
+ * @param [dev][in] a pointer to ds3231_dev_t
+ * @param [unix_time][out] a pointer to int64_t
+ * @returns true on success false on fail
+ */
+bool ds3231_get_unix_time(ds3231_dev_t* dev, int64_t* unix_time);
+
+/**
+ * @brief set the time in ds3231 from seconds since 1970-01-01 00:00:00, see ds3231_set_time.
+ * @param [dev][in] a pointer to ds3231_dev_t
+ * @param [unix_time][in] must be in the range DS3231_UNIX_TIME_MIN-DS3231_UNIX_TIME_MAX
+ * @param [use_24_format][in] true for 24 hours mode
+ * @returns true on success false on fail
+ */
+bool ds3231_set_unix_time(ds3231_dev_t* dev, int64_t unix_time, bool use_24_format);
 
 /**
  * @brief get the hours mode 12/24 
@@ -135,6 +387,33 @@ bool ds3231_is_12_hours_mode(ds3231_dev_t* dev,bool* is_12);
  */
 bool ds3231_get_temperature(ds3231_dev_t*dev, int8_t* number,uint8_t* fraction);
 
+/**
+ * @brief start a temperature conversion by setting CONV. CONV clears itself when the new
+ * temperature is in 0x11-0x12 (up to 200ms). check BSY first, CONV can't start while the
+ * automatic conversion is running. see ds3231_temp_convert for the whole sequence.
+ * @param [dev][in] a pointer to ds3231_dev_t
+ * @returns true on success false on fail
+ */
+bool ds3231_start_temperature_conversion(ds3231_dev_t* dev);
+
+/**
+ * @brief decode the 2 temperature registers (0x11-0x12) as read from the chip, no bus traffic.
+ * @param [regs][in] the registers starting at the temperature msb
+ * @param [number][out] integer part, see ds3231_get_temperature
+ * @param [fraction][out] fractional part in 0.25 steps, see ds3231_get_temperature
+ */
+bool ds3231_decode_temperature(const uint8_t* regs, int8_t* number, uint8_t* fraction);
+
+/**
+ * @brief read the whole register file (0x00-0x12) in a single burst and decode it.
+ * replaces separate ds3231_get_time, ds3231_get_alarm, ds3231_get_temperature and
+ * ds3231_get_oscillator_stop_flag calls. refreshes the register shadow if it is enabled.
+ * @param [dev][in] a pointer to ds3231_dev_t
+ * @param [snapshot][out] a pointer to ds3231_snapshot_t
+ * @returns true on success false on fail
+ */
+bool ds3231_read_snapshot(ds3231_dev_t* dev, ds3231_snapshot_t* snapshot);
+
 /**
  * @brief set alarm according to time_data in ds3231_dev_t. 
  * @param [dev] a pointer to ds3231_dev_t
@@ -147,6 +426,21 @@ bool ds3231_set_alarm(ds3231_dev_t* dev, ds3231_time_data_t* time_data,
                       ds3231_alarm2_options* alarm2_options);
 
 
+/**
+ * @brief program alarm1, alarm2 or both in a single burst write covering the alarm,
+ * control and status registers. enables the interrupt of each programmed alarm and clears its flag.
+ * unlike ds3231_set_alarm the interrupt enable of an alarm that is not programmed is left untouched.
+ * costs one write with a valid register shadow, otherwise one read and one write.
+ * @param [dev][in] a pointer to ds3231_dev_t
+ * @param [alarm1_time][in] a pointer to ds3231_time_data_t. NULL if ONCE_PER_SECOND is used or alarm1 is not programmed.
+ * @param [alarm1_options][in] a pointer to ds3231_alarm1_options. NULL to leave alarm1 untouched.
+ * @param [alarm2_time][in] a pointer to ds3231_time_data_t. NULL if ONCE_PER_MINUTE is used or alarm2 is not programmed.
+ * @param [alarm2_options][in] a pointer to ds3231_alarm2_options. NULL to leave alarm2 untouched.
+ * @returns true on success false on fail
+ */
+bool ds3231_set_alarms(ds3231_dev_t* dev,
+                       ds3231_time_data_t* alarm1_time, ds3231_alarm1_options* alarm1_options,
+                       ds3231_time_data_t* alarm2_time, ds3231_alarm2_options* alarm2_options);
 /**
  * @brief get alarm1/alarm2 data.does not indicate if alarm is enabled, 
  * only used to show it's trigger settings
@@ -182,6 +476,18 @@ bool ds3231_enable_alarm(ds3231_dev_t* dev, bool alarm2);
  */
 bool ds3231_clear_alarm_flag(ds3231_dev_t* dev, bool alarm2);
 
+/**
+ * @brief service a wake up in two transactions: read REG_STATUS once and clear the requested flags
+ * that were set with one write. the flags not cleared are written as 1, so a flag set by the chip
+ * between the read and the write survives. no write is done when nothing needs clearing.
+ * replaces ds3231_get_oscillator_stop_flag, ds3231_clear_oscillator_stop_flag and ds3231_clear_alarm_flag.
+ * @param [dev][in] a pointer to ds3231_dev_t
+ * @param [clear_mask][in] DS3231_FLAG_A1F, DS3231_FLAG_A2F and DS3231_FLAG_OSF to clear, 0 to only read. BSY is read only.
+ * @param [flags][out] the ds3231_status_flag bits set at the read. can be NULL.
+ * @returns true on success false on fail
+ */
+bool ds3231_poll_events(ds3231_dev_t* dev, uint8_t clear_mask, uint8_t* flags);
+
 
 
 /**
@@ -215,6 +521,24 @@ bool ds3231_enable_32khz_output(ds3231_dev_t* dev);
 bool ds3231_disable_32khz_output(ds3231_dev_t* dev);
 
 
+/**
+ * @brief get the aging offset (0x10). served from the register shadow when it is valid,
+ * a value staged by an open transaction is returned either way.
+ * @param [dev][in] a pointer to ds3231_dev_t
+ * @param [aging_offset][out] two's complement, positive values slow the oscillator by about 0.1ppm per LSB at 25C
+ * @returns true on success false on fail
+ */
+bool ds3231_get_aging_offset(ds3231_dev_t* dev, int8_t* aging_offset);
+
+/**
+ * @brief set the aging offset (0x10). it is applied at the next temperature conversion,
+ * see ds3231_start_temperature_conversion. ds3231_calib_apply computes it from measured drift.
+ * @param [dev][in] a pointer to ds3231_dev_t
+ * @param [aging_offset][in] two's complement, positive values slow the oscillator
+ * @returns true on success false on fail
+ */
+bool ds3231_set_aging_offset(ds3231_dev_t* dev, int8_t aging_offset);
+
 /**
  * enable rtc internal oscillator
  */
@@ -227,10 +551,175 @@ bool ds3231_disable_oscillator(ds3231_dev_t* dev);
 
 
 /**
- * deinitialize i2c driver
+ * @brief read the hours mode, alarm, control, status and aging offset registers in one burst and
+ * enable the register shadow. while the shadow is valid configuration calls cost a single
+ * write and skip the write when the register already holds the requested value.
+ * alarm/oscillator stop flags, BSY and CONV are never served from the shadow.
+ * call again after anything other than this driver may have written the registers.
+ * @param [dev][in] a pointer to ds3231_dev_t
+ * @returns true on success false on fail. the shadow is disabled on fail.
  */
-bool ds3231_deinit(ds3231_dev_t* dev);
+bool ds3231_shadow_resync(ds3231_dev_t* dev);
+
+/**
+ * @brief disable the register shadow. configuration calls go back to read-modify-write.
+ * the shadow is also invalidated by ds3231_init, ds3231_deinit and by any failed write.
+ * @param [dev][in] a pointer to ds3231_dev_t
+ */
+bool ds3231_shadow_invalidate(ds3231_dev_t* dev);
+
+
+/**
+ * @brief open a transaction. until ds3231_txn_commit every register write issued by the
+ * configuration, alarm and time setting calls is staged in memory instead of sent.
+ * reads still go to the bus, read-modify-write sees the staged values.
+ * combine with ds3231_shadow_resync to make the staged calls free of bus traffic.
+ * @param [dev][in] a pointer to ds3231_dev_t
+ * @returns true on success false if a transaction is already open
+ */
+bool ds3231_txn_begin(ds3231_dev_t* dev);
+
+/**
+ * @brief flush the staged registers, merging adjacent registers into a single burst write each.
+ * @param [dev][in] a pointer to ds3231_dev_t
+ * @param [saved_transactions][out] number of bus writes saved compared to running the calls
+ * without a transaction, saturates at 255. can be NULL.
+ * @returns true on success false on fail. the transaction is closed either way.
+ */
+bool ds3231_txn_commit(ds3231_dev_t* dev, uint8_t* saved_transactions);
+
+/**
+ * @brief drop the staged registers without writing them. invalidates the register shadow.
+ * @param [dev][in] a pointer to ds3231_dev_t
+ */
+bool ds3231_txn_abort(ds3231_dev_t* dev);
+
+
+#ifdef CONFIG_USE_STATS
+/**
+ * @brief copy the transfer counters and latency histograms of the device.
+ * counters are updated by the transport layer on every transfer, including failed ones.
+ * @param [dev][in] a pointer to ds3231_dev_t
+ * @param [stats][out] a pointer to ds3231_stats_t
+ */
+bool ds3231_get_stats(ds3231_dev_t* dev, ds3231_stats_t* stats);
+
+/**
+ * @brief zero the transfer counters and latency histograms of the device.
+ * @param [dev][in] a pointer to ds3231_dev_t
+ */
+bool ds3231_reset_stats(ds3231_dev_t* dev);
+#endif
+
+
+/**
+ * @brief fill in the policy ds3231_init and ds3231_bus_attach start with:
+ * 400 kHz, 4 times the wire time plus 2ms, 2 retries backing off 0.5ms up to 4ms, bus recovery after 2 failed attempts.
+ * @param [policy][out] a pointer to ds3231_policy_t
+ */
+bool ds3231_default_policy(ds3231_policy_t* policy);
+
+/**
+ * @brief set the timeout, retry and recovery policy of a device. applies from the next transfer.
+ * @param [dev][in] a pointer to ds3231_dev_t
+ * @param [policy][in] a pointer to ds3231_policy_t, copied
+ * @returns true on success false on an invalid policy (no speed, factor 0, backoff_max_us below backoff_us)
+ */
+bool ds3231_set_policy(ds3231_dev_t* dev, const ds3231_policy_t* policy);
+
+/**
+ * @brief get the policy of a device.
+ * @param [dev][in] a pointer to ds3231_dev_t
+ * @param [policy][out] a pointer to ds3231_policy_t
+ */
+bool ds3231_get_policy(ds3231_dev_t* dev, ds3231_policy_t* policy);
+
+/**
+ * @brief worst case time one transfer can take under a policy, every attempt timing out
+ * and every back off and recovery taken. timeouts are rounded up as the port applies them.
+ * excludes waiting for the lock of a shared bus and the mux, see ds3231_worst_case_us.
+ * @param [policy][in] a pointer to ds3231_policy_t
+ * @param [op][in] DS3231_STATS_OP_READ or DS3231_STATS_OP_WRITE
+ * @param [byte_length][in] number of registers
+ * @param [us][out] the bound in microseconds
+ */
+bool ds3231_policy_worst_case_us(const ds3231_policy_t* policy, ds3231_stats_op op, uint8_t byte_length, uint32_t* us);
+
+/**
+ * @brief worst case time one transfer of a device can take: ds3231_policy_worst_case_us of its policy,
+ * behind a mux plus the control writes before the first attempt and after every recovery.
+ * excludes waiting for the lock of a shared bus.
+ * @param [dev][in] a pointer to ds3231_dev_t
+ * @param [op][in] DS3231_STATS_OP_READ or DS3231_STATS_OP_WRITE
+ * @param [byte_length][in] number of registers
+ * @param [us][out] the bound in microseconds
+ */
+bool ds3231_worst_case_us(ds3231_dev_t* dev, ds3231_stats_op op, uint8_t byte_length, uint32_t* us);
+
+/**
+ * @brief create a bus shared by several devices: the port, its lock and the mux if mux_address is set.
+ * @param [bus][in] a pointer to ds3231_bus_t
+ * @param [i2c_sda_num][in] sda pin
+ * @param [i2c_scl_num][in] scl pin
+ * @param [i2c_port][in] i2c port
+ * @param [mux_address][in] 7 bit address of a TCA9548A style mux (0x70-0x77), 0 without a mux
+ * @returns true on success false on fail, e.g. once DS3231_BUS_POOL_SIZE buses are initialized.
+ * nothing is left behind on fail.
+ */
+bool ds3231_bus_init(ds3231_bus_t* bus, uint32_t i2c_sda_num, uint32_t i2c_scl_num,
+                     int32_t i2c_port, uint8_t mux_address);
+
+/**
+ * @brief attach a device to a bus, replaces ds3231_init. detach with ds3231_deinit.
+ * @param [dev][in] a pointer to ds3231_dev_t
+ * @param [bus][in] a pointer to an initialized ds3231_bus_t
+ * @param [mux_channel][in] mux channel (0-7) the device sits behind, DS3231_BUS_NO_MUX if none
+ * @returns true on success false on fail
+ */
+bool ds3231_bus_attach(ds3231_dev_t* dev, ds3231_bus_t* bus, uint8_t mux_channel);
+
+/**
+ * @brief take the bus lock to run several calls on devices of the bus without other tasks in between.
+ * the lock is recursive, every transfer takes it as well.
+ * @param [bus][in] a pointer to ds3231_bus_t
+ */
+bool ds3231_bus_lock(ds3231_bus_t* bus);
+
+/**
+ * @brief release the bus lock taken with ds3231_bus_lock.
+ * @param [bus][in] a pointer to ds3231_bus_t
+ */
+bool ds3231_bus_unlock(ds3231_bus_t* bus);
+
+/**
+ * @brief read the time registers of several devices of the bus in one locked sweep.
+ * the first device rotates between sweeps so every device gets its turn at the start of the window.
+ * @param [bus][in] a pointer to ds3231_bus_t
+ * @param [devs][in] devices attached to the bus
+ * @param [count][in] number of devices
+ * @param [times][out] count times, in the order of devs
+ * @param [read_ns][out] count monotonic midpoints of each read, in the order of devs. can be NULL.
+ * @param [valid][out] count flags, false for a device whose read failed. can be NULL.
+ * @param [sweep_ns][out] time from the start of the first read to the end of the last. can be NULL.
+ * @returns true if every read succeeded false otherwise
+ */
+bool ds3231_bus_sweep_time(ds3231_bus_t* bus, ds3231_dev_t** devs, uint8_t count,
+                           ds3231_time_data_t* times, uint64_t* read_ns, bool* valid, uint32_t* sweep_ns);
 
+/**
+ * @brief release the bus. fails while devices are attached.
+ * @param [bus][in] a pointer to ds3231_bus_t
+ */
+bool ds3231_bus_deinit(ds3231_bus_t* bus);
 
 
+/**
+ * deinitialize i2c driver
+ */
+bool ds3231_deinit(ds3231_dev_t* dev);
+
 
+//the formatters take ds3231_time_data_t, included once it is defined
+#ifdef CONFIG_USE_UTIL
+#include "ds3231_lib_util.h"
+#endif
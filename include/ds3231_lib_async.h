@@ -0,0 +1,158 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "ds3231_lib.h"
+
+/**
+ * asynchronous driver API (ds3231_lib_async.c).
+ * calls are queued into a fixed capacity ring and executed by ds3231_async_poll, called from a
+ * worker task or thread. one task enqueues and one worker polls, no locks are taken.
+ * queued reads up to a few registers apart are merged into one burst read, queued writes to
+ * consecutive registers into one burst write. results are delivered through a completion
+ * callback (run by the worker), a future, or both.
+ * while a queue is in use only its worker may access the device.
+ */
+
+#ifndef DS3231_ASYNC_QUEUE_SIZE
+/** capacity of the operation queue, must be a power of two */
+#define DS3231_ASYNC_QUEUE_SIZE 16
+#endif
+
+typedef enum{
+  DS3231_ASYNC_OP_READ,
+  DS3231_ASYNC_OP_WRITE,
+  DS3231_ASYNC_OP_GET_TIME,
+  DS3231_ASYNC_OP_GET_TEMPERATURE,
+  DS3231_ASYNC_OP_SET_TIME,
+  DS3231_ASYNC_OP_CALL
+}ds3231_async_op_kind;
+
+/**
+ * completed by the worker: result and latency_us are valid once done reads true
+ */
+typedef struct{
+  atomic_bool done;
+  bool result;
+  /** time from enqueue to completion */
+  uint32_t latency_us;
+}ds3231_async_future_t;
+
+typedef void (*ds3231_async_cb_t)(bool result, void* ctx);
+
+/** a blocking call run by the worker, e.g. a wrapper around any public ds3231_ function */
+typedef bool (*ds3231_async_call_t)(ds3231_dev_t* dev, void* arg);
+
+typedef struct{
+  /** called by the worker on completion. can be NULL. */
+  ds3231_async_cb_t cb;
+  void* ctx;
+  /** completed after cb. can be NULL. */
+  ds3231_async_future_t* future;
+}ds3231_async_completion_t;
+
+typedef struct{
+  ds3231_async_op_kind kind;
+  uint8_t reg_start;
+  uint8_t byte_length;
+  bool use_24_format;
+  /** write data, read landing buffer or the time to set */
+  union{
+    uint8_t regs[0x13];
+    ds3231_time_data_t time;
+  }payload;
+  /** read destination: registers, ds3231_time_data_t or the temperature integer part */
+  void* out;
+  /** temperature fractional part */
+  uint8_t* out_fraction;
+  ds3231_async_call_t call;
+  void* call_arg;
+  ds3231_async_completion_t completion;
+  uint64_t enqueued_ns;
+}ds3231_async_op_t;
+
+typedef struct{
+  ds3231_dev_t* dev;
+  ds3231_async_op_t ops[DS3231_ASYNC_QUEUE_SIZE];
+  /** next operation to run, advanced by the worker */
+  atomic_uint head;
+  /** next free slot, advanced by the producer */
+  atomic_uint tail;
+  /** bus transactions issued for merged reads and writes, written by the worker */
+  uint32_t transactions;
+  /** operations completed, written by the worker */
+  uint32_t completed;
+}ds3231_async_t;
+
+
+/**
+ * @brief initialize an empty queue for an initialized device.
+ * @param [async][in] a pointer to ds3231_async_t
+ * @param [dev][in] a pointer to ds3231_dev_t
+ */
+bool ds3231_async_init(ds3231_async_t* async, ds3231_dev_t* dev);
+
+/**
+ * @brief queue a read of byte_length registers from reg_start.
+ * @param [async][in] a pointer to ds3231_async_t
+ * @param [reg_start][in] first register
+ * @param [data_out][out] must stay valid until completion
+ * @param [byte_length][in] number of registers, reg_start + byte_length must not pass 0x13
+ * @param [completion][in] a pointer to ds3231_async_completion_t, copied. can be NULL.
+ * @returns true if queued false if the queue is full or the range is invalid
+ */
+bool ds3231_async_read(ds3231_async_t* async, uint8_t reg_start, uint8_t* data_out, uint8_t byte_length,
+                       const ds3231_async_completion_t* completion);
+
+/**
+ * @brief queue a write of byte_length registers from reg_start. the data is copied.
+ * raw writes bypass the register shadow and invalidate it.
+ * @returns true if queued false if the queue is full or the range is invalid
+ */
+bool ds3231_async_write(ds3231_async_t* async, uint8_t reg_start, const uint8_t* data, uint8_t byte_length,
+                        const ds3231_async_completion_t* completion);
+
+/**
+ * @brief queue ds3231_get_time. merges with neighbouring queued reads.
+ * @param [time_data][out] must stay valid until completion
+ */
+bool ds3231_async_get_time(ds3231_async_t* async, ds3231_time_data_t* time_data,
+                           const ds3231_async_completion_t* completion);
+
+/**
+ * @brief queue ds3231_get_temperature. merges with neighbouring queued reads.
+ * @param [number][out] must stay valid until completion
+ * @param [fraction][out] must stay valid until completion
+ */
+bool ds3231_async_get_temperature(ds3231_async_t* async, int8_t* number, uint8_t* fraction,
+                                  const ds3231_async_completion_t* completion);
+
+/**
+ * @brief queue ds3231_set_time. the time is copied.
+ */
+bool ds3231_async_set_time(ds3231_async_t* async, bool use_24_format, const ds3231_time_data_t* time_data,
+                           const ds3231_async_completion_t* completion);
+
+/**
+ * @brief queue any blocking call, run by the worker in order with the other operations.
+ * @param [call][in] the call, its return value is the result
+ * @param [arg][in] passed to call, must stay valid until completion
+ */
+bool ds3231_async_call(ds3231_async_t* async, ds3231_async_call_t call, void* arg,
+                       const ds3231_async_completion_t* completion);
+
+/**
+ * @brief run every queued operation, merging adjacent register operations. called by the worker.
+ * @param [async][in] a pointer to ds3231_async_t
+ * @param [completed][out] number of operations completed by this call. can be NULL.
+ * @returns true on success false on invalid arguments. failed operations complete with false.
+ */
+bool ds3231_async_poll(ds3231_async_t* async, uint32_t* completed);
+
+/**
+ * @brief check a future without blocking.
+ * @param [future][in] a pointer to ds3231_async_future_t
+ * @param [result][out] the operation result once done. can be NULL.
+ * @returns true if the operation completed
+ */
+bool ds3231_async_future_done(ds3231_async_future_t* future, bool* result);
@@ -0,0 +1,103 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "ds3231_lib.h"
+
+/**
+ * aging offset calibration (ds3231_lib_calib.c).
+ * each point pairs an rtc seconds rollover with the time of a reference clock: the port's
+ * monotonic counter, a clock disciplined by the network or a pps, or an edge of the 1Hz square
+ * wave timestamped by capture hardware (ds3231_calib_add_point).
+ * a least squares line through the last DS3231_CALIB_POINTS points gives the rtc rate against the
+ * reference, ds3231_calib_apply turns it into aging offset steps and writes them. the points
+ * measured at the old offset are dropped, the loop runs on with the new one.
+ * one aging LSB is about 0.1ppm at 25C, the calibration is best done near the operating temperature.
+ */
+
+#ifndef DS3231_CALIB_POINTS
+/** points in the sliding window of the fit */
+#define DS3231_CALIB_POINTS 16
+#endif
+
+#ifndef DS3231_CALIB_MIN_POINTS
+/** points needed for an estimate */
+#define DS3231_CALIB_MIN_POINTS 4
+#endif
+
+/**
+ * maps the monotonic time of an rtc rollover to the reference clock.
+ * @returns false if the reference is not available, the point is skipped
+ */
+typedef bool (*ds3231_calib_reference_t)(uint64_t monotonic_ns, uint64_t* reference_ns, void* ctx);
+
+typedef struct{
+  int64_t rtc_seconds;
+  uint64_t reference_ns;
+}ds3231_calib_point_t;
+
+typedef struct{
+  ds3231_dev_t* dev;
+  /** NULL when the monotonic counter is the reference */
+  ds3231_calib_reference_t reference;
+  void* reference_ctx;
+  /** estimates need the window to span at least this many rtc seconds */
+  uint32_t min_span_s;
+  ds3231_calib_point_t __points[DS3231_CALIB_POINTS];
+  uint8_t __next;
+  uint8_t __count;
+  /** aging offset writes done by ds3231_calib_apply */
+  uint32_t corrections;
+}ds3231_calib_t;
+
+
+/**
+ * @brief initialize a calibration with an empty window. does not touch the bus.
+ * @param [calib][in] a pointer to ds3231_calib_t
+ * @param [dev][in] a pointer to ds3231_dev_t
+ * @param [min_span_s][in] see ds3231_calib_t. the edge uncertainty divided by the span bounds the error.
+ * @param [reference][in] the reference clock. NULL for the monotonic counter.
+ * @param [reference_ctx][in] passed to reference
+ */
+bool ds3231_calib_init(ds3231_calib_t* calib, ds3231_dev_t* dev, uint32_t min_span_s,
+                       ds3231_calib_reference_t reference, void* reference_ctx);
+
+/**
+ * @brief measure one point: wait for a seconds rollover (ds3231_get_time_aligned) and take its
+ * reference time. blocks up to about two seconds.
+ * @param [calib][in] a pointer to ds3231_calib_t
+ * @returns true on success false on fail
+ */
+bool ds3231_calib_sample(ds3231_calib_t* calib);
+
+/**
+ * @brief add a point measured elsewhere, e.g. a 1Hz square wave edge captured against a pps.
+ * a point more than half a second off the previous ones (rtc set) restarts the window.
+ * @param [calib][in] a pointer to ds3231_calib_t
+ * @param [rtc_seconds][in] unix time of the rtc second starting at the edge
+ * @param [reference_ns][in] reference time of the edge
+ */
+bool ds3231_calib_add_point(ds3231_calib_t* calib, int64_t rtc_seconds, uint64_t reference_ns);
+
+/**
+ * @brief least squares rate of the rtc against the reference over the window. no bus traffic.
+ * @param [calib][in] a pointer to ds3231_calib_t
+ * @param [rate_ppb][out] parts per billion, positive when the rtc runs fast
+ * @param [residual_ns][out] largest distance of a point from the fitted line. can be NULL.
+ * @returns true on success false with too few points or a too short span
+ */
+bool ds3231_calib_estimate(const ds3231_calib_t* calib, int32_t* rate_ppb, uint32_t* residual_ns);
+
+/**
+ * @brief correct the aging offset by the estimated rate, rounded to whole steps, and start a
+ * temperature conversion so it applies at once. nothing is written below half a step.
+ * @param [calib][in] a pointer to ds3231_calib_t
+ * @param [aging_offset][out] the aging offset in effect. can be NULL.
+ * @param [written][out] true if the offset was changed and the window restarted. can be NULL.
+ * @returns true on success false on fail or without an estimate
+ */
+bool ds3231_calib_apply(ds3231_calib_t* calib, int8_t* aging_offset, bool* written);
+
+/**
+ * @brief drop every point, e.g. after the rtc was set or the offset changed elsewhere.
+ */
+bool ds3231_calib_reset(ds3231_calib_t* calib);
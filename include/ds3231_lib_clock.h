@@ -0,0 +1,119 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "ds3231_lib.h"
+
+/**
+ * sub second clock service (ds3231_lib_clock.c).
+ * the rtc is read once at a detected seconds rollover (the anchor). after that ds3231_now
+ * interpolates from the port's monotonic counter without any bus traffic.
+ * ds3231_clock_poll re-anchors periodically and measures how far the interpolation drifted
+ * from the rtc. the rate is measured over all anchors since the rtc was last set, so it gets
+ * more accurate the longer the clock runs, and is applied to the following interpolation.
+ * every anchor is published under a sequence counter, ds3231_now and ds3231_stamp_batch read it
+ * without a lock while another task re-anchors.
+ */
+
+#ifndef DS3231_CLOCK_READ_RETRIES
+/** copies of the published anchor ds3231_now and ds3231_stamp_batch attempt while a re-anchor is publishing */
+#define DS3231_CLOCK_READ_RETRIES 64
+#endif
+
+/** ds3231_stamp_batch rounds the rate correction in fixed point, ds3231_now divides */
+#define DS3231_STAMP_ROUNDING_NS 3
+
+/** published anchor: seconds and monotonic time as two words each, and the rate */
+#define DS3231_CLOCK_PUBLISHED_WORDS 5
+
+typedef struct{
+  /** seconds since 1970-01-01 00:00:00 */
+  int64_t seconds;
+  /** must be in the range of 0-999999999 */
+  uint32_t nanoseconds;
+}ds3231_timespec_t;
+
+typedef struct{
+  ds3231_dev_t* dev;
+  /** unix time of the rtc second that started at anchor_ns */
+  int64_t anchor_seconds;
+  /** monotonic time of the detected seconds rollover */
+  uint64_t anchor_ns;
+  /** the rollover happened within anchor_ns +- anchor_uncertainty_ns */
+  uint32_t anchor_uncertainty_ns;
+  /** ds3231_clock_poll re-anchors once the anchor is older than this */
+  uint64_t reanchor_interval_ns;
+  /** rtc time minus interpolated time at the last re-anchor, positive when the rtc was ahead */
+  int64_t skew_ns;
+  /** rate of the rtc against the monotonic counter in parts per billion, positive when the rtc runs fast */
+  int32_t rate_ppb;
+  /** number of successful anchors */
+  uint32_t anchors;
+  /** first anchor since the rtc was last set, the rate is measured against it */
+  int64_t __base_seconds;
+  uint64_t __base_ns;
+  bool __anchor_f;
+  /** published anchor_seconds, anchor_ns and rate_ppb. the sequence is odd while publishing, 0 before the first anchor */
+  atomic_uint __sequence;
+  atomic_uint __published[DS3231_CLOCK_PUBLISHED_WORDS];
+}ds3231_clock_t;
+
+
+/**
+ * @brief initialize the clock service of an initialized device. does not touch the bus,
+ * call ds3231_clock_anchor before the first ds3231_now.
+ * @param [clock][in] a pointer to ds3231_clock_t
+ * @param [dev][in] a pointer to ds3231_dev_t
+ * @param [reanchor_interval_s][in] seconds between re-anchors done by ds3231_clock_poll
+ * @returns true on success false on fail
+ */
+bool ds3231_clock_init(ds3231_clock_t* clock, ds3231_dev_t* dev, uint32_t reanchor_interval_s);
+
+/**
+ * @brief wait for a seconds rollover of the rtc and anchor the clock on it, see ds3231_get_time_aligned.
+ * blocks up to about two seconds. on a re-anchor skew_ns and rate_ppb are updated,
+ * a skew of more than a second is taken as the rtc being set and resets the rate.
+ * @param [clock][in] a pointer to ds3231_clock_t
+ * @returns true on success false on fail. a previous anchor stays in use on fail.
+ */
+bool ds3231_clock_anchor(ds3231_clock_t* clock);
+
+/**
+ * @brief re-anchor if the anchor is older than the re-anchor interval. call from a low priority task.
+ * @param [clock][in] a pointer to ds3231_clock_t
+ * @param [reanchored][out] true if a re-anchor was done. can be NULL.
+ * @returns true on success false on fail
+ */
+bool ds3231_clock_poll(ds3231_clock_t* clock, bool* reanchored);
+
+/**
+ * @brief current time interpolated from the published anchor. no bus traffic or locks,
+ * safe while another task runs ds3231_clock_poll.
+ * @param [clock][in] a pointer to ds3231_clock_t
+ * @param [now][out] a pointer to ds3231_timespec_t
+ * @returns true on success false if the clock was never anchored or a re-anchor kept publishing
+ */
+bool ds3231_now(ds3231_clock_t* clock, ds3231_timespec_t* now);
+
+/**
+ * @brief get the skew measured at the last re-anchor.
+ * @param [clock][in] a pointer to ds3231_clock_t
+ * @param [skew_ns][out] rtc time minus interpolated time. can be NULL.
+ * @param [rate_ppb][out] rate of the rtc against the monotonic counter. can be NULL.
+ * @returns true on success false if the clock was anchored less than twice
+ */
+bool ds3231_clock_get_skew(ds3231_clock_t* clock, int64_t* skew_ns, int32_t* rate_ppb);
+
+/**
+ * @brief convert a batch of monotonic timestamps to rtc time against the last published anchor,
+ * in one pass without bus traffic or locks. safe while another task runs ds3231_clock_poll.
+ * timestamps before the anchor are converted too. a cycle counter has to be scaled to the port's
+ * monotonic nanoseconds first. for a counter ds3231_now could read, the stamp is within
+ * DS3231_STAMP_ROUNDING_NS of what ds3231_now returns then.
+ * @param [clock][in] a pointer to ds3231_clock_t
+ * @param [monotonic_ns][in] count timestamps as counted by the port
+ * @param [stamps][out] count rtc times, must not overlap monotonic_ns
+ * @param [count][in] number of timestamps
+ * @returns true on success false if the clock was never anchored or a re-anchor kept publishing
+ */
+bool ds3231_stamp_batch(ds3231_clock_t* clock, const uint64_t* monotonic_ns, ds3231_timespec_t* stamps, uint32_t count);
@@ -4,4 +4,10 @@
 #define CONFIG_USE_I2C_PORT
 #define CONFIG_USE_I2C_BUS
 #define CONFIG_USE_I2C_DEVICE
-#define CONFIG_USE_UTIL
\ No newline at end of file
+#define CONFIG_USE_UTIL
+
+/** linux i2c-dev port (ds3231_lib_private_linux.c): file descriptor of /dev/i2c-<i2c_port> */
+//#define CONFIG_USE_I2C_FD
+
+/** per device transfer counters and latency histograms, see ds3231_get_stats */
+//#define CONFIG_USE_STATS
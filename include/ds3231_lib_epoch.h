@@ -0,0 +1,58 @@
+#pragma once
+#include <stdint.h>
+
+/**
+ * calendar <-> day count conversion without libc (no mktime/timegm, no TZ).
+ * header only and free of tables and loops so the compiler folds constant arguments.
+ * proleptic gregorian calendar, days counted from 1970-01-01.
+ * see http://howardhinnant.github.io/date_algorithms.html
+ */
+
+/** first second the chip can represent, 2000-01-01 00:00:00 */
+#define DS3231_UNIX_TIME_MIN 946684800LL
+/** last second the chip can represent, 2199-12-31 23:59:59 */
+#define DS3231_UNIX_TIME_MAX 7258118399LL
+
+
+/**
+ * @brief days since 1970-01-01.
+ * @param [year][in] full year, e.g. 2024
+ * @param [month][in] must be in the range of 1-12
+ * @param [day][in] must be in the range of 1-31. days past the end of the month count into the next one.
+ */
+static inline int32_t ds3231_days_from_civil(int32_t year, uint32_t month, uint32_t day){
+    //years start in march so the leap day is the last day of the year
+    year -= (month <= 2u);
+    const int32_t era = (year >= 0 ? year : year - 399) / 400;
+    const uint32_t year_of_era = (uint32_t)(year - era * 400);
+    const uint32_t day_of_year = (153u * (month > 2u ? month - 3u : month + 9u) + 2u) / 5u + day - 1u;
+    const uint32_t day_of_era = year_of_era * 365u + year_of_era / 4u - year_of_era / 100u + day_of_year;
+    return era * 146097 + (int32_t)day_of_era - 719468;
+}
+
+/**
+ * @brief civil date of a day count since 1970-01-01.
+ * @param [days][in] days since 1970-01-01
+ * @param [year][out] full year
+ * @param [month][out] 1-12
+ * @param [day][out] 1-31
+ */
+static inline void ds3231_civil_from_days(int32_t days, int32_t* year, uint32_t* month, uint32_t* day){
+    days += 719468;
+    const int32_t era = (days >= 0 ? days : days - 146096) / 146097;
+    const uint32_t day_of_era = (uint32_t)(days - era * 146097);
+    const uint32_t year_of_era = (day_of_era - day_of_era / 1460u + day_of_era / 36524u - day_of_era / 146096u) / 365u;
+    const uint32_t day_of_year = day_of_era - (365u * year_of_era + year_of_era / 4u - year_of_era / 100u);
+    const uint32_t month_from_march = (5u * day_of_year + 2u) / 153u;
+    *day = day_of_year - (153u * month_from_march + 2u) / 5u + 1u;
+    *month = month_from_march < 10u ? month_from_march + 3u : month_from_march - 9u;
+    *year = (int32_t)year_of_era + era * 400 + (*month <= 2u);
+}
+
+/**
+ * @brief iso day of week of a day count since 1970-01-01, 1 = monday .. 7 = sunday.
+ */
+static inline uint8_t ds3231_day_of_week_from_days(int32_t days){
+    //1970-01-01 was a thursday
+    return (uint8_t)((days % 7 + 10) % 7 + 1);
+}
@@ -0,0 +1,149 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "ds3231_lib.h"
+
+/**
+ * interrupt driven event pipeline (ds3231_lib_events.c).
+ * the INT/SQW pin handler only timestamps the falling edge and pushes it into a lock free single
+ * producer single consumer ring, no bus access. a worker task drains the ring with
+ * ds3231_events_process: one REG_STATUS read, the A1F/A2F/OSF callbacks and one write clearing
+ * every flag that was set. edges queued meanwhile are served by the same read.
+ * on esp-idf register ds3231_events_isr_handler with gpio_isr_handler_add and wake the worker from
+ * the notify hook. the handler, ds3231_events_push and the port's monotonic counter are in IRAM, so
+ * the interrupt may be allocated with ESP_INTR_FLAG_IRAM as long as notify is IRAM_ATTR too. on linux an edge source (eventfd or gpio line) and ds3231_events_pump stand in
+ * for the pin. the ring holds DS3231_EVENTS_QUEUE_SIZE edges, more are counted as dropped.
+ */
+
+#ifndef DS3231_EVENTS_QUEUE_SIZE
+/** capacity of the edge ring, must be a power of two */
+#define DS3231_EVENTS_QUEUE_SIZE 16
+#endif
+
+typedef enum{
+  DS3231_EVENT_ALARM1,
+  DS3231_EVENT_ALARM2,
+  DS3231_EVENT_OSC_STOP,
+  DS3231_EVENT_KINDS
+}ds3231_event_kind;
+
+/**
+ * run by the worker for every flag found set. the flag is already cleared on the chip.
+ * @param [edge_ns] monotonic time of the first edge served by the status read
+ */
+typedef void (*ds3231_event_cb_t)(ds3231_event_kind kind, uint64_t edge_ns, void* ctx);
+
+/** called by the producer after an edge was queued, e.g. vTaskNotifyGiveFromISR. must be isr safe on esp-idf, and IRAM_ATTR for an IRAM interrupt. */
+typedef void (*ds3231_events_notify_t)(void* ctx);
+
+typedef struct ds3231_edge_source_s ds3231_edge_source_t;
+
+/**
+ * source of INT edges for ds3231_events_pump.
+ */
+struct ds3231_edge_source_s{
+  /**
+   * block until the next edge or the timeout.
+   * @returns true with edge_ns set on an edge, false on timeout or error
+   */
+  bool (*wait)(ds3231_edge_source_t* source, uint32_t timeout_ms, uint64_t* edge_ns);
+  void* ctx;
+  /** file descriptor of the linux sources */
+  int fd;
+};
+
+typedef struct{
+  ds3231_dev_t* dev;
+  uint64_t __edges[DS3231_EVENTS_QUEUE_SIZE];
+  /** next edge to serve, advanced by the worker */
+  atomic_uint head;
+  /** next free slot, advanced by the producer */
+  atomic_uint tail;
+  /** edges lost to a full ring */
+  atomic_uint dropped;
+  ds3231_events_notify_t notify;
+  void* notify_ctx;
+  ds3231_event_cb_t __cbs[DS3231_EVENT_KINDS];
+  void* __ctxs[DS3231_EVENT_KINDS];
+  /** callbacks run and status reads issued, written by the worker */
+  uint32_t dispatched;
+  uint32_t status_reads;
+  /** edge to callback time of the last and the slowest dispatch, written by the worker */
+  uint32_t last_latency_ns;
+  uint32_t max_latency_ns;
+}ds3231_events_t;
+
+
+/**
+ * @brief initialize an empty pipeline for an initialized device. does not touch the bus.
+ * enable the alarm interrupts (ds3231_enable_alarm) so INT follows A1F/A2F.
+ * @param [events][in] a pointer to ds3231_events_t
+ * @param [dev][in] a pointer to ds3231_dev_t
+ * @param [notify][in] wakes the worker after an edge was queued. can be NULL.
+ * @param [notify_ctx][in] passed to notify
+ */
+bool ds3231_events_init(ds3231_events_t* events, ds3231_dev_t* dev, ds3231_events_notify_t notify, void* notify_ctx);
+
+/**
+ * @brief register the callback of one event kind, replaces the previous one.
+ * @param [cb][in] the callback, NULL to unregister. the flag is cleared either way.
+ */
+bool ds3231_events_on(ds3231_events_t* events, ds3231_event_kind kind, ds3231_event_cb_t cb, void* ctx);
+
+/**
+ * @brief queue an edge. lock free and isr safe, one producer only.
+ * @param [events][in] a pointer to ds3231_events_t
+ * @param [edge_ns][in] monotonic time of the edge
+ * @returns true if queued false if the ring is full
+ */
+bool ds3231_events_push(ds3231_events_t* events, uint64_t edge_ns);
+
+/**
+ * @brief INT pin handler, timestamps the edge with the port's monotonic counter and queues it.
+ * matches gpio_isr_t, pass the ds3231_events_t as argument.
+ */
+void ds3231_events_isr_handler(void* arg);
+
+/**
+ * @brief wait for one edge of a source and queue it. called in a loop by a listener thread.
+ * @param [timeout_ms][in] passed to the source
+ * @returns true if an edge was queued
+ */
+bool ds3231_events_pump(ds3231_events_t* events, ds3231_edge_source_t* source, uint32_t timeout_ms);
+
+/**
+ * @brief serve the queued edges, called by the worker. reads REG_STATUS once, clears every set
+ * flag in one write and runs the callbacks. nothing is read when no edge is queued.
+ * @param [events][in] a pointer to ds3231_events_t
+ * @param [dispatched][out] callbacks run by this call. can be NULL.
+ * @returns true on success false on fail, the edges stay queued on a failed read or write
+ */
+bool ds3231_events_process(ds3231_events_t* events, uint32_t* dispatched);
+
+#ifdef __linux__
+/**
+ * linux edge sources (ds3231_lib_events_linux.c), timestamps are CLOCK_MONOTONIC like the linux port.
+ */
+
+/**
+ * @brief edges from an eventfd: every write to it is an edge, stamped when the read returns.
+ * @param [source][out] a pointer to ds3231_edge_source_t
+ * @param [fd][in] an eventfd, owned by the caller
+ */
+bool ds3231_edge_source_eventfd(ds3231_edge_source_t* source, int fd);
+
+/**
+ * @brief edges from a gpio character device line (e.g. a gpio-sim line), falling edges stamped by the kernel.
+ * @param [source][out] a pointer to ds3231_edge_source_t
+ * @param [chip_path][in] e.g. "/dev/gpiochip0"
+ * @param [offset][in] line offset on the chip
+ * @returns true on success false if the line can't be requested
+ */
+bool ds3231_edge_source_gpio(ds3231_edge_source_t* source, const char* chip_path, uint32_t offset);
+
+/**
+ * @brief close the file descriptor of a gpio source.
+ */
+bool ds3231_edge_source_close(ds3231_edge_source_t* source);
+#endif
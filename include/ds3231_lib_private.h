@@ -10,12 +10,13 @@
 
 
 /**
- * initialize i2c device. failes on previous initialization
+ * initialize i2c device. failes on previous initialization.
+ * a device with dev->bus set is added to that bus instead of creating its own
  */
 bool __ds3231_i2c_init(ds3231_dev_t* dev);
 
 /**
- * deinitialize i2c device if already initialized
+ * deinitialize i2c device if already initialized. a shared bus stays up
  */
 bool __ds3231_i2c_deinit(ds3231_dev_t* dev);
 
@@ -39,4 +40,102 @@ bool __ds3231_i2c_read_single(ds3231_dev_t* dev, uint8_t reg_address, uint8_t* d
  */
 bool __ds3231_i2c_read_multi(ds3231_dev_t* dev, uint8_t reg_address_start, uint8_t* data_out, uint8_t byte_length);
 
+/**
+ * read a free running monotonic counter in nanoseconds, independent of the rtc
+ */
+bool __ds3231_get_monotonic_ns(ds3231_dev_t* dev, uint64_t* ns);
+
+/**
+ * wait at least us microseconds. may sleep the calling task
+ */
+bool __ds3231_delay_us(ds3231_dev_t* dev, uint32_t us);
+
+
+/**
+ * create the shared bus: port handle, recursive lock and mux device when bus->mux_address is set.
+ * cleans up everything it created on fail
+ */
+bool __ds3231_bus_init(ds3231_bus_t* bus);
+
+/**
+ * release the shared bus
+ */
+bool __ds3231_bus_deinit(ds3231_bus_t* bus);
+
+/**
+ * take the recursive bus lock
+ */
+bool __ds3231_bus_lock(ds3231_bus_t* bus);
+
+/**
+ * release the recursive bus lock
+ */
+bool __ds3231_bus_unlock(ds3231_bus_t* bus);
+
+/**
+ * write the mux control register (one bit per channel)
+ */
+bool __ds3231_bus_write_mux(ds3231_bus_t* bus, uint8_t control);
+
+/**
+ * called by the port before every transfer: lock the shared bus of the device and route the mux
+ * to it. nothing to do for a device that owns its bus
+ */
+bool __ds3231_bus_acquire(ds3231_dev_t* dev);
 
+/**
+ * called by the port after every transfer started with __ds3231_bus_acquire
+ */
+void __ds3231_bus_release(ds3231_dev_t* dev);
+
+/**
+ * recover a stuck bus: clock scl until the slave releases sda, then send a stop.
+ * the shared bus lock is held by the caller
+ */
+bool __ds3231_i2c_recover(ds3231_dev_t* dev);
+
+/**
+ * the timeout the port applies for a requested one, rounded up to the steps its driver takes
+ */
+uint32_t __ds3231_i2c_timeout_us(uint32_t timeout_us);
+
+/**
+ * the longest a mux control write of the port can take
+ */
+uint32_t __ds3231_bus_mux_timeout_us(void);
+
+
+/**
+ * state of one transfer under the device policy, see __ds3231_policy_begin
+ */
+typedef struct{
+  /** timeout of the next attempt */
+  uint32_t timeout_us;
+  /** back off before the next retry */
+  uint32_t backoff_us;
+  /** attempts made so far */
+  uint8_t attempts;
+  /** failed attempts since the last recovery */
+  uint8_t failures;
+}ds3231_attempt_t;
+
+/**
+ * called by the port before the first attempt of a transfer, derives its timeout from the policy.
+ * an invalid policy (a device never passed through ds3231_init) is replaced by the default one
+ */
+void __ds3231_policy_begin(ds3231_dev_t* dev, ds3231_attempt_t* attempt, ds3231_stats_op op, uint8_t byte_length);
+
+/**
+ * called by the port after every attempt with its result. on a failure with retries left it backs
+ * off, recovers the bus when due and returns true to have the port attempt again.
+ * the port must not hold the shared bus across the call
+ */
+bool __ds3231_policy_retry(ds3231_dev_t* dev, ds3231_attempt_t* attempt, ds3231_stats_status status);
+
+#ifdef CONFIG_USE_STATS
+/**
+ * record one transfer in the device counters. called by the port after every attempt.
+ */
+void __ds3231_stats_record(ds3231_dev_t* dev, ds3231_stats_op op, uint8_t byte_length,
+                           ds3231_stats_status status, uint32_t latency_us);
+#endif
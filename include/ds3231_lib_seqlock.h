@@ -0,0 +1,69 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "ds3231_lib.h"
+
+/**
+ * lock free published snapshot (ds3231_lib_seqlock.c).
+ * one refresher task reads the device with ds3231_read_snapshot and publishes the result under a
+ * sequence counter. any number of tasks or threads read the last published copy with no bus
+ * access and no lock: a reader copies the snapshot and retries if the counter moved meanwhile.
+ * the writer never waits for readers. only the refresher may access the device.
+ */
+
+#ifndef DS3231_SEQLOCK_READ_RETRIES
+/** copies a reader attempts before giving up, a writer preempted mid publish must not spin a reader forever */
+#define DS3231_SEQLOCK_READ_RETRIES 64
+#endif
+
+typedef struct{
+  ds3231_snapshot_t snapshot;
+  /** monotonic time of the read */
+  uint64_t read_ns;
+}ds3231_seqlock_data_t;
+
+/** the published copy is kept in atomic words so readers racing the writer stay defined behaviour */
+#define DS3231_SEQLOCK_WORDS ((sizeof(ds3231_seqlock_data_t) + sizeof(uint32_t) - 1u) / sizeof(uint32_t))
+
+typedef struct{
+  ds3231_dev_t* dev;
+  /** odd while a publish is in progress, 0 before the first publish */
+  atomic_uint __sequence;
+  atomic_uint __words[DS3231_SEQLOCK_WORDS];
+}ds3231_seqlock_t;
+
+
+/**
+ * @brief initialize an empty seqlock for an initialized device. does not touch the bus.
+ * @param [seqlock][in] a pointer to ds3231_seqlock_t
+ * @param [dev][in] a pointer to ds3231_dev_t
+ * @returns true on success false on fail
+ */
+bool ds3231_seqlock_init(ds3231_seqlock_t* seqlock, ds3231_dev_t* dev);
+
+/**
+ * @brief read time, temperature and status in one transaction and publish them. single writer only.
+ * @param [seqlock][in] a pointer to ds3231_seqlock_t
+ * @returns true on success false on fail. the previous copy stays published on fail.
+ */
+bool ds3231_seqlock_refresh(ds3231_seqlock_t* seqlock);
+
+/**
+ * @brief publish a snapshot read elsewhere, e.g. by the async worker. single writer only.
+ * @param [seqlock][in] a pointer to ds3231_seqlock_t
+ * @param [snapshot][in] a pointer to ds3231_snapshot_t
+ * @param [read_ns][in] monotonic time of the read
+ * @returns true on success false on fail
+ */
+bool ds3231_seqlock_publish(ds3231_seqlock_t* seqlock, const ds3231_snapshot_t* snapshot, uint64_t read_ns);
+
+/**
+ * @brief copy the last published snapshot. safe from any number of tasks, never blocks the writer.
+ * @param [seqlock][in] a pointer to ds3231_seqlock_t
+ * @param [snapshot][out] a pointer to ds3231_snapshot_t
+ * @param [read_ns][out] monotonic time of the read. can be NULL.
+ * @returns true on success false if nothing was published yet or the writer kept
+ * publishing for DS3231_SEQLOCK_READ_RETRIES attempts
+ */
+bool ds3231_seqlock_read(ds3231_seqlock_t* seqlock, ds3231_snapshot_t* snapshot, uint64_t* read_ns);
@@ -0,0 +1,170 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "ds3231_lib.h"
+
+/**
+ * host side ds3231 simulator implementing ds3231_lib_private.h (ds3231_lib_private_sim.c).
+ * build it instead of ds3231_lib_private.c to run the driver without hardware.
+ * simulated time only moves through ds3231_sim_advance_ns and transaction latency,
+ * so years of rollover can be pushed through the driver in seconds.
+ *
+ * modelled from the datasheet:
+ *  - bcd time keeping with 12/24 hours modes, leap years and the century bit
+ *  - alarm matching with A1Mx/A2Mx and DY/DT masks setting A1F/A2F
+ *  - OSF and EOSC (the oscillator stops only on battery)
+ *  - temperature conversion every 64 seconds and on CONV, with BSY
+ *  - the aging offset trimming the oscillator by 0.1ppm per LSB
+ */
+
+/**
+ * faults injected into the transactions of a simulator, see ds3231_sim_set_fault.
+ * each transaction draws once from a seeded generator, so a seed replays the same faults.
+ */
+typedef struct{
+  /** chance in parts per million that a transaction is lost: the master waits out its timeout */
+  uint32_t drop_ppm;
+  /** chance in parts per million that the device does not acknowledge */
+  uint32_t nack_ppm;
+  /** chance in parts per million that a transaction is delayed by delay_ns, a timeout if that passes its timeout */
+  uint32_t delay_ppm;
+  uint32_t delay_ns;
+  /** sda held low: every transaction times out until the bus is recovered */
+  bool stuck;
+  uint32_t seed;
+}ds3231_sim_fault_t;
+
+typedef struct{
+  /** register file 0x00-0x12 */
+  uint8_t regs[0x13];
+  /** simulated monotonic time */
+  uint64_t now_ns;
+  /** time into the current second of the countdown chain */
+  uint64_t phase_ns;
+  /** time left of the running temperature conversion, 0 when idle */
+  uint64_t busy_remaining_ns;
+  /** latency added to every transaction */
+  uint32_t latency_ns;
+  /** duration of a temperature conversion */
+  uint32_t conversion_ns;
+  /** oscillator error in parts per billion, positive runs fast */
+  int32_t drift_ppb;
+  /** seconds since the last automatic temperature conversion */
+  uint8_t conversion_ticks;
+  /** die temperature in 0.25 degree steps */
+  int16_t temperature_quarters;
+  /** running from VBAT, EOSC stops the oscillator */
+  bool on_battery;
+  /** number of transactions served */
+  uint32_t transactions;
+  /** bytes on the wire including address and register bytes */
+  uint32_t wire_bytes;
+  /** scl clocks on the wire including start, repeated start and stop conditions */
+  uint64_t wire_clocks;
+  ds3231_sim_fault_t fault;
+  /** injected faults and bus recoveries */
+  uint32_t drops;
+  uint32_t nacks;
+  uint32_t delays;
+  uint32_t recoveries;
+  uint32_t __random;
+}ds3231_sim_t;
+
+/**
+ * TCA9548A style mux in front of simulated devices on a shared bus, see ds3231_sim_attach_bus.
+ * a device behind the mux only answers while its channel is routed.
+ * every simulator keeps its own time, so times measured across devices are not comparable.
+ */
+typedef struct{
+  /** control register, one bit per routed channel */
+  uint8_t control;
+  /** control register writes */
+  uint32_t transactions;
+  /** bytes on the wire including the address byte */
+  uint32_t wire_bytes;
+  /** scl clocks on the wire including start and stop conditions */
+  uint64_t wire_clocks;
+}ds3231_sim_mux_t;
+
+
+/**
+ * @brief reset the simulator to the datasheet power on state:
+ * 01/01/00 day 1 00:00:00 24 hours mode, OSF and EN32KHZ set, INTCN and RS2/RS1 set, 25 degrees.
+ * @param [sim][in] a pointer to ds3231_sim_t
+ */
+bool ds3231_sim_init(ds3231_sim_t* sim);
+
+/**
+ * @brief connect a device to the simulator. call before ds3231_init.
+ * @param [dev][in] a pointer to ds3231_dev_t
+ * @param [sim][in] a pointer to ds3231_sim_t
+ */
+bool ds3231_sim_attach(ds3231_dev_t* dev, ds3231_sim_t* sim);
+
+/**
+ * @brief reset a mux to its power on state, every channel closed.
+ * @param [mux][in] a pointer to ds3231_sim_mux_t
+ */
+bool ds3231_sim_mux_init(ds3231_sim_mux_t* mux);
+
+/**
+ * @brief connect a shared bus to a simulated mux. call before ds3231_bus_init.
+ * the simulated bus lock is a no-op, the simulator is single threaded.
+ * @param [bus][in] a pointer to ds3231_bus_t
+ * @param [mux][in] a pointer to ds3231_sim_mux_t, NULL for a bus without mux
+ */
+bool ds3231_sim_attach_bus(ds3231_bus_t* bus, ds3231_sim_mux_t* mux);
+
+/**
+ * @brief advance the simulated time, running every tick, alarm match and conversion on the way.
+ * @param [sim][in] a pointer to ds3231_sim_t
+ * @param [ns][in] nanoseconds to advance
+ */
+bool ds3231_sim_advance_ns(ds3231_sim_t* sim, uint64_t ns);
+
+/**
+ * @brief set the latency every transaction adds to the simulated time.
+ * reads latch the registers at the start of a transaction, writes apply at its end.
+ */
+bool ds3231_sim_set_latency(ds3231_sim_t* sim, uint32_t latency_ns);
+
+/**
+ * @brief set the oscillator error in parts per billion, positive runs fast.
+ */
+bool ds3231_sim_set_drift(ds3231_sim_t* sim, int32_t drift_ppb);
+
+/**
+ * @brief set the die temperature picked up by the next conversion, in 0.25 degree steps.
+ */
+bool ds3231_sim_set_temperature(ds3231_sim_t* sim, int16_t temperature_quarters);
+
+/**
+ * @brief switch between VCC and VBAT. on VBAT EOSC stops the oscillator.
+ */
+bool ds3231_sim_set_battery(ds3231_sim_t* sim, bool on_battery);
+
+/**
+ * @brief inject faults into the following transactions, a zeroed ds3231_sim_fault_t turns them off.
+ * @param [sim][in] a pointer to ds3231_sim_t
+ * @param [fault][in] a pointer to ds3231_sim_fault_t, copied
+ */
+bool ds3231_sim_set_fault(ds3231_sim_t* sim, const ds3231_sim_fault_t* fault);
+
+/**
+ * @brief state of the active low INT/SQW pin in interrupt mode.
+ * @returns true if INTCN is set and an enabled alarm flag is set
+ */
+bool ds3231_sim_int_active(ds3231_sim_t* sim);
+
+/**
+ * @brief clear the transaction, byte, clock, fault and recovery counters.
+ */
+bool ds3231_sim_reset_counters(ds3231_sim_t* sim);
+
+/**
+ * @brief estimate the bus time of the transactions counted since the last reset.
+ * @param [sim][in] a pointer to ds3231_sim_t
+ * @param [scl_speed_hz][in] bus speed, e.g. 100000 or 400000
+ * @param [bus_time_ns][out] the estimated bus time in nanoseconds
+ */
+bool ds3231_sim_get_bus_time(ds3231_sim_t* sim, uint32_t scl_speed_hz, uint64_t* bus_time_ns);
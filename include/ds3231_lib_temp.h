@@ -0,0 +1,122 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "ds3231_lib.h"
+
+/**
+ * temperature service (ds3231_lib_temp.c).
+ * the chip converts the temperature every 64 seconds, reading 0x11-0x12 in between returns the
+ * same value. ds3231_temp_get serves a cached value until the next automatic conversion is due.
+ * the conversion phase is learned from the value changing between two reads or from BSY, after
+ * that the registers are only probed inside a short window around each expected conversion.
+ * ds3231_temp_convert forces a fresh conversion (CONV) and waits for it.
+ * every conversion seen lands in a ring of recent samples and in streaming min/max/mean/variance.
+ * temperatures are fixed point centi-degrees (2525 = 25.25C). one task uses a service.
+ */
+
+#ifndef DS3231_TEMP_SAMPLES
+/** recent samples kept in the ring */
+#define DS3231_TEMP_SAMPLES 32
+#endif
+
+#ifndef DS3231_TEMP_PROBE_MS
+/** minimal time between two register reads while a conversion is due, the worst staleness once locked */
+#define DS3231_TEMP_PROBE_MS 1000
+#endif
+
+#ifndef DS3231_TEMP_POLL_US
+/** first wait of ds3231_temp_convert, doubles up to DS3231_TEMP_POLL_MAX_US */
+#define DS3231_TEMP_POLL_US 4000
+#endif
+
+#ifndef DS3231_TEMP_POLL_MAX_US
+#define DS3231_TEMP_POLL_MAX_US 32000
+#endif
+
+#ifndef DS3231_TEMP_CONVERT_TIMEOUT_US
+/** an automatic conversion to finish plus the forced one, tCONV is at most 200ms each */
+#define DS3231_TEMP_CONVERT_TIMEOUT_US 500000
+#endif
+
+typedef struct{
+  /** conversions seen since init or ds3231_temp_reset_stats */
+  uint32_t count;
+  int16_t min_centi;
+  int16_t max_centi;
+  int16_t mean_centi;
+  /** population variance in centi-degrees squared */
+  uint32_t variance_centi2;
+}ds3231_temp_stats_t;
+
+typedef struct{
+  ds3231_dev_t* dev;
+  /** last value read, valid after the first successful ds3231_temp_get or ds3231_temp_convert */
+  int16_t centi;
+  bool __valid_f;
+  /** monotonic time of the last register read */
+  uint64_t __read_ns;
+  /** the next automatic conversion completes between these monotonic times */
+  uint64_t __window_start_ns;
+  uint64_t __window_end_ns;
+  int16_t __samples[DS3231_TEMP_SAMPLES];
+  uint16_t __sample_next;
+  uint16_t __sample_count;
+  /** streaming statistics, sums are kept relative to the first sample */
+  uint32_t __count;
+  int16_t __offset;
+  int16_t __min;
+  int16_t __max;
+  int64_t __sum;
+  uint64_t __sum_sq;
+  /** register reads issued and ds3231_temp_get calls served from the cache */
+  uint32_t reads;
+  uint32_t hits;
+}ds3231_temp_t;
+
+
+/**
+ * @brief initialize a temperature service for an initialized device. does not touch the bus.
+ * @param [temp][in] a pointer to ds3231_temp_t
+ * @param [dev][in] a pointer to ds3231_dev_t
+ */
+bool ds3231_temp_init(ds3231_temp_t* temp, ds3231_dev_t* dev);
+
+/**
+ * @brief get the temperature of the last conversion. reads the chip only when a conversion may
+ * have completed since the last read, at most every DS3231_TEMP_PROBE_MS.
+ * @param [temp][in] a pointer to ds3231_temp_t
+ * @param [centi][out] temperature in centi-degrees
+ * @returns true on success false on fail
+ */
+bool ds3231_temp_get(ds3231_temp_t* temp, int16_t* centi);
+
+/**
+ * @brief force a conversion and wait for it: waits for a running conversion (BSY), sets CONV and
+ * polls until CONV and BSY clear with a doubling back off. blocks up to DS3231_TEMP_CONVERT_TIMEOUT_US.
+ * @param [temp][in] a pointer to ds3231_temp_t
+ * @param [centi][out] the fresh temperature in centi-degrees. can be NULL.
+ * @returns true on success false on fail or timeout
+ */
+bool ds3231_temp_convert(ds3231_temp_t* temp, int16_t* centi);
+
+/**
+ * @brief statistics of the conversions seen, no bus traffic.
+ * @param [temp][in] a pointer to ds3231_temp_t
+ * @param [stats][out] a pointer to ds3231_temp_stats_t
+ * @returns true on success false if no conversion was seen yet
+ */
+bool ds3231_temp_get_stats(const ds3231_temp_t* temp, ds3231_temp_stats_t* stats);
+
+/**
+ * @brief restart the statistics, the sample ring is kept.
+ */
+bool ds3231_temp_reset_stats(ds3231_temp_t* temp);
+
+/**
+ * @brief copy the most recent samples, oldest first. no bus traffic.
+ * @param [temp][in] a pointer to ds3231_temp_t
+ * @param [centi][out] array of max_count samples
+ * @param [max_count][in] size of centi
+ * @param [count][out] samples copied
+ */
+bool ds3231_temp_history(const ds3231_temp_t* temp, int16_t* centi, uint16_t max_count, uint16_t* count);
@@ -0,0 +1,96 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "ds3231_lib.h"
+
+/**
+ * software timers multiplexed over the two hardware alarms (ds3231_lib_timer.c).
+ * any number of one shot or periodic timers with whole second deadlines (unix time) are kept in
+ * two min heaps: minute aligned deadlines are served by alarm2, all others by alarm1. each alarm
+ * holds the nearest deadline of its heap, so the INT pin only fires for a due timer.
+ * ds3231_timers_service, called after INT or after starting and stopping timers, reads the
+ * time once, runs the due timers and re-arms the alarms whose deadline changed in one burst write.
+ * keep the register shadow valid (ds3231_shadow_resync) so the re-arm needs no read.
+ * timers are owned by the caller, nothing is allocated.
+ */
+
+#ifndef DS3231_TIMERS_MAX
+/** timers each alarm can hold */
+#define DS3231_TIMERS_MAX 32
+#endif
+
+typedef struct ds3231_timer_s ds3231_timer_t;
+
+/** run by ds3231_timers_service. may start or stop any timer, including this one */
+typedef void (*ds3231_timer_cb_t)(ds3231_timer_t* timer, void* ctx);
+
+struct ds3231_timer_s{
+  /** next expiry, seconds since 1970-01-01 00:00:00 */
+  int64_t deadline;
+  /** seconds between expiries, 0 for a one shot timer */
+  uint32_t period_s;
+  ds3231_timer_cb_t cb;
+  void* ctx;
+  /** heap the timer is in, 0 when stopped */
+  uint8_t __heap;
+  uint16_t __index;
+};
+
+typedef struct{
+  ds3231_dev_t* dev;
+  /** [0] alarm1, [1] alarm2 */
+  ds3231_timer_t* __heaps[2][DS3231_TIMERS_MAX];
+  uint16_t __counts[2];
+  /** deadline programmed into each alarm, 0 when disabled, -1 when not known */
+  int64_t __armed[2];
+  /** timers run */
+  uint32_t fired;
+  /** ds3231_timers_service calls that found a programmed alarm expired */
+  uint32_t wakes;
+  /** periodic timers stopped because the next expiry could not be scheduled: the heap of its alarm was
+   * full (a period that is not a multiple of 60 moves between the alarms) or it is past DS3231_UNIX_TIME_MAX */
+  uint32_t dropped;
+}ds3231_timers_t;
+
+
+/**
+ * @brief initialize an empty scheduler for an initialized device. does not touch the bus.
+ * the first ds3231_timers_service disables alarms left over from before.
+ * @param [timers][in] a pointer to ds3231_timers_t
+ * @param [dev][in] a pointer to ds3231_dev_t
+ * @returns true on success false on fail
+ */
+bool ds3231_timers_init(ds3231_timers_t* timers, ds3231_dev_t* dev);
+
+/**
+ * @brief start a timer or restart a running one. does not touch the bus, call ds3231_timers_service to arm it.
+ * a deadline that already passed runs on the next ds3231_timers_service.
+ * @param [timers][in] a pointer to ds3231_timers_t
+ * @param [timer][in] a pointer to ds3231_timer_t, must stay valid until stopped or expired. zero it
+ * before its first start, a running timer is told by its heap field
+ * @param [deadline][in] unix time, must be in the range DS3231_UNIX_TIME_MIN-DS3231_UNIX_TIME_MAX
+ * @param [period_s][in] seconds between expiries, 0 for one shot
+ * @param [cb][in] run on every expiry
+ * @param [ctx][in] passed to cb
+ * @returns true on success false if the alarm's heap is full or the deadline is out of range
+ */
+bool ds3231_timer_start(ds3231_timers_t* timers, ds3231_timer_t* timer, int64_t deadline, uint32_t period_s,
+                        ds3231_timer_cb_t cb, void* ctx);
+
+/**
+ * @brief stop a timer. does not touch the bus, the alarm is re-armed by the next ds3231_timers_service.
+ * @returns true on success false if the timer was not running
+ */
+bool ds3231_timer_stop(ds3231_timers_t* timers, ds3231_timer_t* timer);
+
+/**
+ * @brief read the time, run every due timer (periodic ones are rescheduled after the last missed
+ * expiry, or stopped and counted in dropped when that fails) and re-arm the alarms whose nearest deadline changed.
+ * costs one read plus one burst write when an alarm changed, also when one alarm is re-armed and the other
+ * disabled, and one more read when the nearest deadline is the next second.
+ * deadlines more than 27 days ahead are reached through intermediate wakes, the date match of an alarm would fire a month early.
+ * @param [timers][in] a pointer to ds3231_timers_t
+ * @param [next_deadline][out] nearest deadline of all timers, 0 if none. can be NULL.
+ * @returns true on success false on fail
+ */
+bool ds3231_timers_service(ds3231_timers_t* timers, int64_t* next_deadline);
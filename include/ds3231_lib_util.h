@@ -2,6 +2,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stddef.h>
+#include "ds3231_lib.h"
 
 /**
  * utilites for display representation of time
@@ -17,3 +18,104 @@
  * @returns true on success false on fail
  */
 bool ds3231_decimal_to_tm1637(uint8_t decimal_number,uint8_t* tm1637_number, uint8_t byte_size_tm1637,bool dot);
+
+
+/**
+ * 4 digit tm1637 clock frames. the encoder keeps the frame on the display and reports the digits
+ * that changed, so a refresh only writes those: one digit a minute for HH:MM without colon blink.
+ * the colon is the dot of the second digit, as wired on the common clock modules.
+ */
+
+#define DS3231_TM1637_DIGITS 4
+
+typedef enum{
+  DS3231_TM1637_HH_MM,
+  DS3231_TM1637_MM_SS
+}ds3231_tm1637_layout;
+
+typedef struct{
+  ds3231_tm1637_layout layout;
+  /** HH:MM shows 0-23 hours, otherwise 1-12 */
+  bool use_24_hours;
+  /** blank the first digit when it is 0 */
+  bool suppress_leading_zero;
+  /** colon on in even seconds only, otherwise always on */
+  bool blink_colon;
+  uint8_t __frame[DS3231_TM1637_DIGITS];
+  bool __valid_f;
+}ds3231_tm1637_t;
+
+
+/**
+ * @brief initialize an encoder. nothing is on the display yet, the first update reports every digit.
+ * @param [display][in] a pointer to ds3231_tm1637_t
+ */
+bool ds3231_tm1637_init(ds3231_tm1637_t* display, ds3231_tm1637_layout layout, bool use_24_hours,
+                        bool suppress_leading_zero, bool blink_colon);
+
+/**
+ * @brief encode a time and diff it against the frame on the display.
+ * write the digits in changed_mask, each at its fixed address (0xC0 + position), or the run from the
+ * lowest to the highest with address auto increment.
+ * @param [display][in] a pointer to ds3231_tm1637_t
+ * @param [time_data][in] a pointer to ds3231_time_data_t, 12 or 24 hours. only the time fields are used.
+ * @param [frame][out] segments of all DS3231_TM1637_DIGITS digits. can be NULL.
+ * @param [changed_mask][out] bit n set when digit n changed
+ * @returns true on success false on a field out of range, the kept frame is unchanged
+ */
+bool ds3231_tm1637_update(ds3231_tm1637_t* display, const ds3231_time_data_t* time_data,
+                          uint8_t* frame, uint8_t* changed_mask);
+
+/**
+ * @brief forget the kept frame, e.g. after the display was cleared or powered up. the next update reports every digit.
+ */
+bool ds3231_tm1637_invalidate(ds3231_tm1637_t* display);
+
+
+/**
+ * text formatting of ds3231_time_data_t. digits come from a two digit lookup table, nothing is
+ * allocated and no stdio is used. 12 hours times are converted where a 24 hours field is written.
+ * every formatter writes a NUL terminated string, on fail buffer holds an empty string.
+ */
+
+/** "2026-01-31T23:59:58" */
+#define DS3231_ISO8601_LENGTH 19
+/** "2026-01-31T23:59:58+01:00", or with Z for offset 0 */
+#define DS3231_RFC3339_LENGTH 25
+/** "235958" */
+#define DS3231_HHMMSS_LENGTH 6
+
+/**
+ * @brief format as ISO-8601 local time, YYYY-MM-DDTHH:MM:SS.
+ * @param [time_data][in] a pointer to ds3231_time_data_t
+ * @param [buffer][out] at least DS3231_ISO8601_LENGTH + 1 chars
+ * @param [size][in] size of buffer
+ * @param [length][out] characters written without the NUL. can be NULL.
+ * @returns true on success false on a too small buffer or a field out of range
+ */
+bool ds3231_format_iso8601(const ds3231_time_data_t* time_data, char* buffer, size_t size, size_t* length);
+
+/**
+ * @brief format as RFC-3339 with a fixed offset, YYYY-MM-DDTHH:MM:SS+HH:MM. the rtc holds the local
+ * time of that offset, 0 writes Z.
+ * @param [offset_minutes][in] offset from UTC, -1439 to 1439
+ * @param [buffer][out] at least DS3231_RFC3339_LENGTH + 1 chars
+ */
+bool ds3231_format_rfc3339(const ds3231_time_data_t* time_data, int16_t offset_minutes,
+                           char* buffer, size_t size, size_t* length);
+
+/**
+ * @brief format as compact HHMMSS, 24 hours.
+ * @param [buffer][out] at least DS3231_HHMMSS_LENGTH + 1 chars
+ */
+bool ds3231_format_hhmmss(const ds3231_time_data_t* time_data, char* buffer, size_t size, size_t* length);
+
+/**
+ * @brief format with a pattern. other characters are copied.
+ *  %Y year 4 digits, %y year 2 digits, %m month, %d day of month,
+ *  %H hours 00-23, %I hours 01-12, %p AM/PM, %M minutes, %S seconds, %u day of week 1-7, %% a %.
+ * @param [pattern][in] NUL terminated, e.g. "%d.%m.%Y %H:%M"
+ * @returns true on success false on a too small buffer, an unknown conversion or a field out of range
+ */
+bool ds3231_format(const ds3231_time_data_t* time_data, const char* pattern, char* buffer, size_t size, size_t* length);
+
@@ -0,0 +1,139 @@
+#include <string.h>
+#include "ds3231_test.h"
+#include "ds3231_lib_async.h"
+#include "ds3231_lib_private.h"
+
+/**
+ * async queue throughput and latency on the simulator. every round queues a random mix of time,
+ * temperature, status and alarm reads and alarm writes, arriving up to 500us apart in simulated
+ * time, then the worker polls once. the same operations run as blocking calls for comparison.
+ * reports operations per second of simulated bus time, the host cost per operation and the
+ * future latencies (enqueue to completion, simulated) as percentiles.
+ * usage: bench_async [rounds]
+ */
+
+static const uint32_t LATENCY_NS = 150000u;
+static const uint32_t SEED = 0x2545F491u;
+
+typedef struct{
+    ds3231_time_data_t time;
+    int8_t number;
+    uint8_t fraction;
+    uint8_t regs[7];
+}outputs_t;
+
+static uint32_t next_random(uint32_t* state){
+    *state ^= *state << 13u;
+    *state ^= *state >> 17u;
+    *state ^= *state << 5u;
+    return *state;
+}
+
+static int compare_u32(const void* a, const void* b){
+    const uint32_t x = *(const uint32_t*)a;
+    const uint32_t y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+/** queue operation kind 0-4, or run it blocking when async is NULL */
+static bool run_op(ds3231_async_t* async, ds3231_dev_t* dev, uint32_t kind, outputs_t* out,
+                   const ds3231_async_completion_t* completion){
+    static const uint8_t alarm[4] = {0x00u, 0x30u, 0x12u, 0x81u};
+    switch(kind){
+    case 0:
+        return (NULL != async) ? ds3231_async_get_time(async,&out->time,completion) : ds3231_get_time(dev,&out->time);
+    case 1:
+        return (NULL != async) ? ds3231_async_get_temperature(async,&out->number,&out->fraction,completion)
+                               : ds3231_get_temperature(dev,&out->number,&out->fraction);
+    case 2:
+        return (NULL != async) ? ds3231_async_read(async,0x0Fu,out->regs,1u,completion)
+                               : __ds3231_i2c_read_multi(dev,0x0Fu,out->regs,1u);
+    case 3:
+        return (NULL != async) ? ds3231_async_read(async,0x07u,out->regs,4u,completion)
+                               : __ds3231_i2c_read_multi(dev,0x07u,out->regs,4u);
+    default:
+        //alarm1 seconds/minutes, then hours/day: consecutive when queued back to back
+        return (NULL != async) ? ds3231_async_write(async,0x07u + 2u * (kind - 4u),&alarm[2u * (kind - 4u)],2u,completion)
+                               : __ds3231_i2c_write_multi(dev,(uint8_t*)&alarm[2u * (kind - 4u)],0x07u + 2u * (kind - 4u),2u);
+    }
+}
+
+int main(int argc, char** argv){
+    uint32_t rounds = test_arg_count(argc,argv,1,100000u);
+    rounds = (0u == rounds) ? 1u : rounds;
+    uint32_t* latencies_us = calloc((size_t)rounds * DS3231_ASYNC_QUEUE_SIZE,sizeof(uint32_t));
+    uint32_t* kinds = calloc((size_t)rounds * DS3231_ASYNC_QUEUE_SIZE,sizeof(uint32_t));
+    uint32_t* arrivals_ns = calloc((size_t)rounds * DS3231_ASYNC_QUEUE_SIZE,sizeof(uint32_t));
+    uint32_t* round_ops = calloc(rounds,sizeof(uint32_t));
+    TEST_CHECK(NULL != latencies_us && NULL != kinds && NULL != arrivals_ns && NULL != round_ops);
+    uint32_t state = SEED;
+    uint32_t ops = 0;
+    for(uint32_t r = 0; r < rounds; r++){
+        round_ops[r] = 1u + next_random(&state) % DS3231_ASYNC_QUEUE_SIZE;
+        for(uint32_t i = 0; i < round_ops[r]; i++){
+            kinds[ops] = next_random(&state) % 6u;
+            arrivals_ns[ops] = next_random(&state) % 500000u;
+            ops += 1u;
+        }
+    }
+
+    ds3231_sim_t sim;
+    ds3231_dev_t dev;
+    ds3231_async_t async;
+    outputs_t out;
+    ds3231_async_future_t futures[DS3231_ASYNC_QUEUE_SIZE];
+    TEST_CHECK(test_sim_device(&sim,&dev,LATENCY_NS) && ds3231_async_init(&async,&dev));
+    TEST_CHECK(ds3231_sim_reset_counters(&sim));
+    uint64_t bus_ns = 0;
+    uint64_t host_ns = 0;
+    uint32_t op = 0;
+    for(uint32_t r = 0; r < rounds; r++){
+        const uint32_t first = op;
+        for(uint32_t i = 0; i < round_ops[r]; i++, op++){
+            const ds3231_async_completion_t completion = {.future = &futures[i]};
+            TEST_CHECK(ds3231_sim_advance_ns(&sim,arrivals_ns[op]));
+            const uint64_t start_ns = test_now_ns();
+            TEST_CHECK(run_op(&async,&dev,kinds[op],&out,&completion));
+            host_ns += test_now_ns() - start_ns;
+        }
+        const uint64_t bus_start_ns = sim.now_ns;
+        const uint64_t start_ns = test_now_ns();
+        TEST_CHECK(ds3231_async_poll(&async,NULL));
+        host_ns += test_now_ns() - start_ns;
+        bus_ns += sim.now_ns - bus_start_ns;
+        for(uint32_t i = 0; i < round_ops[r]; i++){
+            bool result = false;
+            TEST_CHECK(ds3231_async_future_done(&futures[i],&result) && result);
+            latencies_us[first + i] = futures[i].latency_us;
+        }
+    }
+    const uint32_t async_transactions = sim.transactions;
+    //the host time includes the simulator's share of every transaction
+    test_consume(&out);
+
+    //the same operations one blocking call each
+    TEST_CHECK(ds3231_sim_reset_counters(&sim));
+    const uint64_t blocking_start_ns = sim.now_ns;
+    for(op = 0; op < ops; op++){
+        TEST_CHECK(run_op(NULL,&dev,kinds[op],&out,NULL));
+    }
+    const uint64_t blocking_bus_ns = sim.now_ns - blocking_start_ns;
+    const uint32_t blocking_transactions = sim.transactions;
+
+    qsort(latencies_us,ops,sizeof(latencies_us[0]),compare_u32);
+    printf("%u operations in %u rounds, %u us per transaction\n",ops,rounds,LATENCY_NS / 1000u);
+    printf("%-10s %12s %10s %14s\n","","transactions","bus ms","ops/bus s");
+    printf("%-10s %12u %10.1f %14.0f\n","async",async_transactions,bus_ns / 1e6,ops * 1e9 / (double)bus_ns);
+    printf("%-10s %12u %10.1f %14.0f\n","blocking",blocking_transactions,blocking_bus_ns / 1e6,
+           ops * 1e9 / (double)blocking_bus_ns);
+    printf("host %.1f ns per queued operation, queue and simulator\n",(double)host_ns / ops);
+    printf("future latency us: p50 %u p90 %u p99 %u max %u\n",latencies_us[ops / 2u],latencies_us[(ops * 90u) / 100u],
+           latencies_us[(ops * 99u) / 100u],latencies_us[ops - 1u]);
+    TEST_CHECK(async_transactions < blocking_transactions);
+    TEST_CHECK(ds3231_deinit(&dev));
+    free(latencies_us);
+    free(kinds);
+    free(arrivals_ns);
+    free(round_ops);
+    return test_result("bench_async");
+}
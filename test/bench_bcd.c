@@ -0,0 +1,230 @@
+//white box: the codec is static in the driver, it is built into this benchmark directly
+#include "../ds3231_lib.c"
+#include "ds3231_test.h"
+
+/**
+ * microbenchmark of the bcd codec against the subtract-10 loops it replaced.
+ * usage: bench_bcd [rounds], every round converts each of the 256 inputs (100 for encoding)
+ * and decodes/encodes 256 full time register sets.
+ */
+
+/** the replaced codec, as it was before the lookup table and the nibble arithmetic */
+static uint8_t loop_dec_to_bcd(uint8_t* number){
+    if(NULL == number){
+        return 0;
+    }else if(99 < *number){
+        return 0;
+    }else{
+        uint8_t temp_number = *number;
+        uint8_t temp_tens = 0;
+        uint8_t temp_ones = 0;
+        while(temp_number > 0x09){
+            temp_number -= 0x0A;
+            temp_tens += 1;
+        }
+        temp_ones = temp_number;
+        temp_tens <<= 4u;
+        temp_ones |= temp_tens;
+        return temp_ones;
+    }
+}
+
+static uint8_t loop_bcd_to_dec(uint8_t* number,uint8_t width_of_tens){
+    if(NULL == number){
+        return 0;
+    }else if(*number < 0x0A){
+        return *number;
+    }else if (99 < *number){
+        return 0;
+    }else{
+        uint8_t temp_number = *number;
+        const uint8_t temp_ones = temp_number &~ (0xf0u);
+        uint8_t temp_tens = temp_number >> 4u;
+        uint8_t mask = 0x00;
+        switch(width_of_tens){
+            default:
+                mask = 0x00;
+                break;
+            case(0x01):
+                mask = 0xfe;
+                break;
+            case(0x02):
+                mask = 0xfc;
+                break;
+            case(0x03):
+                mask = 0xf8;
+                break;
+            case(0x04):
+                mask = 0xf0;
+                break;
+        }
+        temp_tens &= ~(mask);
+        return ((temp_tens * 0x0Au) + temp_ones);
+    }
+}
+
+static void loop_decode_time(uint8_t* buffer, ds3231_time_data_t* time_data){
+    time_data->seconds = loop_bcd_to_dec(&buffer[0],3);
+    time_data->minutes = loop_bcd_to_dec(&buffer[1],3);
+    const uint8_t width_of_tens_hours = (buffer[2] >> BIT_SHIFT_HOURS_24_12_SELECT_BIT) & 0x01u ? 1 : 2;
+    time_data->hours = loop_bcd_to_dec(&buffer[2],width_of_tens_hours);
+    time_data->day_of_week = buffer[3];
+    time_data->day_of_month = loop_bcd_to_dec(&buffer[4],2);
+    time_data->month = loop_bcd_to_dec(&buffer[5],1);
+    time_data->year = loop_bcd_to_dec(&buffer[6],4);
+}
+
+static void loop_encode_time(bool use_24_format, ds3231_time_data_t* time_data, uint8_t* buffer){
+    buffer[0] = loop_dec_to_bcd(&time_data->seconds);
+    buffer[1] = loop_dec_to_bcd(&time_data->minutes);
+    buffer[2] = loop_dec_to_bcd(&time_data->hours);
+    if(!use_24_format){
+        buffer[2] |= (1u << BIT_SHIFT_HOURS_24_12_SELECT_BIT);
+        buffer[2] |= ((uint8_t)time_data->pm << BIT_SHIFT_AMPM);
+    }
+    buffer[3] = time_data->day_of_week;
+    buffer[4] = loop_dec_to_bcd(&time_data->day_of_month);
+    buffer[5] = loop_dec_to_bcd(&time_data->month);
+    buffer[6] = loop_dec_to_bcd(&time_data->year);
+}
+
+enum{ SETS = 256 };
+static uint8_t register_sets[SETS][7];
+static ds3231_time_data_t time_sets[SETS];
+
+/** valid 24h register sets spread over the ranges of every field */
+static void fill_sets(void){
+    for(uint32_t i = 0; i < SETS; i++){
+        ds3231_time_data_t* t = &time_sets[i];
+        t->seconds = (uint8_t)((i * 7u) % 60u);
+        t->minutes = (uint8_t)((i * 13u) % 60u);
+        t->hours = (uint8_t)((i * 5u) % 24u);
+        t->day_of_week = (uint8_t)(1u + i % 7u);
+        t->day_of_month = (uint8_t)(1u + (i * 3u) % 31u);
+        t->month = (uint8_t)(1u + i % 12u);
+        t->year = (uint8_t)((i * 11u) % 100u);
+        encode_time(true,t,register_sets[i]);
+    }
+}
+
+typedef void (*bench_fn)(uint32_t rounds, uint32_t* sink);
+
+static void bench_encode_loop(uint32_t rounds, uint32_t* sink){
+    for(uint32_t r = 0; r < rounds; r++){
+        for(uint8_t v = 0; v < 100u; v++){
+            uint8_t in = v;
+            test_consume(&in);
+            *sink += loop_dec_to_bcd(&in);
+        }
+    }
+}
+
+static void bench_encode_table(uint32_t rounds, uint32_t* sink){
+    for(uint32_t r = 0; r < rounds; r++){
+        for(uint8_t v = 0; v < 100u; v++){
+            uint8_t in = v;
+            test_consume(&in);
+            *sink += dec_to_bcd(in);
+        }
+    }
+}
+
+static void bench_decode_loop(uint32_t rounds, uint32_t* sink){
+    for(uint32_t r = 0; r < rounds; r++){
+        for(uint32_t v = 0; v < 256u; v++){
+            uint8_t in = (uint8_t)v;
+            test_consume(&in);
+            *sink += loop_bcd_to_dec(&in,3);
+        }
+    }
+}
+
+static void bench_decode_nibble(uint32_t rounds, uint32_t* sink){
+    for(uint32_t r = 0; r < rounds; r++){
+        for(uint32_t v = 0; v < 256u; v++){
+            uint8_t in = (uint8_t)v;
+            test_consume(&in);
+            *sink += bcd_to_dec(in,BCD_MASK_SECONDS);
+        }
+    }
+}
+
+static void bench_decode_time_loop(uint32_t rounds, uint32_t* sink){
+    ds3231_time_data_t t = {0};
+    for(uint32_t r = 0; r < rounds; r++){
+        for(uint32_t i = 0; i < SETS; i++){
+            test_consume(register_sets[i]);
+            loop_decode_time(register_sets[i],&t);
+            *sink += t.seconds + t.hours + t.year;
+        }
+    }
+}
+
+static void bench_decode_time_packed(uint32_t rounds, uint32_t* sink){
+    ds3231_time_data_t t = {0};
+    for(uint32_t r = 0; r < rounds; r++){
+        for(uint32_t i = 0; i < SETS; i++){
+            test_consume(register_sets[i]);
+            decode_time(register_sets[i],&t);
+            *sink += t.seconds + t.hours + t.year;
+        }
+    }
+}
+
+static void bench_encode_time_loop(uint32_t rounds, uint32_t* sink){
+    uint8_t buffer[7] = {0};
+    for(uint32_t r = 0; r < rounds; r++){
+        for(uint32_t i = 0; i < SETS; i++){
+            test_consume(&time_sets[i]);
+            loop_encode_time(true,&time_sets[i],buffer);
+            *sink += buffer[0] + buffer[2] + buffer[6];
+        }
+    }
+}
+
+static void bench_encode_time_table(uint32_t rounds, uint32_t* sink){
+    uint8_t buffer[7] = {0};
+    for(uint32_t r = 0; r < rounds; r++){
+        for(uint32_t i = 0; i < SETS; i++){
+            test_consume(&time_sets[i]);
+            encode_time(true,&time_sets[i],buffer);
+            *sink += buffer[0] + buffer[2] + buffer[6];
+        }
+    }
+}
+
+static double bench_run(bench_fn fn, uint32_t rounds, uint32_t ops_per_round){
+    uint32_t sink = 0;
+    const uint64_t start_ns = test_now_ns();
+    fn(rounds,&sink);
+    const uint64_t elapsed_ns = test_now_ns() - start_ns;
+    test_consume(&sink);
+    return (double)elapsed_ns / ((double)rounds * ops_per_round);
+}
+
+static void bench_pair(const char* name, bench_fn loop, bench_fn current, uint32_t rounds, uint32_t ops_per_round){
+    const double loop_ns = bench_run(loop,rounds,ops_per_round);
+    const double current_ns = bench_run(current,rounds,ops_per_round);
+    printf("%-12s loop %7.2f ns/op  new %7.2f ns/op  x%.1f\n",name,loop_ns,current_ns,
+           (0.0 < current_ns) ? loop_ns / current_ns : 0.0);
+}
+
+int main(int argc, char** argv){
+    const uint32_t rounds = test_arg_count(argc,argv,1,100000u);
+    fill_sets();
+    //both codecs agree wherever the old one was defined: it read registers above 99 (bcd 64-99) as 0
+    for(uint32_t v = 0; v < 100u; v++){
+        uint8_t in = (uint8_t)v;
+        TEST_CHECK(loop_dec_to_bcd(&in) == dec_to_bcd(in));
+        if(64u > v){
+            in = dec_to_bcd(in);
+            TEST_CHECK(loop_bcd_to_dec(&in,4) == bcd_to_dec(in,BCD_MASK(4)));
+        }
+    }
+    printf("bcd codec, %u rounds\n",rounds);
+    bench_pair("dec_to_bcd",bench_encode_loop,bench_encode_table,rounds,100u);
+    bench_pair("bcd_to_dec",bench_decode_loop,bench_decode_nibble,rounds,256u);
+    bench_pair("encode_time",bench_encode_time_loop,bench_encode_time_table,rounds,SETS);
+    bench_pair("decode_time",bench_decode_time_loop,bench_decode_time_packed,rounds,SETS);
+    return test_result("bench_bcd");
+}
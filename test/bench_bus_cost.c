@@ -0,0 +1,266 @@
+#include "ds3231_test.h"
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * bus cost of every public call against the simulator: transactions, bytes on the wire (address
+ * and register bytes included), bus time at 100 and 400 kHz and host cpu time per call, each without
+ * and with a valid register shadow. results go out as json.
+ *
+ * usage: bench_bus_cost [-n rounds] [-b baseline.json] [-o results.json]
+ *  -n  calls timed per entry, 0 leaves the cpu time out (that is how the baseline is written)
+ *  -b  fail if any call needs more transactions than in the baseline, or is missing from it
+ *  -o  write the json there instead of stdout
+ * refresh the baseline after an intended change with: bench_bus_cost -n 0 -o bus_cost_baseline.json
+ */
+
+static ds3231_sim_t sim;
+static ds3231_dev_t dev;
+static ds3231_time_data_t t = {.seconds = 1,.minutes = 2,.hours = 3,.day_of_week = 1,
+                               .day_of_month = 4,.month = 5,.year = 6};
+static ds3231_alarm1_options alarm1_option;
+static ds3231_alarm2_options alarm2_option;
+
+typedef struct{
+    char name[96];
+    /** brings the chip into the state the call changes, not counted */
+    bool (*prepare)(void);
+    bool (*call)(void);
+    ds3231_alarm1_options alarm1_option;
+    ds3231_alarm2_options alarm2_option;
+}bench_entry_t;
+
+#define CALL(name) static bool call_##name(void)
+CALL(set_time){ return ds3231_set_time(&dev,true,&t); }
+CALL(get_time){ ds3231_time_data_t g; return ds3231_get_time(&dev,&g); }
+CALL(set_alarm1){ return ds3231_set_alarm(&dev,&t,&alarm1_option,NULL); }
+CALL(set_alarm2){ return ds3231_set_alarm(&dev,&t,NULL,&alarm2_option); }
+CALL(set_alarms){
+    ds3231_alarm1_options o1 = DS3231_ALARM1_HOURS_MINUTES_SECONDS;
+    ds3231_alarm2_options o2 = DS3231_ALARM2_HOURS_MINUTES;
+    return ds3231_set_alarms(&dev,&t,&o1,&t,&o2);
+}
+CALL(get_alarm1){ ds3231_time_data_t g; ds3231_alarm1_options o; return ds3231_get_alarm(&dev,&g,&o,NULL); }
+CALL(get_alarm2){ ds3231_time_data_t g; ds3231_alarm2_options o; return ds3231_get_alarm(&dev,&g,NULL,&o); }
+CALL(enable_alarm){ return ds3231_enable_alarm(&dev,false); }
+CALL(disable_alarm){ return ds3231_disable_alarm(&dev,false); }
+CALL(clear_alarm_flag){ return ds3231_clear_alarm_flag(&dev,false); }
+CALL(poll_events){ uint8_t flags; return ds3231_poll_events(&dev,DS3231_FLAG_A1F | DS3231_FLAG_A2F,&flags); }
+CALL(enable_sqw){ return ds3231_enable_square_wave_output(&dev,DS3231_SQW_1HZ,false); }
+CALL(disable_sqw){ return ds3231_disable_square_wave_output(&dev); }
+CALL(enable_32khz){ return ds3231_enable_32khz_output(&dev); }
+CALL(disable_32khz){ return ds3231_disable_32khz_output(&dev); }
+CALL(enable_oscillator){ return ds3231_enable_oscillator(&dev); }
+CALL(disable_oscillator){ return ds3231_disable_oscillator(&dev); }
+CALL(get_osf){ bool osf; return ds3231_get_oscillator_stop_flag(&dev,&osf); }
+CALL(clear_osf){ return ds3231_clear_oscillator_stop_flag(&dev); }
+CALL(get_temperature){ int8_t n; uint8_t f; return ds3231_get_temperature(&dev,&n,&f); }
+CALL(get_aging_offset){ int8_t offset; return ds3231_get_aging_offset(&dev,&offset); }
+CALL(set_aging_offset){ return ds3231_set_aging_offset(&dev,-3); }
+CALL(zero_aging_offset){ return ds3231_set_aging_offset(&dev,0); }
+CALL(read_snapshot){ ds3231_snapshot_t s; return ds3231_read_snapshot(&dev,&s); }
+#undef CALL
+
+enum{ MAX_ENTRIES = 48 };
+static bench_entry_t entries[MAX_ENTRIES];
+static uint32_t entry_count = 0;
+
+static void add_entry(const char* name, bool (*prepare)(void), bool (*call)(void)){
+    bench_entry_t* entry = &entries[entry_count++];
+    snprintf(entry->name,sizeof(entry->name),"%s",name);
+    entry->prepare = prepare;
+    entry->call = call;
+}
+
+static void add_entries(void){
+    static const struct{ ds3231_alarm1_options option; const char* name; } alarm1_options[] = {
+        {DS3231_ALARM1_DAY_OF_MONTH_HOURS_MINUTES_SECONDS,"DS3231_ALARM1_DAY_OF_MONTH_HOURS_MINUTES_SECONDS"},
+        {DS3231_ALARM1_ONCE_PER_SECOND,"DS3231_ALARM1_ONCE_PER_SECOND"},
+        {DS3231_ALARM1_HOURS_MINUTES_SECONDS,"DS3231_ALARM1_HOURS_MINUTES_SECONDS"},
+        {DS3231_ALARM1_MINUTES_SECONDS,"DS3231_ALARM1_MINUTES_SECONDS"},
+        {DS3231_ALARM1_SECONDS,"DS3231_ALARM1_SECONDS"},
+        {DS3231_ALARM1_DAY_OF_WEEK_HOURS_MINUTES_SECONDS,"DS3231_ALARM1_DAY_OF_WEEK_HOURS_MINUTES_SECONDS"},
+    };
+    static const struct{ ds3231_alarm2_options option; const char* name; } alarm2_options[] = {
+        {DS3231_ALARM2_DAY_OF_MONTH_HOURS_MINUTES,"DS3231_ALARM2_DAY_OF_MONTH_HOURS_MINUTES"},
+        {DS3231_ALARM2_HOURS_MINUTES,"DS3231_ALARM2_HOURS_MINUTES"},
+        {DS3231_ALARM2_MINUTES,"DS3231_ALARM2_MINUTES"},
+        {DS3231_ALARM2_ONCE_PER_MINUTE,"DS3231_ALARM2_ONCE_PER_MINUTE"},
+        {DS3231_ALARM2_DAY_OF_WEEK_HOURS_MINUTES,"DS3231_ALARM2_DAY_OF_WEEK_HOURS_MINUTES"},
+    };
+    char name[96];
+    add_entry("ds3231_set_time",NULL,call_set_time);
+    add_entry("ds3231_get_time",NULL,call_get_time);
+    for(size_t i = 0; i < sizeof(alarm1_options) / sizeof(alarm1_options[0]); i++){
+        snprintf(name,sizeof(name),"ds3231_set_alarm %s",alarm1_options[i].name);
+        add_entry(name,NULL,call_set_alarm1);
+        entries[entry_count - 1u].alarm1_option = alarm1_options[i].option;
+    }
+    for(size_t i = 0; i < sizeof(alarm2_options) / sizeof(alarm2_options[0]); i++){
+        snprintf(name,sizeof(name),"ds3231_set_alarm %s",alarm2_options[i].name);
+        add_entry(name,NULL,call_set_alarm2);
+        entries[entry_count - 1u].alarm2_option = alarm2_options[i].option;
+    }
+    add_entry("ds3231_set_alarms",NULL,call_set_alarms);
+    add_entry("ds3231_get_alarm alarm1",NULL,call_get_alarm1);
+    add_entry("ds3231_get_alarm alarm2",NULL,call_get_alarm2);
+    add_entry("ds3231_enable_alarm",call_disable_alarm,call_enable_alarm);
+    add_entry("ds3231_disable_alarm",call_enable_alarm,call_disable_alarm);
+    add_entry("ds3231_clear_alarm_flag",NULL,call_clear_alarm_flag);
+    add_entry("ds3231_poll_events",NULL,call_poll_events);
+    add_entry("ds3231_enable_square_wave_output",call_disable_sqw,call_enable_sqw);
+    add_entry("ds3231_disable_square_wave_output",call_enable_sqw,call_disable_sqw);
+    add_entry("ds3231_enable_32khz_output",call_disable_32khz,call_enable_32khz);
+    add_entry("ds3231_disable_32khz_output",call_enable_32khz,call_disable_32khz);
+    add_entry("ds3231_enable_oscillator",call_disable_oscillator,call_enable_oscillator);
+    add_entry("ds3231_disable_oscillator",call_enable_oscillator,call_disable_oscillator);
+    add_entry("ds3231_get_oscillator_stop_flag",NULL,call_get_osf);
+    add_entry("ds3231_clear_oscillator_stop_flag",NULL,call_clear_osf);
+    add_entry("ds3231_get_temperature",NULL,call_get_temperature);
+    add_entry("ds3231_get_aging_offset",NULL,call_get_aging_offset);
+    add_entry("ds3231_set_aging_offset",call_zero_aging_offset,call_set_aging_offset);
+    add_entry("ds3231_read_snapshot",NULL,call_read_snapshot);
+}
+
+typedef struct{
+    uint32_t transactions;
+    uint32_t bytes;
+    uint64_t bus_ns_100khz;
+    uint64_t bus_ns_400khz;
+    double cpu_ns;
+}bench_result_t;
+
+/** run the preparation and put the shadow in the state the entry is measured with */
+static bool bench_setup(const bench_entry_t* entry, bool shadow){
+    alarm1_option = entry->alarm1_option;
+    alarm2_option = entry->alarm2_option;
+    if(NULL != entry->prepare && !entry->prepare()){
+        return false;
+    }
+    return shadow ? ds3231_shadow_resync(&dev) : ds3231_shadow_invalidate(&dev);
+}
+
+static bool bench_entry(const bench_entry_t* entry, bool shadow, uint32_t rounds, bench_result_t* result){
+    if(!bench_setup(entry,shadow) || !ds3231_sim_reset_counters(&sim) || !entry->call()){
+        return false;
+    }
+    result->transactions = sim.transactions;
+    result->bytes = sim.wire_bytes;
+    ds3231_sim_get_bus_time(&sim,100000u,&result->bus_ns_100khz);
+    ds3231_sim_get_bus_time(&sim,400000u,&result->bus_ns_400khz);
+    uint64_t cpu_ns = 0u;
+    for(uint32_t i = 0; i < rounds; i++){
+        if(!bench_setup(entry,shadow)){
+            return false;
+        }
+        const uint64_t start_ns = test_now_ns();
+        const bool ok = entry->call();
+        cpu_ns += test_now_ns() - start_ns;
+        if(!ok){
+            return false;
+        }
+    }
+    result->cpu_ns = (0u < rounds) ? (double)cpu_ns / rounds : 0.0;
+    return true;
+}
+
+/** transactions of a call in the baseline, false if it isn't there */
+static bool baseline_find(FILE* baseline, const char* name, bool shadow, uint32_t* transactions){
+    char line[256];
+    rewind(baseline);
+    while(NULL != fgets(line,sizeof(line),baseline)){
+        char call[96] = {0};
+        char shadow_text[6] = {0};
+        uint32_t count = 0;
+        const char* entry = strstr(line,"{\"call\": \"");
+        if(NULL != entry
+                    && 3 == sscanf(entry,"{\"call\": \"%95[^\"]\", \"shadow\": %5[a-z], \"transactions\": %u",call,shadow_text,&count)
+                    && 0 == strcmp(call,name) && shadow == (0 == strcmp(shadow_text,"true"))){
+            *transactions = count;
+            return true;
+        }
+    }
+    return false;
+}
+
+int main(int argc, char** argv){
+    uint32_t rounds = 10000u;
+    const char* baseline_path = NULL;
+    const char* output_path = NULL;
+    int option = 0;
+    while(-1 != (option = getopt(argc,argv,"n:b:o:"))){
+        switch(option){
+            case('n'):
+                rounds = (uint32_t)strtoul(optarg,NULL,10);
+                break;
+            case('b'):
+                baseline_path = optarg;
+                break;
+            case('o'):
+                output_path = optarg;
+                break;
+            default:
+                fprintf(stderr,"usage: %s [-n rounds] [-b baseline.json] [-o results.json]\n",argv[0]);
+                return 2;
+        }
+    }
+    FILE* output = (NULL == output_path) ? stdout : fopen(output_path,"w");
+    FILE* baseline = (NULL == baseline_path) ? NULL : fopen(baseline_path,"r");
+    if(NULL == output || (NULL != baseline_path && NULL == baseline)){
+        fprintf(stderr,"can't open %s\n",(NULL == output) ? output_path : baseline_path);
+        return 2;
+    }
+
+    //no latency: the simulated clock only moves on delays, the counters are what is measured
+    TEST_CHECK(test_sim_device(&sim,&dev,0u));
+    TEST_CHECK(ds3231_shadow_resync(&dev));
+    add_entries();
+
+    fprintf(output,"{\n  \"simulator\": \"ds3231_lib_private_sim.c\",\n  \"results\": [\n");
+    for(uint32_t i = 0; i < entry_count; i++){
+        for(uint8_t shadow = 0; shadow < 2; shadow++){
+            bench_result_t result = {0};
+            if(!bench_entry(&entries[i],shadow,rounds,&result)){
+                fprintf(stderr,"%s failed\n",entries[i].name);
+                test_failures += 1u;
+                continue;
+            }
+            const bool last = (entry_count - 1u == i) && 1u == shadow;
+            fprintf(output,"    {\"call\": \"%s\", \"shadow\": %s, \"transactions\": %u, \"bytes\": %u, "
+                           "\"bus_us_100khz\": %llu, \"bus_us_400khz\": %llu",
+                    entries[i].name,shadow ? "true" : "false",result.transactions,result.bytes,
+                    (unsigned long long)(result.bus_ns_100khz / 1000u),(unsigned long long)(result.bus_ns_400khz / 1000u));
+            if(0u < rounds){
+                fprintf(output,", \"cpu_ns\": %.0f",result.cpu_ns);
+            }
+            fprintf(output,"}%s\n",last ? "" : ",");
+
+            uint32_t baseline_transactions = 0;
+            if(NULL == baseline){
+                //nothing to compare with
+            }else if(!baseline_find(baseline,entries[i].name,shadow,&baseline_transactions)){
+                fprintf(stderr,"%s (shadow %s) is not in the baseline\n",entries[i].name,shadow ? "on" : "off");
+                test_failures += 1u;
+            }else if(result.transactions > baseline_transactions){
+                fprintf(stderr,"%s (shadow %s): %u transactions, baseline %u\n",
+                        entries[i].name,shadow ? "on" : "off",result.transactions,baseline_transactions);
+                test_failures += 1u;
+            }else if(result.transactions < baseline_transactions){
+                fprintf(stderr,"%s (shadow %s): %u transactions, baseline %u, refresh the baseline\n",
+                        entries[i].name,shadow ? "on" : "off",result.transactions,baseline_transactions);
+            }
+        }
+    }
+    fprintf(output,"  ]\n}\n");
+    if(stdout != output){
+        fclose(output);
+    }
+    if(NULL != baseline){
+        fclose(baseline);
+    }
+    if(0u != test_failures){
+        fprintf(stderr,"bench_bus_cost: %u failed\n",test_failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,128 @@
+#include "ds3231_test.h"
+#include "ds3231_lib_events.h"
+#include "fake_i2c_dev.h"
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <linux/i2c.h>
+
+/**
+ * edge to callback latency of the event pipeline on linux: a producer thread raises A1F on the
+ * fake adapter and writes an eventfd as INT, a listener runs ds3231_events_pump, a worker woken
+ * by notify runs ds3231_events_process, which reads and clears the status through the linux port.
+ * reports the pipeline's own edge to callback time (events->last_latency_ns) and the time from
+ * the eventfd write, as percentiles. the bus is the in-process fake, so no wire time is included.
+ * usage: bench_events [edges]
+ */
+
+static ds3231_dev_t dev;
+static ds3231_events_t events;
+static ds3231_edge_source_t source;
+static sem_t worker_wake;
+static sem_t served;
+static atomic_bool stop;
+static uint64_t raised_ns;
+static uint32_t* pipeline_ns;
+static uint32_t* write_ns;
+static uint32_t callbacks = 0u;
+
+static void notify_worker(void* ctx){
+    (void)ctx;
+    sem_post(&worker_wake);
+}
+
+static void on_alarm1(ds3231_event_kind kind, uint64_t edge_ns, void* ctx){
+    (void)kind;
+    (void)edge_ns;
+    (void)ctx;
+    const uint64_t now_ns = test_now_ns();
+    pipeline_ns[callbacks] = events.last_latency_ns;
+    write_ns[callbacks] = (uint32_t)(now_ns - raised_ns);
+    callbacks += 1u;
+    sem_post(&served);
+}
+
+static void* listener_main(void* arg){
+    (void)arg;
+    while(!atomic_load(&stop)){
+        ds3231_events_pump(&events,&source,100);
+    }
+    return NULL;
+}
+
+static void* worker_main(void* arg){
+    (void)arg;
+    while(!atomic_load(&stop)){
+        sem_wait(&worker_wake);
+        TEST_CHECK(ds3231_events_process(&events,NULL));
+    }
+    return NULL;
+}
+
+static int compare_u32(const void* a, const void* b){
+    const uint32_t x = *(const uint32_t*)a;
+    const uint32_t y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+static void print_percentiles(const char* name, uint32_t* ns, uint32_t count){
+    qsort(ns,count,sizeof(ns[0]),compare_u32);
+    printf("%-26s %9u %9u %9u %9u\n",name,ns[count / 2u],ns[(count * 90u) / 100u],ns[(count * 99u) / 100u],ns[count - 1u]);
+}
+
+int main(int argc, char** argv){
+    uint32_t edges = test_arg_count(argc,argv,1,10000u);
+    edges = (0u == edges) ? 1u : edges;
+    pipeline_ns = calloc(edges,sizeof(uint32_t));
+    write_ns = calloc(edges,sizeof(uint32_t));
+    const int fd = eventfd(0,EFD_CLOEXEC);
+    fake_i2c_reset(I2C_FUNC_I2C | I2C_FUNC_NOSTART);
+    TEST_CHECK(NULL != pipeline_ns && NULL != write_ns && 0 <= fd);
+    TEST_CHECK(ds3231_init(&dev,0,0,FAKE_I2C_PORT,false));
+    TEST_CHECK(ds3231_edge_source_eventfd(&source,fd));
+    TEST_CHECK(ds3231_events_init(&events,&dev,notify_worker,NULL));
+    TEST_CHECK(ds3231_events_on(&events,DS3231_EVENT_ALARM1,on_alarm1,NULL));
+    sem_init(&worker_wake,0,0);
+    sem_init(&served,0,0);
+    atomic_store(&stop,false);
+    pthread_t listener;
+    pthread_t worker;
+    TEST_CHECK(0 == pthread_create(&listener,NULL,listener_main,NULL));
+    TEST_CHECK(0 == pthread_create(&worker,NULL,worker_main,NULL));
+
+    //one edge at a time, the next is raised once the callback ran
+    const uint64_t one = 1u;
+    for(uint32_t i = 0; i < edges; i++){
+        fake_i2c.regs[0x0F] |= DS3231_FLAG_A1F;
+        raised_ns = test_now_ns();
+        TEST_CHECK(sizeof(one) == write(fd,&one,sizeof(one)));
+        const struct timespec deadline = {.tv_sec = time(NULL) + 2,.tv_nsec = 0};
+        if(0 != sem_timedwait(&served,&deadline)){
+            fprintf(stderr,"edge %u was not served\n",i);
+            test_failures += 1u;
+            break;
+        }
+    }
+
+    atomic_store(&stop,true);
+    sem_post(&worker_wake);
+    pthread_join(listener,NULL);
+    pthread_join(worker,NULL);
+    TEST_CHECK(edges == callbacks);
+    TEST_CHECK(callbacks == events.status_reads);
+    TEST_CHECK(0u == atomic_load(&events.dropped));
+    TEST_CHECK(0u == (fake_i2c.regs[0x0F] & DS3231_FLAG_A1F));
+    if(0u < callbacks){
+        printf("edge to callback over %u edges, ns\n%-26s %9s %9s %9s %9s\n",callbacks,"","p50","p90","p99","max");
+        print_percentiles("pump stamp to callback",pipeline_ns,callbacks);
+        print_percentiles("eventfd write to callback",write_ns,callbacks);
+    }
+    TEST_CHECK(ds3231_deinit(&dev));
+    close(fd);
+    free(pipeline_ns);
+    free(write_ns);
+    return test_result("bench_events");
+}
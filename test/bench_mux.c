@@ -0,0 +1,90 @@
+#include "ds3231_test.h"
+
+/**
+ * ds3231_bus_sweep_time over 1 to 8 devices behind a simulated TCA9548A: transactions, mux writes
+ * and bus time per sweep at 100 kHz, 400 kHz and 1 MHz, and host cpu time per sweep.
+ * checks every sweep reads every device once, with one mux write per device switch.
+ * usage: bench_mux [sweeps]
+ */
+
+enum{ MAX_DEVICES = 8 };
+static const uint32_t scl_speeds_hz[] = {100000u,400000u,1000000u};
+static const uint64_t window_ns = 1000000u;
+
+static ds3231_sim_t sims[MAX_DEVICES];
+static ds3231_dev_t rtc[MAX_DEVICES];
+static ds3231_sim_mux_t mux;
+static ds3231_bus_t bus;
+
+static void bench_devices(uint8_t count, uint32_t sweeps){
+    ds3231_dev_t* devs[MAX_DEVICES];
+    ds3231_time_data_t times[MAX_DEVICES];
+    bool valid[MAX_DEVICES];
+    const ds3231_bus_t empty_bus = {0};
+    bus = empty_bus;
+    TEST_CHECK(ds3231_sim_mux_init(&mux) && ds3231_sim_attach_bus(&bus,&mux));
+    TEST_CHECK(ds3231_bus_init(&bus,0,0,0,0x70));
+    for(uint8_t i = 0; i < count; i++){
+        const ds3231_dev_t empty = {0};
+        rtc[i] = empty;
+        devs[i] = &rtc[i];
+        TEST_CHECK(ds3231_sim_init(&sims[i]) && ds3231_sim_attach(&rtc[i],&sims[i]));
+        TEST_CHECK(ds3231_bus_attach(&rtc[i],&bus,i));
+        ds3231_time_data_t t = {.seconds = i,.minutes = 1,.hours = 2,.day_of_week = 3,
+                                .day_of_month = 4,.month = 5,.year = 26};
+        TEST_CHECK(ds3231_set_time(&rtc[i],true,&t));
+    }
+
+    //one sweep counted, the mux keeps its routing
+    for(uint8_t i = 0; i < count; i++){
+        ds3231_sim_reset_counters(&sims[i]);
+    }
+    mux.transactions = 0u;
+    mux.wire_bytes = 0u;
+    mux.wire_clocks = 0u;
+    TEST_CHECK(ds3231_bus_sweep_time(&bus,devs,count,times,NULL,valid,NULL));
+    uint32_t transactions = 0u;
+    uint64_t wire_clocks = mux.wire_clocks;
+    for(uint8_t i = 0; i < count; i++){
+        transactions += sims[i].transactions;
+        wire_clocks += sims[i].wire_clocks;
+        TEST_CHECK(valid[i] && i == times[i].seconds);
+        TEST_CHECK(1u == sims[i].transactions);
+    }
+    //a single device stays routed, more switch on every device
+    const uint32_t mux_writes = mux.transactions;
+    TEST_CHECK(((1u == count) ? 0u : count) == mux_writes);
+
+    //cpu time, the same devices over and over
+    const uint64_t start_ns = test_now_ns();
+    for(uint32_t k = 0; k < sweeps; k++){
+        TEST_CHECK(ds3231_bus_sweep_time(&bus,devs,count,times,NULL,valid,NULL));
+    }
+    const double cpu_ns = (0u < sweeps) ? (double)(test_now_ns() - start_ns) / sweeps : 0.0;
+
+    printf("%7u %12u %9u",count,transactions,mux_writes);
+    uint32_t fits_hz = 0u;
+    for(size_t s = 0; s < sizeof(scl_speeds_hz) / sizeof(scl_speeds_hz[0]); s++){
+        const uint64_t bus_ns = wire_clocks * 1000000000u / scl_speeds_hz[s];
+        printf(" %10llu",(unsigned long long)(bus_ns / 1000u));
+        if(0u == fits_hz && window_ns >= bus_ns){
+            fits_hz = scl_speeds_hz[s];
+        }
+    }
+    printf(" %12s %10.0f\n",(0u == fits_hz) ? "no" : (100000u == fits_hz) ? "100 kHz" : (400000u == fits_hz) ? "400 kHz" : "1 MHz",cpu_ns);
+
+    for(uint8_t i = 0; i < count; i++){
+        TEST_CHECK(ds3231_deinit(&rtc[i]));
+    }
+    TEST_CHECK(ds3231_bus_deinit(&bus));
+}
+
+int main(int argc, char** argv){
+    const uint32_t sweeps = test_arg_count(argc,argv,1,100000u);
+    printf("bus sweep behind a mux, %u sweeps timed\n",sweeps);
+    printf("%7s %12s %9s %10s %10s %10s %12s %10s\n","devices","transactions","mux","100kHz us","400kHz us","1MHz us","fits 1ms at","cpu ns");
+    for(uint8_t count = 1; count <= MAX_DEVICES; count++){
+        bench_devices(count,sweeps);
+    }
+    return test_result("bench_mux");
+}
@@ -0,0 +1,95 @@
+#include "ds3231_test.h"
+#include "ds3231_lib_seqlock.h"
+#include <pthread.h>
+#include <stdatomic.h>
+
+/**
+ * reader throughput of the seqlock against a mutex protected copy, 1 to 16 reader threads,
+ * with a refresher publishing every millisecond as a ds3231_seqlock_refresh task would.
+ * usage: bench_seqlock [milliseconds per run]
+ */
+
+enum{ MAX_READERS = 16 };
+
+static ds3231_seqlock_t seqlock;
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static ds3231_seqlock_data_t locked_data;
+static atomic_bool stop;
+
+typedef struct{
+    pthread_t thread;
+    bool use_mutex;
+    uint64_t reads;
+}reader_t;
+
+static void* reader_main(void* arg){
+    reader_t* reader = (reader_t*)arg;
+    ds3231_snapshot_t snapshot;
+    uint64_t read_ns = 0;
+    while(!atomic_load_explicit(&stop,memory_order_relaxed)){
+        if(reader->use_mutex){
+            pthread_mutex_lock(&mutex);
+            snapshot = locked_data.snapshot;
+            read_ns = locked_data.read_ns;
+            pthread_mutex_unlock(&mutex);
+            reader->reads += 1u;
+        }else if(ds3231_seqlock_read(&seqlock,&snapshot,&read_ns)){
+            reader->reads += 1u;
+        }
+        test_consume(&snapshot);
+    }
+    return NULL;
+}
+
+static double bench_run(uint32_t reader_count, bool use_mutex, uint32_t duration_ms){
+    reader_t readers[MAX_READERS] = {0};
+    atomic_store(&stop,false);
+    for(uint32_t i = 0; i < reader_count; i++){
+        readers[i].use_mutex = use_mutex;
+        TEST_CHECK(0 == pthread_create(&readers[i].thread,NULL,reader_main,&readers[i]));
+    }
+    const uint64_t start_ns = test_now_ns();
+    const uint64_t end_ns = start_ns + (uint64_t)duration_ms * 1000000u;
+    uint64_t publishes = 0u;
+    while(test_now_ns() < end_ns){
+        publishes += 1u;
+        ds3231_snapshot_t snapshot = {0};
+        snapshot.time.seconds = (uint8_t)(publishes % 60u);
+        if(use_mutex){
+            pthread_mutex_lock(&mutex);
+            locked_data.snapshot = snapshot;
+            locked_data.read_ns = publishes;
+            pthread_mutex_unlock(&mutex);
+        }else{
+            ds3231_seqlock_publish(&seqlock,&snapshot,publishes);
+        }
+        const struct timespec period = {.tv_sec = 0,.tv_nsec = 1000000};
+        nanosleep(&period,NULL);
+    }
+    atomic_store(&stop,true);
+    uint64_t reads = 0u;
+    for(uint32_t i = 0; i < reader_count; i++){
+        pthread_join(readers[i].thread,NULL);
+        reads += readers[i].reads;
+    }
+    const double seconds = (double)(test_now_ns() - start_ns) / 1e9;
+    return (double)reads / seconds;
+}
+
+int main(int argc, char** argv){
+    const uint32_t duration_ms = test_arg_count(argc,argv,1,1000u);
+    ds3231_dev_t dev = {0};
+    const ds3231_snapshot_t empty = {0};
+    TEST_CHECK(ds3231_seqlock_init(&seqlock,&dev));
+    TEST_CHECK(ds3231_seqlock_publish(&seqlock,&empty,0u));
+    printf("reader throughput, %u ms per run, writer at 1 kHz\n",duration_ms);
+    printf("%7s %16s %16s %8s\n","readers","seqlock reads/s","mutex reads/s","ratio");
+    for(uint32_t reader_count = 1; reader_count <= MAX_READERS; reader_count *= 2u){
+        const double seqlock_rate = bench_run(reader_count,false,duration_ms);
+        const double mutex_rate = bench_run(reader_count,true,duration_ms);
+        printf("%7u %16.0f %16.0f %8.2f\n",reader_count,seqlock_rate,mutex_rate,
+               (0.0 < mutex_rate) ? seqlock_rate / mutex_rate : 0.0);
+        TEST_CHECK(0.0 < seqlock_rate);
+    }
+    return test_result("bench_seqlock");
+}
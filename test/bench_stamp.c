@@ -0,0 +1,60 @@
+#include "ds3231_test.h"
+#include "ds3231_lib_clock.h"
+
+/**
+ * throughput of ds3231_stamp_batch in batches of 1024 counters, against one ds3231_now per stamp.
+ * the rate is measured from a simulated oscillator 2500 ppb fast, so the correction is not skipped.
+ * usage: bench_stamp [millions of stamps]
+ */
+
+#define BATCH 1024u
+
+static uint64_t monotonic_ns[BATCH];
+static ds3231_timespec_t stamps[BATCH];
+
+int main(int argc, char** argv){
+    const uint32_t millions = test_arg_count(argc,argv,1,100u);
+    const uint64_t total = (uint64_t)millions * 1000000u;
+    const uint64_t batches = (total + BATCH - 1u) / BATCH;
+    ds3231_sim_t sim;
+    ds3231_dev_t dev;
+    ds3231_clock_t clock;
+    TEST_CHECK(test_sim_device(&sim,&dev,50000u));
+    TEST_CHECK(ds3231_sim_set_drift(&sim,2500));
+    TEST_CHECK(ds3231_set_unix_time(&dev,1760000000,true));
+    TEST_CHECK(ds3231_clock_init(&clock,&dev,600u) && ds3231_clock_anchor(&clock));
+    TEST_CHECK(ds3231_sim_advance_ns(&sim,3600000000000u) && ds3231_clock_anchor(&clock));
+    TEST_CHECK(0 != clock.rate_ppb);
+
+    //counters spread over the minute after the anchor, like a capture buffer
+    for(uint32_t i = 0; i < BATCH; i++){
+        monotonic_ns[i] = clock.anchor_ns + (uint64_t)i * 58593750u + i % 7u;
+    }
+    uint64_t start_ns = test_now_ns();
+    for(uint64_t b = 0; b < batches; b++){
+        TEST_CHECK(ds3231_stamp_batch(&clock,monotonic_ns,stamps,BATCH));
+        test_consume(stamps);
+    }
+    const uint64_t batch_ns = test_now_ns() - start_ns;
+    const uint64_t batch_stamps = batches * BATCH;
+
+    //one ds3231_now per stamp, the simulator's counter standing in for the port's
+    uint64_t sum = 0;
+    start_ns = test_now_ns();
+    for(uint64_t s = 0; s < batch_stamps; s++){
+        ds3231_timespec_t now = {0};
+        sim.now_ns = monotonic_ns[s % BATCH];
+        TEST_CHECK(ds3231_now(&clock,&now));
+        sum += now.nanoseconds;
+    }
+    const uint64_t now_ns = test_now_ns() - start_ns;
+    test_consume(&sum);
+
+    printf("%llu stamps, rate %d ppb\n",(unsigned long long)batch_stamps,clock.rate_ppb);
+    printf("%-20s %10s %14s\n","","ns/stamp","Mstamps/s");
+    printf("%-20s %10.2f %14.1f\n","ds3231_stamp_batch",(double)batch_ns / batch_stamps,
+           (0u == batch_ns) ? 0.0 : batch_stamps * 1e3 / (double)batch_ns);
+    printf("%-20s %10.2f %14.1f\n","ds3231_now",(double)now_ns / batch_stamps,
+           (0u == now_ns) ? 0.0 : batch_stamps * 1e3 / (double)now_ns);
+    return test_result("bench_stamp");
+}
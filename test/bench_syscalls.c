@@ -0,0 +1,117 @@
+#include "ds3231_test.h"
+#include "fake_i2c_dev.h"
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+
+/**
+ * syscalls per api call of the linux port against a naive read()/write() transport.
+ * each call runs through the port on the fake adapter, then the transfers it made are replayed
+ * through the naive transport: a read is write(register) + read(data), a write is one write()
+ * of the register and a copy of the data. fails if the port needs more than one syscall a transfer.
+ */
+
+static ds3231_dev_t dev;
+static ds3231_time_data_t t = {.seconds = 1,.minutes = 2,.hours = 3,.day_of_week = 1,
+                               .day_of_month = 4,.month = 5,.year = 6};
+
+static bool naive_read(int fd, uint8_t reg_address, uint8_t* data, uint8_t byte_length){
+    return 1 == write(fd,&reg_address,1) && byte_length == read(fd,data,byte_length);
+}
+
+static bool naive_write(int fd, uint8_t reg_address, const uint8_t* data, uint8_t byte_length){
+    uint8_t buffer[0x13u + 1u] = {0};
+    buffer[0] = reg_address;
+    memcpy(&buffer[1],data,byte_length);
+    return byte_length + 1 == write(fd,buffer,byte_length + 1u);
+}
+
+/** replay the logged transfers through the naive transport, returns its syscalls */
+static uint32_t naive_replay(void){
+    fake_i2c_transfer_t log[FAKE_I2C_LOG_SIZE];
+    const uint32_t length = fake_i2c.log_length;
+    memcpy(log,fake_i2c.log,sizeof(log));
+    fake_i2c_reset_counters();
+    //the naive transport addresses the device once per descriptor
+    ioctl(fake_i2c.fd,I2C_SLAVE,0x68ul);
+    fake_i2c.ioctls = 0u;
+    uint8_t data[0x13] = {0};
+    for(uint32_t i = 0; i < length && i < FAKE_I2C_LOG_SIZE; i++){
+        if(log[i].read){
+            TEST_CHECK(naive_read(fake_i2c.fd,log[i].reg_address,data,log[i].byte_length));
+        }else{
+            memcpy(data,&fake_i2c.regs[log[i].reg_address],log[i].byte_length);
+            TEST_CHECK(naive_write(fake_i2c.fd,log[i].reg_address,data,log[i].byte_length));
+        }
+    }
+    return fake_i2c_syscalls();
+}
+
+#define CALL(name) static bool call_##name(void)
+CALL(get_time){ ds3231_time_data_t g; return ds3231_get_time(&dev,&g); }
+CALL(set_time){ return ds3231_set_time(&dev,true,&t); }
+CALL(read_snapshot){ ds3231_snapshot_t s; return ds3231_read_snapshot(&dev,&s); }
+CALL(set_alarm){ ds3231_alarm1_options o = DS3231_ALARM1_HOURS_MINUTES_SECONDS; return ds3231_set_alarm(&dev,&t,&o,NULL); }
+CALL(set_alarms){
+    ds3231_alarm1_options o1 = DS3231_ALARM1_HOURS_MINUTES_SECONDS;
+    ds3231_alarm2_options o2 = DS3231_ALARM2_HOURS_MINUTES;
+    return ds3231_set_alarms(&dev,&t,&o1,&t,&o2);
+}
+CALL(get_alarm){ ds3231_time_data_t g; ds3231_alarm1_options o; return ds3231_get_alarm(&dev,&g,&o,NULL); }
+CALL(get_temperature){ int8_t n; uint8_t f; return ds3231_get_temperature(&dev,&n,&f); }
+CALL(square_wave){ return ds3231_enable_square_wave_output(&dev,DS3231_SQW_1HZ,false); }
+CALL(clear_alarm_flag){ return ds3231_clear_alarm_flag(&dev,false); }
+CALL(poll_events){ uint8_t flags; return ds3231_poll_events(&dev,0x03,&flags); }
+#undef CALL
+
+typedef struct{
+    const char* name;
+    bool (*call)(void);
+}bench_call_t;
+
+static const bench_call_t calls[] = {
+    {"ds3231_get_time",call_get_time},
+    {"ds3231_set_time",call_set_time},
+    {"ds3231_read_snapshot",call_read_snapshot},
+    {"ds3231_set_alarm",call_set_alarm},
+    {"ds3231_set_alarms",call_set_alarms},
+    {"ds3231_get_alarm",call_get_alarm},
+    {"ds3231_get_temperature",call_get_temperature},
+    {"ds3231_enable_square_wave_output",call_square_wave},
+    {"ds3231_clear_alarm_flag",call_clear_alarm_flag},
+    {"ds3231_poll_events",call_poll_events},
+};
+
+static void bench_adapter(const char* name, unsigned long funcs){
+    fake_i2c_reset(funcs);
+    fake_i2c.regs[0x0E] = 0x1Cu;
+    const ds3231_dev_t empty = {0};
+    dev = empty;
+    TEST_CHECK(ds3231_init(&dev,0,0,FAKE_I2C_PORT,false));
+    printf("\n%s\n%-34s %9s %6s %6s\n",name,"call","transfers","port","naive");
+    uint32_t port_total = 0u;
+    uint32_t naive_total = 0u;
+    for(size_t i = 0; i < sizeof(calls) / sizeof(calls[0]); i++){
+        fake_i2c_reset_counters();
+        TEST_CHECK(calls[i].call());
+        const uint32_t transfers = fake_i2c.log_length;
+        const uint32_t port = fake_i2c_syscalls();
+        const uint32_t ioctls = fake_i2c.ioctls;
+        const uint32_t naive = naive_replay();
+        printf("%-34s %9u %6u %6u\n",calls[i].name,transfers,port,naive);
+        //one ioctl per transfer, nothing else
+        TEST_CHECK(transfers == port && port == ioctls);
+        port_total += port;
+        naive_total += naive;
+    }
+    printf("%-34s %9s %6u %6u\n","total","",port_total,naive_total);
+    TEST_CHECK(ds3231_deinit(&dev));
+}
+
+int main(void){
+    bench_adapter("i2c adapter with NOSTART",I2C_FUNC_I2C | I2C_FUNC_NOSTART);
+    bench_adapter("i2c adapter",I2C_FUNC_I2C);
+    return test_result("bench_syscalls");
+}
@@ -0,0 +1,49 @@
+#include "ds3231_test.h"
+#include "ds3231_lib_epoch.h"
+
+/**
+ * ds3231_unix_to_time -> ds3231_time_to_unix over every second from 2000 to 2199, every stride-th
+ * second for a shorter run. every second must come back unchanged. the same walk through the
+ * host's gmtime_r/timegm for comparison.
+ * usage: bench_unix [stride seconds, 1 for every second]
+ */
+
+int main(int argc, char** argv){
+    uint32_t stride = test_arg_count(argc,argv,1,1u);
+    stride = (0u == stride) ? 1u : stride;
+    uint64_t conversions = 0;
+    uint64_t mismatches = 0;
+    uint64_t start_ns = test_now_ns();
+    for(int64_t unix_time = DS3231_UNIX_TIME_MIN; unix_time <= DS3231_UNIX_TIME_MAX; unix_time += stride){
+        ds3231_time_data_t t;
+        int64_t back = 0;
+        if(!ds3231_unix_to_time(unix_time,0u != (unix_time & 0x01),&t) || !ds3231_time_to_unix(&t,&back) || unix_time != back){
+            if(0u == mismatches){
+                fprintf(stderr,"unix %lld came back as %lld\n",(long long)unix_time,(long long)back);
+            }
+            mismatches += 1u;
+        }
+        conversions += 1u;
+    }
+    const uint64_t lib_ns = test_now_ns() - start_ns;
+    TEST_CHECK(0u == mismatches);
+
+    uint64_t host_sum = 0;
+    start_ns = test_now_ns();
+    for(int64_t unix_time = DS3231_UNIX_TIME_MIN; unix_time <= DS3231_UNIX_TIME_MAX; unix_time += stride){
+        const time_t host_time = (time_t)unix_time;
+        struct tm tm;
+        gmtime_r(&host_time,&tm);
+        host_sum += (uint64_t)timegm(&tm);
+    }
+    const uint64_t host_ns = test_now_ns() - start_ns;
+    test_consume(&host_sum);
+
+    printf("%llu round trips 2000-2199, stride %u s\n",(unsigned long long)conversions,stride);
+    printf("%-22s %10s %14s\n","","ns/trip","trips/s");
+    printf("%-22s %10.1f %14.0f\n","unix_to_time+to_unix",(double)lib_ns / conversions,
+           (0u == lib_ns) ? 0.0 : conversions * 1e9 / (double)lib_ns);
+    printf("%-22s %10.1f %14.0f\n","gmtime_r+timegm",(double)host_ns / conversions,
+           (0u == host_ns) ? 0.0 : conversions * 1e9 / (double)host_ns);
+    return test_result("bench_unix");
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include "ds3231_lib.h"
+#include "ds3231_lib_sim.h"
+
+/**
+ * helpers shared by the host tests and benchmarks.
+ * a test returns test_result(): 0 when every TEST_CHECK passed, so ctest fails it otherwise.
+ */
+
+static __attribute__((unused)) uint32_t test_failures = 0;
+
+/** record a failed check with its location and keep going */
+#define TEST_CHECK(cond) do{ \
+        if(!(cond)){ \
+            fprintf(stderr,"%s:%d: check failed: %s\n",__FILE__,__LINE__,#cond); \
+            test_failures += 1u; \
+        } \
+    }while(0)
+
+static inline int test_result(const char* name){
+    printf("%s: %s (%u failed checks)\n",name,(0u == test_failures) ? "ok" : "FAILED",test_failures);
+    return (0u == test_failures) ? 0 : 1;
+}
+
+/** host monotonic clock for the benchmarks */
+static inline uint64_t test_now_ns(void){
+    struct timespec now = {0};
+    clock_gettime(CLOCK_MONOTONIC,&now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+/** argv[index] as a count, fallback when missing */
+static inline uint32_t test_arg_count(int argc, char** argv, int index, uint32_t fallback){
+    return (index < argc) ? (uint32_t)strtoul(argv[index],NULL,10) : fallback;
+}
+
+/** keep the compiler from dropping a benchmarked result */
+static inline void test_consume(const void* p){
+    __asm__ volatile("" : : "r"(p) : "memory");
+}
+
+/**
+ * @brief power up a simulator and initialize a device on it.
+ * every transaction costs latency_ns of simulated time, the aligned reads need it to be non zero.
+ */
+static inline bool test_sim_device(ds3231_sim_t* sim, ds3231_dev_t* dev, uint32_t latency_ns){
+    const ds3231_dev_t empty = {0};
+    *dev = empty;
+    return ds3231_sim_init(sim)
+        && ds3231_sim_set_latency(sim,latency_ns)
+        && ds3231_sim_attach(dev,sim)
+        && ds3231_init(dev,0,0,0,false);
+}
@@ -0,0 +1,9 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+typedef int i2c_port_num_t;
+typedef struct i2c_master_bus_t* i2c_master_bus_handle_t;
+typedef struct i2c_master_dev_t* i2c_master_dev_handle_t;
+typedef enum{ I2C_ADDR_BIT_LEN_7 }i2c_addr_bit_len_t;
+typedef enum{ I2C_CLK_SRC_DEFAULT }i2c_clock_source_t;
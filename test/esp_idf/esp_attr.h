@@ -0,0 +1,4 @@
+#pragma once
+//no iram on the host
+#define IRAM_ATTR
+#define DRAM_ATTR
@@ -0,0 +1,10 @@
+#pragma once
+//host declarations of the esp-idf calls ds3231_lib_private.c makes, implemented by ../fake_esp_idf.c
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_NO_MEM 0x101
+#define ESP_ERR_INVALID_ARG 0x102
+#define ESP_ERR_INVALID_STATE 0x103
+#define ESP_ERR_TIMEOUT 0x107
+#define ESP_ERR_INVALID_RESPONSE 0x108
@@ -0,0 +1,11 @@
+#pragma once
+#include "freertos/FreeRTOS.h"
+typedef void* SemaphoreHandle_t;
+typedef struct{
+    uint8_t storage[80];
+}StaticSemaphore_t;
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void);
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutexStatic(StaticSemaphore_t* buffer);
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t semaphore, TickType_t ticks);
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t semaphore);
+void vSemaphoreDelete(SemaphoreHandle_t semaphore);
@@ -0,0 +1,156 @@
+#include "fake_esp_idf.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "driver/i2c_master.h"
+#include "esp_timer.h"
+#include "esp_rom_sys.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+enum{ FAKE_BUSES = 8, FAKE_DEVICES = 32 };
+
+struct i2c_master_bus_t{
+    bool used;
+};
+
+struct i2c_master_dev_t{
+    bool used;
+};
+
+static struct i2c_master_bus_t buses[FAKE_BUSES];
+static struct i2c_master_dev_t devices[FAKE_DEVICES];
+
+fake_esp_idf_t fake_esp = {0};
+
+void fake_esp_fail_at(uint32_t step){
+    fake_esp.steps = 0u;
+    fake_esp.fail_step = step;
+}
+
+static bool fake_step_fails(void){
+    fake_esp.steps += 1u;
+    return fake_esp.steps == fake_esp.fail_step;
+}
+
+esp_err_t i2c_new_master_bus(const i2c_master_bus_config_t* bus_config, i2c_master_bus_handle_t* ret_bus_handle){
+    if(NULL == bus_config || NULL == ret_bus_handle){
+        return ESP_ERR_INVALID_ARG;
+    }else if(fake_step_fails()){
+        return ESP_FAIL;
+    }
+    for(uint32_t i = 0; i < FAKE_BUSES; i++){
+        if(!buses[i].used){
+            buses[i].used = true;
+            fake_esp.live_buses += 1u;
+            *ret_bus_handle = &buses[i];
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NO_MEM;
+}
+
+esp_err_t i2c_del_master_bus(i2c_master_bus_handle_t bus_handle){
+    if(NULL == bus_handle || !bus_handle->used){
+        return ESP_ERR_INVALID_ARG;
+    }else if(fake_step_fails()){
+        return ESP_FAIL;
+    }
+    bus_handle->used = false;
+    fake_esp.live_buses -= 1u;
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_bus_add_device(i2c_master_bus_handle_t bus_handle, const i2c_device_config_t* dev_config, i2c_master_dev_handle_t* ret_handle){
+    if(NULL == bus_handle || !bus_handle->used || NULL == dev_config || NULL == ret_handle){
+        return ESP_ERR_INVALID_ARG;
+    }else if(fake_step_fails()){
+        return ESP_FAIL;
+    }
+    for(uint32_t i = 0; i < FAKE_DEVICES; i++){
+        if(!devices[i].used){
+            devices[i].used = true;
+            fake_esp.live_devices += 1u;
+            *ret_handle = &devices[i];
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NO_MEM;
+}
+
+esp_err_t i2c_master_bus_rm_device(i2c_master_dev_handle_t handle){
+    if(NULL == handle || !handle->used){
+        return ESP_ERR_INVALID_ARG;
+    }else if(fake_step_fails()){
+        return ESP_FAIL;
+    }
+    handle->used = false;
+    fake_esp.live_devices -= 1u;
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_bus_reset(i2c_master_bus_handle_t bus_handle){
+    return (NULL == bus_handle) ? ESP_ERR_INVALID_ARG : ESP_OK;
+}
+
+esp_err_t i2c_master_transmit(i2c_master_dev_handle_t i2c_dev, const uint8_t* write_buffer, size_t write_size, int xfer_timeout_ms){
+    (void)write_size;
+    (void)xfer_timeout_ms;
+    return (NULL == i2c_dev || NULL == write_buffer) ? ESP_ERR_INVALID_ARG : ESP_OK;
+}
+
+esp_err_t i2c_master_multi_buffer_transmit(i2c_master_dev_handle_t i2c_dev, i2c_master_transmit_multi_buffer_info_t* buffer_info_array, size_t array_size, int xfer_timeout_ms){
+    (void)array_size;
+    (void)xfer_timeout_ms;
+    return (NULL == i2c_dev || NULL == buffer_info_array) ? ESP_ERR_INVALID_ARG : ESP_OK;
+}
+
+esp_err_t i2c_master_transmit_receive(i2c_master_dev_handle_t i2c_dev, const uint8_t* write_buffer, size_t write_size, uint8_t* read_buffer, size_t read_size, int xfer_timeout_ms){
+    (void)write_size;
+    (void)xfer_timeout_ms;
+    if(NULL == i2c_dev || NULL == write_buffer || NULL == read_buffer){
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(read_buffer,0,read_size);
+    return ESP_OK;
+}
+
+int64_t esp_timer_get_time(void){
+    struct timespec now = {0};
+    clock_gettime(CLOCK_MONOTONIC,&now);
+    return (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+void esp_rom_delay_us(uint32_t us){
+    (void)us;
+}
+
+void vTaskDelay(TickType_t ticks){
+    (void)ticks;
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void){
+    //the port takes its locks from a static pool, a heap mutex is a bug
+    abort();
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutexStatic(StaticSemaphore_t* buffer){
+    fake_esp.live_semaphores += 1u;
+    return buffer;
+}
+
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t semaphore, TickType_t ticks){
+    (void)ticks;
+    return (NULL == semaphore) ? pdFALSE : pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t semaphore){
+    return (NULL == semaphore) ? pdFALSE : pdTRUE;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore){
+    if(NULL != semaphore){
+        fake_esp.live_semaphores -= 1u;
+    }
+}
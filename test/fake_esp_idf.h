@@ -0,0 +1,25 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * host stand-in for the esp-idf i2c master driver and the freertos calls of ds3231_lib_private.c,
+ * declared by the headers in esp_idf/. handles come from static tables and the live ones are
+ * counted, so a test can see what an init or deinit path leaves behind. transfers succeed and
+ * read zeros.
+ */
+
+typedef struct{
+  uint32_t live_buses;
+  uint32_t live_devices;
+  uint32_t live_semaphores;
+  /** handle creations and deletions so far */
+  uint32_t steps;
+  /** the creation or deletion with this step number fails, 0 never */
+  uint32_t fail_step;
+}fake_esp_idf_t;
+
+extern fake_esp_idf_t fake_esp;
+
+/** restart the step count, the creation or deletion numbered step then fails (0 never). live handles stay */
+void fake_esp_fail_at(uint32_t step);
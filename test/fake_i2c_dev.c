@@ -0,0 +1,266 @@
+#include "fake_i2c_dev.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+
+static const uint16_t fake_i2c_device_address = 0x68u;
+
+fake_i2c_dev_t fake_i2c = {.fd = -1};
+
+int __real_open(const char* path, int flags, ...);
+int __real_close(int fd);
+int __real_ioctl(int fd, unsigned long request, ...);
+ssize_t __real_read(int fd, void* buf, size_t count);
+ssize_t __real_write(int fd, const void* buf, size_t count);
+
+
+void fake_i2c_reset(unsigned long funcs){
+    memset(fake_i2c.regs,0,sizeof(fake_i2c.regs));
+    fake_i2c.pointer = 0u;
+    fake_i2c.funcs = funcs;
+    fake_i2c.slave = 0u;
+    //an adapter that starts with 1s and retries on its own
+    fake_i2c.timeout = 100u;
+    fake_i2c.retries = 3u;
+    fake_i2c.fail_count = 0u;
+    fake_i2c.fail_errno = 0;
+    fake_i2c_reset_counters();
+}
+
+void fake_i2c_reset_counters(void){
+    fake_i2c.opens = 0u;
+    fake_i2c.closes = 0u;
+    fake_i2c.ioctls = 0u;
+    fake_i2c.reads = 0u;
+    fake_i2c.writes = 0u;
+    fake_i2c.msgs = 0u;
+    fake_i2c.smbus = 0u;
+    fake_i2c.log_length = 0u;
+}
+
+uint32_t fake_i2c_syscalls(void){
+    return fake_i2c.opens + fake_i2c.closes + fake_i2c.ioctls + fake_i2c.reads + fake_i2c.writes;
+}
+
+static void fake_log(bool read, uint8_t reg_address, uint32_t byte_length){
+    if(FAKE_I2C_LOG_SIZE > fake_i2c.log_length){
+        fake_i2c.log[fake_i2c.log_length] = (fake_i2c_transfer_t){
+            .read = read,
+            .reg_address = reg_address,
+            .byte_length = (uint8_t)byte_length
+        };
+    }
+    fake_i2c.log_length += 1u;
+}
+
+/** the register pointer wraps after the last register like on the chip */
+static uint8_t fake_next(void){
+    const uint8_t reg_address = fake_i2c.pointer;
+    fake_i2c.pointer = (sizeof(fake_i2c.regs) - 1u == reg_address) ? 0u : reg_address + 1u;
+    return reg_address;
+}
+
+static bool fake_fail(void){
+    if(0u < fake_i2c.fail_count){
+        fake_i2c.fail_count -= 1u;
+        errno = fake_i2c.fail_errno;
+        return true;
+    }
+    return false;
+}
+
+static int fake_rdwr(struct i2c_rdwr_ioctl_data* data){
+    if(NULL == data || 0u == data->nmsgs || I2C_RDWR_IOCTL_MAX_MSGS < data->nmsgs || !(fake_i2c.funcs & I2C_FUNC_I2C)){
+        errno = EINVAL;
+        return -1;
+    }
+    for(uint32_t i = 0; i < data->nmsgs; i++){
+        const struct i2c_msg* msg = &data->msgs[i];
+        if(fake_i2c_device_address != msg->addr){
+            errno = ENXIO;
+            return -1;
+        }else if((msg->flags & I2C_M_NOSTART) && (0u == i || !(fake_i2c.funcs & I2C_FUNC_NOSTART))){
+            errno = EOPNOTSUPP;
+            return -1;
+        }
+    }
+    if(fake_fail()){
+        return -1;
+    }
+    uint8_t reg_address = fake_i2c.pointer;
+    uint32_t byte_length = 0u;
+    bool read = false;
+    for(uint32_t i = 0; i < data->nmsgs; i++){
+        const struct i2c_msg* msg = &data->msgs[i];
+        uint16_t start = 0u;
+        if(!(msg->flags & (I2C_M_RD | I2C_M_NOSTART)) && 0u < msg->len){
+            //a new write message starts with the register address
+            fake_i2c.pointer = msg->buf[0] % sizeof(fake_i2c.regs);
+            reg_address = fake_i2c.pointer;
+            start = 1u;
+        }
+        for(uint16_t k = start; k < msg->len; k++){
+            if(msg->flags & I2C_M_RD){
+                msg->buf[k] = fake_i2c.regs[fake_next()];
+            }else{
+                fake_i2c.regs[fake_next()] = msg->buf[k];
+            }
+        }
+        read |= (msg->flags & I2C_M_RD);
+        byte_length += msg->len - start;
+        fake_i2c.msgs += 1u;
+    }
+    fake_log(read,reg_address,byte_length);
+    return (int)data->nmsgs;
+}
+
+static int fake_smbus(struct i2c_smbus_ioctl_data* args){
+    if(NULL == args || NULL == args->data){
+        errno = EINVAL;
+        return -1;
+    }else if(fake_i2c_device_address != fake_i2c.slave){
+        errno = ENXIO;
+        return -1;
+    }
+    const bool read = I2C_SMBUS_READ == args->read_write;
+    uint32_t byte_length = 0u;
+    if(I2C_SMBUS_BYTE_DATA == args->size && (fake_i2c.funcs & I2C_FUNC_SMBUS_BYTE_DATA)){
+        byte_length = 1u;
+    }else if(I2C_SMBUS_I2C_BLOCK_DATA == args->size && (fake_i2c.funcs & I2C_FUNC_SMBUS_I2C_BLOCK)
+                && 0u < args->data->block[0] && I2C_SMBUS_BLOCK_MAX >= args->data->block[0]){
+        byte_length = args->data->block[0];
+    }else{
+        errno = EOPNOTSUPP;
+        return -1;
+    }
+    if(fake_fail()){
+        return -1;
+    }
+    fake_i2c.pointer = args->command % sizeof(fake_i2c.regs);
+    uint8_t* bytes = (1u == byte_length && I2C_SMBUS_BYTE_DATA == args->size) ? &args->data->byte : &args->data->block[1];
+    for(uint32_t k = 0; k < byte_length; k++){
+        if(read){
+            bytes[k] = fake_i2c.regs[fake_next()];
+        }else{
+            fake_i2c.regs[fake_next()] = bytes[k];
+        }
+    }
+    fake_i2c.smbus += 1u;
+    fake_log(read,args->command,byte_length);
+    return 0;
+}
+
+int __wrap_open(const char* path, int flags, ...){
+    mode_t mode = 0;
+    if(flags & O_CREAT){
+        va_list args;
+        va_start(args,flags);
+        mode = va_arg(args,mode_t);
+        va_end(args);
+    }
+    char fake_path[20] = {0};
+    snprintf(fake_path,sizeof(fake_path),"/dev/i2c-%d",FAKE_I2C_PORT);
+    if(0 != strcmp(path,fake_path)){
+        return __real_open(path,flags,mode);
+    }else if(0 <= fake_i2c.fd){
+        errno = EBUSY;
+        return -1;
+    }else{
+        //a real descriptor so the number can't collide with anything else
+        fake_i2c.fd = __real_open("/dev/null",O_RDWR | (flags & O_CLOEXEC));
+        fake_i2c.opens += 1u;
+        return fake_i2c.fd;
+    }
+}
+
+int __wrap_close(int fd){
+    if(0 <= fd && fd == fake_i2c.fd){
+        fake_i2c.fd = -1;
+        fake_i2c.closes += 1u;
+    }
+    return __real_close(fd);
+}
+
+int __wrap_ioctl(int fd, unsigned long request, ...){
+    va_list args;
+    va_start(args,request);
+    void* arg = va_arg(args,void*);
+    va_end(args);
+    if(0 > fd || fd != fake_i2c.fd){
+        return __real_ioctl(fd,request,arg);
+    }
+    fake_i2c.ioctls += 1u;
+    switch(request){
+        case(I2C_FUNCS):
+            *(unsigned long*)arg = fake_i2c.funcs;
+            return 0;
+        case(I2C_SLAVE):
+        case(I2C_SLAVE_FORCE):
+            fake_i2c.slave = (uint16_t)(uintptr_t)arg;
+            return 0;
+        case(I2C_TIMEOUT):
+            fake_i2c.timeout = (unsigned long)(uintptr_t)arg;
+            return 0;
+        case(I2C_RETRIES):
+            fake_i2c.retries = (unsigned long)(uintptr_t)arg;
+            return 0;
+        case(I2C_RDWR):
+            return fake_rdwr((struct i2c_rdwr_ioctl_data*)arg);
+        case(I2C_SMBUS):
+            return fake_smbus((struct i2c_smbus_ioctl_data*)arg);
+        default:
+            errno = ENOTTY;
+            return -1;
+    }
+}
+
+ssize_t __wrap_read(int fd, void* buf, size_t count){
+    if(0 > fd || fd != fake_i2c.fd){
+        return __real_read(fd,buf,count);
+    }
+    fake_i2c.reads += 1u;
+    if(fake_i2c_device_address != fake_i2c.slave || !(fake_i2c.funcs & I2C_FUNC_I2C)){
+        errno = ENXIO;
+        return -1;
+    }else if(fake_fail()){
+        return -1;
+    }
+    const uint8_t reg_address = fake_i2c.pointer;
+    for(size_t k = 0; k < count; k++){
+        ((uint8_t*)buf)[k] = fake_i2c.regs[fake_next()];
+    }
+    fake_log(true,reg_address,(uint32_t)count);
+    return (ssize_t)count;
+}
+
+ssize_t __wrap_write(int fd, const void* buf, size_t count){
+    if(0 > fd || fd != fake_i2c.fd){
+        return __real_write(fd,buf,count);
+    }
+    fake_i2c.writes += 1u;
+    if(fake_i2c_device_address != fake_i2c.slave || !(fake_i2c.funcs & I2C_FUNC_I2C)){
+        errno = ENXIO;
+        return -1;
+    }else if(fake_fail()){
+        return -1;
+    }else if(0u == count){
+        return 0;
+    }
+    const uint8_t* bytes = (const uint8_t*)buf;
+    fake_i2c.pointer = bytes[0] % sizeof(fake_i2c.regs);
+    const uint8_t reg_address = fake_i2c.pointer;
+    for(size_t k = 1; k < count; k++){
+        fake_i2c.regs[fake_next()] = bytes[k];
+    }
+    //a lone register address only moves the pointer for the following read()
+    if(1u < count){
+        fake_log(false,reg_address,(uint32_t)(count - 1u));
+    }
+    return (ssize_t)count;
+}
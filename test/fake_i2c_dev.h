@@ -0,0 +1,60 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * in-process stand-in for /dev/i2c-FAKE_I2C_PORT with a ds3231 at 0x68, for the linux port.
+ * link with -Wl,--wrap=open,--wrap=close,--wrap=ioctl,--wrap=read,--wrap=write: calls on the
+ * fake path and its descriptor are served here and counted, everything else goes to the kernel.
+ * the adapter answers I2C_FUNCS, I2C_SLAVE, I2C_TIMEOUT, I2C_RETRIES, I2C_RDWR, I2C_SMBUS and plain read()/write() as
+ * i2c-dev does. the register file does not tick, a write moves the register pointer like on the chip.
+ */
+
+#define FAKE_I2C_PORT 99
+#define FAKE_I2C_LOG_SIZE 64u
+
+/** one transfer as seen on the bus */
+typedef struct{
+  bool read;
+  uint8_t reg_address;
+  uint8_t byte_length;
+}fake_i2c_transfer_t;
+
+typedef struct{
+  uint8_t regs[0x13];
+  uint8_t pointer;
+  /** I2C_FUNC_* bits the adapter reports */
+  unsigned long funcs;
+  /** address set with I2C_SLAVE, used by smbus and read()/write() */
+  uint16_t slave;
+  /** I2C_TIMEOUT in 10ms steps and I2C_RETRIES as last set */
+  unsigned long timeout;
+  unsigned long retries;
+  int fd;
+  /** syscalls on the fake */
+  uint32_t opens;
+  uint32_t closes;
+  uint32_t ioctls;
+  uint32_t reads;
+  uint32_t writes;
+  /** I2C_RDWR messages and I2C_SMBUS transfers */
+  uint32_t msgs;
+  uint32_t smbus;
+  /** the next fail_count transfers fail with fail_errno */
+  uint32_t fail_count;
+  int fail_errno;
+  /** transfers in order, stops counting at FAKE_I2C_LOG_SIZE */
+  fake_i2c_transfer_t log[FAKE_I2C_LOG_SIZE];
+  uint32_t log_length;
+}fake_i2c_dev_t;
+
+extern fake_i2c_dev_t fake_i2c;
+
+/** clear the registers and counters, the adapter reports funcs */
+void fake_i2c_reset(unsigned long funcs);
+
+/** clear the syscall counters and the transfer log */
+void fake_i2c_reset_counters(void);
+
+/** syscalls on the fake since the last reset */
+uint32_t fake_i2c_syscalls(void);
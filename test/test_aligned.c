@@ -0,0 +1,103 @@
+#include "ds3231_test.h"
+
+/**
+ * error bounds of ds3231_get_time_aligned and ds3231_set_time_aligned against the simulator's own
+ * countdown chain, over several transaction latencies and phases: the reported edge and start are
+ * within the reported bound of the true rollover, and the bound stays within the transport latency.
+ * a set that comes too late fails without writing the clock.
+ */
+
+static const uint64_t NS_PER_SECOND = 1000000000u;
+
+/** simulated time the current second started, valid while no tick passed since */
+static uint64_t true_second_start(const ds3231_sim_t* sim){
+    return sim->now_ns - sim->phase_ns;
+}
+
+static uint64_t distance(uint64_t a, uint64_t b){
+    return (a > b) ? a - b : b - a;
+}
+
+static void check_get_aligned(uint32_t latency_ns, uint64_t phase_ns){
+    ds3231_sim_t sim;
+    ds3231_dev_t dev;
+    TEST_CHECK(test_sim_device(&sim,&dev,latency_ns));
+    TEST_CHECK(ds3231_sim_advance_ns(&sim,phase_ns));
+    ds3231_time_data_t t = {0};
+    uint64_t edge_ns = 0;
+    uint32_t bound_ns = 0;
+    TEST_CHECK(ds3231_get_time_aligned(&dev,&t,&edge_ns,&bound_ns));
+    const uint64_t true_edge_ns = true_second_start(&sim);
+    if(distance(edge_ns,true_edge_ns) > bound_ns || bound_ns > 2u * latency_ns){
+        fprintf(stderr,"get latency %u phase %llu: edge %llu true %llu bound %u\n",latency_ns,
+                (unsigned long long)phase_ns,(unsigned long long)edge_ns,(unsigned long long)true_edge_ns,bound_ns);
+        test_failures += 1u;
+    }
+    TEST_CHECK(t.seconds == (uint8_t)(((sim.regs[0x00] >> 4u) & 0x07u) * 10u + (sim.regs[0x00] & 0x0Fu)));
+    TEST_CHECK(ds3231_deinit(&dev));
+}
+
+static void check_set_aligned(uint32_t latency_ns, uint64_t lead_ns){
+    ds3231_sim_t sim;
+    ds3231_dev_t dev;
+    TEST_CHECK(test_sim_device(&sim,&dev,latency_ns));
+    TEST_CHECK(ds3231_sim_advance_ns(&sim,NS_PER_SECOND / 3u));
+    ds3231_time_data_t target = {.seconds = 30u, .minutes = 15u, .hours = 10u, .day_of_week = 3u,
+                                 .day_of_month = 14u, .month = 10u, .year = 26u};
+    const uint64_t start_ns = sim.now_ns + lead_ns;
+    uint32_t bound_ns = 0;
+    TEST_CHECK(ds3231_set_time_aligned(&dev,true,&target,start_ns,&bound_ns));
+    const uint64_t true_start_ns = true_second_start(&sim);
+    if(distance(true_start_ns,start_ns) > bound_ns || bound_ns > latency_ns){
+        fprintf(stderr,"set latency %u lead %llu: start %llu true %llu bound %u\n",latency_ns,
+                (unsigned long long)lead_ns,(unsigned long long)start_ns,(unsigned long long)true_start_ns,bound_ns);
+        test_failures += 1u;
+    }
+    TEST_CHECK(0x30u == sim.regs[0x00] && 0x15u == sim.regs[0x01] && 0x10u == sim.regs[0x02] && 0x14u == sim.regs[0x04]);
+
+    //the edge read back is on the grid of start_ns within both bounds
+    ds3231_time_data_t t = {0};
+    uint64_t edge_ns = 0;
+    uint32_t edge_bound_ns = 0;
+    TEST_CHECK(ds3231_get_time_aligned(&dev,&t,&edge_ns,&edge_bound_ns));
+    const uint64_t seconds = (edge_ns + NS_PER_SECOND / 2u - start_ns) / NS_PER_SECOND;
+    TEST_CHECK(distance(edge_ns,start_ns + seconds * NS_PER_SECOND) <= (uint64_t)bound_ns + edge_bound_ns);
+    TEST_CHECK(30u + seconds == t.seconds && 15u == t.minutes);
+    TEST_CHECK(ds3231_deinit(&dev));
+}
+
+/** a start that can't be met fails before the clock is written */
+static void check_too_late(void){
+    ds3231_sim_t sim;
+    ds3231_dev_t dev;
+    TEST_CHECK(test_sim_device(&sim,&dev,250000u));
+    TEST_CHECK(ds3231_sim_advance_ns(&sim,5u * NS_PER_SECOND + NS_PER_SECOND / 2u));
+    uint8_t before[7];
+    for(uint8_t i = 0; i < 7u; i++){
+        before[i] = sim.regs[i];
+    }
+    const uint64_t phase_ns = sim.phase_ns;
+    ds3231_time_data_t target = {.seconds = 30u, .minutes = 15u, .hours = 10u, .day_of_week = 3u,
+                                 .day_of_month = 14u, .month = 10u, .year = 26u};
+    uint32_t bound_ns = 0;
+    TEST_CHECK(!ds3231_set_time_aligned(&dev,true,&target,sim.now_ns + 100000u,&bound_ns));
+    for(uint8_t i = 0; i < 7u; i++){
+        TEST_CHECK(before[i] == sim.regs[i]);
+    }
+    //the countdown chain was not reset either
+    TEST_CHECK(sim.phase_ns > phase_ns);
+    TEST_CHECK(ds3231_deinit(&dev));
+}
+
+int main(void){
+    static const uint32_t latencies_ns[] = {20000u, 250000u, 1000000u, 5000000u};
+    static const uint64_t phases_ns[] = {0u, 1000u, 333333333u, 500000000u, 999000000u, 999999000u};
+    for(uint32_t l = 0; l < sizeof(latencies_ns) / sizeof(latencies_ns[0]); l++){
+        for(uint32_t p = 0; p < sizeof(phases_ns) / sizeof(phases_ns[0]); p++){
+            check_get_aligned(latencies_ns[l],phases_ns[p]);
+            check_set_aligned(latencies_ns[l],2u * NS_PER_SECOND + phases_ns[p]);
+        }
+    }
+    check_too_late();
+    return test_result("test_aligned");
+}
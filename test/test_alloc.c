@@ -0,0 +1,178 @@
+#include "ds3231_test.h"
+#include "fake_esp_idf.h"
+
+/**
+ * the esp-idf port (ds3231_lib_private.c) against fake_esp_idf.c with malloc, calloc, realloc
+ * and free counted: init, attach and deinit of devices and buses never touch the heap, and a
+ * failure at any step of them leaves no bus, device or lock behind.
+ * also times init/deinit on the host, i.e. the driver's own share of the boot budget.
+ * usage: test_alloc [rounds]
+ */
+
+static bool counting = false;
+static uint32_t allocations = 0u;
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* p, size_t size);
+void __real_free(void* p);
+
+void* __wrap_malloc(size_t size){
+    allocations += counting;
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size){
+    allocations += counting;
+    return __real_calloc(count,size);
+}
+
+void* __wrap_realloc(void* p, size_t size){
+    allocations += counting;
+    return __real_realloc(p,size);
+}
+
+void __wrap_free(void* p){
+    allocations += counting && (NULL != p);
+    __real_free(p);
+}
+
+static bool nothing_live(void){
+    return 0u == fake_esp.live_buses && 0u == fake_esp.live_devices && 0u == fake_esp.live_semaphores;
+}
+
+/** a failed deinit is retried without injected failures, as a caller would */
+static bool deinit_device(ds3231_dev_t* dev){
+    if(ds3231_deinit(dev)){
+        return true;
+    }
+    fake_esp_fail_at(0u);
+    return ds3231_deinit(dev);
+}
+
+static bool deinit_bus(ds3231_bus_t* bus){
+    if(ds3231_bus_deinit(bus)){
+        return true;
+    }
+    fake_esp_fail_at(0u);
+    return ds3231_bus_deinit(bus);
+}
+
+/** own bus: new bus, add device, remove device, delete bus */
+static void check_device_failures(void){
+    for(uint32_t step = 1; step <= 5; step++){
+        ds3231_dev_t dev = {0};
+        fake_esp_fail_at(step);
+        if(ds3231_init(&dev,21,22,0,false)){
+            ds3231_time_data_t t;
+            TEST_CHECK(ds3231_get_time(&dev,&t));
+            TEST_CHECK(deinit_device(&dev));
+        }
+        TEST_CHECK(!dev.__i2c_init_f && NULL == dev.i2c_bus && NULL == dev.i2c_dev);
+        TEST_CHECK(nothing_live());
+    }
+}
+
+/** shared bus with a mux: new bus, add mux, add device, remove device, remove mux, delete bus */
+static void check_bus_failures(void){
+    for(uint32_t step = 1; step <= 7; step++){
+        ds3231_bus_t bus = {0};
+        ds3231_dev_t dev = {0};
+        fake_esp_fail_at(step);
+        if(ds3231_bus_init(&bus,21,22,0,0x70)){
+            if(ds3231_bus_attach(&dev,&bus,3)){
+                TEST_CHECK(deinit_device(&dev));
+            }
+            TEST_CHECK(0u == bus.__devices);
+            TEST_CHECK(deinit_bus(&bus));
+        }
+        TEST_CHECK(!bus.__i2c_init_f && NULL == bus.__lock);
+        TEST_CHECK(nothing_live());
+    }
+    fake_esp_fail_at(0u);
+}
+
+/** the bus locks come from a static pool */
+static void check_pool(void){
+    ds3231_bus_t buses[DS3231_BUS_POOL_SIZE + 1] = {0};
+    for(uint32_t i = 0; i < DS3231_BUS_POOL_SIZE; i++){
+        TEST_CHECK(ds3231_bus_init(&buses[i],21,22,(int32_t)i,0));
+    }
+    TEST_CHECK(!ds3231_bus_init(&buses[DS3231_BUS_POOL_SIZE],21,22,DS3231_BUS_POOL_SIZE,0));
+    TEST_CHECK(DS3231_BUS_POOL_SIZE == fake_esp.live_buses);
+    TEST_CHECK(ds3231_bus_deinit(&buses[0]));
+    TEST_CHECK(ds3231_bus_init(&buses[DS3231_BUS_POOL_SIZE],21,22,DS3231_BUS_POOL_SIZE,0));
+    for(uint32_t i = 1; i <= DS3231_BUS_POOL_SIZE; i++){
+        TEST_CHECK(ds3231_bus_deinit(&buses[i]));
+    }
+    TEST_CHECK(nothing_live());
+}
+
+typedef struct{
+    uint64_t total_ns;
+    uint64_t max_ns;
+}latency_t;
+
+static void latency_add(latency_t* latency, uint64_t start_ns){
+    const uint64_t ns = test_now_ns() - start_ns;
+    latency->total_ns += ns;
+    latency->max_ns = (ns > latency->max_ns) ? ns : latency->max_ns;
+}
+
+static void latency_print(const char* name, const latency_t* latency, uint32_t rounds){
+    printf("%-18s %10.0f %10llu\n",name,(double)latency->total_ns / rounds,(unsigned long long)latency->max_ns);
+}
+
+static void measure_latency(uint32_t rounds){
+    latency_t init = {0};
+    latency_t deinit = {0};
+    latency_t bus_init = {0};
+    latency_t attach = {0};
+    latency_t detach = {0};
+    latency_t bus_deinit = {0};
+    for(uint32_t i = 0; i < rounds; i++){
+        ds3231_dev_t dev = {0};
+        ds3231_bus_t bus = {0};
+        uint64_t start_ns = test_now_ns();
+        TEST_CHECK(ds3231_init(&dev,21,22,0,false));
+        latency_add(&init,start_ns);
+        start_ns = test_now_ns();
+        TEST_CHECK(ds3231_deinit(&dev));
+        latency_add(&deinit,start_ns);
+
+        start_ns = test_now_ns();
+        TEST_CHECK(ds3231_bus_init(&bus,21,22,0,0x70));
+        latency_add(&bus_init,start_ns);
+        start_ns = test_now_ns();
+        TEST_CHECK(ds3231_bus_attach(&dev,&bus,0));
+        latency_add(&attach,start_ns);
+        start_ns = test_now_ns();
+        TEST_CHECK(ds3231_deinit(&dev));
+        latency_add(&detach,start_ns);
+        start_ns = test_now_ns();
+        TEST_CHECK(ds3231_bus_deinit(&bus));
+        latency_add(&bus_deinit,start_ns);
+    }
+    counting = false;
+    printf("host latency over %u rounds, esp-idf driver calls stubbed\n%-18s %10s %10s\n",rounds,"call","mean ns","max ns");
+    latency_print("ds3231_init",&init,rounds);
+    latency_print("ds3231_deinit",&deinit,rounds);
+    latency_print("ds3231_bus_init",&bus_init,rounds);
+    latency_print("ds3231_bus_attach",&attach,rounds);
+    latency_print("ds3231_deinit (bus)",&detach,rounds);
+    latency_print("ds3231_bus_deinit",&bus_deinit,rounds);
+}
+
+int main(int argc, char** argv){
+    const uint32_t rounds = test_arg_count(argc,argv,1,100000u);
+    counting = true;
+    check_device_failures();
+    check_bus_failures();
+    check_pool();
+    measure_latency((0u == rounds) ? 1u : rounds);
+    //measure_latency stops counting before it prints
+    printf("heap calls during init/deinit: %u\n",allocations);
+    TEST_CHECK(0u == allocations);
+    TEST_CHECK(nothing_live());
+    return test_result("test_alloc");
+}
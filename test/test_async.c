@@ -0,0 +1,273 @@
+#include <string.h>
+#include "ds3231_test.h"
+#include "ds3231_lib_async.h"
+
+/**
+ * the async queue against the simulator: overlapping and gapped reads merged into one burst or
+ * split, writes to consecutive registers merged and overlapping ones kept apart, the data each
+ * operation gets, the bus transactions counted by the queue and by the simulator, future
+ * latencies in simulated time and a full queue refusing operations.
+ */
+
+static const uint32_t LATENCY_NS = 100000u;
+
+typedef struct{
+    uint32_t calls;
+    uint32_t order[DS3231_ASYNC_QUEUE_SIZE];
+}completion_log_t;
+
+static completion_log_t log_of_calls;
+
+static void on_done(bool result, void* ctx){
+    if(result){
+        log_of_calls.order[log_of_calls.calls % DS3231_ASYNC_QUEUE_SIZE] = (uint32_t)(uintptr_t)ctx;
+    }
+    log_of_calls.calls += 1u;
+}
+
+static void setup(ds3231_sim_t* sim, ds3231_dev_t* dev, ds3231_async_t* async){
+    TEST_CHECK(test_sim_device(sim,dev,LATENCY_NS));
+    TEST_CHECK(ds3231_set_unix_time(dev,1760000000,true));
+    TEST_CHECK(ds3231_sim_set_temperature(sim,4 * 25 + 3));
+    //a conversion lands the temperature, then a second known to be far from its end
+    TEST_CHECK(ds3231_sim_advance_ns(sim,64000000000ull + 300000000u));
+    //alarm registers 0x07-0x0D hold a pattern to tell the bytes apart
+    for(uint8_t reg = 0x07u; reg <= 0x0Du; reg++){
+        sim->regs[reg] = (uint8_t)(0x10u + reg);
+    }
+    TEST_CHECK(ds3231_async_init(async,dev));
+    TEST_CHECK(ds3231_sim_reset_counters(sim));
+    log_of_calls = (completion_log_t){0};
+}
+
+/** poll and check the bus transactions it took, by the queue's count and the simulator's */
+static void poll_expecting(ds3231_sim_t* sim, ds3231_async_t* async, uint32_t operations, uint32_t transactions){
+    const uint32_t queue_before = async->transactions;
+    const uint32_t sim_before = sim->transactions;
+    uint32_t completed = 0;
+    TEST_CHECK(ds3231_async_poll(async,&completed));
+    if(operations != completed || transactions != async->transactions - queue_before
+            || transactions != sim->transactions - sim_before){
+        fprintf(stderr,"expected %u operations in %u transactions, %u operations in %u (simulator %u)\n",operations,
+                transactions,completed,async->transactions - queue_before,sim->transactions - sim_before);
+        test_failures += 1u;
+    }
+}
+
+static void check_overlapping_reads(void){
+    ds3231_sim_t sim;
+    ds3231_dev_t dev;
+    ds3231_async_t async;
+    setup(&sim,&dev,&async);
+    uint8_t seconds[3] = {0};
+    uint8_t alarm[4] = {0};
+    uint8_t status = 0;
+    ds3231_time_data_t time = {0};
+    //0x00-0x02, 0x00-0x06 and 0x05-0x08 overlap, 0x0F is three registers past 0x0B
+    uint8_t control[2] = {0};
+    TEST_CHECK(ds3231_async_read(&async,0x00u,seconds,3u,NULL));
+    TEST_CHECK(ds3231_async_get_time(&async,&time,NULL));
+    TEST_CHECK(ds3231_async_read(&async,0x05u,alarm,4u,NULL));
+    TEST_CHECK(ds3231_async_read(&async,0x0Au,control,2u,NULL));
+    TEST_CHECK(ds3231_async_read(&async,0x0Fu,&status,1u,NULL));
+    uint8_t regs[0x13];
+    memcpy(regs,sim.regs,sizeof(regs));
+    poll_expecting(&sim,&async,5u,1u);
+    TEST_CHECK(0 == memcmp(seconds,&regs[0x00],3u) && 0 == memcmp(alarm,&regs[0x05],4u));
+    TEST_CHECK(0 == memcmp(control,&regs[0x0A],2u) && regs[0x0F] == status);
+    ds3231_time_data_t expected = {0};
+    TEST_CHECK(ds3231_decode_time(regs,&expected) && 0 == memcmp(&expected,&time,sizeof(time)));
+    //the burst covered 0x00-0x0F
+    TEST_CHECK(3u + 16u == sim.wire_bytes);
+
+    //merged backwards too: 0x08-0x0A is three registers before 0x0E
+    int8_t number = 0;
+    uint8_t fraction = 0;
+    TEST_CHECK(ds3231_async_read(&async,0x0Eu,control,2u,NULL));
+    TEST_CHECK(ds3231_async_read(&async,0x08u,alarm,3u,NULL));
+    TEST_CHECK(ds3231_async_get_temperature(&async,&number,&fraction,NULL));
+    memcpy(regs,sim.regs,sizeof(regs));
+    poll_expecting(&sim,&async,3u,1u);
+    TEST_CHECK(0 == memcmp(control,&regs[0x0E],2u) && 0 == memcmp(alarm,&regs[0x08],3u));
+    TEST_CHECK(25 == number && 3u == fraction);
+    TEST_CHECK(ds3231_deinit(&dev));
+}
+
+static void check_gapped_reads(void){
+    ds3231_sim_t sim;
+    ds3231_dev_t dev;
+    ds3231_async_t async;
+    setup(&sim,&dev,&async);
+    uint8_t first[2] = {0};
+    uint8_t second[2] = {0};
+    uint8_t third[3] = {0};
+    //a gap of four registers costs more than a new read: 0x00-0x01 then 0x06-0x07
+    TEST_CHECK(ds3231_async_read(&async,0x00u,first,2u,NULL));
+    TEST_CHECK(ds3231_async_read(&async,0x06u,second,2u,NULL));
+    poll_expecting(&sim,&async,2u,2u);
+    TEST_CHECK(0 == memcmp(first,&sim.regs[0x00],2u) && 0 == memcmp(second,&sim.regs[0x06],2u));
+
+    //and backwards: 0x0E-0x0F then 0x07-0x09
+    TEST_CHECK(ds3231_async_read(&async,0x0Eu,first,2u,NULL));
+    TEST_CHECK(ds3231_async_read(&async,0x07u,third,3u,NULL));
+    poll_expecting(&sim,&async,2u,2u);
+    TEST_CHECK(0 == memcmp(first,&sim.regs[0x0E],2u) && 0 == memcmp(third,&sim.regs[0x07],3u));
+
+    //a gap of exactly three is still merged
+    TEST_CHECK(ds3231_async_read(&async,0x00u,first,2u,NULL));
+    TEST_CHECK(ds3231_async_read(&async,0x05u,second,2u,NULL));
+    poll_expecting(&sim,&async,2u,1u);
+    TEST_CHECK(0 == memcmp(first,&sim.regs[0x00],2u) && 0 == memcmp(second,&sim.regs[0x05],2u));
+
+    //a write in between keeps the order: the second read sees the written value
+    const uint8_t value = 0x21u;
+    TEST_CHECK(ds3231_async_read(&async,0x07u,first,1u,NULL));
+    TEST_CHECK(ds3231_async_write(&async,0x07u,&value,1u,NULL));
+    TEST_CHECK(ds3231_async_read(&async,0x07u,second,1u,NULL));
+    poll_expecting(&sim,&async,3u,3u);
+    TEST_CHECK(0x17u == first[0] && value == second[0]);
+    TEST_CHECK(ds3231_deinit(&dev));
+}
+
+static void check_writes(void){
+    ds3231_sim_t sim;
+    ds3231_dev_t dev;
+    ds3231_async_t async;
+    setup(&sim,&dev,&async);
+    //0x07-0x08, 0x09-0x0A and 0x0B in one burst
+    const uint8_t a[2] = {0x01u, 0x02u};
+    const uint8_t b[2] = {0x03u, 0x04u};
+    const uint8_t c = 0x05u;
+    TEST_CHECK(ds3231_async_write(&async,0x07u,a,2u,NULL));
+    TEST_CHECK(ds3231_async_write(&async,0x09u,b,2u,NULL));
+    TEST_CHECK(ds3231_async_write(&async,0x0Bu,&c,1u,NULL));
+    poll_expecting(&sim,&async,3u,1u);
+    TEST_CHECK(0x01u == sim.regs[0x07] && 0x02u == sim.regs[0x08] && 0x03u == sim.regs[0x09]
+               && 0x04u == sim.regs[0x0A] && 0x05u == sim.regs[0x0B] && 0x1Cu == sim.regs[0x0C]);
+    TEST_CHECK(5u + 2u == sim.wire_bytes);
+    TEST_CHECK(!dev.__shadow_f);
+
+    //overlapping writes run one by one, the later one wins
+    const uint8_t d[2] = {0x11u, 0x12u};
+    const uint8_t e = 0x13u;
+    TEST_CHECK(ds3231_async_write(&async,0x07u,d,2u,NULL));
+    TEST_CHECK(ds3231_async_write(&async,0x08u,&e,1u,NULL));
+    poll_expecting(&sim,&async,2u,2u);
+    TEST_CHECK(0x11u == sim.regs[0x07] && 0x13u == sim.regs[0x08]);
+
+    //a gap is not filled with whatever the chip holds
+    TEST_CHECK(ds3231_async_write(&async,0x07u,&e,1u,NULL));
+    TEST_CHECK(ds3231_async_write(&async,0x09u,&e,1u,NULL));
+    poll_expecting(&sim,&async,2u,2u);
+    TEST_CHECK(0x13u == sim.regs[0x07] && 0x13u == sim.regs[0x08] && 0x13u == sim.regs[0x09]);
+
+    //set time runs ds3231_set_time, its clearing of OSF and the write are not merged or counted by the queue
+    const ds3231_time_data_t time = {.seconds = 5u, .minutes = 4u, .hours = 3u, .day_of_week = 2u,
+                                     .day_of_month = 1u, .month = 6u, .year = 30u};
+    TEST_CHECK(ds3231_async_set_time(&async,true,&time,NULL));
+    TEST_CHECK(ds3231_async_write(&async,0x07u,&c,1u,NULL));
+    const uint32_t queue_before = async.transactions;
+    TEST_CHECK(ds3231_sim_reset_counters(&sim) && ds3231_async_poll(&async,NULL));
+    TEST_CHECK(1u == async.transactions - queue_before && 3u + 1u == sim.transactions);
+    TEST_CHECK(0x05u == sim.regs[0x00] && 0x30u == sim.regs[0x06] && 0x05u == sim.regs[0x07]);
+    TEST_CHECK(ds3231_deinit(&dev));
+}
+
+static void check_futures(void){
+    ds3231_sim_t sim;
+    ds3231_dev_t dev;
+    ds3231_async_t async;
+    setup(&sim,&dev,&async);
+    ds3231_async_future_t futures[4];
+    uint8_t out[4][2];
+    bool result = false;
+    //queued 5 ms apart: the first waits for the others, the merged burst completes all three,
+    //the gapped read waits for the burst too
+    for(uint32_t i = 0; i < 3u; i++){
+        const ds3231_async_completion_t completion = {.cb = on_done, .ctx = (void*)(uintptr_t)(i + 1u), .future = &futures[i]};
+        TEST_CHECK(ds3231_async_read(&async,(uint8_t)(2u * i),out[i],2u,&completion));
+        TEST_CHECK(!ds3231_async_future_done(&futures[i],&result));
+        TEST_CHECK(ds3231_sim_advance_ns(&sim,5000000u));
+    }
+    const ds3231_async_completion_t last = {.cb = on_done, .ctx = (void*)(uintptr_t)4u, .future = &futures[3]};
+    TEST_CHECK(ds3231_async_read(&async,0x10u,out[3],2u,&last));
+    poll_expecting(&sim,&async,4u,2u);
+    const uint32_t latency_us = LATENCY_NS / 1000u;
+    TEST_CHECK(15000u + latency_us == futures[0].latency_us);
+    TEST_CHECK(10000u + latency_us == futures[1].latency_us);
+    TEST_CHECK(5000u + latency_us == futures[2].latency_us);
+    TEST_CHECK(2u * latency_us == futures[3].latency_us);
+    for(uint32_t i = 0; i < 4u; i++){
+        result = false;
+        TEST_CHECK(ds3231_async_future_done(&futures[i],&result) && result);
+        //callbacks ran in queue order, before the future completed
+        TEST_CHECK(i + 1u == log_of_calls.order[i]);
+    }
+    TEST_CHECK(4u == log_of_calls.calls && 4u == async.completed);
+
+    //a failed burst completes every merged operation with false and leaves their buffers alone
+    const ds3231_sim_fault_t nack = {.nack_ppm = 1000000u, .seed = 1u};
+    ds3231_policy_t policy;
+    TEST_CHECK(ds3231_default_policy(&policy));
+    policy.retries = 0u;
+    TEST_CHECK(ds3231_set_policy(&dev,&policy) && ds3231_sim_set_fault(&sim,&nack));
+    memset(out,0xAA,sizeof(out));
+    for(uint32_t i = 0; i < 2u; i++){
+        const ds3231_async_completion_t completion = {.cb = on_done, .future = &futures[i]};
+        TEST_CHECK(ds3231_async_read(&async,(uint8_t)(2u * i),out[i],2u,&completion));
+    }
+    TEST_CHECK(ds3231_async_poll(&async,NULL));
+    for(uint32_t i = 0; i < 2u; i++){
+        result = true;
+        TEST_CHECK(ds3231_async_future_done(&futures[i],&result) && !result);
+        TEST_CHECK(0xAAu == out[i][0] && 0xAAu == out[i][1]);
+    }
+    TEST_CHECK(6u == log_of_calls.calls);
+    TEST_CHECK(ds3231_deinit(&dev));
+}
+
+static bool count_call(ds3231_dev_t* dev, void* arg){
+    (void)dev;
+    *(uint32_t*)arg += 1u;
+    return true;
+}
+
+static void check_queue_full(void){
+    ds3231_sim_t sim;
+    ds3231_dev_t dev;
+    ds3231_async_t async;
+    setup(&sim,&dev,&async);
+    uint32_t calls = 0;
+    uint8_t out = 0;
+    for(uint32_t i = 0; i < DS3231_ASYNC_QUEUE_SIZE; i++){
+        TEST_CHECK(ds3231_async_call(&async,count_call,&calls,NULL));
+    }
+    //refused without touching the queued operations
+    TEST_CHECK(!ds3231_async_read(&async,0x00u,&out,1u,NULL));
+    TEST_CHECK(!ds3231_async_call(&async,count_call,&calls,NULL));
+    TEST_CHECK(DS3231_ASYNC_QUEUE_SIZE == atomic_load(&async.tail) - atomic_load(&async.head));
+    poll_expecting(&sim,&async,DS3231_ASYNC_QUEUE_SIZE,0u);
+    TEST_CHECK(DS3231_ASYNC_QUEUE_SIZE == calls);
+    //free again, the ring wraps
+    for(uint32_t i = 0; i < DS3231_ASYNC_QUEUE_SIZE; i++){
+        TEST_CHECK(ds3231_async_read(&async,(uint8_t)(i % 0x13u),&out,1u,NULL));
+    }
+    TEST_CHECK(!ds3231_async_read(&async,0x00u,&out,1u,NULL));
+    TEST_CHECK(ds3231_async_poll(&async,NULL) && 2u * DS3231_ASYNC_QUEUE_SIZE == async.completed);
+
+    //ranges past the register file are refused
+    uint8_t two[2];
+    TEST_CHECK(!ds3231_async_read(&async,0x12u,two,2u,NULL) && !ds3231_async_read(&async,0x00u,two,0u,NULL));
+    TEST_CHECK(!ds3231_async_write(&async,0x13u,two,1u,NULL));
+    TEST_CHECK(atomic_load(&async.tail) == atomic_load(&async.head));
+    TEST_CHECK(ds3231_deinit(&dev));
+}
+
+int main(void){
+    check_overlapping_reads();
+    check_gapped_reads();
+    check_writes();
+    check_futures();
+    check_queue_full();
+    return test_result("test_async");
+}
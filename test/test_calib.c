@@ -0,0 +1,132 @@
+#include "ds3231_test.h"
+#include "ds3231_lib_calib.h"
+
+/**
+ * aging offset calibration against the simulated oscillator with a known drift: the estimated
+ * rate is within the edge uncertainty over the span, ds3231_calib_apply writes the rounded
+ * step count and restarts the window, and after the correction the rtc measures on rate and no
+ * further step is written. also through a reference clock with its own rate and with a jump.
+ */
+
+static const uint32_t LATENCY_NS = 50000u;
+static const uint64_t SAMPLE_PERIOD_NS = 600000000000u; /** 10 minutes */
+static const uint32_t MIN_SPAN_S = 3600u;
+/** two edges each off by up to the latency over at least MIN_SPAN_S */
+static const int32_t TOLERANCE_PPB = 2 * 50000 / 3600 + 1;
+
+/** a reference running ppb fast against the monotonic counter, from an arbitrary epoch */
+static bool fast_reference(uint64_t monotonic_ns, uint64_t* reference_ns, void* ctx){
+    const int64_t ppb = *(const int32_t*)ctx;
+    *reference_ns = 1700000000000000000ull + monotonic_ns + (uint64_t)(((int64_t)monotonic_ns * ppb) / 1000000000);
+    return true;
+}
+
+static int32_t distance(int32_t a, int32_t b){
+    return (a > b) ? a - b : b - a;
+}
+
+/** sample a full window, checking the estimate is refused until the span and count are reached */
+static void fill_window(ds3231_sim_t* sim, ds3231_calib_t* calib){
+    int32_t rate_ppb = 0;
+    for(uint32_t i = 0; i < DS3231_CALIB_POINTS; i++){
+        TEST_CHECK(ds3231_calib_sample(calib));
+        const bool enough = DS3231_CALIB_MIN_POINTS <= i + 1u && (uint64_t)MIN_SPAN_S * 1000000000u <= i * SAMPLE_PERIOD_NS;
+        if(!enough){
+            TEST_CHECK(!ds3231_calib_estimate(calib,&rate_ppb,NULL));
+        }
+        TEST_CHECK(ds3231_sim_advance_ns(sim,SAMPLE_PERIOD_NS));
+    }
+}
+
+/**
+ * @brief calibrate a simulator drifting by drift_ppb, measured against a reference reference_ppb fast.
+ * @param [expected_steps][in] the aging offset the correction must write
+ */
+static void check_drift(int32_t drift_ppb, int32_t reference_ppb, int8_t expected_steps){
+    ds3231_sim_t sim;
+    ds3231_dev_t dev;
+    ds3231_calib_t calib;
+    TEST_CHECK(test_sim_device(&sim,&dev,LATENCY_NS));
+    TEST_CHECK(ds3231_sim_set_drift(&sim,drift_ppb));
+    TEST_CHECK(ds3231_set_unix_time(&dev,1760000000,true));
+    TEST_CHECK(ds3231_calib_init(&calib,&dev,MIN_SPAN_S,(0 == reference_ppb) ? NULL : fast_reference,&reference_ppb));
+
+    //the rtc against the reference: a fast reference makes the rtc look slow
+    const int32_t expected_ppb = drift_ppb - reference_ppb;
+    int32_t rate_ppb = 0;
+    uint32_t residual_ns = 0;
+    fill_window(&sim,&calib);
+    TEST_CHECK(ds3231_calib_estimate(&calib,&rate_ppb,&residual_ns));
+    if(distance(rate_ppb,expected_ppb) > TOLERANCE_PPB || 2u * LATENCY_NS < residual_ns){
+        fprintf(stderr,"drift %d reference %d: rate %d residual %u\n",drift_ppb,reference_ppb,rate_ppb,residual_ns);
+        test_failures += 1u;
+    }
+
+    int8_t aging_offset = 0;
+    bool written = false;
+    TEST_CHECK(ds3231_calib_apply(&calib,&aging_offset,&written));
+    if(0 == expected_steps){
+        //below half a step nothing is written and the window runs on
+        TEST_CHECK(!written && 0 == aging_offset && 0u == calib.corrections);
+        TEST_CHECK(ds3231_calib_estimate(&calib,&rate_ppb,NULL));
+        printf("drift %6d ppb reference %5d ppb: %3d steps, %4d ppb left\n",drift_ppb,reference_ppb,aging_offset,rate_ppb);
+        TEST_CHECK(ds3231_deinit(&dev));
+        return;
+    }
+    TEST_CHECK(written && expected_steps == aging_offset && (uint8_t)expected_steps == sim.regs[0x10]);
+    TEST_CHECK(1u == calib.corrections);
+    //the new offset is applied by the conversion started with it
+    TEST_CHECK(0u != (sim.regs[0x0F] & 0x04u));
+    //the window restarted
+    TEST_CHECK(!ds3231_calib_estimate(&calib,&rate_ppb,NULL));
+    TEST_CHECK(!ds3231_calib_apply(&calib,&aging_offset,&written));
+
+    //on rate within the half step the offset can't resolve, nothing more to write
+    fill_window(&sim,&calib);
+    TEST_CHECK(ds3231_calib_estimate(&calib,&rate_ppb,NULL));
+    const int32_t left_ppb = expected_ppb - 100 * expected_steps;
+    if(distance(rate_ppb,left_ppb) > TOLERANCE_PPB){
+        fprintf(stderr,"drift %d reference %d: %d ppb left after the correction, expected %d\n",drift_ppb,
+                reference_ppb,rate_ppb,left_ppb);
+        test_failures += 1u;
+    }
+    TEST_CHECK(ds3231_calib_apply(&calib,&aging_offset,&written));
+    TEST_CHECK(!written && expected_steps == aging_offset && 1u == calib.corrections);
+    printf("drift %6d ppb reference %5d ppb: %3d steps, %4d ppb left\n",drift_ppb,reference_ppb,aging_offset,rate_ppb);
+    TEST_CHECK(ds3231_deinit(&dev));
+}
+
+/** a point far off the line of the window (the rtc was set) restarts it */
+static void check_jump(void){
+    ds3231_sim_t sim;
+    ds3231_dev_t dev;
+    ds3231_calib_t calib;
+    TEST_CHECK(test_sim_device(&sim,&dev,LATENCY_NS));
+    TEST_CHECK(ds3231_calib_init(&calib,&dev,60u,NULL,NULL));
+    const uint64_t base_ns = 5000000000u;
+    for(uint32_t i = 0; i < 8u; i++){
+        TEST_CHECK(ds3231_calib_add_point(&calib,1000 + 30 * (int64_t)i,base_ns + 30000000000ull * i));
+    }
+    int32_t rate_ppb = 1;
+    TEST_CHECK(ds3231_calib_estimate(&calib,&rate_ppb,NULL) && 0 == rate_ppb);
+    //the rtc jumped a few seconds ahead
+    TEST_CHECK(ds3231_calib_add_point(&calib,1000 + 30 * 8 + 5,base_ns + 30000000000ull * 8u));
+    TEST_CHECK(!ds3231_calib_estimate(&calib,&rate_ppb,NULL));
+    //a second the rtc already counted
+    TEST_CHECK(ds3231_calib_add_point(&calib,1000,base_ns + 30000000000ull * 9u));
+    TEST_CHECK(1u == calib.__count);
+    TEST_CHECK(ds3231_calib_reset(&calib) && 0u == calib.__count);
+    TEST_CHECK(ds3231_deinit(&dev));
+}
+
+int main(void){
+    check_drift(2500,0,25);
+    check_drift(-1800,0,-18);
+    check_drift(2549,0,25);
+    check_drift(-1851,0,-19);
+    check_drift(30,0,0);
+    check_drift(2500,700,18);
+    check_drift(20000,0,127);
+    check_jump();
+    return test_result("test_calib");
+}
@@ -0,0 +1,229 @@
+#include "ds3231_test.h"
+#include "ds3231_lib_util.h"
+#include <string.h>
+
+/**
+ * the ds3231_lib_util.h formatters against snprintf: every time of a day in both hours formats on a
+ * spread of dates gives the same text, and the failure cases leave an empty string. then the
+ * throughput of each formatter next to the snprintf call writing the same text.
+ * usage: test_format [timed formats]
+ */
+
+static const char* PATTERN = "%d.%m.%y %I:%M %p %u %% %H%S %Y";
+
+/** the time of day of time_data in 24 hours */
+static uint8_t reference_hours(const ds3231_time_data_t* time_data){
+    return time_data->is_12_hours_format ? (uint8_t)(time_data->hours % 12u + (time_data->pm ? 12u : 0u)) : time_data->hours;
+}
+
+static uint32_t reference_year(const ds3231_time_data_t* time_data){
+    return (time_data->century ? 2100u : 2000u) + time_data->year;
+}
+
+static int reference_iso8601(const ds3231_time_data_t* t, char* buffer, size_t size){
+    return snprintf(buffer,size,"%04u-%02u-%02uT%02u:%02u:%02u",reference_year(t),t->month,t->day_of_month,
+                    reference_hours(t),t->minutes,t->seconds);
+}
+
+static int reference_rfc3339(const ds3231_time_data_t* t, int16_t offset_minutes, char* buffer, size_t size){
+    const int length = reference_iso8601(t,buffer,size);
+    if(0 == offset_minutes){
+        return length + snprintf(buffer + length,size - (size_t)length,"Z");
+    }else{
+        const int offset = abs(offset_minutes);
+        return length + snprintf(buffer + length,size - (size_t)length,"%c%02d:%02d",(0 > offset_minutes) ? '-' : '+',
+                                 offset / 60,offset % 60);
+    }
+}
+
+static int reference_hhmmss(const ds3231_time_data_t* t, char* buffer, size_t size){
+    return snprintf(buffer,size,"%02u%02u%02u",reference_hours(t),t->minutes,t->seconds);
+}
+
+static int reference_pattern(const ds3231_time_data_t* t, char* buffer, size_t size){
+    const uint8_t hours = reference_hours(t);
+    return snprintf(buffer,size,"%02u.%02u.%02u %02u:%02u %s %u %% %02u%02u %04u",t->day_of_month,t->month,t->year,
+                    (0u == hours % 12u) ? 12u : hours % 12u,t->minutes,(12u <= hours) ? "PM" : "AM",t->day_of_week,
+                    hours,t->seconds,reference_year(t));
+}
+
+/** format time_data with every formatter and compare with snprintf */
+static void check_same_text(const ds3231_time_data_t* t, int16_t offset_minutes){
+    char text[64];
+    char expected[64];
+    size_t length = 0;
+    int expected_length = reference_iso8601(t,expected,sizeof(expected));
+    TEST_CHECK(ds3231_format_iso8601(t,text,sizeof(text),&length));
+    TEST_CHECK(DS3231_ISO8601_LENGTH == length && (size_t)expected_length == length && 0 == strcmp(expected,text));
+
+    expected_length = reference_rfc3339(t,offset_minutes,expected,sizeof(expected));
+    TEST_CHECK(ds3231_format_rfc3339(t,offset_minutes,text,sizeof(text),&length));
+    TEST_CHECK((size_t)expected_length == length && 0 == strcmp(expected,text));
+    TEST_CHECK((0 == offset_minutes) ? (DS3231_ISO8601_LENGTH + 1u == length) : (DS3231_RFC3339_LENGTH == length));
+
+    expected_length = reference_hhmmss(t,expected,sizeof(expected));
+    TEST_CHECK(ds3231_format_hhmmss(t,text,sizeof(text),&length));
+    TEST_CHECK(DS3231_HHMMSS_LENGTH == length && (size_t)expected_length == length && 0 == strcmp(expected,text));
+
+    expected_length = reference_pattern(t,expected,sizeof(expected));
+    TEST_CHECK(ds3231_format(t,PATTERN,text,sizeof(text),&length));
+    TEST_CHECK((size_t)expected_length == length && 0 == strcmp(expected,text));
+}
+
+/** a formatter that fails must leave an empty string and a zero length */
+#define CHECK_FAILS_EMPTY(call) TEST_CHECK(!(call) && '\0' == text[0] && 0u == length)
+
+static void check_failures(const ds3231_time_data_t* valid){
+    char text[64];
+    size_t length = 99;
+    //exactly the length does not leave room for the NUL
+    memset(text,'x',sizeof(text));
+    CHECK_FAILS_EMPTY(ds3231_format_iso8601(valid,text,DS3231_ISO8601_LENGTH,&length));
+    memset(text,'x',sizeof(text));
+    CHECK_FAILS_EMPTY(ds3231_format_rfc3339(valid,60,text,DS3231_RFC3339_LENGTH,&length));
+    memset(text,'x',sizeof(text));
+    CHECK_FAILS_EMPTY(ds3231_format_hhmmss(valid,text,DS3231_HHMMSS_LENGTH,&length));
+    memset(text,'x',sizeof(text));
+    CHECK_FAILS_EMPTY(ds3231_format(valid,"%H:%M",text,5u,&length));
+    TEST_CHECK(ds3231_format_hhmmss(valid,text,DS3231_HHMMSS_LENGTH + 1u,&length) && DS3231_HHMMSS_LENGTH == length);
+
+    //unknown conversion, trailing %, offset out of range
+    CHECK_FAILS_EMPTY(ds3231_format(valid,"%H %q",text,sizeof(text),&length));
+    CHECK_FAILS_EMPTY(ds3231_format(valid,"%H %",text,sizeof(text),&length));
+    CHECK_FAILS_EMPTY(ds3231_format_rfc3339(valid,1440,text,sizeof(text),&length));
+    CHECK_FAILS_EMPTY(ds3231_format_rfc3339(valid,-1440,text,sizeof(text),&length));
+
+    //fields out of range
+    ds3231_time_data_t t = *valid;
+    t.is_12_hours_format = false;
+    t.hours = 24u;
+    CHECK_FAILS_EMPTY(ds3231_format_iso8601(&t,text,sizeof(text),&length));
+    t.is_12_hours_format = true;
+    t.hours = 0u;
+    CHECK_FAILS_EMPTY(ds3231_format_hhmmss(&t,text,sizeof(text),&length));
+    t = *valid;
+    t.minutes = 60u;
+    CHECK_FAILS_EMPTY(ds3231_format(&t,"%M",text,sizeof(text),&length));
+    t = *valid;
+    t.month = 13u;
+    CHECK_FAILS_EMPTY(ds3231_format_rfc3339(&t,0,text,sizeof(text),&length));
+    t = *valid;
+    t.day_of_week = 0u;
+    CHECK_FAILS_EMPTY(ds3231_format_iso8601(&t,text,sizeof(text),&length));
+
+    //no output pointer for the length
+    TEST_CHECK(ds3231_format_iso8601(valid,text,sizeof(text),NULL));
+    TEST_CHECK(!ds3231_format_iso8601(NULL,text,sizeof(text),&length));
+    TEST_CHECK(!ds3231_format(valid,NULL,text,sizeof(text),&length));
+}
+
+typedef bool (*format_fn)(const ds3231_time_data_t* t, char* buffer, size_t size);
+typedef int (*reference_fn)(const ds3231_time_data_t* t, char* buffer, size_t size);
+
+static bool lib_iso8601(const ds3231_time_data_t* t, char* buffer, size_t size){
+    return ds3231_format_iso8601(t,buffer,size,NULL);
+}
+
+static bool lib_rfc3339(const ds3231_time_data_t* t, char* buffer, size_t size){
+    return ds3231_format_rfc3339(t,60,buffer,size,NULL);
+}
+
+static int ref_rfc3339(const ds3231_time_data_t* t, char* buffer, size_t size){
+    return reference_rfc3339(t,60,buffer,size);
+}
+
+static bool lib_hhmmss(const ds3231_time_data_t* t, char* buffer, size_t size){
+    return ds3231_format_hhmmss(t,buffer,size,NULL);
+}
+
+static bool lib_pattern(const ds3231_time_data_t* t, char* buffer, size_t size){
+    return ds3231_format(t,PATTERN,buffer,size,NULL);
+}
+
+/** ns per call of the formatter and of snprintf, times cycling through a day */
+static void bench(const char* name, format_fn lib, reference_fn reference, const ds3231_time_data_t* times,
+                  uint32_t count, uint32_t calls){
+    char text[64];
+    uint64_t start_ns = test_now_ns();
+    for(uint32_t i = 0; i < calls; i++){
+        lib(&times[i % count],text,sizeof(text));
+        test_consume(text);
+    }
+    const uint64_t lib_ns = test_now_ns() - start_ns;
+    start_ns = test_now_ns();
+    for(uint32_t i = 0; i < calls; i++){
+        reference(&times[i % count],text,sizeof(text));
+        test_consume(text);
+    }
+    const uint64_t reference_ns = test_now_ns() - start_ns;
+    printf("%-10s %8.1f %8.1f %6.1fx\n",name,(double)lib_ns / calls,(double)reference_ns / calls,
+           (0u == lib_ns) ? 0.0 : (double)reference_ns / (double)lib_ns);
+}
+
+int main(int argc, char** argv){
+    const uint32_t calls = test_arg_count(argc,argv,1,2000000u);
+    static const int16_t offsets[] = {0, 60, -300, 330, -1439, 1439, 45};
+    //dates spread over both centuries and the field limits
+    static const uint8_t dates[][3] = {{0, 1, 1}, {26, 1, 31}, {99, 12, 31}, {48, 2, 29}, {7, 10, 9}, {63, 6, 15}};
+
+    uint32_t checked = 0;
+    for(uint32_t d = 0; d < sizeof(dates) / sizeof(dates[0]); d++){
+        for(uint32_t second_of_day = 0; second_of_day < 86400u; second_of_day += 7u){
+            for(uint32_t format = 0; format < 2u; format++){
+                const uint8_t hours = (uint8_t)(second_of_day / 3600u);
+                ds3231_time_data_t t = {
+                    .seconds = (uint8_t)(second_of_day % 60u),
+                    .minutes = (uint8_t)(second_of_day / 60u % 60u),
+                    .hours = (1u == format) ? (uint8_t)((0u == hours % 12u) ? 12u : hours % 12u) : hours,
+                    .day_of_month = dates[d][2],
+                    .month = dates[d][1],
+                    .year = dates[d][0],
+                    .day_of_week = (uint8_t)(1u + (second_of_day + d) % 7u),
+                    .is_12_hours_format = (1u == format),
+                    .pm = (1u == format) && 12u <= hours,
+                    .century = (1u == d % 2u)
+                };
+                check_same_text(&t,offsets[(second_of_day + d) % (sizeof(offsets) / sizeof(offsets[0]))]);
+                checked += 1u;
+            }
+        }
+    }
+    //every second of one day so no hour, minute or second is skipped
+    for(uint32_t second_of_day = 0; second_of_day < 86400u; second_of_day++){
+        ds3231_time_data_t t = {
+            .seconds = (uint8_t)(second_of_day % 60u),
+            .minutes = (uint8_t)(second_of_day / 60u % 60u),
+            .hours = (uint8_t)(second_of_day / 3600u),
+            .day_of_month = 31u, .month = 1u, .year = 26u, .day_of_week = 6u
+        };
+        check_same_text(&t,0);
+        checked += 1u;
+    }
+    printf("%u times formatted like snprintf\n",checked);
+
+    const ds3231_time_data_t valid = {.seconds = 58u, .minutes = 59u, .hours = 11u, .day_of_month = 31u, .month = 1u,
+                                      .year = 26u, .day_of_week = 6u, .is_12_hours_format = true, .pm = true};
+    char text[DS3231_RFC3339_LENGTH + 1];
+    TEST_CHECK(ds3231_format_rfc3339(&valid,60,text,sizeof(text),NULL) && 0 == strcmp("2026-01-31T23:59:58+01:00",text));
+    check_failures(&valid);
+
+    if(0u < calls){
+        ds3231_time_data_t* times = calloc(1440u,sizeof(ds3231_time_data_t));
+        TEST_CHECK(NULL != times);
+        for(uint32_t minute = 0; NULL != times && minute < 1440u; minute++){
+            const ds3231_time_data_t t = {.seconds = (uint8_t)(minute % 60u), .minutes = (uint8_t)(minute % 60u),
+                                          .hours = (uint8_t)(minute / 60u), .day_of_month = 31u, .month = 1u,
+                                          .year = 26u, .day_of_week = 6u};
+            times[minute] = t;
+        }
+        if(NULL != times){
+            printf("ns per call over %u calls\n%-10s %8s %8s %7s\n",calls,"","format","snprintf","ratio");
+            bench("iso8601",lib_iso8601,reference_iso8601,times,1440u,calls);
+            bench("rfc3339",lib_rfc3339,ref_rfc3339,times,1440u,calls);
+            bench("hhmmss",lib_hhmmss,reference_hhmmss,times,1440u,calls);
+            bench("pattern",lib_pattern,reference_pattern,times,1440u,calls);
+        }
+        free(times);
+    }
+    return test_result("test_format");
+}
@@ -0,0 +1,198 @@
+#include "ds3231_test.h"
+#include "ds3231_lib_private.h"
+#include "fake_i2c_dev.h"
+#include <errno.h>
+#include <linux/i2c.h>
+
+/**
+ * the linux i2c-dev port against the fake adapter in fake_i2c_dev.c: one ioctl per transfer,
+ * the message layout per adapter type, the policy timeout on the adapter, errors and the
+ * descriptor life cycle.
+ * with DS3231_I2C_STUB_BUS=N in the environment it also runs against /dev/i2c-N, e.g. the
+ * kernel's stub after: modprobe i2c-stub chip_addr=0x68
+ */
+
+static const unsigned long FUNCS_NOSTART = I2C_FUNC_I2C | I2C_FUNC_NOSTART | I2C_FUNC_SMBUS_EMUL;
+static const unsigned long FUNCS_PLAIN   = I2C_FUNC_I2C | I2C_FUNC_SMBUS_EMUL;
+static const unsigned long FUNCS_SMBUS   = I2C_FUNC_SMBUS_BYTE_DATA | I2C_FUNC_SMBUS_I2C_BLOCK;
+
+static ds3231_time_data_t test_time(void){
+    return (ds3231_time_data_t){.seconds = 56,.minutes = 34,.hours = 12,.day_of_week = 3,
+                                .day_of_month = 15,.month = 10,.year = 26};
+}
+
+static bool same_time(const ds3231_time_data_t* a, const ds3231_time_data_t* b){
+    return a->seconds == b->seconds && a->minutes == b->minutes && a->hours == b->hours
+        && a->day_of_week == b->day_of_week && a->day_of_month == b->day_of_month
+        && a->month == b->month && a->year == b->year;
+}
+
+/** the last logged transfer */
+static const fake_i2c_transfer_t* last_transfer(void){
+    return &fake_i2c.log[fake_i2c.log_length - 1u];
+}
+
+static void check_adapter(const char* name, unsigned long funcs){
+    printf("adapter %s\n",name);
+    fake_i2c_reset(funcs);
+    ds3231_dev_t dev = {0};
+    TEST_CHECK(ds3231_init(&dev,0,0,FAKE_I2C_PORT,false));
+    TEST_CHECK(1u == fake_i2c.opens);
+    //smbus transfers need the device address set once at open
+    TEST_CHECK((funcs & I2C_FUNC_I2C) || 0x68u == fake_i2c.slave);
+    //the policy does the retries, the default timeouts fit one 10ms step
+    TEST_CHECK(0u == fake_i2c.retries && 1u == fake_i2c.timeout);
+
+    //a burst write is one ioctl
+    ds3231_time_data_t t = test_time();
+    uint8_t time_regs[7] = {0};
+    TEST_CHECK(__ds3231_i2c_write_multi(&dev,(uint8_t[7]){0x56,0x34,0x12,0x03,0x15,0x10,0x26},0x00,7));
+    TEST_CHECK(1u == fake_i2c.log_length && !last_transfer()->read
+               && 0x00u == last_transfer()->reg_address && 7u == last_transfer()->byte_length);
+    if(FUNCS_NOSTART == funcs){
+        //register address and data in two messages, the second continues the first
+        TEST_CHECK(2u == fake_i2c.msgs);
+    }else if(FUNCS_PLAIN == funcs){
+        TEST_CHECK(1u == fake_i2c.msgs);
+    }else{
+        TEST_CHECK(1u == fake_i2c.smbus);
+    }
+
+    //a read is one ioctl, a write + repeated start read pair on plain adapters
+    fake_i2c_reset_counters();
+    ds3231_time_data_t back = {0};
+    TEST_CHECK(ds3231_get_time(&dev,&back));
+    TEST_CHECK(same_time(&t,&back));
+    TEST_CHECK(1u == fake_i2c_syscalls() && 1u == fake_i2c.ioctls);
+    TEST_CHECK(1u == fake_i2c.log_length && last_transfer()->read
+               && 0x00u == last_transfer()->reg_address && 7u == last_transfer()->byte_length);
+    TEST_CHECK((funcs & I2C_FUNC_I2C) ? 2u == fake_i2c.msgs : 1u == fake_i2c.smbus);
+
+    //single register accesses
+    fake_i2c_reset_counters();
+    uint8_t control = 0;
+    TEST_CHECK(__ds3231_i2c_write_single(&dev,0x0E,0x1C));
+    TEST_CHECK(__ds3231_i2c_read_single(&dev,0x0E,&control));
+    TEST_CHECK(0x1Cu == control && 2u == fake_i2c.ioctls);
+
+    //the whole api on top
+    t.hours = 23;
+    TEST_CHECK(ds3231_set_time(&dev,true,&t));
+    TEST_CHECK(ds3231_get_time(&dev,&back) && same_time(&t,&back));
+    ds3231_snapshot_t snapshot;
+    fake_i2c_reset_counters();
+    TEST_CHECK(ds3231_read_snapshot(&dev,&snapshot));
+    TEST_CHECK(1u == fake_i2c.ioctls && 19u == last_transfer()->byte_length);
+    TEST_CHECK(same_time(&t,&snapshot.time));
+    TEST_CHECK(__ds3231_i2c_read_multi(&dev,0x00,time_regs,7) && 0x23u == time_regs[2]);
+
+    //a nack is retried by the policy, the attempts show in the stats
+    fake_i2c_reset_counters();
+    TEST_CHECK(ds3231_reset_stats(&dev));
+    fake_i2c.fail_count = 1u;
+    fake_i2c.fail_errno = ENXIO;
+    TEST_CHECK(ds3231_get_time(&dev,&back));
+    TEST_CHECK(2u == fake_i2c.ioctls);
+    ds3231_stats_t stats;
+    TEST_CHECK(ds3231_get_stats(&dev,&stats) && 1u == stats.nacks && 2u == stats.reads);
+    //a policy timeout over 10ms is set on the adapter once, then kept until it changes
+    ds3231_policy_t policy;
+    TEST_CHECK(ds3231_get_policy(&dev,&policy));
+    const ds3231_policy_t default_policy = policy;
+    policy.timeout_margin_us = 25000u;
+    TEST_CHECK(ds3231_set_policy(&dev,&policy));
+    fake_i2c_reset_counters();
+    TEST_CHECK(ds3231_get_time(&dev,&back));
+    TEST_CHECK(3u == fake_i2c.timeout && 2u == fake_i2c.ioctls);
+    TEST_CHECK(ds3231_get_time(&dev,&back) && 3u == fake_i2c.ioctls);
+    TEST_CHECK(ds3231_set_policy(&dev,&default_policy));
+    TEST_CHECK(ds3231_get_time(&dev,&back));
+    TEST_CHECK(1u == fake_i2c.timeout && 5u == fake_i2c.ioctls);
+
+    //a transfer failing every attempt fails the call. i2c-dev can't recover the bus,
+    //so it ends when the recovery is due after 2 attempts instead of using the third
+    fake_i2c.fail_count = 100u;
+    fake_i2c.fail_errno = ETIMEDOUT;
+    TEST_CHECK(!ds3231_get_time(&dev,&back));
+    TEST_CHECK(ds3231_get_stats(&dev,&stats) && 2u == stats.timeouts);
+    fake_i2c.fail_count = 0u;
+
+    //out of range registers never reach the adapter
+    fake_i2c_reset_counters();
+    TEST_CHECK(!__ds3231_i2c_read_multi(&dev,0x10,time_regs,7));
+    TEST_CHECK(0u == fake_i2c_syscalls());
+
+    TEST_CHECK(ds3231_deinit(&dev));
+    TEST_CHECK(1u == fake_i2c.closes && 0 > fake_i2c.fd);
+}
+
+static void check_unsupported_adapter(void){
+    printf("adapter without i2c or i2c block transfers\n");
+    fake_i2c_reset(I2C_FUNC_SMBUS_BYTE_DATA);
+    ds3231_dev_t dev = {0};
+    TEST_CHECK(!ds3231_init(&dev,0,0,FAKE_I2C_PORT,false));
+    TEST_CHECK(1u == fake_i2c.opens && 1u == fake_i2c.closes);
+
+    //a mux needs plain i2c messages
+    fake_i2c_reset(FUNCS_SMBUS);
+    ds3231_bus_t bus = {0};
+    TEST_CHECK(!ds3231_bus_init(&bus,0,0,FAKE_I2C_PORT,0x70));
+    TEST_CHECK(1u == fake_i2c.opens && 1u == fake_i2c.closes);
+
+    ds3231_dev_t missing = {0};
+    TEST_CHECK(!ds3231_init(&missing,0,0,FAKE_I2C_PORT + 1,false));
+}
+
+static void check_shared_bus(void){
+    printf("shared bus\n");
+    fake_i2c_reset(FUNCS_NOSTART);
+    ds3231_bus_t bus = {0};
+    ds3231_dev_t dev = {0};
+    TEST_CHECK(ds3231_bus_init(&bus,0,0,FAKE_I2C_PORT,0));
+    TEST_CHECK(ds3231_bus_attach(&dev,&bus,DS3231_BUS_NO_MUX));
+    //the device borrows the descriptor of the bus
+    TEST_CHECK(1u == fake_i2c.opens && dev.i2c_fd == bus.i2c_fd);
+    ds3231_time_data_t t = test_time();
+    ds3231_time_data_t back = {0};
+    TEST_CHECK(ds3231_set_time(&dev,true,&t));
+    TEST_CHECK(ds3231_get_time(&dev,&back) && same_time(&t,&back));
+    //the adapter timeout is kept per bus, the descriptor's users share it
+    ds3231_policy_t policy;
+    TEST_CHECK(ds3231_get_policy(&dev,&policy));
+    policy.timeout_margin_us = 45000u;
+    TEST_CHECK(ds3231_set_policy(&dev,&policy) && ds3231_get_time(&dev,&back));
+    TEST_CHECK(5u == fake_i2c.timeout && 5u == bus.__i2c_timeout);
+    TEST_CHECK(ds3231_deinit(&dev));
+    TEST_CHECK(0u == fake_i2c.closes);
+    TEST_CHECK(ds3231_bus_deinit(&bus));
+    TEST_CHECK(1u == fake_i2c.closes);
+}
+
+/** the same round trip through the kernel */
+static void check_stub(void){
+    const char* bus_env = getenv("DS3231_I2C_STUB_BUS");
+    if(NULL == bus_env){
+        printf("i2c-stub: skipped, set DS3231_I2C_STUB_BUS to the adapter number of i2c-stub\n");
+        return;
+    }
+    printf("i2c-stub on /dev/i2c-%s\n",bus_env);
+    ds3231_dev_t dev = {0};
+    TEST_CHECK(ds3231_init(&dev,0,0,(int32_t)strtol(bus_env,NULL,10),false));
+    ds3231_time_data_t t = test_time();
+    ds3231_time_data_t back = {0};
+    TEST_CHECK(ds3231_set_time(&dev,true,&t));
+    TEST_CHECK(ds3231_get_time(&dev,&back) && same_time(&t,&back));
+    ds3231_snapshot_t snapshot;
+    TEST_CHECK(ds3231_read_snapshot(&dev,&snapshot) && same_time(&t,&snapshot.time));
+    TEST_CHECK(ds3231_deinit(&dev));
+}
+
+int main(void){
+    check_adapter("i2c with NOSTART",FUNCS_NOSTART);
+    check_adapter("i2c",FUNCS_PLAIN);
+    check_adapter("smbus only",FUNCS_SMBUS);
+    check_unsupported_adapter();
+    check_shared_bus();
+    check_stub();
+    return test_result("test_linux_port");
+}
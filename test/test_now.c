@@ -0,0 +1,181 @@
+#include "ds3231_test.h"
+#include "ds3231_lib_clock.h"
+
+/**
+ * ds3231_now against the simulator's true rtc time, over several transaction latencies and
+ * oscillator drifts: the anchor is within its uncertainty of the true seconds rollover, ds3231_now
+ * stays within the anchor uncertainty plus the rate error over the elapsed time, the skew measured
+ * at a re-anchor matches the true one within both anchor uncertainties, and the rate converges on
+ * the drift. setting the rtc restarts the rate, and ds3231_now never touches the bus.
+ */
+
+static const int64_t NS_PER_SECOND = 1000000000;
+static const uint32_t REANCHOR_INTERVAL_S = 60u;
+static const uint64_t STEP_NS = 7300000000u;
+static const uint32_t STEPS = 250u;
+
+static int64_t distance(int64_t a, int64_t b){
+    return (a > b) ? a - b : b - a;
+}
+
+/** rtc time in ns at the simulator's current time: the seconds registers and the phase of a drifting second */
+static int64_t true_rtc_ns(const ds3231_sim_t* sim){
+    ds3231_time_data_t t = {0};
+    int64_t seconds = 0;
+    TEST_CHECK(ds3231_decode_time(sim->regs,&t) && ds3231_time_to_unix(&t,&seconds));
+    const uint64_t period_ns = (uint64_t)(NS_PER_SECOND - sim->drift_ppb);
+    return seconds * NS_PER_SECOND + (int64_t)((sim->phase_ns * (uint64_t)NS_PER_SECOND) / period_ns);
+}
+
+/** rate of the simulated rtc against the monotonic counter in ppb */
+static double true_rate_ppb(const ds3231_sim_t* sim){
+    return (double)sim->drift_ppb * 1e9 / (double)(NS_PER_SECOND - sim->drift_ppb);
+}
+
+/** the error ds3231_now may have: the anchor uncertainty plus the rate error over the time since the anchor */
+static int64_t now_bound_ns(const ds3231_sim_t* sim, const ds3231_clock_t* clock){
+    const double rate_error = true_rate_ppb(sim) - (double)clock->rate_ppb;
+    const double elapsed_ns = (double)(sim->now_ns - clock->anchor_ns);
+    return (int64_t)clock->anchor_uncertainty_ns + (int64_t)((rate_error < 0 ? -rate_error : rate_error) * elapsed_ns / 1e9) + 2;
+}
+
+/** ds3231_now against the true time within the bound, returns the error */
+static int64_t check_now(const char* what, ds3231_sim_t* sim, ds3231_clock_t* clock){
+    ds3231_timespec_t now = {0};
+    const uint32_t transactions = sim->transactions;
+    TEST_CHECK(ds3231_now(clock,&now));
+    TEST_CHECK(transactions == sim->transactions && NS_PER_SECOND > now.nanoseconds);
+    const int64_t error_ns = now.seconds * NS_PER_SECOND + now.nanoseconds - true_rtc_ns(sim);
+    const int64_t bound_ns = now_bound_ns(sim,clock);
+    if(distance(error_ns,0) > bound_ns){
+        fprintf(stderr,"%s drift %d: now off by %lld ns, bound %lld ns, %llu ns after the anchor, rate %d\n",what,
+                sim->drift_ppb,(long long)error_ns,(long long)bound_ns,(unsigned long long)(sim->now_ns - clock->anchor_ns),
+                clock->rate_ppb);
+        test_failures += 1u;
+    }
+    return distance(error_ns,0);
+}
+
+/** the anchor is on the rollover the simulator just counted, within the uncertainty */
+static void check_anchor(const ds3231_sim_t* sim, const ds3231_clock_t* clock, uint32_t latency_ns){
+    ds3231_time_data_t t = {0};
+    int64_t seconds = 0;
+    TEST_CHECK(ds3231_decode_time(sim->regs,&t) && ds3231_time_to_unix(&t,&seconds));
+    //returns right after the edge, no tick since
+    TEST_CHECK(sim->phase_ns < (uint64_t)NS_PER_SECOND / 10u);
+    const int64_t true_edge_ns = (int64_t)(sim->now_ns - sim->phase_ns);
+    if(seconds != clock->anchor_seconds || distance((int64_t)clock->anchor_ns,true_edge_ns) > clock->anchor_uncertainty_ns
+                || clock->anchor_uncertainty_ns > 2u * latency_ns){
+        fprintf(stderr,"latency %u: anchor %lld at %llu +- %u, true %lld at %lld\n",latency_ns,(long long)clock->anchor_seconds,
+                (unsigned long long)clock->anchor_ns,clock->anchor_uncertainty_ns,(long long)seconds,(long long)true_edge_ns);
+        test_failures += 1u;
+    }
+}
+
+static void check_drift(uint32_t latency_ns, int32_t drift_ppb, uint64_t phase_ns){
+    ds3231_sim_t sim;
+    ds3231_dev_t dev;
+    ds3231_clock_t clock;
+    TEST_CHECK(test_sim_device(&sim,&dev,latency_ns));
+    TEST_CHECK(ds3231_sim_set_drift(&sim,drift_ppb));
+    TEST_CHECK(ds3231_set_unix_time(&dev,1760000000,true));
+    TEST_CHECK(ds3231_sim_advance_ns(&sim,phase_ns));
+    TEST_CHECK(ds3231_clock_init(&clock,&dev,REANCHOR_INTERVAL_S));
+    ds3231_timespec_t now = {0};
+    TEST_CHECK(!ds3231_now(&clock,&now));
+
+    bool reanchored = false;
+    TEST_CHECK(ds3231_clock_poll(&clock,&reanchored) && reanchored);
+    check_anchor(&sim,&clock,latency_ns);
+    TEST_CHECK(!ds3231_clock_get_skew(&clock,NULL,NULL));
+    check_now("anchor",&sim,&clock);
+
+    int64_t worst_ns = 0;
+    int64_t worst_skew_error_ns = 0;
+    for(uint32_t i = 0; i < STEPS; i++){
+        TEST_CHECK(ds3231_sim_advance_ns(&sim,STEP_NS));
+        const int64_t error_ns = check_now("interpolated",&sim,&clock);
+        worst_ns = (error_ns > worst_ns) ? error_ns : worst_ns;
+
+        //where the interpolation of the current anchor puts the next rollover the simulator counts
+        const int64_t old_seconds = clock.anchor_seconds;
+        const uint64_t old_ns = clock.anchor_ns;
+        const uint32_t old_uncertainty_ns = clock.anchor_uncertainty_ns;
+        const int32_t old_rate_ppb = clock.rate_ppb;
+        const uint32_t anchors = clock.anchors;
+        const uint32_t transactions = sim.transactions;
+        TEST_CHECK(ds3231_clock_poll(&clock,&reanchored));
+        if(!reanchored){
+            TEST_CHECK(anchors == clock.anchors && transactions == sim.transactions);
+            continue;
+        }
+        TEST_CHECK(anchors + 1u == clock.anchors);
+        check_anchor(&sim,&clock,latency_ns);
+        const uint64_t true_edge_ns = sim.now_ns - sim.phase_ns;
+        const double interpolated_ns = (double)(true_edge_ns - old_ns) * (1.0 + (double)old_rate_ppb / 1e9);
+        const int64_t true_skew_ns = (clock.anchor_seconds - old_seconds) * NS_PER_SECOND - (int64_t)interpolated_ns;
+        int64_t skew_ns = 0;
+        int32_t rate_ppb = 0;
+        TEST_CHECK(ds3231_clock_get_skew(&clock,&skew_ns,&rate_ppb) && skew_ns == clock.skew_ns && rate_ppb == clock.rate_ppb);
+        const int64_t skew_error_ns = distance(skew_ns,true_skew_ns);
+        if(skew_error_ns > (int64_t)old_uncertainty_ns + clock.anchor_uncertainty_ns + 2){
+            fprintf(stderr,"latency %u drift %d: skew %lld, true %lld\n",latency_ns,drift_ppb,(long long)skew_ns,
+                    (long long)true_skew_ns);
+            test_failures += 1u;
+        }
+        worst_skew_error_ns = (skew_error_ns > worst_skew_error_ns) ? skew_error_ns : worst_skew_error_ns;
+        check_now("reanchored",&sim,&clock);
+    }
+    //the rate over the whole run: two edges each off by up to twice the latency
+    const double span_s = (double)(clock.anchor_ns - clock.__base_ns) / 1e9;
+    const double rate_error = true_rate_ppb(&sim) - (double)clock.rate_ppb;
+    if((rate_error < 0 ? -rate_error : rate_error) > 4.0 * latency_ns / span_s + 1.0){
+        fprintf(stderr,"latency %u drift %d: rate %d over %.0f s\n",latency_ns,drift_ppb,clock.rate_ppb,span_s);
+        test_failures += 1u;
+    }
+    printf("latency %8u ns drift %7d ppb: rate %7d ppb, worst now %7lld ns, worst skew error %7lld ns, %u anchors\n",
+           latency_ns,drift_ppb,clock.rate_ppb,(long long)worst_ns,(long long)worst_skew_error_ns,clock.anchors);
+    TEST_CHECK(ds3231_deinit(&dev));
+}
+
+/** setting the rtc shows as a skew of more than a second at the next re-anchor and restarts the rate */
+static void check_set(void){
+    ds3231_sim_t sim;
+    ds3231_dev_t dev;
+    ds3231_clock_t clock;
+    TEST_CHECK(test_sim_device(&sim,&dev,250000u));
+    TEST_CHECK(ds3231_sim_set_drift(&sim,20000));
+    TEST_CHECK(ds3231_set_unix_time(&dev,1760000000,true));
+    TEST_CHECK(ds3231_clock_init(&clock,&dev,REANCHOR_INTERVAL_S) && ds3231_clock_anchor(&clock));
+    for(uint32_t i = 0; i < 5u; i++){
+        TEST_CHECK(ds3231_sim_advance_ns(&sim,(uint64_t)REANCHOR_INTERVAL_S * NS_PER_SECOND));
+        TEST_CHECK(ds3231_clock_anchor(&clock));
+    }
+    TEST_CHECK(0 != clock.rate_ppb);
+
+    //an hour ahead, until the next re-anchor ds3231_now keeps to the old time
+    ds3231_timespec_t before = {0};
+    ds3231_timespec_t now = {0};
+    TEST_CHECK(ds3231_now(&clock,&before));
+    TEST_CHECK(ds3231_set_unix_time(&dev,before.seconds + 3600,true));
+    TEST_CHECK(ds3231_now(&clock,&now) && before.seconds + 2 > now.seconds);
+    TEST_CHECK(ds3231_clock_anchor(&clock));
+    TEST_CHECK(0 == clock.rate_ppb && 3599 * NS_PER_SECOND < clock.skew_ns && 3602 * NS_PER_SECOND > clock.skew_ns);
+    check_anchor(&sim,&clock,250000u);
+    check_now("set",&sim,&clock);
+    TEST_CHECK(ds3231_sim_advance_ns(&sim,5u * (uint64_t)NS_PER_SECOND));
+    check_now("set",&sim,&clock);
+    TEST_CHECK(ds3231_deinit(&dev));
+}
+
+int main(void){
+    static const uint32_t latencies_ns[] = {20000u, 250000u, 2000000u};
+    static const int32_t drifts_ppb[] = {0, 20000, -15000, 150000};
+    for(uint32_t l = 0; l < sizeof(latencies_ns) / sizeof(latencies_ns[0]); l++){
+        for(uint32_t d = 0; d < sizeof(drifts_ppb) / sizeof(drifts_ppb[0]); d++){
+            check_drift(latencies_ns[l],drifts_ppb[d],333333333u * (d + 1u));
+        }
+    }
+    check_set();
+    return test_result("test_now");
+}
@@ -0,0 +1,177 @@
+#include "ds3231_test.h"
+#include "ds3231_lib_private.h"
+
+/**
+ * the transfer policy under the simulator's injected faults, with a fixed seed: dropped, nacked
+ * and delayed transactions and a stuck bus. the simulated time every transfer takes stays within
+ * ds3231_worst_case_us, recover_after recovers a stuck bus, and behind a mux the bound includes
+ * the control writes that route the device again after a recovery.
+ * usage: test_policy [transfers per case]
+ */
+
+static const uint32_t SEED = 0x2545F491u;
+
+typedef struct{
+    const char* name;
+    ds3231_sim_fault_t fault;
+}fault_case_t;
+
+static ds3231_policy_t policy_of(uint8_t retries, uint8_t recover_after){
+    ds3231_policy_t policy;
+    ds3231_default_policy(&policy);
+    policy.retries = retries;
+    policy.recover_after = recover_after;
+    return policy;
+}
+
+/**
+ * @brief one transfer, alternating reads and writes of 1 and 7 registers.
+ * @returns the simulated time it took in microseconds, rounded up
+ */
+static uint64_t timed_transfer(ds3231_sim_t* sim, ds3231_dev_t* dev, uint32_t index, bool* res,
+                               ds3231_stats_op* op, uint8_t* byte_length){
+    uint8_t buffer[7] = {0};
+    const uint64_t start_ns = sim->now_ns;
+    *op = (0u == index % 2u) ? DS3231_STATS_OP_READ : DS3231_STATS_OP_WRITE;
+    //the alarm registers, writing them leaves the clock alone
+    *byte_length = (0u == (index / 2u) % 2u) ? 1u : 7u;
+    if(DS3231_STATS_OP_READ == *op){
+        *res = __ds3231_i2c_read_multi(dev,0x07u,buffer,*byte_length);
+    }else{
+        *res = __ds3231_i2c_write_multi(dev,buffer,0x07u,*byte_length);
+    }
+    return (sim->now_ns - start_ns + 999u) / 1000u;
+}
+
+static void check_bound(const fault_case_t* fault_case, const ds3231_policy_t* policy, uint32_t transfers){
+    ds3231_sim_t sim;
+    ds3231_dev_t dev;
+    TEST_CHECK(test_sim_device(&sim,&dev,100000u));
+    TEST_CHECK(ds3231_set_policy(&dev,policy));
+    TEST_CHECK(ds3231_sim_set_fault(&sim,&fault_case->fault));
+    uint32_t failed = 0;
+    uint64_t longest_us = 0;
+    uint32_t longest_bound_us = 0;
+    for(uint32_t i = 0; i < transfers; i++){
+        bool res = false;
+        ds3231_stats_op op = DS3231_STATS_OP_READ;
+        uint8_t byte_length = 0;
+        const uint64_t elapsed_us = timed_transfer(&sim,&dev,i,&res,&op,&byte_length);
+        uint32_t bound_us = 0;
+        TEST_CHECK(ds3231_worst_case_us(&dev,op,byte_length,&bound_us));
+        if(elapsed_us > bound_us){
+            fprintf(stderr,"%s transfer %u: %llu us over the bound of %u us\n",fault_case->name,i,
+                    (unsigned long long)elapsed_us,bound_us);
+            test_failures += 1u;
+        }
+        if(elapsed_us > longest_us){
+            longest_us = elapsed_us;
+            longest_bound_us = bound_us;
+        }
+        failed += res ? 0u : 1u;
+    }
+    printf("%-8s %7u %7u %6u %6u %6u %10u %9llu %9u\n",fault_case->name,policy->retries,policy->recover_after,
+           sim.drops,sim.nacks,sim.delays,failed,(unsigned long long)longest_us,longest_bound_us);
+    TEST_CHECK(ds3231_deinit(&dev));
+}
+
+/** a stuck bus times out until recover_after failed attempts recover it */
+static void check_stuck(void){
+    ds3231_sim_t sim;
+    ds3231_dev_t dev;
+    uint8_t buffer[7] = {0};
+    uint32_t bound_us = 0;
+    const ds3231_sim_fault_t stuck = {.stuck = true, .seed = SEED};
+
+    //recovered after the second attempt, the third one goes through
+    ds3231_policy_t policy = policy_of(2u,2u);
+    TEST_CHECK(test_sim_device(&sim,&dev,100000u) && ds3231_set_policy(&dev,&policy));
+    TEST_CHECK(ds3231_sim_set_fault(&sim,&stuck) && ds3231_sim_reset_counters(&sim));
+    uint64_t start_ns = sim.now_ns;
+    TEST_CHECK(__ds3231_i2c_read_multi(&dev,0x00u,buffer,7));
+    TEST_CHECK(ds3231_worst_case_us(&dev,DS3231_STATS_OP_READ,7,&bound_us));
+    TEST_CHECK(1u == sim.recoveries && 1u == sim.transactions && !sim.fault.stuck);
+    TEST_CHECK((sim.now_ns - start_ns) / 1000u <= bound_us);
+    TEST_CHECK(ds3231_deinit(&dev));
+
+    //recovered after every attempt
+    policy = policy_of(3u,1u);
+    TEST_CHECK(test_sim_device(&sim,&dev,100000u) && ds3231_set_policy(&dev,&policy));
+    TEST_CHECK(ds3231_sim_set_fault(&sim,&stuck) && ds3231_sim_reset_counters(&sim));
+    TEST_CHECK(__ds3231_i2c_write_multi(&dev,buffer,0x07u,4));
+    TEST_CHECK(1u == sim.recoveries && 1u == sim.transactions);
+    TEST_CHECK(ds3231_deinit(&dev));
+
+    //never recovered, every attempt times out and the bound is met exactly but for the back offs
+    policy = policy_of(2u,0u);
+    TEST_CHECK(test_sim_device(&sim,&dev,100000u) && ds3231_set_policy(&dev,&policy));
+    TEST_CHECK(ds3231_sim_set_fault(&sim,&stuck) && ds3231_sim_reset_counters(&sim));
+    start_ns = sim.now_ns;
+    TEST_CHECK(!__ds3231_i2c_read_multi(&dev,0x00u,buffer,7));
+    TEST_CHECK(ds3231_worst_case_us(&dev,DS3231_STATS_OP_READ,7,&bound_us));
+    TEST_CHECK(0u == sim.recoveries && 0u == sim.transactions && sim.fault.stuck);
+    TEST_CHECK(bound_us == (sim.now_ns - start_ns) / 1000u);
+    TEST_CHECK(ds3231_deinit(&dev));
+}
+
+/** behind a mux a recovery forgets the routing, the bound pays for writing it again */
+static void check_mux(void){
+    ds3231_sim_t sim;
+    ds3231_dev_t dev = {0};
+    ds3231_sim_mux_t mux;
+    ds3231_bus_t bus = {0};
+    uint8_t buffer[7] = {0};
+    TEST_CHECK(ds3231_sim_mux_init(&mux) && ds3231_sim_attach_bus(&bus,&mux));
+    TEST_CHECK(ds3231_bus_init(&bus,0,0,0,0x70));
+    TEST_CHECK(ds3231_sim_init(&sim) && ds3231_sim_set_latency(&sim,100000u) && ds3231_sim_attach(&dev,&sim));
+    TEST_CHECK(ds3231_bus_attach(&dev,&bus,3));
+
+    const ds3231_policy_t policy = policy_of(4u,2u);
+    uint32_t policy_us = 0;
+    uint32_t device_us = 0;
+    TEST_CHECK(ds3231_set_policy(&dev,&policy));
+    TEST_CHECK(ds3231_policy_worst_case_us(&policy,DS3231_STATS_OP_READ,7,&policy_us));
+    TEST_CHECK(ds3231_worst_case_us(&dev,DS3231_STATS_OP_READ,7,&device_us));
+    //routed before the first attempt and after both recoveries
+    TEST_CHECK(policy_us + 3u * __ds3231_bus_mux_timeout_us() == device_us);
+
+    const ds3231_sim_fault_t stuck = {.stuck = true, .seed = SEED};
+    TEST_CHECK(ds3231_sim_set_fault(&sim,&stuck) && ds3231_sim_reset_counters(&sim));
+    mux.transactions = 0u;
+    const uint64_t start_ns = sim.now_ns;
+    TEST_CHECK(__ds3231_i2c_read_multi(&dev,0x00u,buffer,7));
+    TEST_CHECK(1u == sim.recoveries && 2u == mux.transactions && (0x01u << 3) == mux.control);
+    TEST_CHECK((sim.now_ns - start_ns) / 1000u <= device_us);
+
+    //a device without a mux pays nothing for it
+    ds3231_dev_t alone;
+    TEST_CHECK(test_sim_device(&sim,&alone,100000u) && ds3231_set_policy(&alone,&policy));
+    TEST_CHECK(ds3231_worst_case_us(&alone,DS3231_STATS_OP_READ,7,&device_us) && policy_us == device_us);
+    TEST_CHECK(ds3231_deinit(&alone));
+
+    TEST_CHECK(ds3231_deinit(&dev));
+    TEST_CHECK(ds3231_bus_deinit(&bus));
+}
+
+int main(int argc, char** argv){
+    const uint32_t transfers = test_arg_count(argc,argv,1,20000u);
+    const fault_case_t cases[] = {
+        {"drop", {.drop_ppm = 300000u, .seed = SEED}},
+        {"nack", {.nack_ppm = 400000u, .seed = SEED}},
+        {"delay", {.delay_ppm = 300000u, .delay_ns = 1500000u, .seed = SEED}},
+        {"late", {.delay_ppm = 300000u, .delay_ns = 20000000u, .seed = SEED}},
+        {"mixed", {.drop_ppm = 150000u, .nack_ppm = 150000u, .delay_ppm = 150000u, .delay_ns = 5000000u, .seed = SEED}},
+        {"stuck", {.stuck = true, .seed = SEED}}
+    };
+    const ds3231_policy_t policies[] = {policy_of(2u,2u), policy_of(4u,1u), policy_of(3u,0u), policy_of(0u,0u)};
+    printf("%-8s %7s %7s %6s %6s %6s %10s %9s %9s\n","fault","retries","recover","drops","nacks","delays",
+           "failed","worst us","bound us");
+    for(size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++){
+        for(size_t p = 0; p < sizeof(policies) / sizeof(policies[0]); p++){
+            check_bound(&cases[c],&policies[p],transfers);
+        }
+    }
+    check_stuck();
+    check_mux();
+    return test_result("test_policy");
+}
@@ -0,0 +1,86 @@
+#include "ds3231_test.h"
+
+/**
+ * ds3231_poll_events against flags the chip sets while it runs: with a transaction latency long
+ * enough for alarm2 to match between the status read and the clearing write, the new flag survives
+ * even when it was asked to be cleared. one read and at most one write per call, with and without
+ * a valid register shadow.
+ */
+
+static const uint64_t NS_PER_MS = 1000000u;
+
+/**
+ * @brief alarm1 matching at :59 and alarm2 every minute, polled just after the :59 tick.
+ * @param [latency_ms][in] per transaction, the :00 tick lands in the write's latency, or in the read's past 1s
+ */
+static void check_flag_between(uint32_t latency_ms, bool shadow, uint8_t clear_mask){
+    ds3231_sim_t sim;
+    ds3231_dev_t dev;
+    TEST_CHECK(test_sim_device(&sim,&dev,0u));
+    TEST_CHECK(ds3231_set_unix_time(&dev,1760000000 + 38,true));
+    ds3231_time_data_t alarm1 = {.seconds = 59u};
+    ds3231_alarm1_options alarm1_options = DS3231_ALARM1_SECONDS;
+    ds3231_alarm2_options alarm2_options = DS3231_ALARM2_ONCE_PER_MINUTE;
+    TEST_CHECK(ds3231_set_alarms(&dev,&alarm1,&alarm1_options,NULL,&alarm2_options));
+    TEST_CHECK(ds3231_clear_oscillator_stop_flag(&dev));
+    if(shadow){
+        TEST_CHECK(ds3231_shadow_resync(&dev));
+    }else{
+        TEST_CHECK(ds3231_shadow_invalidate(&dev));
+    }
+    //1760000038 is xx:53:58, poll 1ms after the :59 tick
+    TEST_CHECK(ds3231_sim_advance_ns(&sim,1001u * NS_PER_MS - sim.phase_ns));
+    TEST_CHECK(0x59u == sim.regs[0x00] && 0x01u == (sim.regs[0x0F] & 0x03u));
+    TEST_CHECK(ds3231_sim_set_latency(&sim,latency_ms * (uint32_t)NS_PER_MS) && ds3231_sim_reset_counters(&sim));
+
+    uint8_t flags = 0xFFu;
+    TEST_CHECK(ds3231_poll_events(&dev,clear_mask,&flags));
+    //A1F was set at the read, A2F came with the :00 tick before the write landed
+    TEST_CHECK(DS3231_FLAG_A1F == flags);
+    TEST_CHECK(0x02u == (sim.regs[0x0F] & 0x03u));
+    //EN32KHZ written back as it was, OSF not set again
+    TEST_CHECK(0x08u == (sim.regs[0x0F] & 0x88u));
+    //one single register read (3 + 1 bytes) and one single register write (2 + 1 bytes)
+    TEST_CHECK(2u == sim.transactions && 4u + 3u == sim.wire_bytes);
+    if(0u != test_failures){
+        fprintf(stderr,"latency %u ms shadow %d mask %02x: flags %02x status %02x\n",latency_ms,shadow,clear_mask,flags,sim.regs[0x0F]);
+    }
+
+    //the next poll reports and clears it
+    TEST_CHECK(ds3231_sim_set_latency(&sim,100000u) && ds3231_sim_reset_counters(&sim));
+    TEST_CHECK(ds3231_poll_events(&dev,clear_mask | DS3231_FLAG_A2F,&flags));
+    TEST_CHECK(DS3231_FLAG_A2F == flags && 0x00u == (sim.regs[0x0F] & 0x03u) && 2u == sim.transactions);
+    //nothing set, nothing written
+    TEST_CHECK(ds3231_sim_reset_counters(&sim));
+    TEST_CHECK(ds3231_poll_events(&dev,DS3231_FLAG_A1F | DS3231_FLAG_A2F | DS3231_FLAG_OSF,&flags));
+    TEST_CHECK(0x00u == flags && 1u == sim.transactions);
+    TEST_CHECK(ds3231_deinit(&dev));
+}
+
+/** a flag set but not asked for is reported and left for later, only the read is done */
+static void check_not_requested(void){
+    ds3231_sim_t sim;
+    ds3231_dev_t dev;
+    TEST_CHECK(test_sim_device(&sim,&dev,100000u));
+    uint8_t flags = 0;
+    TEST_CHECK(ds3231_sim_reset_counters(&sim));
+    //OSF is set at power on
+    TEST_CHECK(ds3231_poll_events(&dev,DS3231_FLAG_A1F,&flags));
+    TEST_CHECK(DS3231_FLAG_OSF == flags && 0x80u == (sim.regs[0x0F] & 0x80u) && 1u == sim.transactions);
+    TEST_CHECK(ds3231_poll_events(&dev,DS3231_FLAG_OSF,&flags) && DS3231_FLAG_OSF == flags);
+    TEST_CHECK(0x08u == sim.regs[0x0F] && 3u == sim.transactions);
+    TEST_CHECK(ds3231_deinit(&dev));
+}
+
+int main(void){
+    static const uint32_t latencies_ms[] = {600u, 999u, 1500u};
+    for(uint32_t i = 0; i < sizeof(latencies_ms) / sizeof(latencies_ms[0]); i++){
+        for(uint8_t shadow = 0; shadow < 2u; shadow++){
+            check_flag_between(latencies_ms[i],1u == shadow,DS3231_FLAG_A1F);
+            check_flag_between(latencies_ms[i],1u == shadow,DS3231_FLAG_A1F | DS3231_FLAG_A2F);
+            check_flag_between(latencies_ms[i],1u == shadow,DS3231_FLAG_A1F | DS3231_FLAG_A2F | DS3231_FLAG_OSF);
+        }
+    }
+    check_not_requested();
+    return test_result("test_poll_events");
+}
@@ -0,0 +1,117 @@
+#include "ds3231_test.h"
+#include "ds3231_lib_seqlock.h"
+#include <pthread.h>
+#include <stdatomic.h>
+
+/**
+ * seqlock stress: one writer publishes back to back while reader threads check every copy
+ * for torn reads. each published snapshot is derived from a counter carried in read_ns,
+ * with fields spread over the whole struct, so a copy mixing two publishes can't pass.
+ * usage: test_seqlock [milliseconds] [readers]
+ */
+
+enum{ MAX_READERS = 16 };
+
+static ds3231_seqlock_t seqlock;
+static atomic_bool stop;
+
+typedef struct{
+    pthread_t thread;
+    uint64_t reads;
+    uint64_t torn;
+    uint64_t backwards;
+    uint64_t gave_up;
+}reader_t;
+
+static ds3231_snapshot_t snapshot_of(uint64_t k){
+    ds3231_snapshot_t snapshot = {0};
+    snapshot.time.seconds = (uint8_t)(k % 60u);
+    snapshot.time.year = (uint8_t)(k % 100u);
+    snapshot.alarm1.minutes = (uint8_t)(k % 59u);
+    snapshot.alarm2.hours = (uint8_t)(k % 24u);
+    snapshot.control = (uint8_t)k;
+    snapshot.status = (uint8_t)(k >> 8u);
+    snapshot.aging_offset = (int8_t)(k % 127u);
+    snapshot.temperature = (int8_t)(k % 101u);
+    snapshot.temperature_fraction = (uint8_t)(k % 4u);
+    return snapshot;
+}
+
+static bool snapshot_matches(const ds3231_snapshot_t* s, uint64_t k){
+    const ds3231_snapshot_t expected = snapshot_of(k);
+    return s->time.seconds == expected.time.seconds && s->time.year == expected.time.year
+        && s->alarm1.minutes == expected.alarm1.minutes && s->alarm2.hours == expected.alarm2.hours
+        && s->control == expected.control && s->status == expected.status
+        && s->aging_offset == expected.aging_offset && s->temperature == expected.temperature
+        && s->temperature_fraction == expected.temperature_fraction;
+}
+
+static void* reader_main(void* arg){
+    reader_t* reader = (reader_t*)arg;
+    uint64_t last = 0u;
+    while(!atomic_load_explicit(&stop,memory_order_relaxed)){
+        ds3231_snapshot_t snapshot;
+        uint64_t k = 0;
+        if(!ds3231_seqlock_read(&seqlock,&snapshot,&k)){
+            reader->gave_up += 1u;
+            continue;
+        }
+        reader->reads += 1u;
+        reader->torn += !snapshot_matches(&snapshot,k);
+        reader->backwards += (k < last);
+        last = k;
+    }
+    return NULL;
+}
+
+int main(int argc, char** argv){
+    const uint32_t duration_ms = test_arg_count(argc,argv,1,1000u);
+    uint32_t reader_count = test_arg_count(argc,argv,2,8u);
+    reader_count = (MAX_READERS < reader_count) ? MAX_READERS : reader_count;
+
+    //empty, then one refresh through the simulator
+    ds3231_sim_t sim;
+    ds3231_dev_t dev;
+    ds3231_snapshot_t snapshot;
+    TEST_CHECK(test_sim_device(&sim,&dev,250000u));
+    TEST_CHECK(ds3231_seqlock_init(&seqlock,&dev));
+    TEST_CHECK(!ds3231_seqlock_read(&seqlock,&snapshot,NULL));
+    TEST_CHECK(ds3231_seqlock_refresh(&seqlock));
+    uint64_t read_ns = 0;
+    TEST_CHECK(ds3231_seqlock_read(&seqlock,&snapshot,&read_ns));
+    TEST_CHECK(0u < read_ns && read_ns < sim.now_ns && 1u == snapshot.time.day_of_month);
+
+    //stress
+    reader_t readers[MAX_READERS] = {0};
+    const ds3231_snapshot_t first = snapshot_of(0u);
+    TEST_CHECK(ds3231_seqlock_publish(&seqlock,&first,0u));
+    atomic_store(&stop,false);
+    for(uint32_t i = 0; i < reader_count; i++){
+        TEST_CHECK(0 == pthread_create(&readers[i].thread,NULL,reader_main,&readers[i]));
+    }
+    uint64_t publishes = 0u;
+    const uint64_t end_ns = test_now_ns() + (uint64_t)duration_ms * 1000000u;
+    while(test_now_ns() < end_ns){
+        for(uint32_t i = 0; i < 1000u; i++){
+            publishes += 1u;
+            const ds3231_snapshot_t next = snapshot_of(publishes);
+            ds3231_seqlock_publish(&seqlock,&next,publishes);
+        }
+    }
+    atomic_store(&stop,true);
+    reader_t total = {0};
+    for(uint32_t i = 0; i < reader_count; i++){
+        pthread_join(readers[i].thread,NULL);
+        total.reads += readers[i].reads;
+        total.torn += readers[i].torn;
+        total.backwards += readers[i].backwards;
+        total.gave_up += readers[i].gave_up;
+    }
+    printf("%u readers, %llu publishes, %llu reads, %llu torn, %llu out of order, %llu gave up\n",
+           reader_count,(unsigned long long)publishes,(unsigned long long)total.reads,
+           (unsigned long long)total.torn,(unsigned long long)total.backwards,(unsigned long long)total.gave_up);
+    TEST_CHECK(0u < total.reads);
+    TEST_CHECK(0u == total.torn);
+    TEST_CHECK(0u == total.backwards);
+    return test_result("test_seqlock");
+}
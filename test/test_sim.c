@@ -0,0 +1,285 @@
+#include <string.h>
+#include "ds3231_test.h"
+#include "ds3231_lib_private.h"
+
+/**
+ * the simulator's register file against the datasheet, driven by ds3231_sim_advance_ns:
+ * every day rollover of 2000-2199 with the chip's leap rule and the century bit, 12 and 24 hours
+ * mode side by side, alarm1/alarm2 matches per mask and DY/DT over eight days, the automatic and
+ * the CONV conversion with BSY, and EOSC/OSF on battery.
+ */
+
+static const uint64_t NS_PER_SECOND = 1000000000u;
+
+static uint8_t bcd(uint8_t number){
+    return (uint8_t)(((number / 10u) << 4u) | (number % 10u));
+}
+
+/** write the time registers as the chip holds them, the countdown chain at the start of a second */
+static void set_clock(ds3231_sim_t* sim, uint8_t hours_reg, uint8_t minutes, uint8_t seconds, uint8_t day,
+                      uint8_t date, uint8_t month, uint8_t year, bool century){
+    sim->regs[0x00] = bcd(seconds);
+    sim->regs[0x01] = bcd(minutes);
+    sim->regs[0x02] = hours_reg;
+    sim->regs[0x03] = day;
+    sim->regs[0x04] = bcd(date);
+    sim->regs[0x05] = bcd(month) | (century ? 0x80u : 0x00u);
+    sim->regs[0x06] = bcd(year);
+    sim->phase_ns = 0u;
+}
+
+static bool tick(ds3231_sim_t* sim){
+    return ds3231_sim_advance_ns(sim,NS_PER_SECOND);
+}
+
+/** 23:59:59 -> 00:00:00 on every day of 2000-2199 and back to 2000 */
+static void check_day_rollover(void){
+    static const uint8_t month_days[12] = {31,28,31,30,31,30,31,31,30,31,30,31};
+    ds3231_sim_t sim;
+    TEST_CHECK(ds3231_sim_init(&sim));
+    //2000-01-01 was a saturday, day 6 counting from monday
+    set_clock(&sim,bcd(23),59,59,6,1,1,0,false);
+    uint32_t days = 0;
+    uint32_t mismatches = 0;
+    uint8_t day = 6u;
+    uint8_t date = 1u;
+    uint8_t month = 1u;
+    uint32_t year = 2000u;
+    do{
+        const uint8_t last = (2u == month && 0u == year % 4u) ? 29u : month_days[month - 1u];
+        day = (7u == day) ? 1u : day + 1u;
+        date += 1u;
+        if(date > last){
+            date = 1u;
+            month += 1u;
+            if(12u < month){
+                month = 1u;
+                year = (2199u == year) ? 2000u : year + 1u;
+            }
+        }
+        TEST_CHECK(tick(&sim));
+        const uint8_t expected[7] = {0x00u, 0x00u, 0x00u, day, bcd(date),
+                                     (uint8_t)(bcd(month) | ((2100u <= year) ? 0x80u : 0x00u)), bcd((uint8_t)(year % 100u))};
+        if(0 != memcmp(expected,sim.regs,sizeof(expected))){
+            if(0u == mismatches){
+                fprintf(stderr,"day %u: expected %u-%02u-%02u day %u, registers %02x %02x %02x %02x\n",days,year,month,date,
+                        day,sim.regs[0x03],sim.regs[0x04],sim.regs[0x05],sim.regs[0x06]);
+            }
+            mismatches += 1u;
+        }
+        sim.regs[0x00] = bcd(59);
+        sim.regs[0x01] = bcd(59);
+        sim.regs[0x02] = bcd(23);
+        days += 1u;
+    }while(!(2000u == year && 1u == month && 1u == date));
+    TEST_CHECK(0u == mismatches);
+    //200 years of 365 days and 50 leap days, 2100 is one for the chip
+    TEST_CHECK(200u * 365u + 50u == days);
+}
+
+/** hours register to 0-23 */
+static uint8_t hours_24(uint8_t hours_reg){
+    if(hours_reg & 0x40u){
+        const uint8_t hours = (uint8_t)((((hours_reg >> 4u) & 0x01u) * 10u + (hours_reg & 0x0Fu)) % 12u);
+        return (hours_reg & 0x20u) ? hours + 12u : hours;
+    }else{
+        return (uint8_t)(((hours_reg >> 4u) & 0x03u) * 10u + (hours_reg & 0x0Fu));
+    }
+}
+
+/** a 12 hours and a 24 hours clock ticking through two days stay on the same time */
+static void check_12_24_hours(void){
+    ds3231_sim_t twelve;
+    ds3231_sim_t twenty_four;
+    TEST_CHECK(ds3231_sim_init(&twelve) && ds3231_sim_init(&twenty_four));
+    //11:58:00 PM and 23:58:00 on 2026-10-15
+    set_clock(&twelve,0x40u | 0x20u | 0x11u,58,0,4,15,10,26,false);
+    set_clock(&twenty_four,bcd(23),58,0,4,15,10,26,false);
+    uint32_t mismatches = 0;
+    for(uint32_t s = 0; s < 2u * 86400u; s++){
+        TEST_CHECK(tick(&twelve) && tick(&twenty_four));
+        const uint8_t hours = twelve.regs[0x02];
+        //1-12 with the 12 hours bit set, never 0 or 13
+        const uint8_t clock_hours = (uint8_t)(((hours >> 4u) & 0x01u) * 10u + (hours & 0x0Fu));
+        if(0u == (hours & 0x40u) || 1u > clock_hours || 12u < clock_hours
+                || hours_24(hours) != hours_24(twenty_four.regs[0x02])
+                || 0 != memcmp(twelve.regs,twenty_four.regs,2u) || 0 != memcmp(&twelve.regs[0x03],&twenty_four.regs[0x03],4u)){
+            mismatches += 1u;
+        }
+    }
+    TEST_CHECK(0u == mismatches);
+    //11:59:59 PM -> 12:00:00 AM moves the date, 11:59:59 AM -> 12:00:00 PM doesn't
+    set_clock(&twelve,0x40u | 0x20u | 0x11u,59,59,4,15,10,26,false);
+    TEST_CHECK(tick(&twelve) && (0x40u | 0x12u) == twelve.regs[0x02] && 0x16u == twelve.regs[0x04] && 5u == twelve.regs[0x03]);
+    set_clock(&twelve,0x40u | 0x11u,59,59,4,15,10,26,false);
+    TEST_CHECK(tick(&twelve) && (0x40u | 0x20u | 0x12u) == twelve.regs[0x02] && 0x15u == twelve.regs[0x04]);
+    //12:59:59 AM -> 01:00:00 AM
+    set_clock(&twelve,0x40u | 0x12u,59,59,4,15,10,26,false);
+    TEST_CHECK(tick(&twelve) && (0x40u | 0x01u) == twelve.regs[0x02] && 0x15u == twelve.regs[0x04]);
+}
+
+typedef struct{
+    const char* name;
+    /** alarm1 0x07-0x0A or alarm2 0x0B-0x0D */
+    uint8_t regs[4];
+    bool alarm2;
+    uint32_t matches;
+}alarm_case_t;
+
+/** count the seconds A1F or A2F gets set over eight days from monday 2024-02-26 00:00:00 */
+static void check_alarm(const alarm_case_t* alarm_case){
+    ds3231_sim_t sim;
+    TEST_CHECK(ds3231_sim_init(&sim));
+    set_clock(&sim,bcd(0),0,0,1,26,2,24,false);
+    //the other alarm never matches: seconds 61 and minutes 61 don't exist
+    memcpy(&sim.regs[0x07],(const uint8_t[]){0x61u, 0x61u, 0x00u, 0x01u},4u);
+    memcpy(&sim.regs[0x0B],(const uint8_t[]){0x61u, 0x00u, 0x01u},3u);
+    memcpy(&sim.regs[alarm_case->alarm2 ? 0x0B : 0x07],alarm_case->regs,alarm_case->alarm2 ? 3u : 4u);
+    sim.regs[0x0F] = 0x00u;
+    const uint8_t flag = alarm_case->alarm2 ? 0x02u : 0x01u;
+    uint32_t matches = 0;
+    uint32_t other = 0;
+    for(uint32_t s = 0; s < 8u * 86400u; s++){
+        TEST_CHECK(tick(&sim));
+        matches += (sim.regs[0x0F] & flag) ? 1u : 0u;
+        other += (sim.regs[0x0F] & 0x03u & ~flag) ? 1u : 0u;
+        //A2F only ever at 00 seconds
+        if((sim.regs[0x0F] & 0x02u) && 0u != sim.regs[0x00]){
+            other += 1u;
+        }
+        sim.regs[0x0F] = 0x00u;
+    }
+    if(alarm_case->matches != matches || 0u != other){
+        fprintf(stderr,"%s: %u matches, expected %u, %u stray flags\n",alarm_case->name,matches,alarm_case->matches,other);
+        test_failures += 1u;
+    }
+}
+
+static void check_alarms(void){
+    //eight days hold 691200 seconds, 11520 minutes and 192 hours. 2024 is a leap year, so
+    //friday march 1st is day 5 and date 1, monday the 26th and the 4th are day 1
+    const alarm_case_t cases[] = {
+        {"A1 every second", {0x80u, 0x80u, 0x80u, 0x80u}, false, 691200u},
+        {"A1 seconds", {0x30u, 0x80u, 0x80u, 0x80u}, false, 11520u},
+        {"A1 minutes seconds", {0x30u, 0x15u, 0x80u, 0x80u}, false, 192u},
+        {"A1 hours minutes seconds", {0x30u, 0x15u, 0x13u, 0x80u}, false, 8u},
+        {"A1 12h alarm on 24h clock", {0x30u, 0x15u, 0x40u | 0x20u | 0x01u, 0x80u}, false, 8u},
+        {"A1 12h midnight", {0x00u, 0x00u, 0x40u | 0x12u, 0x80u}, false, 8u},
+        {"A1 date", {0x30u, 0x15u, 0x13u, 0x01u}, false, 1u},
+        {"A1 leap date", {0x30u, 0x15u, 0x13u, 0x29u}, false, 1u},
+        {"A1 day", {0x30u, 0x15u, 0x13u, 0x40u | 0x01u}, false, 2u},
+        {"A1 day 5", {0x30u, 0x15u, 0x13u, 0x40u | 0x05u}, false, 1u},
+        {"A2 every minute", {0x80u, 0x80u, 0x80u}, true, 11520u},
+        {"A2 minutes", {0x15u, 0x80u, 0x80u}, true, 192u},
+        {"A2 hours minutes", {0x15u, 0x13u, 0x80u}, true, 8u},
+        {"A2 date", {0x15u, 0x13u, 0x29u}, true, 1u},
+        {"A2 day", {0x15u, 0x13u, 0x40u | 0x01u}, true, 2u},
+        {"A2 midnight on day 1", {0x00u, 0x00u, 0x40u | 0x01u}, true, 1u}
+    };
+    for(uint32_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++){
+        check_alarm(&cases[i]);
+    }
+}
+
+/** the automatic conversion every 64 seconds and the one CONV starts, BSY while they run */
+static void check_conversions(void){
+    ds3231_sim_t sim;
+    ds3231_dev_t dev;
+    TEST_CHECK(test_sim_device(&sim,&dev,0u));
+    TEST_CHECK(0x00u == (sim.regs[0x0F] & 0x04u) && 0x19u == sim.regs[0x11] && 0x00u == sim.regs[0x12]);
+    TEST_CHECK(ds3231_sim_set_temperature(&sim,-4 * 10 - 1));
+    //63 seconds in nothing converted, the 64th starts a conversion lasting 125 ms
+    TEST_CHECK(ds3231_sim_advance_ns(&sim,63u * NS_PER_SECOND + NS_PER_SECOND / 2u));
+    TEST_CHECK(0x00u == (sim.regs[0x0F] & 0x04u) && 0x19u == sim.regs[0x11]);
+    TEST_CHECK(ds3231_sim_advance_ns(&sim,NS_PER_SECOND / 2u + 124000000u));
+    TEST_CHECK(0x04u == (sim.regs[0x0F] & 0x04u) && 0x19u == sim.regs[0x11]);
+    //CONV is not set by the automatic conversion
+    TEST_CHECK(0x00u == (sim.regs[0x0E] & 0x20u));
+    TEST_CHECK(ds3231_sim_advance_ns(&sim,1000000u));
+    //-10.25 is 0x3D7 in 10 bits two's complement: 0xF5 (-11) and 0xC0 (+0.75)
+    TEST_CHECK(0x00u == (sim.regs[0x0F] & 0x04u) && 0xF5u == sim.regs[0x11] && 0xC0u == sim.regs[0x12]);
+    //the next one 64 seconds after the last
+    TEST_CHECK(ds3231_sim_advance_ns(&sim,63u * NS_PER_SECOND + NS_PER_SECOND / 2u));
+    TEST_CHECK(0x00u == (sim.regs[0x0F] & 0x04u));
+    TEST_CHECK(ds3231_sim_advance_ns(&sim,NS_PER_SECOND / 2u - 100000000u));
+    TEST_CHECK(0x04u == (sim.regs[0x0F] & 0x04u));
+    TEST_CHECK(ds3231_sim_advance_ns(&sim,200000000u) && 0x00u == (sim.regs[0x0F] & 0x04u));
+
+    //CONV sets BSY, both clear with the result, the other control bits are kept
+    TEST_CHECK(ds3231_sim_set_temperature(&sim,4 * 31 + 2));
+    TEST_CHECK(__ds3231_i2c_write_single(&dev,0x0Eu,0x1Cu | 0x20u));
+    TEST_CHECK((0x1Cu | 0x20u) == sim.regs[0x0E] && 0x04u == (sim.regs[0x0F] & 0x04u));
+    //BSY is read only and writing CONV again doesn't restart the conversion
+    TEST_CHECK(ds3231_sim_advance_ns(&sim,100000000u));
+    TEST_CHECK(__ds3231_i2c_write_single(&dev,0x0Fu,0x00u) && 0x04u == sim.regs[0x0F]);
+    TEST_CHECK(__ds3231_i2c_write_single(&dev,0x0Eu,0x1Cu | 0x20u));
+    TEST_CHECK(ds3231_sim_advance_ns(&sim,25000000u));
+    TEST_CHECK(0x1Cu == sim.regs[0x0E] && 0x00u == sim.regs[0x0F] && 0x1Fu == sim.regs[0x11] && 0x80u == sim.regs[0x12]);
+    //the temperature registers are read only
+    TEST_CHECK(__ds3231_i2c_write_single(&dev,0x11u,0x55u) && 0x1Fu == sim.regs[0x11]);
+    TEST_CHECK(ds3231_deinit(&dev));
+}
+
+/** status writes only clear flags, EN32KHZ is the one writable bit */
+static void check_status_writes(void){
+    ds3231_sim_t sim;
+    ds3231_dev_t dev;
+    TEST_CHECK(test_sim_device(&sim,&dev,0u));
+    TEST_CHECK((0x80u | 0x08u) == sim.regs[0x0F]);
+    TEST_CHECK(__ds3231_i2c_write_single(&dev,0x0Fu,0x8Bu) && (0x80u | 0x08u) == sim.regs[0x0F]);
+    TEST_CHECK(__ds3231_i2c_write_single(&dev,0x0Fu,0x03u) && 0x00u == sim.regs[0x0F]);
+    TEST_CHECK(__ds3231_i2c_write_single(&dev,0x0Fu,0x08u | 0x83u) && 0x08u == sim.regs[0x0F]);
+    //writing the seconds restarts the countdown: a full second to the next tick
+    TEST_CHECK(ds3231_sim_advance_ns(&sim,700000000u));
+    TEST_CHECK(__ds3231_i2c_write_single(&dev,0x00u,0x10u) && 0u == sim.phase_ns);
+    TEST_CHECK(ds3231_sim_advance_ns(&sim,999999999u) && 0x10u == sim.regs[0x00]);
+    TEST_CHECK(ds3231_sim_advance_ns(&sim,1u) && 0x11u == sim.regs[0x00]);
+    TEST_CHECK(ds3231_deinit(&dev));
+}
+
+/** EOSC stops the oscillator on battery only, which sets OSF */
+static void check_oscillator(void){
+    ds3231_sim_t sim;
+    ds3231_dev_t dev;
+    TEST_CHECK(test_sim_device(&sim,&dev,0u));
+    TEST_CHECK(__ds3231_i2c_write_single(&dev,0x0Fu,0x08u) && 0x08u == sim.regs[0x0F]);
+    set_clock(&sim,bcd(12),0,0,1,1,1,26,false);
+
+    //on battery with EOSC clear the clock keeps running
+    TEST_CHECK(ds3231_sim_set_battery(&sim,true));
+    TEST_CHECK(ds3231_sim_advance_ns(&sim,10u * NS_PER_SECOND) && 0x10u == sim.regs[0x00] && 0x08u == sim.regs[0x0F]);
+    //EOSC on vcc keeps running too
+    TEST_CHECK(ds3231_sim_set_battery(&sim,false));
+    TEST_CHECK(__ds3231_i2c_write_single(&dev,0x0Eu,0x80u | 0x1Cu));
+    TEST_CHECK(ds3231_sim_advance_ns(&sim,10u * NS_PER_SECOND) && 0x20u == sim.regs[0x00] && 0x08u == sim.regs[0x0F]);
+
+    //on battery the oscillator stops: OSF set, time, alarms and conversions frozen
+    memcpy(&sim.regs[0x07],(const uint8_t[]){0x80u, 0x80u, 0x80u, 0x80u},4u);
+    TEST_CHECK(ds3231_sim_set_battery(&sim,true));
+    TEST_CHECK(0x88u == sim.regs[0x0F]);
+    uint8_t frozen[7];
+    memcpy(frozen,sim.regs,sizeof(frozen));
+    TEST_CHECK(ds3231_sim_advance_ns(&sim,600u * NS_PER_SECOND));
+    TEST_CHECK(0 == memcmp(frozen,sim.regs,sizeof(frozen)) && 0x88u == sim.regs[0x0F]);
+    //back on vcc it runs on from where it stopped, OSF stays until cleared
+    TEST_CHECK(ds3231_sim_set_battery(&sim,false));
+    TEST_CHECK(ds3231_sim_advance_ns(&sim,NS_PER_SECOND) && 0x21u == sim.regs[0x00]);
+    TEST_CHECK(0x89u == sim.regs[0x0F]);
+    TEST_CHECK(__ds3231_i2c_write_single(&dev,0x0Fu,0x08u) && 0x08u == sim.regs[0x0F]);
+
+    //setting EOSC while on battery stops it as well
+    TEST_CHECK(__ds3231_i2c_write_single(&dev,0x0Eu,0x1Cu) && ds3231_sim_set_battery(&sim,true));
+    TEST_CHECK(0x08u == sim.regs[0x0F]);
+    TEST_CHECK(__ds3231_i2c_write_single(&dev,0x0Eu,0x80u | 0x1Cu) && 0x88u == sim.regs[0x0F]);
+    TEST_CHECK(ds3231_deinit(&dev));
+}
+
+int main(void){
+    check_day_rollover();
+    check_12_24_hours();
+    check_alarms();
+    check_conversions();
+    check_status_writes();
+    check_oscillator();
+    return test_result("test_sim");
+}
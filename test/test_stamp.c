@@ -0,0 +1,104 @@
+#include "ds3231_test.h"
+#include "ds3231_lib_clock.h"
+
+/**
+ * ds3231_stamp_batch against ds3231_now for the same monotonic counter values, with the rate
+ * measured from a drifting simulated oscillator: within DS3231_STAMP_ROUNDING_NS up to a year from
+ * the anchor, exact without a rate, and against the new anchor after a re-anchor.
+ */
+
+static const uint64_t NS_PER_SECOND = 1000000000u;
+static const uint32_t LATENCY_NS = 50000u;
+static const uint32_t BATCH = 64u;
+
+static int64_t stamp_ns(const ds3231_timespec_t* t){
+    return t->seconds * (int64_t)NS_PER_SECOND + t->nanoseconds;
+}
+
+/** ds3231_now at a monotonic time, the simulator's counter is moved there without running the chip */
+static bool now_at(ds3231_sim_t* sim, ds3231_clock_t* clock, uint64_t monotonic_ns, ds3231_timespec_t* now){
+    const uint64_t saved_ns = sim->now_ns;
+    sim->now_ns = monotonic_ns;
+    const bool res = ds3231_now(clock,now);
+    sim->now_ns = saved_ns;
+    return res;
+}
+
+/** a batch of counters from the anchor over elapsed_span_ns, each compared with ds3231_now */
+static int64_t compare_batch(ds3231_sim_t* sim, ds3231_clock_t* clock, uint64_t elapsed_span_ns){
+    uint64_t monotonic_ns[BATCH];
+    ds3231_timespec_t stamps[BATCH];
+    uint32_t seed = 0x9E3779B9u;
+    for(uint32_t i = 0; i < BATCH; i++){
+        seed ^= seed << 13; seed ^= seed >> 17; seed ^= seed << 5;
+        //the anchor itself, whole seconds and arbitrary counters
+        const uint64_t offset_ns = (0u == i) ? 0u : (1u == i) ? NS_PER_SECOND
+                                 : (elapsed_span_ns / BATCH) * i + seed % NS_PER_SECOND;
+        monotonic_ns[i] = clock->anchor_ns + offset_ns;
+    }
+    TEST_CHECK(ds3231_stamp_batch(clock,monotonic_ns,stamps,BATCH));
+    int64_t worst_ns = 0;
+    for(uint32_t i = 0; i < BATCH; i++){
+        ds3231_timespec_t now = {0};
+        TEST_CHECK(now_at(sim,clock,monotonic_ns[i],&now));
+        TEST_CHECK(NS_PER_SECOND > stamps[i].nanoseconds);
+        const uint64_t elapsed_ns = monotonic_ns[i] - clock->anchor_ns;
+        const int64_t difference_ns = stamp_ns(&stamps[i]) - stamp_ns(&now);
+        if(difference_ns > DS3231_STAMP_ROUNDING_NS || -difference_ns > DS3231_STAMP_ROUNDING_NS){
+            fprintf(stderr,"rate %d ppb, %llu ns from the anchor: batch %lld.%09u now %lld.%09u\n",clock->rate_ppb,
+                    (unsigned long long)elapsed_ns,(long long)stamps[i].seconds,stamps[i].nanoseconds,
+                    (long long)now.seconds,now.nanoseconds);
+            test_failures += 1u;
+        }
+        worst_ns = (difference_ns > worst_ns) ? difference_ns : (-difference_ns > worst_ns) ? -difference_ns : worst_ns;
+    }
+    return worst_ns;
+}
+
+static void check_agreement(int32_t drift_ppb){
+    ds3231_sim_t sim;
+    ds3231_dev_t dev;
+    ds3231_clock_t clock;
+    ds3231_timespec_t stamp = {0};
+    const uint64_t counter_ns = 12345u;
+    TEST_CHECK(test_sim_device(&sim,&dev,LATENCY_NS));
+    TEST_CHECK(ds3231_sim_set_drift(&sim,drift_ppb));
+    TEST_CHECK(ds3231_set_unix_time(&dev,1760000000,true));
+    TEST_CHECK(ds3231_clock_init(&clock,&dev,600u));
+    //nothing published yet
+    TEST_CHECK(!ds3231_stamp_batch(&clock,&counter_ns,&stamp,1u));
+    TEST_CHECK(ds3231_clock_anchor(&clock));
+
+    //no rate on the first anchor, both are the same sum
+    TEST_CHECK(0 == clock.rate_ppb);
+    TEST_CHECK(0 == compare_batch(&sim,&clock,3600u * NS_PER_SECOND));
+
+    //the rate measured over an hour, then compared up to a day away from the anchor
+    TEST_CHECK(ds3231_sim_advance_ns(&sim,3600u * NS_PER_SECOND));
+    bool reanchored = false;
+    TEST_CHECK(ds3231_clock_poll(&clock,&reanchored) && reanchored);
+    TEST_CHECK(0 == drift_ppb || 0 != clock.rate_ppb);
+    const int64_t hour_ns = compare_batch(&sim,&clock,3600u * NS_PER_SECOND);
+    const int64_t day_ns = compare_batch(&sim,&clock,86400u * NS_PER_SECOND);
+    const int64_t year_ns = compare_batch(&sim,&clock,365u * 86400u * NS_PER_SECOND);
+
+    //a counter before the anchor is extrapolated back, ds3231_now never sees one
+    const uint64_t before_ns = clock.anchor_ns - NS_PER_SECOND;
+    TEST_CHECK(ds3231_stamp_batch(&clock,&before_ns,&stamp,1u));
+    TEST_CHECK(clock.anchor_seconds - 1 == stamp.seconds || (clock.anchor_seconds - 2 == stamp.seconds && stamp.nanoseconds > 999000000u));
+
+    //empty batches and bad arguments
+    TEST_CHECK(ds3231_stamp_batch(&clock,&counter_ns,&stamp,0u));
+    TEST_CHECK(!ds3231_stamp_batch(&clock,NULL,&stamp,1u) && !ds3231_stamp_batch(&clock,&counter_ns,NULL,1u));
+    printf("drift %7d ppb: rate %7d ppb, batch - now within %lld ns over an hour, %lld over a day, %lld over a year\n",
+           drift_ppb,clock.rate_ppb,(long long)hour_ns,(long long)day_ns,(long long)year_ns);
+    TEST_CHECK(ds3231_deinit(&dev));
+}
+
+int main(void){
+    static const int32_t drifts_ppb[] = {0, 2500, -1800, 30000, -150000, 200000};
+    for(uint32_t i = 0; i < sizeof(drifts_ppb) / sizeof(drifts_ppb[0]); i++){
+        check_agreement(drifts_ppb[i]);
+    }
+    return test_result("test_stamp");
+}
@@ -0,0 +1,186 @@
+#include <math.h>
+#include "ds3231_test.h"
+#include "ds3231_lib_temp.h"
+
+/**
+ * the temperature service against the simulator's 64 second conversions: polled at 10Hz over
+ * several periods the bus is read for about 1% of the calls, every new conversion is served within
+ * DS3231_TEMP_PROBE_MS, a forced conversion returns the fresh value after its back off and times
+ * out when the chip never finishes, and the statistics match the temperatures converted.
+ */
+
+static const uint64_t NS_PER_MS = 1000000u;
+static const uint32_t LATENCY_NS = 100000u;
+static const uint64_t POLL_NS = 100000000u; /** 10Hz */
+
+static int16_t sim_centi(const ds3231_sim_t* sim){
+    return (int16_t)(((int8_t)sim->regs[0x11] * 4 + (sim->regs[0x12] >> 6u)) * 25);
+}
+
+typedef struct{
+    uint32_t calls;
+    uint32_t stale;
+    uint64_t worst_stale_ns;
+}poll_result_t;
+
+/**
+ * @brief poll at 10Hz over one conversion period, the die changing to quarters half way through.
+ * a call is stale when it returns another value than the chip holds, counted from when the chip
+ * got its new value
+ */
+static void poll_period(ds3231_sim_t* sim, ds3231_temp_t* temp, int16_t quarters, poll_result_t* result){
+    static uint64_t changed_ns = 0;
+    static int16_t chip_centi = 0;
+    for(uint32_t i = 0; i < 640u; i++){
+        if(320u == i){
+            TEST_CHECK(ds3231_sim_set_temperature(sim,quarters));
+        }
+        TEST_CHECK(ds3231_sim_advance_ns(sim,POLL_NS));
+        if(sim_centi(sim) != chip_centi){
+            //the conversion ended at most one poll ago, count from the earliest
+            chip_centi = sim_centi(sim);
+            changed_ns = sim->now_ns - POLL_NS;
+        }
+        int16_t centi = 0;
+        TEST_CHECK(ds3231_temp_get(temp,&centi));
+        result->calls += 1u;
+        if(centi != chip_centi){
+            result->stale += 1u;
+            const uint64_t stale_ns = sim->now_ns - changed_ns;
+            result->worst_stale_ns = (stale_ns > result->worst_stale_ns) ? stale_ns : result->worst_stale_ns;
+        }
+    }
+}
+
+static void check_polling(void){
+    ds3231_sim_t sim;
+    ds3231_dev_t dev;
+    ds3231_temp_t temp;
+    TEST_CHECK(test_sim_device(&sim,&dev,LATENCY_NS));
+    TEST_CHECK(ds3231_temp_init(&temp,&dev));
+    //the first period learns the phase. the conversions end just after the start of a period, a
+    //repeated value can't be told from the one before it
+    static const int16_t quarters[] = {101, 102, 99, 99, 80, -3, -40, 140, 141, 100};
+    const uint32_t periods = sizeof(quarters) / sizeof(quarters[0]);
+    poll_result_t first = {0};
+    poll_result_t locked = {0};
+    poll_period(&sim,&temp,quarters[0],&first);
+    const uint32_t learning_reads = temp.reads;
+    const uint32_t transactions = sim.transactions;
+    for(uint32_t p = 1; p < periods; p++){
+        poll_period(&sim,&temp,quarters[p],&locked);
+    }
+    const uint32_t reads = temp.reads - learning_reads;
+    printf("learning period: %u calls, %u reads\n",first.calls,learning_reads);
+    printf("locked %u periods: %u calls, %u reads (%.2f%%), %u hits, %u stale, worst %llu ms\n",periods - 1u,
+           locked.calls,reads,100.0 * reads / locked.calls,temp.hits,locked.stale,
+           (unsigned long long)(locked.worst_stale_ns / NS_PER_MS));
+    //one read per call would be 640 a period, 99% fewer is under 7
+    TEST_CHECK(100u * reads <= locked.calls);
+    TEST_CHECK(reads == sim.transactions - transactions);
+    TEST_CHECK(first.calls + locked.calls == temp.reads + temp.hits);
+    //a new value is served within the probe interval and the poll it lands between
+    TEST_CHECK(first.worst_stale_ns <= (uint64_t)DS3231_TEMP_PROBE_MS * NS_PER_MS + POLL_NS);
+    TEST_CHECK(locked.worst_stale_ns <= (uint64_t)DS3231_TEMP_PROBE_MS * NS_PER_MS + POLL_NS);
+
+    //one sample per conversion, the repeated 99 included
+    int16_t history[DS3231_TEMP_SAMPLES];
+    uint16_t count = 0;
+    TEST_CHECK(ds3231_temp_history(&temp,history,DS3231_TEMP_SAMPLES,&count));
+    //the power on value and the conversions at 64, 128, ... 576 seconds
+    TEST_CHECK(periods == count);
+    TEST_CHECK(2500 == history[0]);
+    for(uint32_t p = 1; p < count; p++){
+        TEST_CHECK(quarters[p - 1u] * 25 == history[p]);
+    }
+    TEST_CHECK(ds3231_deinit(&dev));
+}
+
+static void check_convert(void){
+    ds3231_sim_t sim;
+    ds3231_dev_t dev;
+    ds3231_temp_t temp;
+    int16_t centi = 0;
+    TEST_CHECK(test_sim_device(&sim,&dev,LATENCY_NS));
+    TEST_CHECK(ds3231_temp_init(&temp,&dev));
+    TEST_CHECK(ds3231_sim_advance_ns(&sim,10000u * NS_PER_MS));
+
+    //idle chip: CONV, then polled at 4, 8, 16, 32, 32... ms until the 125ms conversion is over
+    TEST_CHECK(ds3231_sim_set_temperature(&sim,4 * 31 + 1));
+    uint64_t start_ns = sim.now_ns;
+    TEST_CHECK(ds3231_temp_convert(&temp,&centi) && 3125 == centi && 3125 == temp.centi);
+    uint64_t elapsed_ns = sim.now_ns - start_ns;
+    //the back offs: 4+8+16+32+32+32+32 ms is the first sum past the 125ms conversion
+    TEST_CHECK(124u * NS_PER_MS < elapsed_ns && elapsed_ns < 156u * NS_PER_MS + 20u * LATENCY_NS);
+    TEST_CHECK(0x00u == (sim.regs[0x0E] & 0x20u) && 0x00u == (sim.regs[0x0F] & 0x04u));
+    printf("forced conversion: %llu us\n",(unsigned long long)(elapsed_ns / 1000u));
+
+    //during an automatic conversion it waits for BSY to drop before setting CONV
+    TEST_CHECK(ds3231_sim_advance_ns(&sim,64000u * NS_PER_MS - sim.now_ns + 10u * NS_PER_MS));
+    TEST_CHECK(0x04u == (sim.regs[0x0F] & 0x04u));
+    TEST_CHECK(ds3231_sim_set_temperature(&sim,4 * 20));
+    start_ns = sim.now_ns;
+    TEST_CHECK(ds3231_temp_convert(&temp,&centi) && 2000 == centi);
+    elapsed_ns = sim.now_ns - start_ns;
+    TEST_CHECK(2u * 115u * NS_PER_MS < elapsed_ns && elapsed_ns < (uint64_t)DS3231_TEMP_CONVERT_TIMEOUT_US * 1000u);
+
+    //a conversion that never ends times out after the back off sum, not much later
+    sim.conversion_ns = 4000000000u;
+    start_ns = sim.now_ns;
+    TEST_CHECK(!ds3231_temp_convert(&temp,&centi));
+    elapsed_ns = sim.now_ns - start_ns;
+    TEST_CHECK((uint64_t)DS3231_TEMP_CONVERT_TIMEOUT_US * 1000u <= elapsed_ns);
+    TEST_CHECK(elapsed_ns < ((uint64_t)DS3231_TEMP_CONVERT_TIMEOUT_US + DS3231_TEMP_POLL_MAX_US) * 1000u + 40u * LATENCY_NS);
+    printf("timed out after %llu us\n",(unsigned long long)(elapsed_ns / 1000u));
+    TEST_CHECK(ds3231_deinit(&dev));
+}
+
+static void check_stats(void){
+    ds3231_sim_t sim;
+    ds3231_dev_t dev;
+    ds3231_temp_t temp;
+    ds3231_temp_stats_t stats;
+    TEST_CHECK(test_sim_device(&sim,&dev,LATENCY_NS));
+    TEST_CHECK(ds3231_temp_init(&temp,&dev));
+    TEST_CHECK(!ds3231_temp_get_stats(&temp,&stats));
+    //the first read records the power on value, leave it out
+    int16_t centi = 0;
+    TEST_CHECK(ds3231_temp_get(&temp,&centi) && 2500 == centi);
+    TEST_CHECK(ds3231_temp_get_stats(&temp,&stats) && 1u == stats.count && 2500 == stats.mean_centi);
+    TEST_CHECK(ds3231_temp_reset_stats(&temp));
+    //forced conversions, so every sample is known: a cold start warming up through zero
+    static const int16_t quarters[] = {-41, -30, -17, -5, 0, 3, 12, 27, 50, 61, 77, 90, 91, 100, 100, 105};
+    const uint32_t count = sizeof(quarters) / sizeof(quarters[0]);
+    double sum = 0.0;
+    double sum_sq = 0.0;
+    for(uint32_t i = 0; i < count; i++){
+        TEST_CHECK(ds3231_sim_set_temperature(&sim,quarters[i]));
+        TEST_CHECK(ds3231_temp_convert(&temp,NULL));
+        sum += quarters[i] * 25.0;
+        sum_sq += (quarters[i] * 25.0) * (quarters[i] * 25.0);
+    }
+    const double mean = sum / count;
+    const double variance = sum_sq / count - mean * mean;
+    TEST_CHECK(ds3231_temp_get_stats(&temp,&stats));
+    printf("stats: mean %d (%.2f) variance %u (%.2f) min %d max %d\n",stats.mean_centi,mean,stats.variance_centi2,
+           variance,stats.min_centi,stats.max_centi);
+    TEST_CHECK(count == stats.count && -1025 == stats.min_centi && 2625 == stats.max_centi);
+    TEST_CHECK(fabs(stats.mean_centi - mean) <= 0.5);
+    TEST_CHECK(fabs(stats.variance_centi2 - variance) <= 1.0);
+
+    //restarted, the next sample is the new reference
+    TEST_CHECK(ds3231_temp_reset_stats(&temp) && !ds3231_temp_get_stats(&temp,&stats));
+    TEST_CHECK(ds3231_sim_set_temperature(&sim,-8) && ds3231_temp_convert(&temp,NULL));
+    TEST_CHECK(ds3231_sim_set_temperature(&sim,-12) && ds3231_temp_convert(&temp,NULL));
+    TEST_CHECK(ds3231_temp_get_stats(&temp,&stats));
+    TEST_CHECK(2u == stats.count && -250 == stats.mean_centi && 2500u == stats.variance_centi2);
+    TEST_CHECK(-300 == stats.min_centi && -200 == stats.max_centi);
+    TEST_CHECK(ds3231_deinit(&dev));
+}
+
+int main(void){
+    check_polling();
+    check_convert();
+    check_stats();
+    return test_result("test_temp");
+}
@@ -0,0 +1,288 @@
+#include <string.h>
+#include "ds3231_test.h"
+#include "ds3231_lib_timer.h"
+
+/**
+ * the software timers against the simulator, serviced on INT like on a node: both heaps stay
+ * ordered through random starts and stops, minute aligned deadlines go to alarm2 and the rest to
+ * alarm1, every timer fires in its deadline second, a periodic timer skips the expiries missed
+ * while asleep, and a service costs one time read and one burst write per wake.
+ */
+
+static const uint32_t LATENCY_NS = 100000u;
+static const uint64_t NS_PER_SECOND = 1000000000u;
+/** a whole minute, 2025-10-09 08:53:00 */
+static const int64_t MINUTE = 1759999980;
+
+typedef struct{
+    ds3231_sim_t* sim;
+    /** deadline of the next expiry */
+    int64_t expected;
+    uint32_t period_s;
+    uint32_t fires;
+    uint32_t late;
+}timer_log_t;
+
+typedef struct{
+    uint32_t services;
+    uint32_t transactions;
+    /** services taking more than a read and a write, only allowed with a deadline in the next second */
+    uint32_t extra;
+    uint32_t max_transactions;
+    /** seconds INT stayed active after a service */
+    uint32_t stuck;
+}service_log_t;
+
+static int64_t sim_unix(const ds3231_sim_t* sim){
+    ds3231_time_data_t time = {0};
+    int64_t unix_time = 0;
+    ds3231_decode_time(sim->regs,&time);
+    ds3231_time_to_unix(&time,&unix_time);
+    return unix_time;
+}
+
+static void on_timer(ds3231_timer_t* timer, void* ctx){
+    timer_log_t* log = (timer_log_t*)ctx;
+    (void)timer;
+    if(sim_unix(log->sim) != log->expected){
+        log->late += 1u;
+    }
+    log->fires += 1u;
+    log->expected += log->period_s;
+}
+
+static void setup(ds3231_sim_t* sim, ds3231_dev_t* dev, ds3231_timers_t* timers, int64_t now){
+    TEST_CHECK(test_sim_device(sim,dev,LATENCY_NS));
+    TEST_CHECK(ds3231_set_unix_time(dev,now,true));
+    TEST_CHECK(ds3231_shadow_resync(dev));
+    TEST_CHECK(ds3231_timers_init(timers,dev));
+}
+
+/** both heaps ordered and every timer's index pointing at its slot */
+static bool heaps_valid(const ds3231_timers_t* timers){
+    for(uint8_t heap = 0; heap < 2u; heap++){
+        for(uint16_t i = 0; i < timers->__counts[heap]; i++){
+            const ds3231_timer_t* timer = timers->__heaps[heap][i];
+            if(heap + 1u != timer->__heap || i != timer->__index
+                    || (0u < i && timer->deadline < timers->__heaps[heap][(i - 1u) / 2u]->deadline)
+                    || ((1u == heap) != (0 == timer->deadline % 60))){
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static void check_heaps(void){
+    ds3231_sim_t sim;
+    ds3231_dev_t dev;
+    ds3231_timers_t timers;
+    static ds3231_timer_t pool[2u * DS3231_TIMERS_MAX];
+    static timer_log_t logs[2u * DS3231_TIMERS_MAX];
+    setup(&sim,&dev,&timers,MINUTE);
+    memset(pool,0,sizeof(pool));
+    uint32_t seed = 0x2545F491u;
+    uint32_t invalid = 0;
+    for(uint32_t step = 0; step < 20000u; step++){
+        seed ^= seed << 13u; seed ^= seed >> 17u; seed ^= seed << 5u;
+        ds3231_timer_t* timer = &pool[seed % (2u * DS3231_TIMERS_MAX)];
+        //a third of the deadlines on whole minutes, many equal
+        const int64_t deadline = MINUTE + ((0u == (seed >> 8u) % 3u) ? 60 * (int64_t)((seed >> 10u) % 50u)
+                                                                       : (int64_t)((seed >> 10u) % 3000u));
+        if(0u == (seed >> 20u) % 4u){
+            const bool running = 0u != timer->__heap;
+            TEST_CHECK(running == ds3231_timer_stop(&timers,timer));
+        }else{
+            const uint8_t heap = (0 == deadline % 60) ? 1u : 0u;
+            const bool room = DS3231_TIMERS_MAX > timers.__counts[heap] || heap + 1u == timer->__heap;
+            TEST_CHECK(room == ds3231_timer_start(&timers,timer,deadline,0u,on_timer,&logs[0]));
+        }
+        invalid += heaps_valid(&timers) ? 0u : 1u;
+    }
+    TEST_CHECK(0u == invalid);
+    //a full heap refuses, the other one still takes timers
+    TEST_CHECK(ds3231_timers_init(&timers,&dev));
+    for(uint32_t i = 0; i < DS3231_TIMERS_MAX; i++){
+        pool[i].__heap = 0u;
+        TEST_CHECK(ds3231_timer_start(&timers,&pool[i],MINUTE + 60 * (int64_t)(DS3231_TIMERS_MAX - i),0u,on_timer,&logs[0]));
+    }
+    pool[DS3231_TIMERS_MAX].__heap = 0u;
+    TEST_CHECK(!ds3231_timer_start(&timers,&pool[DS3231_TIMERS_MAX],MINUTE + 120,0u,on_timer,&logs[0]));
+    TEST_CHECK(ds3231_timer_start(&timers,&pool[DS3231_TIMERS_MAX],MINUTE + 121,0u,on_timer,&logs[0]));
+    TEST_CHECK(heaps_valid(&timers) && MINUTE + 60 == timers.__heaps[1][0]->deadline);
+    TEST_CHECK(ds3231_deinit(&dev));
+}
+
+/** alarm registers holding unix time target, seconds (alarm1 only), minutes, hours and date */
+static bool alarm_holds(const ds3231_sim_t* sim, bool alarm2, int64_t target){
+    ds3231_time_data_t time = {0};
+    ds3231_unix_to_time(target,true,&time);
+    const uint8_t* regs = &sim->regs[alarm2 ? 0x0B : 0x07];
+    const uint8_t expected[4] = {(uint8_t)(((time.seconds / 10u) << 4u) | (time.seconds % 10u)),
+                                 (uint8_t)(((time.minutes / 10u) << 4u) | (time.minutes % 10u)),
+                                 (uint8_t)(((time.hours / 10u) << 4u) | (time.hours % 10u)),
+                                 (uint8_t)(((time.day_of_month / 10u) << 4u) | (time.day_of_month % 10u))};
+    return 0 == memcmp(regs,alarm2 ? &expected[1] : expected,alarm2 ? 3u : 4u);
+}
+
+/** the first service arms both alarms with the nearest deadline of their heap in one burst */
+static void check_split(void){
+    ds3231_sim_t sim;
+    ds3231_dev_t dev;
+    ds3231_timers_t timers;
+    ds3231_timer_t a = {0}, b = {0}, c = {0}, d = {0};
+    timer_log_t log = {.sim = &sim};
+    setup(&sim,&dev,&timers,MINUTE + 5);
+    TEST_CHECK(ds3231_timer_start(&timers,&a,MINUTE + 185,0u,on_timer,&log));
+    TEST_CHECK(ds3231_timer_start(&timers,&b,MINUTE + 121,0u,on_timer,&log));
+    TEST_CHECK(ds3231_timer_start(&timers,&c,MINUTE + 180,0u,on_timer,&log));
+    TEST_CHECK(ds3231_timer_start(&timers,&d,MINUTE + 120,0u,on_timer,&log));
+    TEST_CHECK(1u == a.__heap && 1u == b.__heap && 2u == c.__heap && 2u == d.__heap);
+    TEST_CHECK(ds3231_sim_reset_counters(&sim));
+    int64_t next = 0;
+    TEST_CHECK(ds3231_timers_service(&timers,&next) && MINUTE + 120 == next);
+    //the time (7 registers) and 0x07-0x0F
+    TEST_CHECK(2u == sim.transactions && (3u + 7u) + (2u + 9u) == sim.wire_bytes);
+    TEST_CHECK(alarm_holds(&sim,false,MINUTE + 121) && alarm_holds(&sim,true,MINUTE + 120));
+    TEST_CHECK(0x07u == (sim.regs[0x0E] & 0x07u) && 0x00u == (sim.regs[0x0F] & 0x03u));
+    TEST_CHECK(0 == timers.wakes && 0u == timers.fired);
+
+    //nothing changed, nothing written
+    TEST_CHECK(ds3231_sim_reset_counters(&sim));
+    TEST_CHECK(ds3231_timers_service(&timers,NULL) && 1u == sim.transactions);
+
+    //stopping the head of alarm2 moves it to the next minute aligned deadline, alarm1 is left alone
+    TEST_CHECK(ds3231_timer_stop(&timers,&d) && !ds3231_timer_stop(&timers,&d));
+    TEST_CHECK(ds3231_sim_reset_counters(&sim));
+    TEST_CHECK(ds3231_timers_service(&timers,&next) && MINUTE + 121 == next);
+    TEST_CHECK(2u == sim.transactions && (3u + 7u) + (2u + 5u) == sim.wire_bytes);
+    TEST_CHECK(alarm_holds(&sim,true,MINUTE + 180) && alarm_holds(&sim,false,MINUTE + 121));
+    TEST_CHECK(ds3231_deinit(&dev));
+}
+
+/**
+ * @brief run the node until end: a second at a time, a service whenever INT is active.
+ * @param [deadlines][in] per second from start, set when some timer is due in that second
+ */
+static void run_node(ds3231_sim_t* sim, ds3231_timers_t* timers, int64_t end, const uint8_t* deadlines,
+                     int64_t start, service_log_t* log){
+    while(sim_unix(sim) < end){
+        TEST_CHECK(ds3231_sim_advance_ns(sim,NS_PER_SECOND));
+        if(!ds3231_sim_int_active(sim)){
+            continue;
+        }
+        const uint32_t before = sim->transactions;
+        TEST_CHECK(ds3231_timers_service(timers,NULL));
+        const uint32_t transactions = sim->transactions - before;
+        const int64_t now = sim_unix(sim);
+        log->services += 1u;
+        log->transactions += transactions;
+        log->max_transactions = (transactions > log->max_transactions) ? transactions : log->max_transactions;
+        //past the end the deadlines are not known
+        if(2u < transactions && now + 1 <= end){
+            const bool soon = (NULL != deadlines && deadlines[now + 1 - start]);
+            log->extra += soon ? 0u : 1u;
+        }
+        log->stuck += ds3231_sim_int_active(sim) ? 1u : 0u;
+    }
+}
+
+/** many periodic and one shot timers across both alarms over an hour */
+static void check_many(void){
+    ds3231_sim_t sim;
+    ds3231_dev_t dev;
+    ds3231_timers_t timers;
+    static const uint32_t periods[] = {7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53, 59, 61, 97, 101,
+                                       60, 120, 180, 300, 600, 900, 0, 0, 0, 0};
+    static const int64_t firsts[] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19,
+                                     60, 120, 120, 300, 600, 900, 1234, 1800, 2401, 3599};
+    const uint32_t count = sizeof(periods) / sizeof(periods[0]);
+    const int64_t start = MINUTE;
+    const int64_t span = 3600;
+    ds3231_timer_t pool[sizeof(periods) / sizeof(periods[0])];
+    timer_log_t logs[sizeof(periods) / sizeof(periods[0])];
+    static uint8_t deadlines[3600 + 1];
+    memset(deadlines,0,sizeof(deadlines));
+    memset(pool,0,sizeof(pool));
+    setup(&sim,&dev,&timers,start);
+    uint32_t expected_fires = 0;
+    for(uint32_t i = 0; i < count; i++){
+        logs[i] = (timer_log_t){.sim = &sim, .expected = start + firsts[i], .period_s = periods[i]};
+        TEST_CHECK(ds3231_timer_start(&timers,&pool[i],start + firsts[i],periods[i],on_timer,&logs[i]));
+        for(int64_t t = firsts[i]; t <= span; t += (0u == periods[i]) ? span + 1 : periods[i]){
+            deadlines[t] = 1u;
+            expected_fires += 1u;
+        }
+    }
+    uint32_t wake_seconds = 0;
+    for(int64_t t = 0; t <= span; t++){
+        wake_seconds += deadlines[t];
+    }
+    TEST_CHECK(ds3231_timers_service(&timers,NULL));
+    TEST_CHECK(ds3231_sim_reset_counters(&sim));
+    service_log_t log = {0};
+    run_node(&sim,&timers,start + span,deadlines,start,&log);
+
+    uint32_t fires = 0;
+    uint32_t late = 0;
+    for(uint32_t i = 0; i < count; i++){
+        fires += logs[i].fires;
+        late += logs[i].late;
+    }
+    printf("%u timers over an hour: %u fires in %u wakes, %u services, %.2f transactions per service, max %u\n",
+           count,fires,timers.wakes,log.services,(double)log.transactions / log.services,log.max_transactions);
+    TEST_CHECK(expected_fires == fires && expected_fires == timers.fired && 0u == late);
+    //INT only for a due timer, once per second with one due
+    TEST_CHECK(wake_seconds == timers.wakes && wake_seconds == log.services);
+    if(0u != log.extra || 0u != log.stuck || 0u != timers.dropped){
+        fprintf(stderr,"%u services with more transactions, %u with INT left active, %u timers dropped\n",log.extra,
+                log.stuck,timers.dropped);
+        test_failures += 1u;
+    }
+    TEST_CHECK(ds3231_deinit(&dev));
+}
+
+/** asleep through nine expiries, the timer fires once and keeps its grid */
+static void check_missed(void){
+    ds3231_sim_t sim;
+    ds3231_dev_t dev;
+    ds3231_timers_t timers;
+    ds3231_timer_t timer = {0};
+    setup(&sim,&dev,&timers,MINUTE + 1);
+    timer_log_t log = {.sim = &sim, .expected = MINUTE + 10, .period_s = 10u};
+    TEST_CHECK(ds3231_timer_start(&timers,&timer,MINUTE + 10,10u,on_timer,&log));
+    TEST_CHECK(ds3231_timers_service(&timers,NULL));
+    TEST_CHECK(ds3231_sim_advance_ns(&sim,95u * NS_PER_SECOND));
+    TEST_CHECK(ds3231_sim_int_active(&sim) && MINUTE + 96 == sim_unix(&sim));
+    TEST_CHECK(ds3231_sim_reset_counters(&sim));
+    int64_t next = 0;
+    TEST_CHECK(ds3231_timers_service(&timers,&next));
+    TEST_CHECK(1u == log.fires && 1u == timers.fired && 1u == timers.wakes);
+    //the first expiry after now on the grid of MINUTE + 10
+    TEST_CHECK(MINUTE + 100 == next && MINUTE + 100 == timer.deadline && 1u == timer.__heap);
+    TEST_CHECK(alarm_holds(&sim,false,MINUTE + 100) && !ds3231_sim_int_active(&sim));
+    //alarm2 never had a timer and stays disabled: the time read and the alarm1 burst
+    TEST_CHECK(0x05u == (sim.regs[0x0E] & 0x07u));
+    TEST_CHECK(2u == sim.transactions);
+    printf("missed expiries: fired once at %lld, next %lld, %u transactions\n",(long long)(MINUTE + 96 - MINUTE),
+           (long long)(next - MINUTE),sim.transactions);
+
+    //the timer goes on from there: 100, 110 and 120 on alarm2. the fire at 96 was late on purpose
+    TEST_CHECK(1u == log.late);
+    log.expected = MINUTE + 100;
+    log.late = 0u;
+    service_log_t service = {0};
+    run_node(&sim,&timers,MINUTE + 125,NULL,MINUTE,&service);
+    TEST_CHECK(4u == log.fires && 0u == log.late && 3u == service.services && 0u == service.stuck);
+    //moving between the alarms programs one and disables the other in the same burst
+    TEST_CHECK(0u == service.extra && 2u == service.max_transactions);
+    TEST_CHECK(ds3231_deinit(&dev));
+}
+
+int main(void){
+    check_heaps();
+    check_split();
+    check_many();
+    check_missed();
+    return test_result("test_timer");
+}
@@ -0,0 +1,140 @@
+#include "ds3231_test.h"
+#include "ds3231_lib_util.h"
+
+/**
+ * the tm1637 frame encoder over a whole day, refreshed every second and every minute, for every
+ * layout and option: each frame matches an encode written out here, the changed mask is exactly
+ * the digits that differ, and a display written only with the changed digits shows the frame.
+ * a time given in 12 hours gives the same frame as in 24 hours.
+ * usage: test_tm1637
+ */
+
+static const uint8_t SEGMENTS[10] = {0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07, 0x7F, 0x6F};
+static const uint8_t COLON = 0x80u;
+
+static ds3231_time_data_t time_of_day(uint32_t second_of_day, bool is_12_hours_format){
+    const uint8_t hours = (uint8_t)(second_of_day / 3600u);
+    const ds3231_time_data_t t = {
+        .seconds = (uint8_t)(second_of_day % 60u),
+        .minutes = (uint8_t)(second_of_day / 60u % 60u),
+        .hours = is_12_hours_format ? (uint8_t)((0u == hours % 12u) ? 12u : hours % 12u) : hours,
+        .day_of_month = 1u, .month = 1u, .year = 26u, .day_of_week = 4u,
+        .is_12_hours_format = is_12_hours_format,
+        .pm = is_12_hours_format && 12u <= hours
+    };
+    return t;
+}
+
+static void reference_frame(const ds3231_tm1637_t* display, uint32_t second_of_day, uint8_t* frame){
+    const uint32_t hours = second_of_day / 3600u;
+    const uint32_t minutes = second_of_day / 60u % 60u;
+    const uint32_t seconds = second_of_day % 60u;
+    uint32_t left = minutes;
+    uint32_t right = seconds;
+    if(DS3231_TM1637_HH_MM == display->layout){
+        left = display->use_24_hours ? hours : ((0u == hours % 12u) ? 12u : hours % 12u);
+        right = minutes;
+    }
+    frame[0] = (display->suppress_leading_zero && 10u > left) ? 0u : SEGMENTS[left / 10u];
+    frame[1] = SEGMENTS[left % 10u];
+    if(!display->blink_colon || 0u == seconds % 2u){
+        frame[1] |= COLON;
+    }
+    frame[2] = SEGMENTS[right / 10u];
+    frame[3] = SEGMENTS[right % 10u];
+}
+
+/**
+ * @brief refresh every step seconds over one day and check every frame and mask.
+ * @returns the digits written to the display that day
+ */
+static uint32_t sweep_day(ds3231_tm1637_layout layout, bool use_24_hours, bool suppress_leading_zero,
+                          bool blink_colon, uint32_t step){
+    ds3231_tm1637_t display;
+    ds3231_tm1637_t display_12;
+    TEST_CHECK(ds3231_tm1637_init(&display,layout,use_24_hours,suppress_leading_zero,blink_colon));
+    TEST_CHECK(ds3231_tm1637_init(&display_12,layout,use_24_hours,suppress_leading_zero,blink_colon));
+    uint8_t shown[DS3231_TM1637_DIGITS] = {0};
+    uint8_t previous[DS3231_TM1637_DIGITS] = {0};
+    uint32_t writes = 0;
+    for(uint32_t second_of_day = 0; second_of_day < 86400u; second_of_day += step){
+        const ds3231_time_data_t t = time_of_day(second_of_day,false);
+        const ds3231_time_data_t t_12 = time_of_day(second_of_day,true);
+        uint8_t frame[DS3231_TM1637_DIGITS];
+        uint8_t frame_12[DS3231_TM1637_DIGITS];
+        uint8_t expected[DS3231_TM1637_DIGITS];
+        uint8_t changed = 0xFFu;
+        uint8_t changed_12 = 0xFFu;
+        TEST_CHECK(ds3231_tm1637_update(&display,&t,frame,&changed));
+        TEST_CHECK(ds3231_tm1637_update(&display_12,&t_12,frame_12,&changed_12));
+        reference_frame(&display,second_of_day,expected);
+        TEST_CHECK(changed == changed_12);
+        uint8_t expected_changed = 0u;
+        for(uint8_t i = 0; i < DS3231_TM1637_DIGITS; i++){
+            TEST_CHECK(expected[i] == frame[i] && frame[i] == frame_12[i]);
+            if(0u == second_of_day || previous[i] != expected[i]){
+                expected_changed |= (uint8_t)(1u << i);
+            }
+            if(0u != (changed & (1u << i))){
+                shown[i] = frame[i];
+                writes += 1u;
+            }
+            TEST_CHECK(shown[i] == expected[i]);
+            previous[i] = expected[i];
+        }
+        TEST_CHECK(expected_changed == changed);
+    }
+    return writes;
+}
+
+static void check_invalidate_and_range(void){
+    ds3231_tm1637_t display;
+    uint8_t frame[DS3231_TM1637_DIGITS];
+    uint8_t changed = 0;
+    ds3231_time_data_t t = time_of_day(12u * 3600u + 34u * 60u,false);
+    TEST_CHECK(ds3231_tm1637_init(&display,DS3231_TM1637_HH_MM,true,false,false));
+    TEST_CHECK(ds3231_tm1637_update(&display,&t,frame,&changed) && 0x0Fu == changed);
+    TEST_CHECK(ds3231_tm1637_update(&display,&t,NULL,&changed) && 0x00u == changed);
+    TEST_CHECK(ds3231_tm1637_invalidate(&display));
+    TEST_CHECK(ds3231_tm1637_update(&display,&t,NULL,&changed) && 0x0Fu == changed);
+
+    //a rejected time keeps the frame, the next update diffs against it
+    ds3231_time_data_t bad = t;
+    bad.hours = 24u;
+    TEST_CHECK(!ds3231_tm1637_update(&display,&bad,frame,&changed));
+    bad = time_of_day(0u,true);
+    bad.hours = 13u;
+    TEST_CHECK(!ds3231_tm1637_update(&display,&bad,frame,&changed));
+    bad = t;
+    bad.minutes = 60u;
+    TEST_CHECK(!ds3231_tm1637_update(&display,&bad,frame,&changed));
+    TEST_CHECK(ds3231_tm1637_update(&display,&t,NULL,&changed) && 0x00u == changed);
+    TEST_CHECK(!ds3231_tm1637_update(&display,&t,frame,NULL));
+    TEST_CHECK(!ds3231_tm1637_init(&display,(ds3231_tm1637_layout)(DS3231_TM1637_MM_SS + 1),true,false,false));
+}
+
+int main(void){
+    static const char* LAYOUTS[] = {"HH:MM", "MM:SS"};
+    printf("digits written in a day, a full refresh writes %u every second\n",4u * 86400u);
+    printf("%-6s %-6s %-9s %-6s %9s %9s\n","layout","hours","zero","colon","1s","60s");
+    for(uint32_t options = 0; options < 16u; options++){
+        const ds3231_tm1637_layout layout = (0u == (options & 8u)) ? DS3231_TM1637_HH_MM : DS3231_TM1637_MM_SS;
+        const bool use_24_hours = 0u != (options & 4u);
+        const bool suppress_leading_zero = 0u != (options & 2u);
+        const bool blink_colon = 0u != (options & 1u);
+        const uint32_t every_second = sweep_day(layout,use_24_hours,suppress_leading_zero,blink_colon,1u);
+        const uint32_t every_minute = sweep_day(layout,use_24_hours,suppress_leading_zero,blink_colon,60u);
+        printf("%-6s %-6s %-9s %-6s %9u %9u\n",LAYOUTS[layout],use_24_hours ? "24" : "12",
+               suppress_leading_zero ? "blank" : "0",blink_colon ? "blink" : "steady",every_second,every_minute);
+        if(DS3231_TM1637_HH_MM == layout && !blink_colon){
+            //nothing changes between minutes, a faster refresh writes nothing more
+            TEST_CHECK(every_second == every_minute);
+        }
+        if(DS3231_TM1637_HH_MM == layout && use_24_hours && !suppress_leading_zero && !blink_colon){
+            //the figure in the README
+            TEST_CHECK(1611u == every_second);
+        }
+    }
+    check_invalidate_and_range();
+    return test_result("test_tm1637");
+}
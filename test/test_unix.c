@@ -0,0 +1,129 @@
+#include "ds3231_test.h"
+#include "ds3231_lib_epoch.h"
+#include <string.h>
+
+/**
+ * ds3231_unix_to_time and ds3231_time_to_unix against the host's gmtime_r/timegm: every day of
+ * 2000-2199 at several seconds, in both hours formats, converts to the same calendar time and
+ * back to the same second. every day_of_month of every month of both centuries is taken exactly
+ * when the chip has that day, the range ends are checked second by second.
+ */
+
+static const uint32_t SECONDS_OF_DAY[] = {0u, 1u, 3599u, 43199u, 43200u, 46800u, 86399u};
+
+static void check_day(int32_t days){
+    for(size_t s = 0; s <= sizeof(SECONDS_OF_DAY) / sizeof(SECONDS_OF_DAY[0]); s++){
+        //the listed seconds and one that moves with the day
+        const uint32_t second_of_day = (s < sizeof(SECONDS_OF_DAY) / sizeof(SECONDS_OF_DAY[0]))
+                                     ? SECONDS_OF_DAY[s] : (uint32_t)(days * 7919) % 86400u;
+        const int64_t unix_time = (int64_t)days * 86400 + second_of_day;
+        const time_t host_time = (time_t)unix_time;
+        struct tm expected;
+        TEST_CHECK(NULL != gmtime_r(&host_time,&expected));
+        for(uint32_t format = 0; format < 2u; format++){
+            const bool use_24_format = (0u == format);
+            ds3231_time_data_t t;
+            int64_t back = 0;
+            TEST_CHECK(ds3231_unix_to_time(unix_time,use_24_format,&t));
+            const uint8_t hours = t.is_12_hours_format ? (uint8_t)(t.hours % 12u + (t.pm ? 12u : 0u)) : t.hours;
+            const bool same = expected.tm_sec == t.seconds && expected.tm_min == t.minutes && expected.tm_hour == hours
+                           && expected.tm_mday == t.day_of_month && expected.tm_mon + 1 == t.month
+                           && expected.tm_year + 1900 == 2000 + (t.century ? 100 : 0) + t.year
+                           && ((expected.tm_wday + 6) % 7) + 1 == t.day_of_week
+                           && use_24_format == !t.is_12_hours_format
+                           && (use_24_format || (1u <= t.hours && 12u >= t.hours));
+            if(!same){
+                fprintf(stderr,"unix %lld %s: %02u:%02u:%02u %02u.%02u.%u%02u dow %u\n",(long long)unix_time,
+                        use_24_format ? "24h" : "12h",t.hours,t.minutes,t.seconds,t.day_of_month,t.month,
+                        t.century ? 21u : 20u,t.year,t.day_of_week);
+                test_failures += 1u;
+            }
+            TEST_CHECK(ds3231_time_to_unix(&t,&back) && unix_time == back);
+        }
+    }
+}
+
+/** every day of every month as the chip counts months: a day is taken exactly when the chip has it */
+static void check_month_lengths(void){
+    static const uint8_t CHIP_DAYS[12] = {31,28,31,30,31,30,31,31,30,31,30,31};
+    for(uint32_t century = 0; century < 2u; century++){
+        for(uint8_t year = 0; year < 100u; year++){
+            for(uint8_t month = 1; month <= 12u; month++){
+                const uint8_t month_days = (2u == month && 0u == year % 4u) ? 29u : CHIP_DAYS[month - 1u];
+                for(uint8_t day = 0; day <= 32u; day++){
+                    const ds3231_time_data_t t = {.seconds = 59u, .minutes = 59u, .hours = 23u, .day_of_month = day,
+                                                  .month = month, .year = year, .day_of_week = 1u, .century = (1u == century)};
+                    int64_t unix_time = 0;
+                    const bool res = ds3231_time_to_unix(&t,&unix_time);
+                    TEST_CHECK(res == (1u <= day && month_days >= day));
+                    if(res){
+                        struct tm host = {.tm_sec = 59, .tm_min = 59, .tm_hour = 23, .tm_mday = day,
+                                          .tm_mon = month - 1, .tm_year = 100 + (int)century * 100 + year};
+                        //timegm carries 2100-02-29 into 2100-03-01 like the conversion does
+                        TEST_CHECK((int64_t)timegm(&host) == unix_time);
+                    }
+                }
+            }
+        }
+    }
+    //the one day the chip has and the gregorian calendar doesn't
+    const ds3231_time_data_t leap_2100 = {.day_of_month = 29u, .month = 2u, .year = 0u, .day_of_week = 1u, .century = true};
+    int64_t unix_time = 0;
+    ds3231_time_data_t t;
+    TEST_CHECK(ds3231_time_to_unix(&leap_2100,&unix_time));
+    TEST_CHECK(ds3231_unix_to_time(unix_time,true,&t) && 1u == t.day_of_month && 3u == t.month);
+}
+
+static void check_fields(void){
+    const ds3231_time_data_t valid = {.seconds = 0u, .minutes = 0u, .hours = 12u, .day_of_month = 1u, .month = 1u,
+                                      .year = 26u, .day_of_week = 4u, .is_12_hours_format = true};
+    int64_t midnight = 0;
+    int64_t noon = 0;
+    ds3231_time_data_t t = valid;
+    //12 AM is midnight, 12 PM is noon
+    TEST_CHECK(ds3231_time_to_unix(&t,&midnight) && 0 == midnight % 86400);
+    t.pm = true;
+    TEST_CHECK(ds3231_time_to_unix(&t,&noon) && midnight + 43200 == noon);
+    t.hours = 0u;
+    TEST_CHECK(!ds3231_time_to_unix(&t,&noon));
+    t.hours = 13u;
+    TEST_CHECK(!ds3231_time_to_unix(&t,&noon));
+    t = valid;
+    t.is_12_hours_format = false;
+    t.hours = 24u;
+    TEST_CHECK(!ds3231_time_to_unix(&t,&noon));
+    t = valid;
+    t.minutes = 60u;
+    TEST_CHECK(!ds3231_time_to_unix(&t,&noon));
+    t = valid;
+    t.seconds = 60u;
+    TEST_CHECK(!ds3231_time_to_unix(&t,&noon));
+    t = valid;
+    t.month = 0u;
+    TEST_CHECK(!ds3231_time_to_unix(&t,&noon));
+    t.month = 13u;
+    TEST_CHECK(!ds3231_time_to_unix(&t,&noon));
+    t = valid;
+    t.year = 100u;
+    TEST_CHECK(!ds3231_time_to_unix(&t,&noon));
+    TEST_CHECK(!ds3231_time_to_unix(NULL,&noon) && !ds3231_time_to_unix(&valid,NULL));
+
+    //the range ends
+    TEST_CHECK(ds3231_unix_to_time(DS3231_UNIX_TIME_MIN,true,&t) && 0u == t.year && !t.century && 1u == t.month);
+    TEST_CHECK(ds3231_unix_to_time(DS3231_UNIX_TIME_MAX,true,&t) && 99u == t.year && t.century && 31u == t.day_of_month);
+    TEST_CHECK(!ds3231_unix_to_time(DS3231_UNIX_TIME_MIN - 1,true,&t));
+    TEST_CHECK(!ds3231_unix_to_time(DS3231_UNIX_TIME_MAX + 1,true,&t));
+    TEST_CHECK(!ds3231_unix_to_time(DS3231_UNIX_TIME_MIN,true,NULL));
+}
+
+int main(void){
+    const int32_t first_day = (int32_t)(DS3231_UNIX_TIME_MIN / 86400);
+    const int32_t last_day = (int32_t)(DS3231_UNIX_TIME_MAX / 86400);
+    for(int32_t days = first_day; days <= last_day; days++){
+        check_day(days);
+    }
+    printf("%d days round tripped\n",(int)(last_day - first_day + 1));
+    check_month_lengths();
+    check_fields();
+    return test_result("test_unix");
+}